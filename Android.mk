@@ -29,8 +29,23 @@ LOCAL_SRC_FILES :=  cpdd.c  \
 					cpdUtil.c \
 					cpdModem.c \
 					cpdModemReadWrite.c \
+					cpdAtTokenizer.c \
+					cpdRingBuffer.c \
+					cpdScan.c \
 					cpdXmlParser.c \
+					cpdXmlSaxDecoder.c \
 					cpdXmlUtils.c \
+					cpdXmlNames.c \
+					cpdXmlArena.c \
+					cpdGppCodec.c \
+					cpdResponseSender.c \
+					cpdSessionTimer.c \
+					cpdSession.c \
+					cpdLastFix.c \
+					cpdAssistStore.c \
+					cpdAidingCache.c \
+					cpdGpsRing.c \
+					cpdGpsWire.c \
 					cpdDebug.c \
 					cpdXmlFormatter.c\
 					cpdGpsComm.c  \
@@ -64,8 +79,13 @@ LOCAL_MODULE_TAGS := optional
 LOCAL_SRC_FILES += \
                     $(CPD_PATH)/cpdInit.c  \
                     $(CPD_PATH)/cpdUtil.c \
+                    $(CPD_PATH)/cpdRingBuffer.c \
+                    $(CPD_PATH)/cpdScan.c \
                     $(CPD_PATH)/cpdDebug.c \
                     $(CPD_PATH)/cpdGpsComm.c  \
+                    $(CPD_PATH)/cpdAidingCache.c \
+                    $(CPD_PATH)/cpdGpsRing.c \
+                    $(CPD_PATH)/cpdGpsWire.c \
                     $(CPD_PATH)/cpdSocketServer.c
 
 LOCAL_C_INCLUDES += $(LOCAL_PATH)
@@ -105,14 +125,30 @@ LOCAL_C_INCLUDES:=          \
     $(TARGET_OUT_HEADERS)/IFX-modem
 
 LOCAL_SRC_FILES :=  cpd.c  \
+    cpdSimChecks.c \
     cpdInit.c  \
     cpdStart.c \
     cpdUtil.c \
     cpdModem.c \
     cpdMMgr.c \
     cpdModemReadWrite.c \
+    cpdAtTokenizer.c \
+    cpdRingBuffer.c \
+    cpdScan.c \
     cpdXmlParser.c \
+    cpdXmlSaxDecoder.c \
     cpdXmlUtils.c \
+    cpdXmlNames.c \
+    cpdXmlArena.c \
+    cpdGppCodec.c \
+    cpdResponseSender.c \
+    cpdSessionTimer.c \
+    cpdSession.c \
+    cpdLastFix.c \
+    cpdAssistStore.c \
+    cpdAidingCache.c \
+    cpdGpsRing.c \
+    cpdGpsWire.c \
     cpdDebug.c \
     cpdXmlFormatter.c\
     cpdGpsComm.c  \
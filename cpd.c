@@ -11,6 +11,7 @@
  */
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <unistd.h>
 #include <fcntl.h>
 #include <errno.h>
@@ -36,9 +37,11 @@
 #include "cpdXmlFormatter.h"
 #include "cpdStart.h"
 #include "cpdSystemMonitor.h"
+#include "cpdSimChecks.h"
 
 #include "cpdDebug.h"
 
+
 static int cpdDeamonRun;
 static void cpdDeamonSignalHandler(int sig)
 {
@@ -116,6 +119,55 @@ int cpdSendRequestMSAToGps_t(pCPD_CONTEXT pCpd)
 
 #define MSA  1
 #define MSB  2
+
+/* checks and benchmarks, the first one selected on command line is run instead of simulator */
+static CPD_CHECK cpdChecks[] = {
+    { "-r", CPD_CHECK_ARG_FILE, 1, NULL, cpdModemReplay_t, 0, NULL },
+    { "-n", CPD_CHECK_ARG_COUNT, 100000, NULL, cpdXmlNamesBenchmark_t, 0, NULL },
+    { "-j", CPD_CHECK_ARG_COUNT, 10000, NULL, cpdScanBenchmark_t, 0, NULL },
+    { "-k", CPD_CHECK_ARG_COUNT, 1000, NULL, cpdGppCodecBenchmark_t, 0, NULL },
+    { "-t", 0, 1, NULL, cpdSessionTimerCheck_t, 0, NULL },
+    { "-c", 0, 1, NULL, cpdSessionCheck_t, 0, NULL },
+    { "-p", CPD_CHECK_ARG_FILE, 1, "cpdAssist_t.bin", cpdAssistStoreCheck_t, 0, NULL },
+    { "-g", CPD_CHECK_ARG_COUNT, 10000, NULL, cpdGpsFramingBenchmark_t, 0, NULL },
+    { "-q", CPD_CHECK_ARG_COUNT, 1000, NULL, cpdGpsRingBenchmark_t, 0, NULL },
+    { "-w", CPD_CHECK_ARG_COUNT, 10000, NULL, cpdGpsWireBenchmark_t, 0, NULL },
+    { "-d", CPD_CHECK_ARG_COUNT, 10000, NULL, cpdAidingCacheCheck_t, 0, NULL },
+    { "-l", 0, 1, NULL, cpdLastFixCheck_t, 0, NULL },
+    { "-s", 0, 1, NULL, cpdResponseSenderCheck_t, 0, NULL },
+    { "-e", CPD_CHECK_ARG_COUNT, 1000, NULL, cpdXmlFormatBenchmark_t, 0, NULL },
+    { "-b", CPD_CHECK_ARG_COUNT | CPD_CHECK_ARG_FILE, 1000, NULL, cpdXmlBenchmark_t, 0, NULL }
+};
+#define CPD_CHECKS  (sizeof(cpdChecks) / sizeof(cpdChecks[0]))
+
+/*
+ * Check selected by argv[i], with count and file name following it. Returns index of the last argument used.
+ */
+static int cpdParseCheck(int argc, char *argv[], int i)
+{
+    pCPD_CHECK pCheck;
+    unsigned int k;
+
+    for (k = 0; k < CPD_CHECKS; k++) {
+        pCheck = &(cpdChecks[k]);
+        if (strncasecmp (argv[i], pCheck->pOption, 2) != 0) {
+            continue;
+        }
+        pCheck->n = pCheck->defaultCount;
+        pCheck->pFileName = pCheck->pDefaultFile;
+        if (((pCheck->args & CPD_CHECK_ARG_COUNT) != 0) && ((i + 1) < argc) && (argv[i + 1][0] != '-')) {
+            i++;
+            pCheck->n = atoi(argv[i]);
+        }
+        if (((pCheck->args & CPD_CHECK_ARG_FILE) != 0) && ((i + 1) < argc) && (argv[i + 1][0] != '-')) {
+            i++;
+            pCheck->pFileName = argv[i];
+        }
+        break;
+    }
+    return i;
+}
+
 int cpdParseCmdLine(pCPD_CONTEXT pCpd, int argc, char *argv[])
 {
     int result = MSB;
@@ -135,6 +187,24 @@ int cpdParseCmdLine(pCPD_CONTEXT pCpd, int argc, char *argv[])
                 strcpy(argv[i], pCpd->modemInfo.modemName);
             }
         }
+        i = cpdParseCheck(argc, argv, i);
+        if (strncasecmp (argv[i], "-a", 2) == 0) {
+            i++;
+            if (i < argc) {
+                pCpd->xmlArena.size = atoi(argv[i]);
+            }
+        }
+        if (strncasecmp (argv[i], "-x", 2) == 0) {
+            i++;
+            if (i < argc) {
+                if (strncasecmp (argv[i], "dom", 3) == 0) {
+                    pCpd->xmlRxParser.decodeMode = XML_DECODE_DOM;
+                }
+                else if (strncasecmp (argv[i], "verify", 6) == 0) {
+                    pCpd->xmlRxParser.decodeMode = XML_DECODE_VERIFY;
+                }
+            }
+        }
     }
     return result;
 }
@@ -153,7 +223,10 @@ int main(int argc, char *argv[])
     int sig = 0;
     unsigned int tRequest;
     unsigned int tResponse;
+    unsigned int responseTime[2] = { 0, 0 };   /* MS-B, MS-A */
+    unsigned int nResponses[2] = { 0, 0 };
     int mode = 0;
+    unsigned int k;
 
 
     LOGD("Starting %s", argv[0]);
@@ -170,6 +243,15 @@ int main(int argc, char *argv[])
         return 1;
     }
     mode = cpdParseCmdLine(pCpd, argc, argv);
+    cpdXmlParserInit(pCpd);
+    for (k = 0; k < CPD_CHECKS; k++) {
+        if (cpdChecks[k].n > 0) {
+            result = cpdChecks[k].pfCheck(pCpd, cpdChecks[k].n, cpdChecks[k].pFileName);
+            CPD_LOG_CLOSE();
+            printf("\n");
+            return (result == CPD_OK) ? 0 : 1;
+        }
+    }
 
     CPD_LOG(CPD_LOG_ID_TXT | CPD_LOG_ID_CONSOLE, "\n%s Running as a deamon PID=%d, PPID=%d",  argv[0], pid, parent );
     LOGV("%s Running as a deamon PID=%d, PPID=%d",  argv[0], pid, parent);
@@ -212,7 +294,8 @@ int main(int argc, char *argv[])
             cpdSendRequestMSAToGps_t(pCpd);
             printf("\nMSA: ");
             mode = 2;
-            while (1) {
+            /* measurements are reported as soon as they come, without waiting for a fix */
+            while (pCpd->response.flag == CPD_NOK) {
                 sleep(1);
                 if (getMsecDt(tRequest) > 72000) {
                     cpdSendStopRequestToGps_t(pCpd);
@@ -224,7 +307,13 @@ int main(int argc, char *argv[])
             CPD_LOG(CPD_LOG_ID_TXT | CPD_LOG_ID_CONSOLE, "\n%u:%d NO FIX, %u", getMsecTime(), i, getMsecDt(tRequest));
         }
         else {
-            CPD_LOG(CPD_LOG_ID_TXT | CPD_LOG_ID_CONSOLE, "\n%u:%d TTFF, %u", getMsecTime(), i, getMsecDt(tRequest));
+            tResponse = getMsecDt(tRequest);
+            responseTime[mode - 1] = responseTime[mode - 1] + tResponse;
+            nResponses[mode - 1]++;
+            CPD_LOG(CPD_LOG_ID_TXT | CPD_LOG_ID_CONSOLE, "\n%u:%d TTFF, %u, response %d, average MS-B %u ms (%u), MS-A %u ms (%u)",
+                    getMsecTime(), i, tResponse, pCpd->response.flag,
+                    (nResponses[0] > 0) ? responseTime[0] / nResponses[0] : 0, nResponses[0],
+                    (nResponses[1] > 0) ? responseTime[1] / nResponses[1] : 0, nResponses[1]);
         }
 
         pCpd->request.flag = REQUEST_FLAG_NONE;
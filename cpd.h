@@ -73,7 +73,7 @@
 #define GPP_LL_UNCERT_C  (10.0)
 #define GPP_LL_UNCERT_1X  (1.0 + 0.1)
 #define GPP_LL_UNCERT_MAX_K (127)
-#define GPP_LL_UNCERT_MAX_M (990)
+#define GPP_LL_UNCERT_MAX_M (1806627)   /* C * ((1 + x)^127 - 1) */
 
 /* Altitude uncertainty calculation */
 #define GPP_ALT_UNCERT_C  (45.0)
@@ -515,6 +515,7 @@ typedef struct {
     int             rel98_assist_data_ext;
     int             rel5_assist_data_ext;
     int             rel7_assist_data_ext;
+    unsigned long long  nav_model_mirrored; /* bit (sat_id - 1): nav_model_elem GPS already has was left out */
 
 } ASSIST_DATA, *pASSIST_DATA;
 
@@ -737,7 +738,7 @@ typedef struct {
 } POS_RESP_MEASUREMENTS, pPOS_RESP_MEASUREMENTS;
 
 /* update version number, when structure or it's size changes */
-#define CPD_MSG_VERSION (0x121218)
+#define CPD_MSG_VERSION (0x121220)
 
 
 /*
@@ -839,13 +840,19 @@ typedef struct {
 
 #define MODEM_RX_BUFFER_SIZE    4096
 #define MODEM_TX_BUFFER_SIZE    4096
-#define XML_RX_BUFFER_SIZE      8192
-#define GPS_COMM_RX_BUFFER_SIZE 4096
+#define XML_RX_MAX_DOC_SIZE     (64 * 1024)
+#define XML_TX_MAX_DOC_SIZE     (4 * 1024)
+#define GPS_COMM_RX_BUFFER_SIZE (8 * 1024)  /* has to hold cpdGpsWireMaxSize(GPS_WIRE_REQUEST) */
+#define CPD_MSG_FRAMING_TEXT    (1)     /* text header and tail, understood by every GPS library */
+#define CPD_MSG_FRAMING_V2      (2)     /* binary header with length and CRC32C, used when other side agrees */
+#define CPD_MSG_PAYLOAD_PACKED  (0x100) /* or-ed to framing: request and response data encoded by cpdGpsWire.c */
+#define CPD_MSG_PAYLOAD_MIRROR  (0x200) /* or-ed to framing: GPS side restores ephemeris left out by cpdAidingStrip() */
 
 #define SOCKET_GPS_USE_LOCAL    (1) /* use local UNIX type sockets to connect to GPS */
 #ifdef SOCKET_GPS_USE_LOCAL
 #define SOCKET_HOST_GPS         "/data/data/gpsSocket"
 #define SOCKET_PORT_GPS         0
+#define GPS_RING_USE            (1) /* offer shared memory rings to GPS, descriptors are passed on local socket */
 #else
 #define SOCKET_HOST_GPS         "localhost"
 #define SOCKET_PORT_GPS         4121
@@ -885,6 +892,94 @@ typedef struct {
 #define CPD_SYSTEMMONITOR_INTERVAL      (5000UL)    /* interval on which CPD will check services status */
 #define CPD_SYSTEMMONITOR_INTERVAL_ACTIVE_SESSION  (1000UL)    /* interval on which CPD will check services status */
 
+/*
+ * Ring buffer for received data (cpdRingBuffer.c).
+ * head, tail are free-running counters, unread data is [tail, head).
+ */
+typedef struct {
+    char                *pBuffer;
+    unsigned int        size;       /* power of 2 */
+    unsigned int        head;       /* total bytes written */
+    unsigned int        tail;       /* total bytes released */
+    int                 mirrored;   /* CPD_OK if buffer is mapped twice back-to-back */
+    int                 fd;         /* shared memory region of mirrored buffer */
+} RING_BUFFER, *pRING_BUFFER;
+
+/*
+ * Tokens reported by the incremental modem Rx tokenizer (cpdAtTokenizer.c).
+ */
+typedef enum {
+    AT_TOKEN_NONE = 0,
+    AT_TOKEN_OK,
+    AT_TOKEN_ERROR,
+    AT_TOKEN_CTRL_Z,
+    AT_TOKEN_ESC,
+    AT_TOKEN_RING,
+    AT_TOKEN_URC_START,
+    AT_TOKEN_URC_END
+} AT_TOKEN_TYPE_E;
+
+typedef struct {
+    AT_TOKEN_TYPE_E     type;
+    int                 start;      /* offset of the token (URC_END: end of URC payload) in Rx buffer */
+    int                 len;        /* number of bytes in the token/terminator */
+    int                 urcStart;   /* URC_START, URC_END: offset of "+CPOSR:" */
+    int                 urcHasXml;  /* URC_END: URC payload contains XML */
+} AT_TOKEN, *pAT_TOKEN;
+
+typedef struct {
+    int                 scanIndex;  /* first byte in Rx buffer not scanned yet */
+    int                 lineStart;  /* start of current line */
+    int                 urcStart;   /* start of URC being received, CPD_ERROR if none */
+    int                 urcEnd;     /* end of last complete line of URC being received */
+    int                 urcHasXml;
+} AT_TOKENIZER, *pAT_TOKENIZER;
+
+#define AT_COMMAND_QUEUE_SIZE   16
+
+/* called with AT_RESPONSE_xxx received (AT_RESPONSE_NONE on timeout or error) and response time in ms */
+typedef  void (fAT_COMMAND_DONE)(void * , int , unsigned int );
+
+/*
+ * AT command queued for modem (cpdModemReadWrite.c).
+ */
+typedef struct {
+    unsigned int        id;
+    const char          *pCmd;          /* must stay valid until command completes */
+    int                 len;
+    int                 waitFor;        /* AT_RESPONSE_xxx completing the command, OK and ERROR always do */
+    unsigned int        timeout;        /* ms, counted from the moment command is written to modem */
+    unsigned int        sentAt;
+    fAT_COMMAND_DONE    *pfDone;
+    void                *pArg;
+} AT_COMMAND, *pAT_COMMAND;
+
+/*
+ * Result of synchronous AT command, filled in by completion callback.
+ */
+typedef struct {
+    int                 done;
+    int                 response;
+    unsigned int        latency;
+} AT_COMMAND_WAIT, *pAT_COMMAND_WAIT;
+
+/*
+ * AT command queue.
+ * Commands are written to modem one at the time, in the order they were submitted. Modem read thread
+ * completes the command as soon as its final result (or <waitFor> response) is received, and writes
+ * the next queued command right away.
+ */
+typedef struct {
+    pthread_mutex_t     lock;
+    pthread_cond_t      done;           /* signalled when synchronous command completes */
+    AT_COMMAND          queue[AT_COMMAND_QUEUE_SIZE];
+    int                 head;           /* oldest command, written to modem if inFlight is set */
+    int                 count;
+    int                 inFlight;
+    int                 busy;           /* completion callback is running, next command is not written yet */
+    unsigned int        nextId;
+} AT_ENGINE, *pAT_ENGINE;
+
 typedef struct {
     char                modemName[MODEM_NAME_MAX_LEN];
     int                 modemFd;
@@ -892,21 +987,22 @@ typedef struct {
 
     pthread_t           modemReadThread;
     THREAD_STATE_E      modemReadThreadState;
-    char                *pModemRxBuffer;
-    int                 modemRxBufferSize;
-    int                 modemRxBufferIndex;
+    RING_BUFFER         modemRxRing;
+    AT_TOKENIZER        atTokenizer;
 
     pthread_mutex_t     modemFdLock;
 
-    int                 waitingForResponse;
-    int                 waitForThisResponse;
-    int                 haveResponse;
-    int                 responseValue;
+    AT_ENGINE           atEngine;
 
     int                 receivingXml;
     unsigned int        lastDataSent;
     unsigned int        lastDataReceived;
 
+    int                 initForCPPending;
+    unsigned int        initForCPStartedAt;
+    unsigned int        modemUpAt;
+    unsigned int        cposrRegistrationTime;  /* ms from modem up to +CPOSR registered */
+
     int                 registeredForCPOSR;
     unsigned int                 registeredForCPOSRat;
     unsigned int                 receivedCPOSRat;
@@ -929,16 +1025,122 @@ typedef struct {
 } XML_BUFFER, *pXML_BUFFER;
 
 
+#define XML_SAX_MAX_DEPTH       (16)
+#define XML_SAX_TEXT_SIZE       (32)
+
+/*
+ * Streaming decoder for +CPOSR XML (cpdXmlSaxDecoder.c).
+ * Values are written into REQUEST_PARAMS as elements close, no document tree is built.
+ */
+typedef struct {
+    unsigned short  stack[XML_SAX_MAX_DEPTH];       /* XML_NAME_E of each open element */
+    unsigned char   nChildren[XML_SAX_MAX_DEPTH];   /* child elements started so far in each open element */
+    int             depth;
+    char            text[XML_SAX_TEXT_SIZE];        /* text of the innermost element, leading blanks skipped */
+    int             textLen;                        /* -1 if element has no text */
+    unsigned int    flags;                          /* parts of current <pos> child found so far */
+    int             result;                         /* decode result of current <pos> child */
+    int             locationResult;
+    int             navIndex;                       /* nav_model_elem_arr[] slot being decoded, CPD_ERROR if none */
+    int             navSatStatus;
+    int             towIndex;                       /* GPS_TOW_assist_arr[] slot being decoded, CPD_ERROR if none */
+} XML_SAX_DECODER, *pXML_SAX_DECODER;
+
+typedef enum {
+    XML_DECODE_SAX,         /* streaming decoder only */
+    XML_DECODE_DOM,         /* document tree of each <pos> child is built and searched */
+    XML_DECODE_VERIFY       /* both, streaming decoder result is checked against document tree result */
+} XML_DECODE_MODE_E;
+
+/*
+ * Incremental parser for XML documents received with +CPOSR (cpdXmlParser.c).
+ * URC fragments are pushed into libxml2 push parser as they arrive.
+ */
+typedef struct {
+    void            *pCtxt;         /* xmlParserCtxtPtr, reused for all documents, NULL until cpdXmlParserInit() */
+    void            *pDict;         /* xmlDictPtr of pCtxt, pos.xsd names are interned once */
+    int             receiving;      /* CPD_OK while document is being received */
+    int             depth;          /* current element nesting */
+    int             docClosed;      /* CPD_OK when root element was closed */
+    int             posMeasDecoded;
+    int             nBytes;
+    unsigned int    startedAt;
+    unsigned int    lastUpdate;
+    unsigned int    maxAge;
+    XML_DECODE_MODE_E   decodeMode;
+    XML_SAX_DECODER     sax;
+    pREQUEST_PARAMS     pVerify;        /* XML_DECODE_VERIFY: request before and after streaming decoder */
+    unsigned int        verifyErrors;
+} XML_RX_PARSER, *pXML_RX_PARSER;
+
+/*
+ * Bump pointer arena for libxml2 allocations of one response formatted as document tree (cpdXmlArena.c).
+ * Responses written from templates and CPOSR decoding don't use it.
+ */
+#define XML_ARENA_SIZE          (24 * 1024)     /* 0 - arena is not used */
+#define XML_ARENA_MAX_ALLOC     (8 * 1024)      /* bigger requests are passed to malloc */
+
+typedef struct {
+    char            *pBase;
+    unsigned int    size;
+    unsigned int    used;
+    int             enabled;        /* CPD_OK if messages may use the arena */
+    int             active;         /* CPD_OK while a message has the arena */
+    pthread_t       owner;          /* thread of the message which has the arena */
+    pthread_mutex_t lock;
+    unsigned int    nMessages;
+    unsigned int    nAllocs;        /* allocations taken from arena */
+    unsigned int    nFallbacks;     /* allocations of arena owner passed to malloc */
+    unsigned int    highWater;      /* most bytes used by one message */
+    unsigned int    maxRequest;     /* biggest single request of arena owner */
+} XML_ARENA, *pXML_ARENA;
+
+/*
+ * Location response kept for periodic reporting (cpdXmlFormatter.c), values are rewritten in place for each fix.
+ */
+#define XML_TX_MAX_SLOTS        (64)
+
+typedef struct {
+    unsigned short  offset;         /* first character of the value in text */
+    unsigned char   len;
+    unsigned char   type;           /* template value mark */
+    long            value;
+} XML_TX_SLOT, *pXML_TX_SLOT;
+
+typedef struct {
+    int             valid;          /* CPD_OK if text was made for request and shape below */
+    unsigned int    requestId;      /* request.dbgStats.posRequestId */
+    SHAPE_TYPE_E    shape;
+    int             len;
+    int             nSlots;
+    XML_TX_SLOT     slots[XML_TX_MAX_SLOTS];
+    char            text[XML_TX_MAX_DOC_SIZE];
+    unsigned int    nBuilt;
+    unsigned int    nPatched;
+} XML_TX_TEMPLATE, *pXML_TX_TEMPLATE;
+
 typedef struct {
     int     scGpsIndex;
     int     rxBufferSize;
     char    *pRxBuffer;
     int     rxBufferIndex;
+    int     rxBufferStart;          /* first byte not handled yet, bytes before it are removed once per read */
     int     rxBufferMessageType;
     int     rxBufferCmdStart;
     int     rxBufferCmdEnd;
     int     rxBufferCmdDataStart;
     int     rxBufferCmdDataSize;
+    int     rxBufferCmdNext;        /* first byte after the message */
+    int     txFraming;              /* CPD_MSG_FRAMING_xx of sent messages, both are received */
+    int     txPacked;               /* CPD_OK: requests and responses are sent encoded, both are received */
+    int     txMirrored;             /* CPD_OK: GPS side keeps ephemeris mirror, known ephemeris is left out of requests */
+    unsigned int    nRxText;
+    unsigned int    nRxV2;
+    unsigned int    nResync;        /* header not at the start of data, bytes before it were dropped */
+    unsigned int    nCrcErrors;
+    unsigned int    bytesDropped;
+    unsigned int    nRxReads;
+    unsigned int    maxRxPerRead;   /* most messages handled from one read */
 
 } GPS_COMM_BUFFER, *pGPS_COMM_BUFFER;
 
@@ -951,10 +1153,301 @@ typedef struct {
     int                 pmfd;
 } SYSTEM_MONITOR, *pSYSTEM_MONITOR;
 
+/*
+ * Responses from GPS waiting to be sent to modem (cpdResponseSender.c).
+ * One worker thread sends them in order, failed sends are retried with growing interval until the deadline of the request.
+ */
+#define CPOS_MIN_INTERVAL               (1000UL)    /* minimum time between two responses sent to modem */
+#define RESPONSE_SENDER_QUEUE_SIZE      (4)
+#define RESPONSE_SENDER_DEADLINE        (30000UL)   /* used when request has no response time limit */
+#define RESPONSE_SENDER_FIRST_RETRY     (100UL)
+#define RESPONSE_SENDER_MAX_RETRY       (3000UL)
+
+typedef struct {
+    unsigned int        serial;
+    unsigned int        sessionId;      /* request.dbgStats.posRequestId the response belongs to */
+    unsigned int        queuedAt;
+    unsigned int        deadline;       /* getMsecTime() after which response is dropped */
+    unsigned int        nextAttemptAt;
+    unsigned int        retryInterval;
+    int                 nAttempts;
+    RESPONSE_PARAMS     response;
+} RESPONSE_JOB, *pRESPONSE_JOB;
+
+typedef struct {
+    pthread_t           senderThread;
+    THREAD_STATE_E      senderThreadState;
+    pthread_mutex_t     lock;           /* recursive, guards the queue and pCpd->response */
+    pthread_cond_t      wake;
+    int                 count;
+    RESPONSE_JOB        jobs[RESPONSE_SENDER_QUEUE_SIZE];  /* oldest first */
+    unsigned int        sending;        /* serial of the job being sent, 0 if none */
+    unsigned int        nQueued;
+    unsigned int        nDone;          /* sent, or not needed any more */
+    unsigned int        nFailed;        /* can't be formatted */
+    unsigned int        nRetries;
+    unsigned int        nReplaced;
+    unsigned int        nDropped;       /* queue was full */
+    unsigned int        nCancelled;
+    unsigned int        nExpired;
+} RESPONSE_SENDER, *pRESPONSE_SENDER;
+
+/*
+ * Positioning sessions requested by network (cpdSession.c).
+ * Each RRLP/RRC request has its own copy of the request and its status, responses from GPS are given to every
+ * session they satisfy, so one GPS run serves all sessions of the same method.
+ */
+#define CPD_MAX_SESSIONS                (4)
+
+typedef struct {
+    unsigned int        sessionId;      /* request.dbgStats.posRequestId, 0 if slot is free */
+    GPP_METHOD_TYPE_E   method;
+    unsigned int        nFixes;         /* responses from GPS given to the session */
+    REQUEST_PARAMS      request;
+} CPD_SESSION, *pCPD_SESSION;
+
+typedef struct {
+    pthread_mutex_t     lock;           /* recursive, taken after responseSender.lock */
+    int                 count;
+    CPD_SESSION         sessions[CPD_MAX_SESSIONS];     /* oldest first */
+    int                 gpsRunning;     /* CPD_OK if request was passed to GPS and GPS wasn't stopped since */
+    GPP_METHOD_TYPE_E   gpsMethod;      /* method GPS runs with, GPP_METHOD_TYPE_NONE if it's stopped */
+    int                 stopPending;    /* CPD_OK if GPS has to be stopped, but stop could not be sent */
+    REQUEST_SUMM        gpsRs;          /* accuracy, response time and interval GPS runs with */
+    unsigned int        nOpened;
+    unsigned int        nShared;        /* served by GPS which was already running */
+    unsigned int        nTightened;     /* request sent again to running GPS, new session needs better QoS */
+    unsigned int        nAssistForwarded;   /* assistance of a session which joined running GPS */
+    unsigned int        nEvicted;       /* table was full */
+    unsigned int        nFannedOut;     /* responses given to more than one session */
+} SESSION_TABLE, *pSESSION_TABLE;
+
+/*
+ * Last location reported by GPS (cpdLastFix.c).
+ * New MS-based session whose accuracy and response time can be met by it is answered at once.
+ */
+#define LAST_FIX_MAX_AGE                (30000UL)   /* ms */
+#define LAST_FIX_DRIFT                  (3)         /* m/s, uncertainty of cached fix grows with its age */
+
+typedef struct {
+    pthread_mutex_t     lock;
+    int                 valid;
+    LOCATION            location;
+    int                 horUncert;      /* m */
+    int                 vertUncert;     /* m, CPD_ERROR if location has no altitude uncertainty */
+    unsigned int        fixedAt;        /* getMsecMonotonic() */
+    unsigned int        maxAge;         /* ms, 0 disables the cache */
+    int                 refine;         /* CPD_OK to start GPS even if the cache fulfils the session, to refresh it */
+    unsigned int        nLookups;
+    unsigned int        nHits;
+    unsigned int        nStale;         /* no fix, or too old for the request */
+    unsigned int        nInaccurate;
+    unsigned int        nTtff;          /* sessions answered by GPS */
+    unsigned long long  ttffTotal;      /* ms, request received to first location from GPS */
+    unsigned long long  savedTotal;     /* ms, average time to first fix for every hit */
+} LAST_FIX_CACHE, *pLAST_FIX_CACHE;
+
+/*
+ * Assistance data kept across restarts (cpdAssistStore.c).
+ * File holds two slots, update is written to the older one, so a torn write leaves the previous data valid.
+ * Slot is used only if its magic, version, size and CRC-32C are right, the newer generation wins.
+ */
+#define CPD_ASSIST_STORE_FILE           "/data/data/cpdAssist.bin"
+#define ASSIST_STORE_MAGIC              (0x41445043)    /* "CPDA" */
+#define ASSIST_STORE_VERSION            (1)
+#define ASSIST_STORE_MAX_SVS            (64)            /* sat_id 1..64 */
+#define ASSIST_STORE_EPHEMERIS_AGE      (4ULL * 3600 * 1000)    /* ms, ephemeris fit interval */
+#define ASSIST_STORE_LOCATION_AGE       (2ULL * 3600 * 1000)
+#define ASSIST_STORE_TIME_AGE           (24ULL * 3600 * 1000)
+#define ASSIST_STORE_TIME_REFRESH       (3600ULL * 1000)        /* stored reference time is not rewritten sooner */
+
+typedef struct {
+    unsigned long long  refTimeAt;      /* CLOCK_REALTIME ms when refTime was valid, 0 if there is none */
+    GPS_TIME            refTime;
+    unsigned long long  refLocationAt;
+    LOCATION_PARAMETERS refLocation;    /* polygon is not stored */
+    unsigned long long  ephemerisAt[ASSIST_STORE_MAX_SVS];     /* indexed by sat_id - 1, 0 if SV has none */
+    NAV_MODEL_ELEM      ephemeris[ASSIST_STORE_MAX_SVS];
+} ASSIST_STORE_DATA, *pASSIST_STORE_DATA;
+
+typedef struct {
+    unsigned int        magic;
+    unsigned int        version;
+    unsigned int        size;           /* sizeof(ASSIST_STORE_SLOT), layout check */
+    unsigned int        generation;
+    unsigned int        crc;            /* CRC-32C of data */
+    unsigned int        reserved;
+    ASSIST_STORE_DATA   data;
+} ASSIST_STORE_SLOT, *pASSIST_STORE_SLOT;
+
+typedef struct {
+    pthread_mutex_t     lock;
+    char                *pFileName;
+    int                 fd;
+    pASSIST_STORE_SLOT  pSlots;         /* 2 slots mapped from pFileName, NULL if store is not open */
+    int                 current;        /* slot with valid data, CPD_ERROR if there is none */
+    int                 dirty;          /* current slot was written since it was last synced to disk */
+    int                 flushing;       /* flush thread is syncing the slots, lock is not held */
+    pthread_t           flushThread;
+    THREAD_STATE_E      flushThreadState;
+    pthread_cond_t      wake;
+    unsigned int        nUpdates;
+    unsigned int        nFlushes;
+    unsigned int        nUnchanged;
+    unsigned int        nMerged;        /* requests to GPS completed from the store */
+    unsigned int        nPushed;
+} ASSIST_STORE, *pASSIST_STORE;
+
+/*
+ * Ephemeris already given to GPS (cpdAidingCache.c).
+ * cpdd leaves out nav_model_elem of SVs GPS has with the same IODC and toe, GPS side puts them back from its
+ * mirror. Each process uses its half: cpdd the sent table, GPS the mirror.
+ */
+#define AIDING_MAX_SVS                  (64)            /* sat_id 1..64, one bit of nav_model_mirrored each */
+#define AIDING_RESEND_AGE               (30UL * 60 * 1000)  /* ms, unchanged ephemeris is sent again after */
+#define AIDING_MIRROR_AGE               (4UL * 3600 * 1000) /* ms, GPS side doesn't restore older ephemeris */
+
+typedef struct {
+    pthread_mutex_t     lock;
+    unsigned long long  sent;           /* bit (sat_id - 1): GPS has ephemeris of SV */
+    int                 sentIodc[AIDING_MAX_SVS];
+    int                 sentToe[AIDING_MAX_SVS];
+    unsigned int        sentAt[AIDING_MAX_SVS];     /* getMsecMonotonic() */
+    unsigned int        nSent;          /* nav_model_elem sent to GPS */
+    unsigned int        nLeftOut;
+    unsigned long long  bytesSaved;
+    unsigned long long  mirrored;       /* GPS side, bit (sat_id - 1): mirror holds ephemeris of SV */
+    NAV_MODEL_ELEM      mirror[AIDING_MAX_SVS];
+    unsigned int        mirrorAt[AIDING_MAX_SVS];
+    unsigned int        nApplied;       /* requests with nav_model_mirrored */
+    unsigned int        nRestored;
+    unsigned int        nMissing;       /* left out, but not in the mirror */
+    unsigned long long  applyUsTotal;
+    unsigned int        applyUsMax;
+} AIDING_CACHE, *pAIDING_CACHE;
+
+/*
+ * Shared memory transport between CPDD and GPS (cpdGpsRing.c).
+ * One memfd holds a single-producer single-consumer ring per direction, CPDD to GPS first. Each ring has an
+ * eventfd doorbell. CPDD passes memfd and doorbells over GPS socket, socket stays in use until GPS accepts them.
+ */
+#define GPS_RING_SIZE                   (64 * 1024)     /* data bytes of one direction, power of 2 */
+#define GPS_RING_MAGIC                  (0x474E5243)    /* "CRNG" */
+#define GPS_RING_VERSION                (1)
+#define GPS_RING_WRAP                   (0xFFFFFFFFU)   /* message length: rest of ring is not used */
+#define GPS_RING_N_FDS                  (3)             /* memfd, doorbell to GPS, doorbell to CPDD */
+
+typedef struct {
+    unsigned int        magic;
+    unsigned int        version;
+    unsigned int        size;
+    unsigned int        reserved[13];
+    unsigned int        head;           /* bytes written by producer, free running */
+    unsigned int        reservedHead[15];
+    unsigned int        tail;           /* bytes read by consumer, on its own cache line */
+    unsigned int        reservedTail[15];
+} GPS_RING_HEADER, *pGPS_RING_HEADER;
+
+typedef struct {
+    unsigned int        length;         /* of data which follows, GPS_RING_WRAP */
+    unsigned int        type;           /* CPD_MSG_TYPE_E */
+} GPS_RING_MSG, *pGPS_RING_MSG;
+
+typedef struct {
+    pthread_mutex_t     lock;           /* held from cpdGpsRingReserve() to cpdGpsRingCommit() */
+    pthread_mutex_t     dispatchLock;   /* messages from socket and ring are handled one at a time */
+    int                 state;          /* CPD_OK when messages are sent through ring */
+    int                 socketIndex;    /* of scGps client which passed the ring, ring is used while it's open */
+    int                 fds[GPS_RING_N_FDS];
+    char                *pMap;
+    pGPS_RING_HEADER    pTx;
+    pGPS_RING_HEADER    pRx;
+    int                 txBell;
+    int                 rxBell;
+    unsigned int        txHead;         /* where message being built starts */
+    pthread_t           rxThread;
+    THREAD_STATE_E      rxThreadState;
+    unsigned int        nTx;
+    unsigned int        nRx;
+    unsigned int        nFull;          /* sent through socket, ring was full */
+    unsigned int        nRejected;      /* framing and ring control messages, they are handled only from socket */
+    unsigned int        nAborted;       /* reserved, but data could not be put */
+} GPS_RING, *pGPS_RING;
+
+/*
+ * Compact encoding of REQUEST_PARAMS and RESPONSE_PARAMS sent between CPDD and GPS (cpdGpsWire.c).
+ * Only populated parts are sent, with the union arm selected by its type, arrays only up to their item count.
+ * Arrays the structures point to are sent inline, received ones are kept here until the next message.
+ */
+#define GPS_WIRE_MAGIC                  (0x45524957)    /* "WIRE", raw structures start with CPD_MSG_VERSION */
+#define GPS_WIRE_REQUEST                (0)
+#define GPS_WIRE_RESPONSE               (1)
+#define GPS_WIRE_MAX_POLYGON            (15)            /* 3GPP polygon points */
+#define GPS_WIRE_MAX_ALM_ELEM           (32)
+
+typedef struct {
+    unsigned int        nEncoded;
+    unsigned int        nDecoded;
+    unsigned long long  bytesRaw;       /* size of structures encoded */
+    unsigned long long  bytesWire;
+    unsigned long long  encodeNs;
+    unsigned long long  decodeNs;
+} GPS_WIRE_STATS, *pGPS_WIRE_STATS;
+
+typedef struct {
+    pthread_mutex_t     lock;           /* of stats */
+    GPS_WIRE_STATS      stats[2];       /* GPS_WIRE_REQUEST, GPS_WIRE_RESPONSE */
+    COORDINATE          requestPolygon[GPS_WIRE_MAX_POLYGON];
+    ALM_ELEM            requestAlmElem[GPS_WIRE_MAX_ALM_ELEM];
+    COORDINATE          responsePolygon[GPS_WIRE_MAX_POLYGON];
+} GPS_WIRE, *pGPS_WIRE;
+
+/*
+ * Deadlines of the positioning session (cpdSessionTimer.c).
+ * One thread waits on a timerfd armed for the earliest deadline.
+ */
+#define SESSION_TIMER_MAX               (4 * CPD_MAX_SESSIONS)
+#define SESSION_TIMEOUT_MARGIN          (1800UL)    /* total timeout, ms per second required by request (1.8 margin) */
+#define SESSION_TIMEOUT_NO_FIX          (120000UL)
+
+typedef enum {
+    SESSION_TIMER_NONE = 0,
+    SESSION_TIMER_RESPONSE_DUE,     /* request should be fulfilled by now */
+    SESSION_TIMER_REPORT,           /* periodic reporting interval */
+    SESSION_TIMER_TOTAL_TIMEOUT,    /* GPS is stopped */
+    SESSION_TIMER_NO_FIX,           /* GPS is stopped if nothing was sent */
+    SESSION_TIMER_COUNT
+} SESSION_TIMER_E;
+
+typedef struct {
+    SESSION_TIMER_E     type;
+    unsigned int        sessionId;      /* request.dbgStats.posRequestId */
+    unsigned long long  deadline;       /* CLOCK_MONOTONIC, us */
+    unsigned int        interval;       /* ms, 0 if timer is not periodic */
+} SESSION_TIMER, *pSESSION_TIMER;
+
+typedef struct {
+    pthread_t           timerThread;
+    THREAD_STATE_E      timerThreadState;
+    int                 fd;             /* timerfd */
+    pthread_mutex_t     lock;
+    int                 count;
+    SESSION_TIMER       timers[SESSION_TIMER_MAX];
+    unsigned long long  armedFor;       /* deadline timerfd is armed for, 0 if none */
+    unsigned int        nSessions;
+    unsigned int        nFired[SESSION_TIMER_COUNT];
+    unsigned int        nLate;          /* request not fulfilled in time */
+    unsigned int        nMissedReports;
+    unsigned long long  totalLateness;  /* us, timer fired after its deadline */
+    unsigned int        maxLateness;
+} SESSION_SCHEDULER, *pSESSION_SCHEDULER;
+
 typedef struct {
     int                     initialized;
     MODEM_INFO              modemInfo;
-    XML_BUFFER              xmlRxBuffer;
+    XML_RX_PARSER           xmlRxParser;
+    XML_ARENA               xmlArena;
+    XML_TX_TEMPLATE         xmlTxTemplate;
     XML_BUFFER              xmlTxBuffer;
 
     REQUEST_PARAMS          request;
@@ -979,7 +1472,14 @@ typedef struct {
 
 
     SYSTEM_MONITOR          systemMonitor;
-    SYSTEM_MONITOR          activeMonitor;
+    RESPONSE_SENDER         responseSender;
+    SESSION_SCHEDULER       sessionScheduler;
+    SESSION_TABLE           sessionTable;
+    LAST_FIX_CACHE          lastFix;
+    ASSIST_STORE            assistStore;
+    AIDING_CACHE            aidingCache;
+    GPS_RING                gpsRing;
+    GPS_WIRE                gpsWire;
 
 } CPD_CONTEXT, *pCPD_CONTEXT;
 
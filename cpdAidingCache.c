@@ -0,0 +1,242 @@
+/*
+ * hardware/Intel/cp_daemon/cpdAidingCache.c
+ *
+ * Ephemeris passed to GPS only when it changes.
+ * CPDD remembers IODC and toe of every SV it sent to GPS and leaves out nav_model_elem which GPS already has,
+ * marking it in nav_model_mirrored. GPS side keeps a mirror of received ephemeris and puts the left out
+ * elements back before request is handled, so GPS library always gets the complete navigation model.
+ * Left out elements are used only when GPS side agreed on CPD_MSG_PAYLOAD_MIRROR.
+ * Ephemeris is marked sent only once the request was written to GPS. GPS side which misses a left out element
+ * passes the request on without navigation model and asks CPDD to send all ephemeris again (AIDING_RESEND).
+ * Both sides are reset when socket to GPS is (re)opened.
+ *
+ * Martin Junkar 09/18/2011
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#define LOG_TAG "CPDD_AC"
+
+#include "cpd.h"
+#include "cpdUtil.h"
+#include "cpdAidingCache.h"
+#include "cpdDebug.h"
+
+
+/*
+ * nav_model_elem which carries ephemeris of a valid SV, returns index of SV or CPD_ERROR.
+ */
+static int cpdAidingSvIndex(pNAV_MODEL_ELEM pElem)
+{
+    int k = pElem->sat_id - 1;
+
+    /* existing satellite with the same navigation model carries no ephemeris */
+    if ((k < 0) || (k >= AIDING_MAX_SVS) ||
+        (pElem->sat_status == NAV_ELEM_SAT_STATUS_ES_SN) || (pElem->sat_status == NAV_ELEM_SAT_STATUS_REVD)) {
+        return CPD_ERROR;
+    }
+    return k;
+}
+
+/*
+ * Socket to GPS was (re)opened, GPS has no ephemeris from this connection.
+ */
+void cpdAidingReset(pCPD_CONTEXT pCpd)
+{
+    pAIDING_CACHE pAc = &(pCpd->aidingCache);
+
+    pthread_mutex_lock(&(pAc->lock));
+    pAc->sent = 0;
+    pthread_mutex_unlock(&(pAc->lock));
+}
+
+/*
+ * GPS side, CPDD (re)connected and negotiates again, ephemeris mirrored from previous connection is not used.
+ */
+void cpdAidingMirrorReset(pCPD_CONTEXT pCpd)
+{
+    pAIDING_CACHE pAc = &(pCpd->aidingCache);
+
+    pthread_mutex_lock(&(pAc->lock));
+    pAc->mirrored = 0;
+    pthread_mutex_unlock(&(pAc->lock));
+}
+
+/*
+ * Leave out nav_model_elem of SVs already sent to GPS with the same IODC and toe, less than AIDING_RESEND_AGE ago.
+ * <pAssistData> is the copy written to GPS socket, it's compacted in place. Bits of SVs whose ephemeris stays in
+ * the copy are put to <pSending>, for cpdAidingSent(). Returns number of elements left out.
+ */
+int cpdAidingStrip(pCPD_CONTEXT pCpd, pASSIST_DATA pAssistData, unsigned long long *pSending)
+{
+    pAIDING_CACHE pAc = &(pCpd->aidingCache);
+    pGPS_ASSIST pGa = &(pAssistData->GPS_assist);
+    pNAV_MODEL_ELEM pElem;
+    unsigned long long bit;
+    unsigned int now = getMsecMonotonic();
+    int i, k;
+    int n = 0;
+    int items = 0;
+
+    *pSending = 0;
+    pAssistData->nav_model_mirrored = 0;
+    if (pGa->nav_model_elem_arr_items > GPS_MAX_N_SVS) {
+        pGa->nav_model_elem_arr_items = GPS_MAX_N_SVS;
+    }
+    pthread_mutex_lock(&(pAc->lock));
+    for (i = 0; i < pGa->nav_model_elem_arr_items; i++) {
+        pElem = &(pGa->nav_model_elem_arr[i]);
+        k = cpdAidingSvIndex(pElem);
+        if (k != CPD_ERROR) {
+            bit = 1ULL << k;
+            if (((pAc->sent & bit) != 0) && ((now - pAc->sentAt[k]) < AIDING_RESEND_AGE) &&
+                (pAc->sentIodc[k] == pElem->ephem_and_clock.iodc) &&
+                (pAc->sentToe[k] == pElem->ephem_and_clock.toe)) {
+                pAssistData->nav_model_mirrored |= bit;
+                n++;
+                continue;
+            }
+            *pSending |= bit;
+        }
+        if (items != i) {
+            memcpy(&(pGa->nav_model_elem_arr[items]), pElem, sizeof(NAV_MODEL_ELEM));
+        }
+        items++;
+    }
+    if (n > 0) {
+        memset(&(pGa->nav_model_elem_arr[items]), 0, (pGa->nav_model_elem_arr_items - items) * sizeof(NAV_MODEL_ELEM));
+        pGa->nav_model_elem_arr_items = items;
+        pAc->nLeftOut += n;
+        pAc->bytesSaved += (unsigned long long) n * sizeof(NAV_MODEL_ELEM);
+    }
+    pthread_mutex_unlock(&(pAc->lock));
+    if (n > 0) {
+        CPD_LOG(CPD_LOG_ID_TXT, "\n%u: %s(), %d sent, %d left out", getMsecTime(), __FUNCTION__, items, n);
+    }
+    return n;
+}
+
+/*
+ * Request with <pAssistData>, as it was before cpdAidingStrip(), was written to GPS:
+ * ephemeris of SVs in <sending> is marked sent.
+ */
+void cpdAidingSent(pCPD_CONTEXT pCpd, pASSIST_DATA pAssistData, unsigned long long sending)
+{
+    pAIDING_CACHE pAc = &(pCpd->aidingCache);
+    pGPS_ASSIST pGa = &(pAssistData->GPS_assist);
+    pNAV_MODEL_ELEM pElem;
+    unsigned long long bit;
+    unsigned int now = getMsecMonotonic();
+    int i, k;
+
+    if (sending == 0) {
+        return;
+    }
+    pthread_mutex_lock(&(pAc->lock));
+    for (i = 0; (i < pGa->nav_model_elem_arr_items) && (i < GPS_MAX_N_SVS); i++) {
+        pElem = &(pGa->nav_model_elem_arr[i]);
+        k = cpdAidingSvIndex(pElem);
+        if (k == CPD_ERROR) {
+            continue;
+        }
+        bit = 1ULL << k;
+        if ((sending & bit) != 0) {
+            pAc->sent |= bit;
+            pAc->sentIodc[k] = pElem->ephem_and_clock.iodc;
+            pAc->sentToe[k] = pElem->ephem_and_clock.toe;
+            pAc->sentAt[k] = now;
+            pAc->nSent++;
+        }
+    }
+    pthread_mutex_unlock(&(pAc->lock));
+}
+
+/*
+ * GPS side: keep received ephemeris and restore elements CPDD left out.
+ * Returns number of left out elements which are not in the mirror, the request is then left without
+ * navigation model: GPS library never gets a partial one.
+ */
+int cpdAidingApply(pCPD_CONTEXT pCpd, pASSIST_DATA pAssistData)
+{
+    pAIDING_CACHE pAc = &(pCpd->aidingCache);
+    pGPS_ASSIST pGa = &(pAssistData->GPS_assist);
+    pNAV_MODEL_ELEM pElem;
+    unsigned long long bit;
+    unsigned int now = getMsecMonotonic();
+    unsigned int us;
+    struct timespec t0, t1;
+    int i, k;
+    int n = 0;
+    int missing = 0;
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    if ((pGa->nav_model_elem_arr_items < 0) || (pGa->nav_model_elem_arr_items > GPS_MAX_N_SVS)) {
+        pGa->nav_model_elem_arr_items = 0;
+    }
+    pthread_mutex_lock(&(pAc->lock));
+    for (i = 0; i < pGa->nav_model_elem_arr_items; i++) {
+        pElem = &(pGa->nav_model_elem_arr[i]);
+        k = cpdAidingSvIndex(pElem);
+        if (k != CPD_ERROR) {
+            memcpy(&(pAc->mirror[k]), pElem, sizeof(NAV_MODEL_ELEM));
+            pAc->mirrorAt[k] = now;
+            pAc->mirrored |= 1ULL << k;
+        }
+    }
+    if (pAssistData->nav_model_mirrored == 0) {
+        pthread_mutex_unlock(&(pAc->lock));
+        return 0;
+    }
+    for (k = 0; k < AIDING_MAX_SVS; k++) {
+        bit = 1ULL << k;
+        if ((pAssistData->nav_model_mirrored & bit) == 0) {
+            continue;
+        }
+        if (((pAc->mirrored & bit) == 0) || ((now - pAc->mirrorAt[k]) >= AIDING_MIRROR_AGE) ||
+            (pGa->nav_model_elem_arr_items >= GPS_MAX_N_SVS)) {
+            missing++;
+            continue;
+        }
+        memcpy(&(pGa->nav_model_elem_arr[pGa->nav_model_elem_arr_items]), &(pAc->mirror[k]), sizeof(NAV_MODEL_ELEM));
+        pGa->nav_model_elem_arr_items++;
+        n++;
+    }
+    pAssistData->nav_model_mirrored = 0;
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    us = (unsigned int) (((t1.tv_sec - t0.tv_sec) * 1000000L) + ((t1.tv_nsec - t0.tv_nsec) / 1000));
+    pAc->nApplied++;
+    pAc->nRestored += n;
+    pAc->nMissing += missing;
+    pAc->applyUsTotal += us;
+    if (us > pAc->applyUsMax) {
+        pAc->applyUsMax = us;
+    }
+    pthread_mutex_unlock(&(pAc->lock));
+    if (missing > 0) {
+        memset(pGa->nav_model_elem_arr, 0, sizeof(pGa->nav_model_elem_arr));
+        pGa->nav_model_elem_arr_items = 0;
+        LOGE("%u: %s(), %d restored, %d not in mirror, navigation model dropped", getMsecTime(), __FUNCTION__, n, missing);
+    }
+    CPD_LOG(CPD_LOG_ID_TXT, "\n%u: %s(), %d restored, %d missing, %u us", getMsecTime(), __FUNCTION__, n, missing, us);
+    return missing;
+}
+
+void cpdAidingStats(pCPD_CONTEXT pCpd)
+{
+    pAIDING_CACHE pAc = &(pCpd->aidingCache);
+
+    pthread_mutex_lock(&(pAc->lock));
+    CPD_LOG(CPD_LOG_ID_TXT, "\n%u: %s(), %u ephemeris sent, %u left out, %llu bytes saved", getMsecTime(), __FUNCTION__,
+            pAc->nSent, pAc->nLeftOut, pAc->bytesSaved);
+    LOGD("%u: %s(), %u sent, %u left out, %llu bytes saved", getMsecTime(), __FUNCTION__,
+            pAc->nSent, pAc->nLeftOut, pAc->bytesSaved);
+    if (pAc->nApplied > 0) {
+        CPD_LOG(CPD_LOG_ID_TXT, "\n%u: %s(), GPS: %u applied, %u restored, %u missing, %llu us avg, %u us max",
+                getMsecTime(), __FUNCTION__, pAc->nApplied, pAc->nRestored, pAc->nMissing,
+                pAc->applyUsTotal / pAc->nApplied, pAc->applyUsMax);
+    }
+    pthread_mutex_unlock(&(pAc->lock));
+}
@@ -0,0 +1,20 @@
+/*
+ * hardware/Intel/cp_daemon/cpdAidingCache.h
+ *
+ * Header file for cpdAidingCache.c.
+ *
+ * Martin Junkar 09/18/2011
+ *
+ */
+
+#ifndef _CPDAIDINGCACHE_H_
+#define _CPDAIDINGCACHE_H_
+#include "cpd.h"
+
+void cpdAidingReset(pCPD_CONTEXT pCpd);
+void cpdAidingMirrorReset(pCPD_CONTEXT pCpd);
+int cpdAidingStrip(pCPD_CONTEXT pCpd, pASSIST_DATA pAssistData, unsigned long long *pSending);
+void cpdAidingSent(pCPD_CONTEXT pCpd, pASSIST_DATA pAssistData, unsigned long long sending);
+int cpdAidingApply(pCPD_CONTEXT pCpd, pASSIST_DATA pAssistData);
+void cpdAidingStats(pCPD_CONTEXT pCpd);
+#endif
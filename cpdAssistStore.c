@@ -0,0 +1,396 @@
+/*
+ * hardware/Intel/cp_daemon/cpdAssistStore.c
+ *
+ * Assistance data kept across restarts of the daemon and resets of the modem.
+ * Ephemeris per SV, reference location and reference time received from network are written to a file on /data,
+ * which is mapped to memory. Ephemeris is replaced when its IODE or toe changes. Stored data is pushed to GPS
+ * when socket to GPS is opened and completes every request passed to GPS, so GPS can hot start without
+ * waiting for network to send assistance again.
+ * Updates come from the modem read thread and only write the mapped memory, a flush thread syncs it to disk.
+ * The other slot is overwritten only once the current one is on disk, until then the current one is
+ * rewritten: a crash leaves at most one damaged slot, which fails its CRC.
+ *
+ * Martin Junkar 09/18/2011
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#define LOG_TAG "CPDD_AS"
+
+#include "cpd.h"
+#include "cpdUtil.h"
+#include "cpdGpsComm.h"
+#include "cpdAssistStore.h"
+#include "cpdDebug.h"
+
+#define ASSIST_STORE_WEEK_MSEC          (604800000L)
+
+
+/*
+ * Milliseconds of CLOCK_REALTIME, stored data has to be aged across reboots.
+ */
+static unsigned long long cpdAssistStoreNow(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return ((unsigned long long) ts.tv_sec * 1000ULL) + (ts.tv_nsec / 1000000);
+}
+
+/*
+ * Data stored at <at> is younger than <maxAge> ms. Data from the future is not trusted, clock was set back.
+ */
+static int cpdAssistStoreIsFresh(unsigned long long at, unsigned long long now, unsigned long long maxAge)
+{
+    return ((at != 0) && (at <= now) && ((now - at) < maxAge)) ? CPD_OK : CPD_NOK;
+}
+
+static int cpdAssistStoreSlotValid(pASSIST_STORE_SLOT pSlot)
+{
+    return ((pSlot->magic == ASSIST_STORE_MAGIC) && (pSlot->version == ASSIST_STORE_VERSION) &&
+            (pSlot->size == sizeof(ASSIST_STORE_SLOT)) &&
+            (pSlot->crc == cpdCrc32c(0, &(pSlot->data), sizeof(ASSIST_STORE_DATA)))) ? CPD_OK : CPD_NOK;
+}
+
+/*
+ * Sync slots to disk whenever an update made them dirty, without holding the lock.
+ */
+static void *cpdAssistStoreFlushThread(void *pArg)
+{
+    pASSIST_STORE pAs = (pASSIST_STORE) pArg;
+
+    LOGV("%u: %s()", getMsecTime(), __FUNCTION__);
+    pthread_mutex_lock(&(pAs->lock));
+    if (pAs->flushThreadState == THREAD_STATE_STARTING) {
+        pAs->flushThreadState = THREAD_STATE_RUNNING;
+    }
+    while (pAs->flushThreadState == THREAD_STATE_RUNNING) {
+        if (pAs->dirty != CPD_OK) {
+            pthread_cond_wait(&(pAs->wake), &(pAs->lock));
+            continue;
+        }
+        pAs->dirty = CPD_NOK;
+        pAs->flushing = CPD_OK;
+        pthread_mutex_unlock(&(pAs->lock));
+        msync(pAs->pSlots, 2 * sizeof(ASSIST_STORE_SLOT), MS_SYNC);
+        pthread_mutex_lock(&(pAs->lock));
+        pAs->flushing = CPD_NOK;
+        pAs->nFlushes++;
+    }
+    pAs->flushThreadState = THREAD_STATE_TERMINATED;
+    pthread_mutex_unlock(&(pAs->lock));
+    LOGV("%u: EXIT %s()", getMsecTime(), __FUNCTION__);
+    return NULL;
+}
+
+/*
+ * Map the store file, the newest valid slot is current. Missing or damaged file gives an empty store.
+ */
+int cpdAssistStoreOpen(pCPD_CONTEXT pCpd)
+{
+    pASSIST_STORE pAs = &(pCpd->assistStore);
+    size_t size = 2 * sizeof(ASSIST_STORE_SLOT);
+    struct stat st;
+    void *p;
+    int i;
+
+    pthread_mutex_lock(&(pAs->lock));
+    if (pAs->pSlots != NULL) {
+        pthread_mutex_unlock(&(pAs->lock));
+        return CPD_OK;
+    }
+    pAs->fd = open(pAs->pFileName, O_RDWR | O_CREAT, 0600);
+    if (pAs->fd < 0) {
+        LOGE("%u: %s(), can't open %s", getMsecTime(), __FUNCTION__, pAs->pFileName);
+        pAs->fd = CPD_ERROR;
+        pthread_mutex_unlock(&(pAs->lock));
+        return CPD_NOK;
+    }
+    if (((fstat(pAs->fd, &st) != 0) || (st.st_size != (off_t) size)) && (ftruncate(pAs->fd, size) != 0)) {
+        p = MAP_FAILED;
+    }
+    else {
+        p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, pAs->fd, 0);
+    }
+    if (p == MAP_FAILED) {
+        LOGE("%u: %s(), can't map %s", getMsecTime(), __FUNCTION__, pAs->pFileName);
+        close(pAs->fd);
+        pAs->fd = CPD_ERROR;
+        pthread_mutex_unlock(&(pAs->lock));
+        return CPD_NOK;
+    }
+    pAs->pSlots = (pASSIST_STORE_SLOT) p;
+    pAs->current = CPD_ERROR;
+    pAs->dirty = CPD_NOK;
+    pAs->flushing = CPD_NOK;
+    for (i = 0; i < 2; i++) {
+        if ((cpdAssistStoreSlotValid(&(pAs->pSlots[i])) == CPD_OK) &&
+            ((pAs->current == CPD_ERROR) ||
+             ((int) (pAs->pSlots[i].generation - pAs->pSlots[pAs->current].generation) > 0))) {
+            pAs->current = i;
+        }
+    }
+    pAs->flushThreadState = THREAD_STATE_STARTING;
+    if (pthread_create(&(pAs->flushThread), NULL, cpdAssistStoreFlushThread, (void *) pAs) != 0) {
+        /* slots are synced when store is closed */
+        LOGE("%u: %s(), no flush thread", getMsecTime(), __FUNCTION__);
+        pAs->flushThreadState = THREAD_STATE_OFF;
+    }
+    CPD_LOG(CPD_LOG_ID_TXT, "\n%u: %s(%s), slot %d, generation %u", getMsecTime(), __FUNCTION__, pAs->pFileName,
+            pAs->current, (pAs->current != CPD_ERROR) ? pAs->pSlots[pAs->current].generation : 0);
+    LOGD("%u: %s(%s), slot %d", getMsecTime(), __FUNCTION__, pAs->pFileName, pAs->current);
+    pthread_mutex_unlock(&(pAs->lock));
+    return CPD_OK;
+}
+
+void cpdAssistStoreClose(pCPD_CONTEXT pCpd)
+{
+    pASSIST_STORE pAs = &(pCpd->assistStore);
+
+    pthread_mutex_lock(&(pAs->lock));
+    if ((pAs->flushThreadState == THREAD_STATE_STARTING) || (pAs->flushThreadState == THREAD_STATE_RUNNING)) {
+        pAs->flushThreadState = THREAD_STATE_TERMINATE;
+        pthread_cond_signal(&(pAs->wake));
+        pthread_mutex_unlock(&(pAs->lock));
+        pthread_join(pAs->flushThread, NULL);
+        pthread_mutex_lock(&(pAs->lock));
+    }
+    if (pAs->pSlots != NULL) {
+        msync(pAs->pSlots, 2 * sizeof(ASSIST_STORE_SLOT), MS_SYNC);
+        munmap(pAs->pSlots, 2 * sizeof(ASSIST_STORE_SLOT));
+        close(pAs->fd);
+        pAs->pSlots = NULL;
+        pAs->fd = CPD_ERROR;
+        pAs->current = CPD_ERROR;
+        CPD_LOG(CPD_LOG_ID_TXT, "\n%u: %s(), %u updates, %u flushes, %u unchanged, %u requests completed, %u pushed",
+                getMsecTime(), __FUNCTION__, pAs->nUpdates, pAs->nFlushes, pAs->nUnchanged, pAs->nMerged, pAs->nPushed);
+    }
+    pthread_mutex_unlock(&(pAs->lock));
+}
+
+/*
+ * Number of items of <pAssistData> which differ from <pOld>, or replace stored items which expired.
+ * Reference time is rewritten only when the stored one is older than ASSIST_STORE_TIME_REFRESH, it's propagated
+ * from the time it was stored. Items are written to <pDst> if it's not NULL.
+ */
+static int cpdAssistStoreApply(pASSIST_STORE_DATA pDst, pASSIST_STORE_DATA pOld, pASSIST_DATA pAssistData,
+                               unsigned long long now)
+{
+    pGPS_ASSIST pGa = &(pAssistData->GPS_assist);
+    pLOCATION_PARAMETERS pLoc = &(pGa->location_parameters);
+    pNAV_MODEL_ELEM pElem;
+    int i, k;
+    int n = 0;
+
+    if ((pGa->ref_time.isSet == CPD_OK) &&
+        ((pOld == NULL) || (cpdAssistStoreIsFresh(pOld->refTimeAt, now, ASSIST_STORE_TIME_REFRESH) != CPD_OK))) {
+        n++;
+        if (pDst != NULL) {
+            memcpy(&(pDst->refTime), &(pGa->ref_time.GPS_time), sizeof(GPS_TIME));
+            pDst->refTimeAt = now - getMsecDt(pGa->ref_time.GPS_time.gpsTimeReceivedAt);
+        }
+    }
+    if ((pLoc->shape_type != SHAPE_TYPE_NONE) && (pLoc->shape_type != SHAPE_TYPE_POLYGON) &&
+        ((pOld == NULL) || (cpdAssistStoreIsFresh(pOld->refLocationAt, now, ASSIST_STORE_LOCATION_AGE) != CPD_OK) ||
+         (memcmp(&(pOld->refLocation), pLoc, sizeof(LOCATION_PARAMETERS)) != 0))) {
+        n++;
+        if (pDst != NULL) {
+            memcpy(&(pDst->refLocation), pLoc, sizeof(LOCATION_PARAMETERS));
+            pDst->refLocationAt = now;
+        }
+    }
+    for (i = 0; (i < pGa->nav_model_elem_arr_items) && (i < GPS_MAX_N_SVS); i++) {
+        pElem = &(pGa->nav_model_elem_arr[i]);
+        k = pElem->sat_id - 1;
+        /* existing satellite with the same navigation model carries no ephemeris */
+        if ((k < 0) || (k >= ASSIST_STORE_MAX_SVS) ||
+            (pElem->sat_status == NAV_ELEM_SAT_STATUS_ES_SN) || (pElem->sat_status == NAV_ELEM_SAT_STATUS_REVD)) {
+            continue;
+        }
+        if ((pOld != NULL) && (cpdAssistStoreIsFresh(pOld->ephemerisAt[k], now, ASSIST_STORE_EPHEMERIS_AGE) == CPD_OK) &&
+            ((pOld->ephemeris[k].ephem_and_clock.iodc & 0xFF) == (pElem->ephem_and_clock.iodc & 0xFF)) &&
+            (pOld->ephemeris[k].ephem_and_clock.toe == pElem->ephem_and_clock.toe)) {
+            continue;
+        }
+        n++;
+        if (pDst != NULL) {
+            memcpy(&(pDst->ephemeris[k]), pElem, sizeof(NAV_MODEL_ELEM));
+            pDst->ephemerisAt[k] = now;
+        }
+    }
+    return n;
+}
+
+/*
+ * Assistance data received from network is written to the older slot, which becomes current, or to the current
+ * one when it isn't on disk yet. Disk is not waited for. Returns CPD_OK if store was updated, CPD_NOK if nothing
+ * changed or store is not open.
+ */
+int cpdAssistStoreUpdate(pCPD_CONTEXT pCpd, pASSIST_DATA pAssistData)
+{
+    pASSIST_STORE pAs = &(pCpd->assistStore);
+    pASSIST_STORE_SLOT pSlot;
+    pASSIST_STORE_DATA pOld = NULL;
+    unsigned int generation = 1;
+    unsigned long long now = cpdAssistStoreNow();
+    int n;
+
+    pthread_mutex_lock(&(pAs->lock));
+    if (pAs->pSlots == NULL) {
+        pthread_mutex_unlock(&(pAs->lock));
+        return CPD_NOK;
+    }
+    if (pAs->current != CPD_ERROR) {
+        pOld = &(pAs->pSlots[pAs->current].data);
+        generation = pAs->pSlots[pAs->current].generation + 1;
+    }
+    n = cpdAssistStoreApply(NULL, pOld, pAssistData, now);
+    if (n == 0) {
+        pAs->nUnchanged++;
+        pthread_mutex_unlock(&(pAs->lock));
+        return CPD_NOK;
+    }
+    if ((pOld != NULL) && ((pAs->dirty == CPD_OK) || (pAs->flushing == CPD_OK))) {
+        /* the other slot is the only one on disk */
+        pSlot = &(pAs->pSlots[pAs->current]);
+        generation--;
+    }
+    else {
+        pSlot = &(pAs->pSlots[(pAs->current == 0) ? 1 : 0]);
+    }
+    pSlot->magic = 0;
+    if (pOld == NULL) {
+        memset(&(pSlot->data), 0, sizeof(ASSIST_STORE_DATA));
+    }
+    else if (pOld != &(pSlot->data)) {
+        memcpy(&(pSlot->data), pOld, sizeof(ASSIST_STORE_DATA));
+    }
+    cpdAssistStoreApply(&(pSlot->data), pOld, pAssistData, now);
+    pSlot->version = ASSIST_STORE_VERSION;
+    pSlot->size = sizeof(ASSIST_STORE_SLOT);
+    pSlot->generation = generation;
+    pSlot->crc = cpdCrc32c(0, &(pSlot->data), sizeof(ASSIST_STORE_DATA));
+    pSlot->magic = ASSIST_STORE_MAGIC;
+    pAs->current = (int) (pSlot - pAs->pSlots);
+    pAs->dirty = CPD_OK;
+    pAs->nUpdates++;
+    pthread_cond_signal(&(pAs->wake));
+    pthread_mutex_unlock(&(pAs->lock));
+
+    CPD_LOG(CPD_LOG_ID_TXT, "\n%u: %s(), %d items, generation %u", getMsecTime(), __FUNCTION__, n, generation);
+    LOGD("%u: %s(), %d items, generation %u", getMsecTime(), __FUNCTION__, n, generation);
+    return CPD_OK;
+}
+
+/*
+ * Add stored items which are still valid and missing from <pAssistData>: reference time propagated to now,
+ * reference location and ephemeris of SVs not in the array. Returns number of added items.
+ */
+static int cpdAssistStoreFill(pASSIST_STORE pAs, pASSIST_DATA pAssistData)
+{
+    pGPS_ASSIST pGa = &(pAssistData->GPS_assist);
+    pASSIST_STORE_DATA pD;
+    unsigned long long now = cpdAssistStoreNow();
+    long tow;
+    int i, k;
+    int n = 0;
+
+    if ((pAs->pSlots == NULL) || (pAs->current == CPD_ERROR)) {
+        return 0;
+    }
+    pD = &(pAs->pSlots[pAs->current].data);
+    if ((pGa->ref_time.isSet != CPD_OK) && (cpdAssistStoreIsFresh(pD->refTimeAt, now, ASSIST_STORE_TIME_AGE) == CPD_OK)) {
+        memset(&(pGa->ref_time), 0, sizeof(REF_TIME));
+        tow = pD->refTime.GPS_TOW_msec + (long) (now - pD->refTimeAt);
+        pGa->ref_time.GPS_time.GPS_week = pD->refTime.GPS_week + (int) (tow / ASSIST_STORE_WEEK_MSEC);
+        pGa->ref_time.GPS_time.GPS_TOW_msec = tow % ASSIST_STORE_WEEK_MSEC;
+        pGa->ref_time.GPS_time.gpsTimeReceivedAt = getMsecTime();
+        pGa->ref_time.isSet = CPD_OK;
+        n++;
+    }
+    if ((pGa->location_parameters.shape_type == SHAPE_TYPE_NONE) &&
+        (cpdAssistStoreIsFresh(pD->refLocationAt, now, ASSIST_STORE_LOCATION_AGE) == CPD_OK)) {
+        memcpy(&(pGa->location_parameters), &(pD->refLocation), sizeof(LOCATION_PARAMETERS));
+        n++;
+    }
+    for (k = 0; (k < ASSIST_STORE_MAX_SVS) && (pGa->nav_model_elem_arr_items < GPS_MAX_N_SVS); k++) {
+        if (cpdAssistStoreIsFresh(pD->ephemerisAt[k], now, ASSIST_STORE_EPHEMERIS_AGE) != CPD_OK) {
+            continue;
+        }
+        for (i = 0; i < pGa->nav_model_elem_arr_items; i++) {
+            if (pGa->nav_model_elem_arr[i].sat_id == k + 1) {
+                break;
+            }
+        }
+        if (i == pGa->nav_model_elem_arr_items) {
+            memcpy(&(pGa->nav_model_elem_arr[i]), &(pD->ephemeris[k]), sizeof(NAV_MODEL_ELEM));
+            pGa->nav_model_elem_arr_items++;
+            n++;
+        }
+    }
+    pAssistData->flag += n;
+    return n;
+}
+
+/*
+ * Complete request passed to GPS with stored assistance data, returns number of added items.
+ */
+int cpdAssistStoreMerge(pCPD_CONTEXT pCpd, pASSIST_DATA pAssistData)
+{
+    pASSIST_STORE pAs = &(pCpd->assistStore);
+    int n;
+
+    pthread_mutex_lock(&(pAs->lock));
+    n = cpdAssistStoreFill(pAs, pAssistData);
+    if (n > 0) {
+        pAs->nMerged++;
+    }
+    pthread_mutex_unlock(&(pAs->lock));
+    if (n > 0) {
+        CPD_LOG(CPD_LOG_ID_TXT, "\n%u: %s(), %d items added", getMsecTime(), __FUNCTION__, n);
+        LOGD("%u: %s(), %d items added", getMsecTime(), __FUNCTION__, n);
+    }
+    return n;
+}
+
+/*
+ * Socket to GPS was opened, send stored assistance data without a positioning request.
+ */
+int cpdAssistStorePush(pCPD_CONTEXT pCpd)
+{
+    pASSIST_STORE pAs = &(pCpd->assistStore);
+    pREQUEST_PARAMS pRequest;
+    int n;
+    int result = CPD_NOK;
+
+    pRequest = malloc(sizeof(REQUEST_PARAMS));
+    if (pRequest == NULL) {
+        return CPD_NOK;
+    }
+    memset(pRequest, 0, sizeof(REQUEST_PARAMS));
+    pthread_mutex_lock(&(pAs->lock));
+    n = cpdAssistStoreFill(pAs, &(pRequest->assist_data));
+    pthread_mutex_unlock(&(pAs->lock));
+    if (n > 0) {
+        pRequest->flag = REQUEST_FLAG_ASSIST_DATA;
+        result = cpdFormatAndSendRequestToGps(pCpd, pRequest);
+        result = (result > CPD_NOK) ? CPD_OK : CPD_NOK;
+        if (result == CPD_OK) {
+            pthread_mutex_lock(&(pAs->lock));
+            pAs->nPushed++;
+            pthread_mutex_unlock(&(pAs->lock));
+        }
+    }
+    free(pRequest);
+    CPD_LOG(CPD_LOG_ID_TXT, "\n%u: %s(), %d items, result %d", getMsecTime(), __FUNCTION__, n, result);
+    LOGD("%u: %s(), %d items, result %d", getMsecTime(), __FUNCTION__, n, result);
+    return result;
+}
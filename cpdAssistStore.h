@@ -0,0 +1,19 @@
+/*
+ * hardware/Intel/cp_daemon/cpdAssistStore.h
+ *
+ * Header file for cpdAssistStore.c.
+ *
+ * Martin Junkar 09/18/2011
+ *
+ */
+
+#ifndef _CPDASSISTSTORE_H_
+#define _CPDASSISTSTORE_H_
+#include "cpd.h"
+
+int cpdAssistStoreOpen(pCPD_CONTEXT pCpd);
+void cpdAssistStoreClose(pCPD_CONTEXT pCpd);
+int cpdAssistStoreUpdate(pCPD_CONTEXT pCpd, pASSIST_DATA pAssistData);
+int cpdAssistStoreMerge(pCPD_CONTEXT pCpd, pASSIST_DATA pAssistData);
+int cpdAssistStorePush(pCPD_CONTEXT pCpd);
+#endif
@@ -0,0 +1,206 @@
+/*
+ *  hardware/Intel/cp_daemon/cpdAtTokenizer.c
+ *
+ * Incremental tokenizer for data received from modem.
+ * Each byte in modem Rx buffer is scanned only once, tokenizer remembers its position between reads.
+ * Tokens (OK, ERROR, Ctrl-Z, ESC, RING, +CPOSR URC start/end) are returned one at the time,
+ * caller processes the token and releases consumed data from Rx buffer, tokenizer is then
+ * re-aligned with the buffer by cpdAtTokenizerRebase().
+ *
+ * Martin Junkar 09/18/2011
+ *
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#define LOG_TAG "CPDD_AT"
+
+#include "cpd.h"
+#include "cpdAtTokenizer.h"
+#include "cpdScan.h"
+
+#define AT_TOKEN_URC_PREFIX         (AT_CMD_CPOSR ":")
+#define AT_TOKEN_URC_PREFIX_LEN     ((int) sizeof(AT_TOKEN_URC_PREFIX) - 1)
+
+#define AT_TOKEN_LINE_IS(pB, start, end, str) \
+    ((((end) - (start)) == (int) sizeof(str) - 1) && (memcmp(&((pB)[(start)]), (str), sizeof(str) - 1) == 0))
+
+/* bytes that can start or end a token; once URC is known to carry XML, '<' is not interesting any more */
+static const SCAN_SET atScanSet = { 5, { AT_CMD_LF_CHR, AT_CMD_CTRL_Z_CHR, AT_CMD_ESC_CHR, AT_CMD_COL_CHR, XML_START_CHAR } };
+static const SCAN_SET atScanSetXml = { 4, { AT_CMD_LF_CHR, AT_CMD_CTRL_Z_CHR, AT_CMD_ESC_CHR, AT_CMD_COL_CHR } };
+
+
+void cpdAtTokenizerReset(pAT_TOKENIZER pTok)
+{
+    pTok->scanIndex = 0;
+    pTok->lineStart = 0;
+    pTok->urcStart = CPD_ERROR;
+    pTok->urcEnd = CPD_ERROR;
+    pTok->urcHasXml = 0;
+}
+
+/*
+ * Classify complete line [start, end), line terminator is not included.
+ */
+static AT_TOKEN_TYPE_E cpdAtTokenizerClassifyLine(const char *pB, int start, int end)
+{
+    if (AT_TOKEN_LINE_IS(pB, start, end, AT_CMD_OK)) {
+        return AT_TOKEN_OK;
+    }
+    if (AT_TOKEN_LINE_IS(pB, start, end, AT_CMD_ERROR)) {
+        return AT_TOKEN_ERROR;
+    }
+    if (AT_TOKEN_LINE_IS(pB, start, end, AT_CMD_RING)) {
+        return AT_TOKEN_RING;
+    }
+    return AT_TOKEN_NONE;
+}
+
+static int cpdAtTokenizerSetToken(pAT_TOKEN pToken, AT_TOKEN_TYPE_E type, int start, int len)
+{
+    pToken->type = type;
+    pToken->start = start;
+    pToken->len = len;
+    pToken->urcStart = CPD_ERROR;
+    pToken->urcHasXml = 0;
+    return CPD_OK;
+}
+
+/*
+ * Close URC being received.
+ * URC payload is [urcStart, end), bytes [end, consumeTo) are URC terminator.
+ */
+static int cpdAtTokenizerCloseUrc(pAT_TOKENIZER pTok, pAT_TOKEN pToken, int end, int consumeTo)
+{
+    cpdAtTokenizerSetToken(pToken, AT_TOKEN_URC_END, end, consumeTo - end);
+    pToken->urcStart = pTok->urcStart;
+    pToken->urcHasXml = pTok->urcHasXml;
+    pTok->urcStart = CPD_ERROR;
+    pTok->urcEnd = CPD_ERROR;
+    pTok->urcHasXml = 0;
+    return CPD_OK;
+}
+
+/*
+ * Scan Rx buffer from the last position and return next token.
+ * returns: CPD_OK if token was found, scanning stops right after the token.
+ *          CPD_NOK if all data in buffer was scanned and there are no more tokens.
+ */
+int cpdAtTokenizerNext(pAT_TOKENIZER pTok, const char *pB, int len, pAT_TOKEN pToken)
+{
+    int i;
+    int j;
+    int start;
+    int end;
+    char c;
+    AT_TOKEN_TYPE_E type;
+
+    pToken->type = AT_TOKEN_NONE;
+    if ((pB == NULL) || (len <= 0)) {
+        return CPD_NOK;
+    }
+    if (pTok->scanIndex > len) {
+        /* Rx buffer was cleared, start over */
+        cpdAtTokenizerReset(pTok);
+    }
+
+    for (i = pTok->scanIndex; i < len; i++) {
+        /* skip over bytes which can't be part of a token */
+        j = cpdScanFind(&(pB[i]), len - i, (pTok->urcHasXml != 0) ? &atScanSetXml : &atScanSet);
+        if (j < 0) {
+            break;
+        }
+        i = i + j;
+        c = pB[i];
+        if (c == AT_CMD_LF_CHR) {
+            start = pTok->lineStart;
+            end = i;
+            while ((end > start) && (pB[end - 1] == AT_CMD_CR_CHR)) {
+                end--;
+            }
+            type = cpdAtTokenizerClassifyLine(pB, start, end);
+            if (pTok->urcStart >= 0) {
+                if (end == start) {
+                    /* empty line terminates URC */
+                    pTok->lineStart = i + 1;
+                    pTok->scanIndex = i + 1;
+                    return cpdAtTokenizerCloseUrc(pTok, pToken, pTok->urcEnd, i + 1);
+                }
+                if ((type == AT_TOKEN_OK) || (type == AT_TOKEN_ERROR)) {
+                    /* final result without empty line in front of it; close URC, then scan this line again */
+                    pTok->scanIndex = i;
+                    return cpdAtTokenizerCloseUrc(pTok, pToken, pTok->urcEnd, start);
+                }
+                pTok->urcEnd = end;
+                pTok->lineStart = i + 1;
+                continue;
+            }
+            pTok->lineStart = i + 1;
+            if (type != AT_TOKEN_NONE) {
+                pTok->scanIndex = i + 1;
+                return cpdAtTokenizerSetToken(pToken, type, start, i + 1 - start);
+            }
+        }
+        else if ((c == AT_CMD_CTRL_Z_CHR) || (c == AT_CMD_ESC_CHR)) {
+            pTok->lineStart = i + 1;
+            pTok->scanIndex = i + 1;
+            if (pTok->urcStart >= 0) {
+                return cpdAtTokenizerCloseUrc(pTok, pToken, i, i + 1);
+            }
+            type = (c == AT_CMD_CTRL_Z_CHR) ? AT_TOKEN_CTRL_Z : AT_TOKEN_ESC;
+            return cpdAtTokenizerSetToken(pToken, type, i, 1);
+        }
+        else if ((c == AT_CMD_COL_CHR) &&
+                 ((i - pTok->lineStart + 1) == AT_TOKEN_URC_PREFIX_LEN) &&
+                 (memcmp(&(pB[pTok->lineStart]), AT_TOKEN_URC_PREFIX, AT_TOKEN_URC_PREFIX_LEN) == 0)) {
+            if (pTok->urcStart >= 0) {
+                /* next URC started without empty line; close previous one, then scan this line again */
+                pTok->scanIndex = i;
+                return cpdAtTokenizerCloseUrc(pTok, pToken, pTok->urcEnd, pTok->lineStart);
+            }
+            pTok->urcStart = pTok->lineStart;
+            pTok->urcEnd = CPD_ERROR;
+            pTok->urcHasXml = 0;
+            pTok->scanIndex = i + 1;
+            cpdAtTokenizerSetToken(pToken, AT_TOKEN_URC_START, pTok->lineStart, AT_TOKEN_URC_PREFIX_LEN);
+            pToken->urcStart = pTok->lineStart;
+            return CPD_OK;
+        }
+        else if (c == XML_START_CHAR) {
+            if (pTok->urcStart >= 0) {
+                pTok->urcHasXml = 1;
+            }
+        }
+    }
+    pTok->scanIndex = len;
+    return CPD_NOK;
+}
+
+/*
+ * <left> bytes were removed from the start of Rx buffer, move all positions accordingly.
+ */
+void cpdAtTokenizerRebase(pAT_TOKENIZER pTok, int left)
+{
+    if (left <= 0) {
+        return;
+    }
+    pTok->scanIndex = (pTok->scanIndex > left) ? (pTok->scanIndex - left) : 0;
+    pTok->lineStart = (pTok->lineStart > left) ? (pTok->lineStart - left) : 0;
+    if (pTok->urcStart >= 0) {
+        if (pTok->urcStart < left) {
+            /* start of URC is gone, the rest of it is useless */
+            LOGW("%s(), URC @ %d dropped from Rx buffer, %d", __FUNCTION__, pTok->urcStart, left);
+            pTok->urcStart = CPD_ERROR;
+            pTok->urcEnd = CPD_ERROR;
+            pTok->urcHasXml = 0;
+        }
+        else {
+            pTok->urcStart = pTok->urcStart - left;
+            if (pTok->urcEnd >= 0) {
+                pTok->urcEnd = pTok->urcEnd - left;
+            }
+        }
+    }
+}
@@ -0,0 +1,20 @@
+/*
+ *  hardware/Intel/cp_daemon/cpdAtTokenizer.h
+ *
+ * Incremental tokenizer for modem Rx data - header file.
+ *
+ * Martin Junkar 09/18/2011
+ *
+ *
+ */
+
+#ifndef _CPDATTOKENIZER_H_
+#define _CPDATTOKENIZER_H_
+
+#include "cpd.h"
+
+void cpdAtTokenizerReset(pAT_TOKENIZER );
+int cpdAtTokenizerNext(pAT_TOKENIZER , const char *, int , pAT_TOKEN );
+void cpdAtTokenizerRebase(pAT_TOKENIZER , int );
+
+#endif /* _CPDATTOKENIZER_H_ */
@@ -0,0 +1,197 @@
+/*
+ * hardware/Intel/cp_daemon/cpdGppCodec.c
+ *
+ * Conversion between 3GPP TS 23.032 encoded values and values used by CPD.
+ * Uncertainty codes K are 0..127, metres for every K and K for every metre up to GPP_UNCERT_TABLE_M
+ * are put into tables once, on first use, so decoding and most encoding is one table read.
+ * Bigger metres are encoded by binary search of the metres table.
+ *
+ * Martin Junkar 09/18/2011
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <pthread.h>
+#define LOG_TAG "CPDD_GC"
+
+#include "cpd.h"
+#include "cpdGppCodec.h"
+#include "cpdDebug.h"
+
+#define GPP_LATITUDE_MAX_K      (8388607L)      /* 23 bits */
+#define GPP_LONGITUDE_MAX_K     (8388607L)      /* 24 bits, two's complement */
+#define GPP_LONGITUDE_MIN_K     (-8388608L)
+#define GPP_CONFIDENCE_MAX      (100)
+#define GPP_UNCERT_TABLE_M      (1023)          /* metres encoded with one table read */
+
+static int gppHorizontalUncertM[GPP_LL_UNCERT_MAX_K + 1];
+static int gppVerticalUncertM[GPP_ALT_UNCERT_MAX_K + 1];
+static unsigned char gppHorizontalUncertK[GPP_UNCERT_TABLE_M + 1];
+static unsigned char gppVerticalUncertK[GPP_UNCERT_TABLE_M + 1];
+static pthread_once_t gppCodecOnce = PTHREAD_ONCE_INIT;
+
+
+/*
+ * r = C * ((1 + x)^K - 1) metres for each K, each metre gets K whose metres are nearest, the bigger K on a tie,
+ * so every K decodes to metres which encode back to the same K.
+ */
+static void cpdGppUncertTables(int *pM, int maxK, unsigned char *pK, double c, double x1)
+{
+    int i;
+    int k = 0;
+
+    for (i = 0; i <= maxK; i++) {
+        pM[i] = (int) (c * (pow(x1, i) - 1.0));
+    }
+    for (i = 0; i <= GPP_UNCERT_TABLE_M; i++) {
+        while ((k < maxK) && (abs(pM[k + 1] - i) <= abs(pM[k] - i))) {
+            k++;
+        }
+        pK[i] = (unsigned char) k;
+    }
+}
+
+static void cpdGppCodecInit(void)
+{
+    cpdGppUncertTables(gppHorizontalUncertM, GPP_LL_UNCERT_MAX_K, gppHorizontalUncertK,
+                       GPP_LL_UNCERT_C, GPP_LL_UNCERT_1X);
+    cpdGppUncertTables(gppVerticalUncertM, GPP_ALT_UNCERT_MAX_K, gppVerticalUncertK,
+                       GPP_ALT_UNCERT_C, GPP_ALT_UNCERT_1X);
+    LOGD("%s(), horizontal %d..%d m, vertical %d..%d m", __FUNCTION__,
+         gppHorizontalUncertM[0], gppHorizontalUncertM[GPP_LL_UNCERT_MAX_K],
+         gppVerticalUncertM[0], gppVerticalUncertM[GPP_ALT_UNCERT_MAX_K]);
+}
+
+/*
+ * K for <uncertM> limited to 0..<maxM>, from table when metres are in it, otherwise the first K
+ * with at least <uncertM> metres or the one below it when that one is nearer, as in cpdGppUncertTables().
+ */
+static int cpdGppUncertK(const int *pM, int maxK, const unsigned char *pK, int maxM, int uncertM)
+{
+    int lo, hi, k;
+
+    if (uncertM < 0) {
+        uncertM = 0;
+    }
+    if (uncertM > maxM) {
+        uncertM = maxM;
+    }
+    if (uncertM <= GPP_UNCERT_TABLE_M) {
+        return pK[uncertM];
+    }
+    lo = pK[GPP_UNCERT_TABLE_M];
+    hi = maxK;
+    while (lo < hi) {
+        k = (lo + hi) / 2;
+        if (pM[k] < uncertM) {
+            lo = k + 1;
+        }
+        else {
+            hi = k;
+        }
+    }
+    if ((lo > 0) && ((uncertM - pM[lo - 1]) < (pM[lo] - uncertM))) {
+        lo--;
+    }
+    return lo;
+}
+
+/*
+ * Convert 3GPP uncertainty code K into meters, K out of 0..127 is limited to that range.
+ */
+int cpdGppHorizontalUncertToM(int uncertK)
+{
+    pthread_once(&gppCodecOnce, cpdGppCodecInit);
+    if (uncertK < 0) {
+        uncertK = 0;
+    }
+    if (uncertK > GPP_LL_UNCERT_MAX_K) {
+        uncertK = GPP_LL_UNCERT_MAX_K;
+    }
+    return gppHorizontalUncertM[uncertK];
+}
+
+/*
+ * Convert meters into 3GPP uncertainty code K, meters are limited to 0..GPP_LL_UNCERT_MAX_M.
+ */
+int cpdGppHorizontalUncertToK(int uncertM)
+{
+    pthread_once(&gppCodecOnce, cpdGppCodecInit);
+    return cpdGppUncertK(gppHorizontalUncertM, GPP_LL_UNCERT_MAX_K, gppHorizontalUncertK, GPP_LL_UNCERT_MAX_M,
+                         uncertM);
+}
+
+int cpdGppVerticalUncertToM(int uncertK)
+{
+    pthread_once(&gppCodecOnce, cpdGppCodecInit);
+    if (uncertK < 0) {
+        uncertK = 0;
+    }
+    if (uncertK > GPP_ALT_UNCERT_MAX_K) {
+        uncertK = GPP_ALT_UNCERT_MAX_K;
+    }
+    return gppVerticalUncertM[uncertK];
+}
+
+int cpdGppVerticalUncertToK(int uncertM)
+{
+    pthread_once(&gppCodecOnce, cpdGppCodecInit);
+    return cpdGppUncertK(gppVerticalUncertM, GPP_ALT_UNCERT_MAX_K, gppVerticalUncertK, GPP_ALT_UNCERT_MAX_M,
+                         uncertM);
+}
+
+/*
+ * Latitude in degrees (negative on south) into 3GPP value, <north> is 3GPP sign bit (1 = south).
+ * Value is truncated, as 3GPP defines it, and limited to 23 bits.
+ */
+long cpdGppLatitudeToK(int north, double degrees)
+{
+    double k;
+
+    k = LATITUDE_FLOAT_TO_GPP * ((north == 0) ? degrees : -degrees);
+    if (k > GPP_LATITUDE_MAX_K) {
+        return GPP_LATITUDE_MAX_K;
+    }
+    if (k < -GPP_LATITUDE_MAX_K) {
+        return -GPP_LATITUDE_MAX_K;
+    }
+    return (long) k;
+}
+
+double cpdGppLatitudeToDegrees(int north, long latitudeK)
+{
+    double degrees = ((double) latitudeK) * LATITUDE_GPP_TO_FLOAT;
+
+    return (north == 1) ? -degrees : degrees;
+}
+
+long cpdGppLongitudeToK(double degrees)
+{
+    double k = LONGITUDE_FLOAT_TO_GPP * degrees;
+
+    if (k > GPP_LONGITUDE_MAX_K) {
+        return GPP_LONGITUDE_MAX_K;
+    }
+    if (k < GPP_LONGITUDE_MIN_K) {
+        return GPP_LONGITUDE_MIN_K;
+    }
+    return (long) k;
+}
+
+double cpdGppLongitudeToDegrees(long longitudeK)
+{
+    return ((double) longitudeK) * LONGITUDE_GPP_TO_FLOAT;
+}
+
+/*
+ * Confidence in percent, limited to 0..100.
+ */
+int cpdGppConfidence(int confidence)
+{
+    if (confidence < 0) {
+        return 0;
+    }
+    return (confidence > GPP_CONFIDENCE_MAX) ? GPP_CONFIDENCE_MAX : confidence;
+}
@@ -0,0 +1,24 @@
+/*
+ * hardware/Intel/cp_daemon/cpdGppCodec.h
+ *
+ * Header file for cpdGppCodec.c.
+ *
+ * Martin Junkar 09/18/2011
+ *
+ */
+
+#ifndef _CPDGPPCODEC_H_
+#define _CPDGPPCODEC_H_
+
+int cpdGppHorizontalUncertToM(int uncertK);
+int cpdGppHorizontalUncertToK(int uncertM);
+int cpdGppVerticalUncertToM(int uncertK);
+int cpdGppVerticalUncertToK(int uncertM);
+
+long cpdGppLatitudeToK(int north, double degrees);
+double cpdGppLatitudeToDegrees(int north, long latitudeK);
+long cpdGppLongitudeToK(double degrees);
+double cpdGppLongitudeToDegrees(long longitudeK);
+
+int cpdGppConfidence(int confidence);
+#endif
@@ -20,6 +20,7 @@
 #include <fcntl.h>
 #include <errno.h>
 #include <string.h>
+#include <stddef.h>
 #include <pthread.h>
 
 #include <termios.h>
@@ -35,10 +36,16 @@
 #include "cpdSocketServer.h"
 
 #include "cpdGpsComm.h"
+#include "cpdScan.h"
+#include "cpdAidingCache.h"
+#include "cpdAssistStore.h"
+#include "cpdGpsRing.h"
+#include "cpdGpsWire.h"
 
 
 int cpdFormatAndSendMsgToCpd(pCPD_CONTEXT pCpd);
 int cpdSendStopToGPS(pCPD_CONTEXT pCpd);
+static int cpdGpsCommSendControl(pCPD_CONTEXT pCpd, int type, int value);
 
 
 /* =========== DEBUG & TEST functions ================= */
@@ -152,6 +159,7 @@ int cpdCreateLocResponseFromAssistData_t(pCPD_CONTEXT pCpd)
 
     pLoc = &(pCpd->response.location);
 
+    pthread_mutex_lock(&(pCpd->responseSender.lock));
     memset(&(pCpd->response), 0, sizeof(RESPONSE_PARAMS));
     pLoc->time_of_fix = 0;
     pLoc->location_parameters.shape_type = SHAPE_TYPE_POINT_ALT_UNCERT_ELLIPSE;
@@ -184,6 +192,7 @@ int cpdCreateLocResponseFromAssistData_t(pCPD_CONTEXT pCpd)
     if (pCpd->pfMessageHandlerInCpd != NULL) {
         pCpd->pfMessageHandlerInCpd(pCpd);
     }
+    pthread_mutex_unlock(&(pCpd->responseSender.lock));
     return CPD_OK;
 }
 
@@ -196,94 +205,185 @@ int cpdCreateLocResponseFromAssistData_t(pCPD_CONTEXT pCpd)
 
 
 
-int cpdGpsMsgFindHeadTail(pGPS_COMM_BUFFER pGpsComm)
+#define CPD_MSG_HEADER_IS(pB, i, len, header) \
+    ((((len) - (i)) >= (int) strlen(header)) && (memcmp(&((pB)[(i)]), (header), strlen(header)) == 0))
+#define CPD_MSG_FRAMING_QUERRY  (0)     /* query header, text without type and length */
+
+/*
+ * Find the first message header of either framing in GPS Rx buffer, in a single pass over the buffer.
+ * Text headers start with CR, binary header with CPD_MSG2_MAGIC_FIRST, only positions of those are checked.
+ * Returns offset of the header, -1 if there is none; <*pFraming> is set to CPD_MSG_FRAMING_xx of the header.
+ */
+static int cpdGpsMsgFindHeader(char *pB, int len, int *pFraming)
 {
-    int result = CPD_NOK;
-    int *pI;
+    static const SCAN_SET headerSet = { 2, { AT_CMD_CR_CHR, CPD_MSG2_MAGIC_FIRST } };
+    unsigned int magic = CPD_MSG2_MAGIC;
+    int i = 0;
+    int r;
+
+    *pFraming = CPD_MSG_FRAMING_TEXT;
+    while (i < len) {
+        r = cpdScanFind(&(pB[i]), len - i, &headerSet);
+        if (r < 0) {
+            break;
+        }
+        i = i + r;
+        if (((len - i) >= (int) sizeof(magic)) && (memcmp(&(pB[i]), &magic, sizeof(magic)) == 0)) {
+            *pFraming = CPD_MSG_FRAMING_V2;
+            return i;
+        }
+        if (CPD_MSG_HEADER_IS(pB, i, len, CPD_MSG_HEADER_TO_GPS) ||
+            CPD_MSG_HEADER_IS(pB, i, len, CPD_MSG_HEADER_FROM_GPS)) {
+            return i;
+        }
+        if (CPD_MSG_HEADER_IS(pB, i, len, CPD_MSG_HEADER_QUERRY)) {
+            *pFraming = CPD_MSG_FRAMING_QUERRY;
+            return i;
+        }
+        i++;
+    }
+    return -1;
+}
+
+/*
+ * Drop first <n> bytes of data not handled yet in GPS Rx buffer.
+ */
+static void cpdGpsMsgDrop(pGPS_COMM_BUFFER pGpsComm, int n)
+{
+    pGpsComm->rxBufferStart = pGpsComm->rxBufferStart + n;
+    pGpsComm->bytesDropped += n;
+}
 
-    if ((pGpsComm->rxBufferCmdStart >= 0) &&
-        (pGpsComm->rxBufferCmdEnd > 0) &&
-        (pGpsComm->rxBufferMessageType != CPD_MSG_TYPE_NONE)) {
+/*
+ * Find complete message at the start of data not handled yet in GPS Rx buffer (rxBufferStart).
+ * Messages follow each other, so the header is checked only at the start of data. Buffer is scanned for header
+ * when data doesn't start with one, or the header found is not valid: length out of range, CRC or tail not
+ * matching. Bytes before the next header are dropped then.
+ * Returns CPD_OK when rxBufferCmdxx describe a complete message.
+ */
+int cpdGpsMsgFindHeadTail(pGPS_COMM_BUFFER pGpsComm)
+{
+    CPD_MSG2_HEADER h;
+    char *pB;
+    int tailLen = strlen(CPD_MSG_TAIL);
+    /* message not complete yet is moved to the start of buffer, so it can fill all of it */
+    int maxData = pGpsComm->rxBufferSize - CPD_MSG_HEAD_SIZE - tailLen - 1;
+    int available;
+    int framing;
+    int start;
+    int textHead[2];    /* <CPD_MSG_TYPE_E><int length> of text message */
+
+    if (pGpsComm->rxBufferCmdNext > 0) {
         return CPD_OK;
     }
 
-    if (pGpsComm->rxBufferCmdStart < 0) {
-        pGpsComm->rxBufferCmdStart = cpdFindString(pGpsComm->pRxBuffer, pGpsComm->rxBufferIndex, CPD_MSG_HEADER_TO_GPS, 0);
-        if (pGpsComm->rxBufferCmdStart < 0) {
-            pGpsComm->rxBufferCmdStart = cpdFindString(pGpsComm->pRxBuffer, pGpsComm->rxBufferIndex, CPD_MSG_HEADER_FROM_GPS, 0);
-        }
-        if (pGpsComm->rxBufferCmdStart < 0) {
-            pGpsComm->rxBufferCmdStart = cpdFindString(pGpsComm->pRxBuffer, pGpsComm->rxBufferIndex, CPD_MSG_HEADER_QUERRY, 0);
-            if (pGpsComm->rxBufferCmdStart >= 0) {
-                pGpsComm->rxBufferCmdEnd = pGpsComm->rxBufferCmdStart + strlen(CPD_MSG_HEADER_QUERRY) - strlen(CPD_MSG_TAIL);
-                pGpsComm->rxBufferMessageType = CPD_MSG_TYPE_QUERRY;
-                pGpsComm->rxBufferCmdDataSize = CPD_ERROR;
-                result = CPD_OK;
-                LOGD("%u: %s()=%d", getMsecTime(), __FUNCTION__, result);
-                return result;
+    while (pGpsComm->rxBufferIndex > pGpsComm->rxBufferStart) {
+        pB = &(pGpsComm->pRxBuffer[pGpsComm->rxBufferStart]);
+        available = pGpsComm->rxBufferIndex - pGpsComm->rxBufferStart;
+        start = cpdGpsMsgFindHeader(pB, available, &framing);
+        if (start < 0) {
+            /* keep the last bytes, they can be the beginning of a header */
+            if (available >= CPD_MSG_HEAD_SIZE) {
+                pGpsComm->nResync++;
+                cpdGpsMsgDrop(pGpsComm, available - CPD_MSG_HEAD_SIZE + 1);
             }
+            return CPD_NOK;
         }
-        if (pGpsComm->rxBufferCmdStart < 0) {
-            return result;
+        if (start > 0) {
+            pGpsComm->nResync++;
+            cpdGpsMsgDrop(pGpsComm, start);
+            pB = &(pB[start]);
+            available = available - start;
+        }
+        pGpsComm->rxBufferCmdStart = pGpsComm->rxBufferStart;
+
+        if (framing == CPD_MSG_FRAMING_QUERRY) {
+            pGpsComm->rxBufferCmdEnd = pGpsComm->rxBufferStart + strlen(CPD_MSG_HEADER_QUERRY) - tailLen;
+            pGpsComm->rxBufferCmdNext = pGpsComm->rxBufferStart + strlen(CPD_MSG_HEADER_QUERRY);
+            pGpsComm->rxBufferMessageType = CPD_MSG_TYPE_QUERRY;
+            pGpsComm->rxBufferCmdDataSize = CPD_ERROR;
+            LOGD("%u: %s()=%d", getMsecTime(), __FUNCTION__, CPD_OK);
+            return CPD_OK;
+        }
+        if (available < CPD_MSG_HEAD_SIZE) {
+            return CPD_NOK;
         }
-    }
-    if (pGpsComm->rxBufferCmdStart > 0) {
-        memmove(pGpsComm->pRxBuffer, &(pGpsComm->pRxBuffer[pGpsComm->rxBufferCmdStart]), pGpsComm->rxBufferIndex - pGpsComm->rxBufferCmdStart);
-        pGpsComm->rxBufferIndex = pGpsComm->rxBufferIndex - pGpsComm->rxBufferCmdStart;
-        pGpsComm->rxBufferCmdStart = 0;
-    }
-    if (pGpsComm->rxBufferIndex < (int) (strlen(CPD_MSG_HEADER_TO_GPS) + sizeof(int))) {
-        return result;
-    }
-    pI = (int *) &(pGpsComm->pRxBuffer[strlen(CPD_MSG_HEADER_TO_GPS)]);
-    pGpsComm->rxBufferMessageType = *pI;
-
-    pGpsComm->rxBufferCmdEnd = cpdFindString(pGpsComm->pRxBuffer, pGpsComm->rxBufferIndex, CPD_MSG_TAIL, 0);
-    if (pGpsComm->rxBufferCmdEnd <= pGpsComm->rxBufferCmdStart) {
-        return result;
-    }
 
-    pI++;
-    pGpsComm->rxBufferCmdDataSize = *pI;
-    pI++;
-    pGpsComm->rxBufferCmdDataStart = (int) (((char *) pI) - pGpsComm->pRxBuffer);
+        if (framing == CPD_MSG_FRAMING_V2) {
+            memcpy(&h, pB, sizeof(h));
+            if ((h.version != CPD_MSG2_VERSION) || (h.length > (unsigned int) maxData)) {
+                cpdGpsMsgDrop(pGpsComm, 1);
+                continue;
+            }
+            if (available < (int) (CPD_MSG_HEAD_SIZE + h.length)) {
+                return CPD_NOK;
+            }
+            if (h.crc != cpdCrc32c(cpdCrc32c(0, &h, offsetof(CPD_MSG2_HEADER, crc)), &(pB[CPD_MSG_HEAD_SIZE]), h.length)) {
+                pGpsComm->nCrcErrors++;
+                cpdGpsMsgDrop(pGpsComm, 1);
+                continue;
+            }
+            pGpsComm->rxBufferMessageType = h.type;
+            pGpsComm->rxBufferCmdDataSize = h.length;
+            pGpsComm->rxBufferCmdDataStart = pGpsComm->rxBufferStart + CPD_MSG_HEAD_SIZE;
+            pGpsComm->rxBufferCmdEnd = pGpsComm->rxBufferCmdDataStart + h.length;
+            pGpsComm->rxBufferCmdNext = pGpsComm->rxBufferCmdEnd;
+            pGpsComm->nRxV2++;
+            break;
+        }
 
-    if ((pGpsComm->rxBufferCmdDataStart + pGpsComm->rxBufferCmdDataSize) == pGpsComm->rxBufferCmdEnd) {
-        result = CPD_OK;
-    } else {
-        memmove(pGpsComm->pRxBuffer, &(pGpsComm->pRxBuffer[pGpsComm->rxBufferCmdEnd]), pGpsComm->rxBufferIndex - pGpsComm->rxBufferCmdEnd);
-        pGpsComm->rxBufferIndex = pGpsComm->rxBufferIndex - pGpsComm->rxBufferCmdEnd;
-        pGpsComm->rxBufferCmdEnd = CPD_ERROR;
-        pGpsComm->rxBufferCmdStart = CPD_ERROR;
-        pGpsComm->rxBufferCmdDataSize = CPD_ERROR;
-        pGpsComm->rxBufferCmdDataStart = CPD_ERROR;
-        pGpsComm->rxBufferMessageType = CPD_ERROR;
+        /* <header><CPD_MSG_TYPE_E><int length><data><CPD_MSG_TAIL>, tail has to follow data; not aligned */
+        memcpy(textHead, &(pB[strlen(CPD_MSG_HEADER_TO_GPS)]), sizeof(textHead));
+        if ((textHead[1] < 0) || (textHead[1] > maxData)) {
+            cpdGpsMsgDrop(pGpsComm, 1);
+            continue;
+        }
+        if (available < (CPD_MSG_HEAD_SIZE + textHead[1] + tailLen)) {
+            return CPD_NOK;
+        }
+        if (memcmp(&(pB[CPD_MSG_HEAD_SIZE + textHead[1]]), CPD_MSG_TAIL, tailLen) != 0) {
+            cpdGpsMsgDrop(pGpsComm, 1);
+            continue;
+        }
+        pGpsComm->rxBufferMessageType = textHead[0];
+        pGpsComm->rxBufferCmdDataSize = textHead[1];
+        pGpsComm->rxBufferCmdDataStart = pGpsComm->rxBufferStart + CPD_MSG_HEAD_SIZE;
+        pGpsComm->rxBufferCmdEnd = pGpsComm->rxBufferCmdDataStart + textHead[1];
+        pGpsComm->rxBufferCmdNext = pGpsComm->rxBufferCmdEnd + tailLen;
+        pGpsComm->nRxText++;
+        break;
     }
-
-    LOGD("%u: %s()=%d", getMsecTime(), __FUNCTION__, result);
-    return result;
+    if (pGpsComm->rxBufferCmdNext <= 0) {
+        return CPD_NOK;
+    }
+    LOGD("%u: %s()=%d", getMsecTime(), __FUNCTION__, CPD_OK);
+    return CPD_OK;
 }
 
 
 /*
- *
+ * Handle message <type> with <dataSize> bytes at <pData>, received through socket or shared memory ring.
  */
-int cpdGpsCommHandlePacket(pCPD_CONTEXT pCpd)
+int cpdGpsCommHandleMessage(pCPD_CONTEXT pCpd, int type, char *pData, int dataSize)
 {
     int result = CPD_OK;
+    int value;
+    int fds[GPS_RING_N_FDS];
+    int n;
     pGPS_COMM_BUFFER pGpsComm;
 
     pGpsComm = &(pCpd->gpsCommBuffer);
-    LOGD("%u: %s(%d,%d)", getMsecTime(), __FUNCTION__,
-        pGpsComm->rxBufferMessageType,
-        pGpsComm->rxBufferCmdDataSize);
-    CPD_LOG(CPD_LOG_ID_TXT, "\n%u: %s(%d,%d) \n", getMsecTime(), __FUNCTION__,
-        pGpsComm->rxBufferMessageType,
-        pGpsComm->rxBufferCmdDataSize);
-
-    switch (pGpsComm->rxBufferMessageType) {
+    LOGD("%u: %s(%d,%d)", getMsecTime(), __FUNCTION__, type, dataSize);
+    CPD_LOG(CPD_LOG_ID_TXT, "\n%u: %s(%d,%d) \n", getMsecTime(), __FUNCTION__, type, dataSize);
+
+    /* control messages carry one int */
+    value = CPD_ERROR;
+    if ((type >= CPD_MSG_TYPE_FRAMING_REQ) && (dataSize >= (int) sizeof(int))) {
+        memcpy(&value, pData, sizeof(int));
+    }
+    switch (type) {
         case CPD_MSG_TYPE_MEAS_ABORT_REQ:
-            CPD_LOG(CPD_LOG_ID_TXT, "\r\n  CPD_MSG_TYPE_MEAS_ABORT_REQ, %d, %d, %d\n", pGpsComm->rxBufferMessageType, pGpsComm->rxBufferCmdDataStart, pGpsComm->rxBufferCmdDataSize);
+            CPD_LOG(CPD_LOG_ID_TXT, "\r\n  CPD_MSG_TYPE_MEAS_ABORT_REQ, %d, %d\n", type, dataSize);
             LOGD("%u: %s(CPD_MSG_TYPE_MEAS_ABORT_REQ)", getMsecTime(), __FUNCTION__);
             memset(&(pCpd->request), 0, sizeof(REQUEST_PARAMS));
             pCpd->request.flag = REQUEST_FLAG_POS_MEAS;
@@ -293,16 +393,26 @@ int cpdGpsCommHandlePacket(pCPD_CONTEXT pCpd)
             }
             break;
         case CPD_MSG_TYPE_POS_MEAS_REQ:
-            CPD_LOG(CPD_LOG_ID_TXT,"%u: %s(CPD_MSG_TYPE_POS_MEAS_REQ, %d, %d), ID=%d", getMsecTime(), __FUNCTION__, pGpsComm->rxBufferCmdDataStart, pGpsComm->rxBufferCmdDataSize, pCpd->request.flag);
-            LOGD("%u: %s(CPD_MSG_TYPE_POS_MEAS_REQ, %d, %d), ID=%d", getMsecTime(), __FUNCTION__, pGpsComm->rxBufferCmdDataStart, pGpsComm->rxBufferCmdDataSize, pCpd->request.flag);
+            CPD_LOG(CPD_LOG_ID_TXT,"%u: %s(CPD_MSG_TYPE_POS_MEAS_REQ, %d), ID=%d", getMsecTime(), __FUNCTION__, dataSize, pCpd->request.flag);
+            LOGD("%u: %s(CPD_MSG_TYPE_POS_MEAS_REQ, %d), ID=%d", getMsecTime(), __FUNCTION__, dataSize, pCpd->request.flag);
             memset(&(pCpd->request), 0, sizeof(REQUEST_PARAMS));
             pCpd->request.flag = CPD_ERROR;
-            if ((int) sizeof(REQUEST_PARAMS) >= pGpsComm->rxBufferCmdDataSize) {
-                memcpy(&(pCpd->request),
-                        &(pGpsComm->pRxBuffer[pGpsComm->rxBufferCmdDataStart]),
-                        pGpsComm->rxBufferCmdDataSize);
-                if (pCpd->request.version != CPD_MSG_VERSION) {
-                    pCpd->request.flag = CPD_ERROR;
+            if (cpdGpsWireIsEncoded(pData, dataSize) == CPD_OK) {
+                if (cpdGpsWireDecode(pCpd, GPS_WIRE_REQUEST, pData, dataSize, &(pCpd->request)) != CPD_OK) {
+                    pCpd->request.version = CPD_ERROR;
+                }
+            }
+            else if ((int) sizeof(REQUEST_PARAMS) >= dataSize) {
+                memcpy(&(pCpd->request), pData, dataSize);
+            }
+            if (pCpd->request.version != CPD_MSG_VERSION) {
+                pCpd->request.flag = CPD_ERROR;
+            }
+            else {
+                n = cpdAidingApply(pCpd, &(pCpd->request.assist_data));
+                if (n > 0) {
+                    /* request goes on without navigation model, CPDD sends all ephemeris again */
+                    cpdGpsCommSendControl(pCpd, CPD_MSG_TYPE_AIDING_RESEND, n);
                 }
             }
             if (pCpd->pfMessageHandlerInGps != NULL) {
@@ -311,48 +421,131 @@ int cpdGpsCommHandlePacket(pCPD_CONTEXT pCpd)
             break;
         case CPD_MSG_TYPE_POS_MEAS_RESP:
             LOGD("%u: %s(CPD_MSG_TYPE_POS_MEAS_RESP)=%d", getMsecTime(), __FUNCTION__, pCpd->response.flag);
-            CPD_LOG(CPD_LOG_ID_TXT , "\r\n  CPD_MSG_POS_MEAS_RESP , %d, %d, %d, ID=%d", pGpsComm->rxBufferMessageType, pGpsComm->rxBufferCmdDataStart, pGpsComm->rxBufferCmdDataSize, pCpd->response.flag);
+            CPD_LOG(CPD_LOG_ID_TXT , "\r\n  CPD_MSG_POS_MEAS_RESP , %d, %d, ID=%d", type, dataSize, pCpd->response.flag);
+            /* response sender may be formatting the previous response */
+            pthread_mutex_lock(&(pCpd->responseSender.lock));
             memset(&(pCpd->response), 0, sizeof(RESPONSE_PARAMS));
             pCpd->response.flag = CPD_ERROR;
-            if ((int) sizeof(RESPONSE_PARAMS) >= pGpsComm->rxBufferCmdDataSize) {
-                memcpy(&(pCpd->response),
-                        &(pGpsComm->pRxBuffer[pGpsComm->rxBufferCmdDataStart]),
-                        pGpsComm->rxBufferCmdDataSize);
-                if (pCpd->response.version != CPD_MSG_VERSION) {
-                    pCpd->response.flag = CPD_ERROR;
+            if (cpdGpsWireIsEncoded(pData, dataSize) == CPD_OK) {
+                if (cpdGpsWireDecode(pCpd, GPS_WIRE_RESPONSE, pData, dataSize, &(pCpd->response)) != CPD_OK) {
+                    pCpd->response.version = CPD_ERROR;
                 }
             }
+            else if ((int) sizeof(RESPONSE_PARAMS) >= dataSize) {
+                memcpy(&(pCpd->response), pData, dataSize);
+            }
+            if (pCpd->response.version != CPD_MSG_VERSION) {
+                pCpd->response.flag = CPD_ERROR;
+            }
             pCpd->request.status.responseFromGpsReceivedAt = getMsecTime();
             if (pCpd->pfMessageHandlerInCpd != NULL) {
+                /* sessions the response is given to are ended by the handler once they are fulfilled */
                 result = pCpd->pfMessageHandlerInCpd(pCpd);
-                if (result == CPD_OK) {
-                    if (cpdIsNumberOfResponsesSufficientForRequest(pCpd)) {
-                        pCpd->request.posMeas.flag = POS_MEAS_NONE;
-                        pCpd->request.assist_data.flag = CPD_NOK;
-                        pCpd->request.flag = CPD_NOK;
-                    }
+            }
+            pthread_mutex_unlock(&(pCpd->responseSender.lock));
+            break;
+        case CPD_MSG_TYPE_FRAMING_REQ:
+            /* GPS side, answer in the framing CPDD used and switch, new connection starts without ephemeris mirror */
+            n = value & (CPD_MSG_PAYLOAD_PACKED | CPD_MSG_PAYLOAD_MIRROR);
+            value = ((value & ~n) >= CPD_MSG_FRAMING_V2) ? CPD_MSG_FRAMING_V2 : CPD_MSG_FRAMING_TEXT;
+            cpdAidingMirrorReset(pCpd);
+            LOGD("%u: %s(CPD_MSG_TYPE_FRAMING_REQ)=%d, %d", getMsecTime(), __FUNCTION__, value, n);
+            CPD_LOG(CPD_LOG_ID_TXT, "\r\n  CPD_MSG_TYPE_FRAMING_REQ, %d, %d", value, n);
+            if (cpdGpsCommSendControl(pCpd, CPD_MSG_TYPE_FRAMING_RESP, value | n) > CPD_NOK) {
+                pGpsComm->txFraming = value;
+                pGpsComm->txPacked = ((n & CPD_MSG_PAYLOAD_PACKED) != 0) ? CPD_OK : CPD_NOK;
+            }
+            break;
+        case CPD_MSG_TYPE_FRAMING_RESP:
+            /* GPS library which doesn't know encoded data or ephemeris mirror answers without the bit */
+            pGpsComm->txPacked = ((value != CPD_ERROR) && ((value & CPD_MSG_PAYLOAD_PACKED) != 0)) ? CPD_OK : CPD_NOK;
+            pGpsComm->txMirrored = ((value != CPD_ERROR) && ((value & CPD_MSG_PAYLOAD_MIRROR) != 0)) ? CPD_OK : CPD_NOK;
+            value = value & ~(CPD_MSG_PAYLOAD_PACKED | CPD_MSG_PAYLOAD_MIRROR);
+            pGpsComm->txFraming = (value == CPD_MSG_FRAMING_V2) ? CPD_MSG_FRAMING_V2 : CPD_MSG_FRAMING_TEXT;
+            LOGD("%u: %s(CPD_MSG_TYPE_FRAMING_RESP)=%d, %d, %d", getMsecTime(), __FUNCTION__,
+                    pGpsComm->txFraming, pGpsComm->txPacked, pGpsComm->txMirrored);
+            CPD_LOG(CPD_LOG_ID_TXT, "\r\n  CPD_MSG_TYPE_FRAMING_RESP, %d, %d, %d",
+                    pGpsComm->txFraming, pGpsComm->txPacked, pGpsComm->txMirrored);
+            break;
+        case CPD_MSG_TYPE_RING_REQ:
+            /* GPS side, descriptors came with this message on the socket it was read from */
+            n = cpdSocketTakeFds(&(pCpd->scGps.clients[pGpsComm->scGpsIndex]), fds, GPS_RING_N_FDS);
+            value = (value == GPS_RING_VERSION) ? cpdGpsRingAttach(pCpd, pGpsComm->scGpsIndex, fds, n) : CPD_ERROR;
+            if (value != CPD_OK) {
+                while (n > 0) {
+                    n--;
+                    close(fds[n]);
                 }
             }
+            LOGD("%u: %s(CPD_MSG_TYPE_RING_REQ)=%d", getMsecTime(), __FUNCTION__, value);
+            CPD_LOG(CPD_LOG_ID_TXT, "\r\n  CPD_MSG_TYPE_RING_REQ, %d", value);
+            if ((cpdGpsCommSendControl(pCpd, CPD_MSG_TYPE_RING_RESP, value) > CPD_NOK) && (value == CPD_OK)) {
+                cpdGpsRingEnable(pCpd);
+            }
+            break;
+        case CPD_MSG_TYPE_RING_RESP:
+            LOGD("%u: %s(CPD_MSG_TYPE_RING_RESP)=%d", getMsecTime(), __FUNCTION__, value);
+            CPD_LOG(CPD_LOG_ID_TXT, "\r\n  CPD_MSG_TYPE_RING_RESP, %d", value);
+            if (value == CPD_OK) {
+                cpdGpsRingEnable(pCpd);
+            }
+            else {
+                cpdGpsRingClose(pCpd);
+            }
+            break;
+        case CPD_MSG_TYPE_AIDING_RESEND:
+            /* GPS side didn't have ephemeris which was left out */
+            LOGE("%u: %s(CPD_MSG_TYPE_AIDING_RESEND)=%d", getMsecTime(), __FUNCTION__, value);
+            CPD_LOG(CPD_LOG_ID_TXT, "\r\n  CPD_MSG_TYPE_AIDING_RESEND, %d", value);
+            cpdAidingReset(pCpd);
+            cpdAssistStorePush(pCpd);
             break;
         case CPD_MSG_TYPE_QUERRY:
             LOGD("%u: %s(CPD_MSG_TYPE_QUERRY)", getMsecTime(), __FUNCTION__);
-            CPD_LOG(CPD_LOG_ID_TXT , "\r\n  CPD_MSG_TYPE_QUERRY , %d, %d, %d\n", pGpsComm->rxBufferMessageType, pGpsComm->rxBufferCmdDataStart, pGpsComm->rxBufferCmdDataSize);
+            CPD_LOG(CPD_LOG_ID_TXT , "\r\n  CPD_MSG_TYPE_QUERRY , %d, %d\n", type, dataSize);
             break;
         default:
             LOGD("%u: %s(DEFAULT)", getMsecTime(), __FUNCTION__);
-            CPD_LOG(CPD_LOG_ID_TXT , "\r\n  CPD_MSG_TYPE_QUERRY, %d, %d, %d\n", pGpsComm->rxBufferMessageType, pGpsComm->rxBufferCmdDataStart, pGpsComm->rxBufferCmdDataSize);
+            CPD_LOG(CPD_LOG_ID_TXT , "\r\n  CPD_MSG_TYPE_QUERRY, %d, %d\n", type, dataSize);
             break;
     }
+    LOGD("%u: %s()=%d", getMsecTime(), __FUNCTION__, result);
+    return result;
+}
+
+/*
+ * Handle message found in receive buffer and skip it, buffer is compacted by cpdGpsCommMsgReader().
+ */
+int cpdGpsCommHandlePacket(pCPD_CONTEXT pCpd)
+{
+    int result;
+    int type;
+    pGPS_COMM_BUFFER pGpsComm;
+
+    pGpsComm = &(pCpd->gpsCommBuffer);
+    type = pGpsComm->rxBufferMessageType;
+    if (type < CPD_MSG_TYPE_FRAMING_REQ) {
+        /* one at a time with messages from ring, control messages open and close the ring */
+        pthread_mutex_lock(&(pCpd->gpsRing.dispatchLock));
+    }
+    result = cpdGpsCommHandleMessage(pCpd, type,
+                                     &(pGpsComm->pRxBuffer[pGpsComm->rxBufferCmdDataStart]),
+                                     pGpsComm->rxBufferCmdDataSize);
+    if (type < CPD_MSG_TYPE_FRAMING_REQ) {
+        pthread_mutex_unlock(&(pCpd->gpsRing.dispatchLock));
+    }
 
-    pGpsComm->rxBufferCmdEnd =  pGpsComm->rxBufferCmdEnd + strlen(CPD_MSG_TAIL);
-    memmove(pGpsComm->pRxBuffer, &(pGpsComm->pRxBuffer[pGpsComm->rxBufferCmdEnd]), pGpsComm->rxBufferIndex - pGpsComm->rxBufferCmdEnd);
-    pGpsComm->rxBufferIndex = pGpsComm->rxBufferIndex - pGpsComm->rxBufferCmdEnd;
+    pGpsComm->rxBufferStart = pGpsComm->rxBufferCmdNext;
+    if (pGpsComm->rxBufferStart >= pGpsComm->rxBufferIndex) {
+        pGpsComm->rxBufferStart = 0;
+        pGpsComm->rxBufferIndex = 0;
+    }
+    pGpsComm->rxBufferCmdNext = CPD_ERROR;
     pGpsComm->rxBufferCmdEnd = CPD_ERROR;
     pGpsComm->rxBufferCmdStart = CPD_ERROR;
     pGpsComm->rxBufferCmdDataSize = CPD_ERROR;
     pGpsComm->rxBufferCmdDataStart = CPD_ERROR;
     pGpsComm->rxBufferMessageType = CPD_ERROR;
-    LOGD("%u: %s()=%d", getMsecTime(), __FUNCTION__, result);
     return result;
 }
 
@@ -360,8 +553,9 @@ int cpdGpsCommHandlePacket(pCPD_CONTEXT pCpd)
 /*
  * Message parsing.
  * Data is received by socket thread, which calls this function with new data blocks.
- * Function assembled received blocks (parts of message), strips-out all non-related data and
- * generates real CP/GPS message structures.
+ * Blocks can carry any part of a message or many messages: every complete message is handled as soon as
+ * its last byte arrives, bytes of the message not complete yet stay in the buffer for the next block.
+ * Handled bytes are removed once per copied block, not after every message.
  */
 int cpdGpsCommMsgReader(void * pArg, char *pB, int len, int index)
 {
@@ -370,9 +564,8 @@ int cpdGpsCommMsgReader(void * pArg, char *pB, int len, int index)
     pGPS_COMM_BUFFER pGpsComm;
     int copySize;
     int remaining;
+    unsigned int nHandled = 0;
 
-    LOGD("%u: %s()", getMsecTime(), __FUNCTION__);
-    CPD_LOG(CPD_LOG_ID_TXT, "\n%u: %s(%d)\n", getMsecTime(), __FUNCTION__, len);
     pCpd = cpdGetContext();
     if (pCpd == NULL) {
         return result;
@@ -381,27 +574,38 @@ int cpdGpsCommMsgReader(void * pArg, char *pB, int len, int index)
     if (pGpsComm->rxBufferSize <= 0) {
         return result;
     }
-    if (pGpsComm->rxBufferIndex >= pGpsComm->rxBufferSize) {
-        pGpsComm->rxBufferIndex = 0;
-        memset(pGpsComm->pRxBuffer, 0, pGpsComm->rxBufferSize);
-    }
+    pGpsComm->scGpsIndex = index;
+    pGpsComm->nRxReads++;
     remaining = len;
     while (remaining > 0) {
-        copySize = pGpsComm->rxBufferSize - pGpsComm->rxBufferIndex - 1;
+        if (pGpsComm->rxBufferStart > 0) {
+            memmove(pGpsComm->pRxBuffer, &(pGpsComm->pRxBuffer[pGpsComm->rxBufferStart]),
+                    pGpsComm->rxBufferIndex - pGpsComm->rxBufferStart);
+            pGpsComm->rxBufferIndex = pGpsComm->rxBufferIndex - pGpsComm->rxBufferStart;
+            pGpsComm->rxBufferStart = 0;
+        }
+        copySize = pGpsComm->rxBufferSize - pGpsComm->rxBufferIndex;
         if (copySize <= 0) {
-            break;
+            /* not expected, message longer than buffer is refused by its header: resync on the next byte */
+            pGpsComm->nResync++;
+            cpdGpsMsgDrop(pGpsComm, 1);
+            continue;
         }
-        if (copySize >= len) {
-            copySize = len;
+        if (copySize > remaining) {
+            copySize = remaining;
         }
-        memcpy(&(pGpsComm->pRxBuffer[pGpsComm->rxBufferIndex]), pB, copySize);
+        memcpy(&(pGpsComm->pRxBuffer[pGpsComm->rxBufferIndex]), &(pB[len - remaining]), copySize);
         pGpsComm->rxBufferIndex =  pGpsComm->rxBufferIndex + copySize;
         remaining = remaining - copySize;
-        if (cpdGpsMsgFindHeadTail(pGpsComm) == CPD_OK) {
+        while (cpdGpsMsgFindHeadTail(pGpsComm) == CPD_OK) {
             result = result + cpdGpsCommHandlePacket(pCpd);
+            nHandled++;
         }
     }
-    CPD_LOG(CPD_LOG_ID_TXT, "\n%u: %s(%d) = %d\n", getMsecTime(), __FUNCTION__, len, result);
+    if (nHandled > pGpsComm->maxRxPerRead) {
+        pGpsComm->maxRxPerRead = nHandled;
+    }
+    CPD_LOG(CPD_LOG_ID_TXT, "\n%u: %s(%d) = %d, %u messages\n", getMsecTime(), __FUNCTION__, len, result, nHandled);
     LOGD("%u: %s(%d)=%d", getMsecTime(), __FUNCTION__, len, result);
     return result;
 }
@@ -409,10 +613,74 @@ int cpdGpsCommMsgReader(void * pArg, char *pB, int len, int index)
 
 /*
  * Message format:
- * <CPD_MSG_HEAGER_xx><CPD_MSG_TYPE_E><int length><data><CPD_MSG_TAIL>
+ * CPD_MSG_FRAMING_TEXT: <CPD_MSG_HEAGER_xx><CPD_MSG_TYPE_E><int length><data><CPD_MSG_TAIL>
+ * CPD_MSG_FRAMING_V2: <CPD_MSG2_HEADER><data>
  * length is length of data part of the message, all other pars have fixed length.
  */
 
+/*
+ * Put header in front of <dataSize> bytes of data at <pB> + CPD_MSG_HEAD_SIZE, in the framing agreed with the
+ * other side. <pB> has room for CPD_MSG_HEAD_SIZE + <dataSize> + tail. Returns length of the message.
+ */
+int cpdGpsMsgFrame(pGPS_COMM_BUFFER pGpsComm, char *pB, const char *pHeader, int type, int dataSize)
+{
+    CPD_MSG2_HEADER h;
+    int len = CPD_MSG_HEAD_SIZE + dataSize;
+    int *pI;
+
+    if (pGpsComm->txFraming == CPD_MSG_FRAMING_V2) {
+        h.magic = CPD_MSG2_MAGIC;
+        h.version = CPD_MSG2_VERSION;
+        h.type = (unsigned short) type;
+        h.length = (unsigned int) dataSize;
+        h.crc = cpdCrc32c(cpdCrc32c(0, &h, offsetof(CPD_MSG2_HEADER, crc)), &(pB[CPD_MSG_HEAD_SIZE]), dataSize);
+        memcpy(pB, &h, sizeof(h));
+        return len;
+    }
+    memcpy(pB, pHeader, strlen(pHeader));
+    pI = (int *) &(pB[strlen(pHeader)]);
+    *pI = type;
+    pI++;
+    *pI = dataSize;
+    memcpy(&(pB[len]), CPD_MSG_TAIL, strlen(CPD_MSG_TAIL));
+    return len + strlen(CPD_MSG_TAIL);
+}
+
+/*
+ * Send control message with one int: offer from CPDD (_REQ) or answer from GPS (_RESP), always through socket.
+ */
+static int cpdGpsCommSendControl(pCPD_CONTEXT pCpd, int type, int value)
+{
+    int result;
+    char pB[CPD_MSG_HEAD_SIZE + sizeof(int) + 16];
+    int len;
+
+    memcpy(&(pB[CPD_MSG_HEAD_SIZE]), &value, sizeof(int));
+    if ((type == CPD_MSG_TYPE_FRAMING_REQ) || (type == CPD_MSG_TYPE_RING_REQ)) {
+        len = cpdGpsMsgFrame(&(pCpd->gpsCommBuffer), pB, CPD_MSG_HEADER_TO_GPS, type, sizeof(int));
+        result = cpdSocketWrite(&(pCpd->scGps.clients[0]), pB, len);
+    }
+    else {
+        len = cpdGpsMsgFrame(&(pCpd->gpsCommBuffer), pB, CPD_MSG_HEADER_FROM_GPS, type, sizeof(int));
+        result = cpdSocketWriteToAll(&(pCpd->scGps), pB, len);
+    }
+    CPD_LOG(CPD_LOG_ID_TXT, "\r\n %u, %s(%d, %d) = %d", getMsecTime(), __FUNCTION__, type, value, result);
+    LOGD("%u: %s(%d, %d)=%d", getMsecTime(), __FUNCTION__, type, value, result);
+    return result;
+}
+
+/*
+ * Socket to GPS was (re)opened: send text messages with raw structures until GPS agrees on binary framing
+ * and encoded data. GPS library which doesn't know the offer ignores it.
+ */
+int cpdGpsCommNegotiate(pCPD_CONTEXT pCpd)
+{
+    pCpd->gpsCommBuffer.txFraming = CPD_MSG_FRAMING_TEXT;
+    pCpd->gpsCommBuffer.txPacked = CPD_NOK;
+    pCpd->gpsCommBuffer.txMirrored = CPD_NOK;
+    return cpdGpsCommSendControl(pCpd, CPD_MSG_TYPE_FRAMING_REQ,
+            CPD_MSG_FRAMING_V2 | CPD_MSG_PAYLOAD_PACKED | CPD_MSG_PAYLOAD_MIRROR);
+}
 
 /*
  * Create data packet with GPS abort request and send it to GPS.
@@ -421,27 +689,20 @@ int cpdFormatAndSendMsg_MeasAbort(pCPD_CONTEXT pCpd)
 {
     int result = CPD_ERROR;
     char pB[80];
-    char *pC;
     int len;
-    int *pI;
     pSOCKET_CLIENT pSc;
 
     LOGD("%u: %s()", getMsecTime(), __FUNCTION__);
     CPD_LOG(CPD_LOG_ID_TXT, "\n%u: %s()\n", getMsecTime(), __FUNCTION__);
 
+    if (cpdGpsRingReserve(pCpd, CPD_MSG_TYPE_MEAS_ABORT_REQ, 0) != NULL) {
+        cpdGpsRingCommit(pCpd, 0);
+        LOGD("%u: %s(), ring", getMsecTime(), __FUNCTION__);
+        return CPD_OK;
+    }
     memset(pB, 0, 64);
-    snprintf(pB, 64, "%s", CPD_MSG_HEADER_TO_GPS);
-    len = strlen(pB);
-    pI = (int *) &(pB[len]);
-    *pI = (int) CPD_MSG_TYPE_MEAS_ABORT_REQ;
-    pI++;
-    *pI = 0;  /* no data for this message */
-    pI++;
-    pC = (char*) pI;
-    len = strlen(CPD_MSG_TAIL);
-    strncpy(pC, CPD_MSG_TAIL, len);
-    pC = pC + len;
-    len  = (int) (pC - pB);
+    /* no data for this message */
+    len = cpdGpsMsgFrame(&(pCpd->gpsCommBuffer), pB, CPD_MSG_HEADER_TO_GPS, CPD_MSG_TYPE_MEAS_ABORT_REQ, 0);
 
     pSc = &(pCpd->scGps.clients[0]);
     result = cpdSocketWrite(pSc, pB, len);
@@ -459,12 +720,12 @@ int cpdFormatAndSendMsg_MeasAbort(pCPD_CONTEXT pCpd)
 }
 
 
-int isCpdSessionActive(pCPD_CONTEXT pCpd)
+int cpdRequestIsActive(pREQUEST_PARAMS pRequest)
 {
     int result = CPD_NOK;
-    if ((pCpd->request.posMeas.flag == POS_MEAS_RRC) || (pCpd->request.posMeas.flag == POS_MEAS_RRLP)) {
-        if ((pCpd->request.status.requestReceivedAt > 0) && (pCpd->request.flag == REQUEST_FLAG_POS_MEAS)) {
-            if (pCpd->request.status.requestReceivedAt > pCpd->request.status.stopSentToGpsAt)
+    if ((pRequest->posMeas.flag == POS_MEAS_RRC) || (pRequest->posMeas.flag == POS_MEAS_RRLP)) {
+        if ((pRequest->status.requestReceivedAt > 0) && (pRequest->flag == REQUEST_FLAG_POS_MEAS)) {
+            if (pRequest->status.requestReceivedAt > pRequest->status.stopSentToGpsAt)
             {
                 result = CPD_OK;
             }
@@ -473,60 +734,75 @@ int isCpdSessionActive(pCPD_CONTEXT pCpd)
     return result;
 }
 
+int isCpdSessionActive(pCPD_CONTEXT pCpd)
+{
+    return cpdRequestIsActive(&(pCpd->request));
+}
+
 
 /*
 Check if number of responses sent so far is sufficient to fulfill request.
 In the case where periodic updates are requested, return COD_NOK - requests are fulfiled only when requesting side stops the request
 */
-int cpdIsNumberOfResponsesSufficientForRequest(pCPD_CONTEXT pCpd)
+int cpdRequestIsFulfilled(pREQUEST_PARAMS pRequest)
 {
     int result = CPD_OK;
-    if (pCpd->request.posMeas.flag == POS_MEAS_RRC) {
-        if (pCpd->request.posMeas.posMeas_u.rrc_meas.rep_crit.period_rep_crit.rep_amount == 0){
+    if (pRequest->posMeas.flag == POS_MEAS_RRC) {
+        if (pRequest->posMeas.posMeas_u.rrc_meas.rep_crit.period_rep_crit.rep_amount == 0){
             result = CPD_NOK;
         }
-        else if ((unsigned int) (pCpd->request.posMeas.posMeas_u.rrc_meas.rep_crit.period_rep_crit.rep_amount) > pCpd->request.status.nResponsesSent) {
+        else if ((unsigned int) (pRequest->posMeas.posMeas_u.rrc_meas.rep_crit.period_rep_crit.rep_amount) > pRequest->status.nResponsesSent) {
             result = CPD_NOK;
         }
     }
-    else if (pCpd->request.posMeas.flag == POS_MEAS_RRLP) {
-        if (pCpd->request.posMeas.posMeas_u.rrlp_meas.mult_sets == MULT_SETS_MULTIPLE) {
+    else if (pRequest->posMeas.flag == POS_MEAS_RRLP) {
+        if (pRequest->posMeas.posMeas_u.rrlp_meas.mult_sets == MULT_SETS_MULTIPLE) {
             result = CPD_NOK;
         }
-        else if (pCpd->request.status.nResponsesSent < 1) {
+        else if (pRequest->status.nResponsesSent < 1) {
             result = CPD_NOK;
         }
     }
     return result;
 }
 
+int cpdIsNumberOfResponsesSufficientForRequest(pCPD_CONTEXT pCpd)
+{
+    return cpdRequestIsFulfilled(&(pCpd->request));
+}
+
 /*
  Return number of seconds allowed to fulfil request = initial time + number of positions (at 1/s)
  */
-int cpdCalcRequredTimneToServiceRequest(pCPD_CONTEXT pCpd)
+int cpdRequestTimeRequired(pREQUEST_PARAMS pRequest)
 {
     int result = -1; /* infinite time */
-    if (pCpd->request.posMeas.flag == POS_MEAS_RRC) {
-        if (pCpd->request.posMeas.posMeas_u.rrc_meas.rep_crit.period_rep_crit.rep_amount == 0){
+    if (pRequest->posMeas.flag == POS_MEAS_RRC) {
+        if (pRequest->posMeas.posMeas_u.rrc_meas.rep_crit.period_rep_crit.rep_amount == 0){
             result = -1; /* infinite time - run until canceled */
         }
         else {
-            result = pCpd->request.posMeas.posMeas_u.rrc_meas.rep_crit.period_rep_crit.rep_amount *
-                    pCpd->request.posMeas.posMeas_u.rrc_meas.rep_crit.period_rep_crit.rep_interval_long +
-                    pCpd->request.posMeas.posMeas_u.rrc_meas.rep_crit.period_rep_crit.rep_interval_long;
+            result = pRequest->posMeas.posMeas_u.rrc_meas.rep_crit.period_rep_crit.rep_amount *
+                    pRequest->posMeas.posMeas_u.rrc_meas.rep_crit.period_rep_crit.rep_interval_long +
+                    pRequest->posMeas.posMeas_u.rrc_meas.rep_crit.period_rep_crit.rep_interval_long;
         }
     }
-    else if (pCpd->request.posMeas.flag == POS_MEAS_RRLP) {
-        if (pCpd->request.posMeas.posMeas_u.rrlp_meas.mult_sets == MULT_SETS_MULTIPLE) {
+    else if (pRequest->posMeas.flag == POS_MEAS_RRLP) {
+        if (pRequest->posMeas.posMeas_u.rrlp_meas.mult_sets == MULT_SETS_MULTIPLE) {
             result = -1; /* infinite time - run until canceled */
         }
-        else if (pCpd->request.status.nResponsesSent < 1) {
-            result = pCpd->request.posMeas.posMeas_u.rrlp_meas.resp_time_seconds + 1;
+        else if (pRequest->status.nResponsesSent < 1) {
+            result = pRequest->posMeas.posMeas_u.rrlp_meas.resp_time_seconds + 1;
         }
     }
     return result;
 }
 
+int cpdCalcRequredTimneToServiceRequest(pCPD_CONTEXT pCpd)
+{
+    return cpdRequestTimeRequired(&(pCpd->request));
+}
+
 
 /*
   Function is aclled when response is sent to modem and modem acqs the message with OK.
@@ -546,7 +822,6 @@ int cpdSendAbortToGps(pCPD_CONTEXT pCpd)
         result = CPD_OK;
         pCpd->request.dbgStats.posAbortId++;
         pCpd->systemMonitor.processingRequest = CPD_NOK;
-        pCpd->activeMonitor.processingRequest = CPD_NOK;
         pCpd->request.status.stopSentToGpsAt = getMsecTime();
     }
     LOGD("%u: %s()=%d, %u", getMsecTime(), __FUNCTION__, result, pCpd->request.status.stopSentToGpsAt);
@@ -559,47 +834,115 @@ int cpdSendAbortToGps(pCPD_CONTEXT pCpd)
  * Create data packet with the request & aiding info and send it to GPS.
  */
 int cpdFormatAndSendMsgToGps(pCPD_CONTEXT pCpd)
+{
+    return cpdFormatAndSendRequestToGps(pCpd, &(pCpd->request));
+}
+
+/*
+ * Put request at <pC>, packed if GPS accepts it. Returns size of data put or CPD_ERROR.
+ * Ephemeris GPS already has is left out of the copy only when GPS side agreed to keep the mirror,
+ * caller's request stays complete. SVs whose ephemeris is put are set in <pSending>, they are marked
+ * sent by caller once the request is written.
+ */
+static int cpdGpsCommPutRequest(pCPD_CONTEXT pCpd, pREQUEST_PARAMS pRequest, char *pC, int size,
+                                unsigned long long *pSending)
+{
+    REQUEST_PARAMS request;
+
+    *pSending = 0;
+    if (pCpd->gpsCommBuffer.txPacked != CPD_OK) {
+        memcpy(pC, pRequest, sizeof(REQUEST_PARAMS));
+        if (pCpd->gpsCommBuffer.txMirrored == CPD_OK) {
+            cpdAidingStrip(pCpd, &(((pREQUEST_PARAMS) pC)->assist_data), pSending);
+        }
+        return sizeof(REQUEST_PARAMS);
+    }
+    memcpy(&request, pRequest, sizeof(REQUEST_PARAMS));
+    if (pCpd->gpsCommBuffer.txMirrored == CPD_OK) {
+        cpdAidingStrip(pCpd, &(request.assist_data), pSending);
+    }
+    return cpdGpsWireEncode(pCpd, GPS_WIRE_REQUEST, &request, pC, size);
+}
+
+/*
+ * Create data packet with <pRequest> and send it to GPS.
+ */
+int cpdFormatAndSendRequestToGps(pCPD_CONTEXT pCpd, pREQUEST_PARAMS pRequest)
 {
     int result = CPD_NOK;
     char *pB = NULL;
     char *pC;
     int pBSize;
+    int size;
     int len;
-    int *pI;
+    unsigned long long sending;
     pSOCKET_CLIENT pSc;
 
-    pBSize = strlen(CPD_MSG_HEADER_TO_GPS) + strlen(CPD_MSG_TAIL) + sizeof(REQUEST_PARAMS) + 128;
+    pRequest->version = CPD_MSG_VERSION;
+    size = sizeof(REQUEST_PARAMS);
+    if (pCpd->gpsCommBuffer.txPacked == CPD_OK) {
+        size = cpdGpsWireMaxSize(GPS_WIRE_REQUEST);
+    }
+    pC = cpdGpsRingReserve(pCpd, CPD_MSG_TYPE_POS_MEAS_REQ, size);
+    if (pC != NULL) {
+        /* built in place, GPS handles it straight from the ring */
+        len = cpdGpsCommPutRequest(pCpd, pRequest, pC, size, &sending);
+        if (len > 0) {
+            cpdGpsRingCommit(pCpd, len);
+            cpdAidingSent(pCpd, &(pRequest->assist_data), sending);
+        }
+        else {
+            cpdGpsRingAbort(pCpd);
+            cpdAidingReset(pCpd);
+        }
+        LOGD("%u: %s(), ring, %d bytes", getMsecTime(), __FUNCTION__, len);
+        return len;
+    }
+    pBSize = CPD_MSG_HEAD_SIZE + strlen(CPD_MSG_TAIL) + size + 128;
     pB = malloc(pBSize);
     if (pB == NULL) {
+        cpdAidingReset(pCpd);
         return result;
     }
-    pCpd->request.version = CPD_MSG_VERSION;
     memset(pB, 0, pBSize);
 
-    snprintf(pB, pBSize, "%s", CPD_MSG_HEADER_TO_GPS);
-    len = strlen(pB);
-    pI = (int *) &(pB[len]);
-    *pI = (int) CPD_MSG_TYPE_POS_MEAS_REQ;
-    pI++;
-    *pI = sizeof(REQUEST_PARAMS);  /* size of the structure */
-    pI++;
-    pC = (char*) pI;
-    memcpy(pC, &(pCpd->request),sizeof(REQUEST_PARAMS));
-    pC = pC + sizeof(REQUEST_PARAMS);
-    len = strlen(CPD_MSG_TAIL);
-    strncpy(pC, CPD_MSG_TAIL, len);
-    pC = pC + len;
-    len  = (int) (pC - pB);
+    pC = &(pB[CPD_MSG_HEAD_SIZE]);
+    len = cpdGpsCommPutRequest(pCpd, pRequest, pC, size, &sending);
+    if (len <= 0) {
+        cpdAidingReset(pCpd);
+        free((void *) pB);
+        return CPD_ERROR;
+    }
+    len = cpdGpsMsgFrame(&(pCpd->gpsCommBuffer), pB, CPD_MSG_HEADER_TO_GPS, CPD_MSG_TYPE_POS_MEAS_REQ, len);
 
 
     pSc = &(pCpd->scGps.clients[0]);
     result = cpdSocketWrite(pSc, pB, len);
+    if (result > CPD_NOK) {
+        cpdAidingSent(pCpd, &(pRequest->assist_data), sending);
+    }
+    else {
+        /* GPS may have received part of it, its mirror is not known */
+        cpdAidingReset(pCpd);
+    }
     CPD_LOG(CPD_LOG_ID_TXT | CPD_LOG_ID_CONSOLE, "\r\n %u, %s([%s]) = %d = %d", getMsecTime(), __FUNCTION__, CPD_MSG_HEADER_TO_GPS, len, result);
     LOGD("%u: %s()=%d", getMsecTime(), __FUNCTION__, result);
     free((void *) pB);
     return result;
 }
 
+/*
+ * Put pCpd->response at <pB>, packed if CPDD accepts it. Returns size of data put or CPD_ERROR.
+ */
+static int cpdGpsCommPutResponse(pCPD_CONTEXT pCpd, char *pB, int size)
+{
+    if (pCpd->gpsCommBuffer.txPacked != CPD_OK) {
+        memcpy(pB, &(pCpd->response), sizeof(RESPONSE_PARAMS));
+        return sizeof(RESPONSE_PARAMS);
+    }
+    return cpdGpsWireEncode(pCpd, GPS_WIRE_RESPONSE, &(pCpd->response), pB, size);
+}
+
 /*
  * Create data packet from GPS measurements and send it to CPD.
  */
@@ -607,34 +950,41 @@ int cpdFormatAndSendMsgToCpd(pCPD_CONTEXT pCpd)
 {
     int result = CPD_NOK;
     char *pB = NULL;
-    char *pC;
     int pBSize;
+    int size;
     int len;
-    int *pI;
     pSOCKET_SERVER pSs;
 
-    pBSize = strlen(CPD_MSG_HEADER_FROM_GPS) + strlen(CPD_MSG_TAIL) + sizeof(RESPONSE_PARAMS) + 128;
+    pCpd->response.version = CPD_MSG_VERSION;
+    size = sizeof(RESPONSE_PARAMS);
+    if (pCpd->gpsCommBuffer.txPacked == CPD_OK) {
+        size = cpdGpsWireMaxSize(GPS_WIRE_RESPONSE);
+    }
+    pB = cpdGpsRingReserve(pCpd, CPD_MSG_TYPE_POS_MEAS_RESP, size);
+    if (pB != NULL) {
+        len = cpdGpsCommPutResponse(pCpd, pB, size);
+        if (len > 0) {
+            cpdGpsRingCommit(pCpd, len);
+        }
+        else {
+            cpdGpsRingAbort(pCpd);
+        }
+        LOGD("%u: %s(), ring, %d bytes", getMsecTime(), __FUNCTION__, len);
+        return (len > 0) ? CPD_OK : CPD_ERROR;
+    }
+    pBSize = CPD_MSG_HEAD_SIZE + strlen(CPD_MSG_TAIL) + size + 128;
     pB = malloc(pBSize);
     if (pB == NULL) {
         return result;
     }
-    pCpd->response.version = CPD_MSG_VERSION;
 
     memset(pB, 0, pBSize);
-    snprintf(pB, pBSize, "%s", CPD_MSG_HEADER_FROM_GPS);
-    len = strlen(pB);
-    pI = (int *) &(pB[len]);
-    *pI = (int) CPD_MSG_TYPE_POS_MEAS_RESP;
-    pI++;
-    *pI = sizeof(RESPONSE_PARAMS);  /* size of the structure */
-    pI++;
-    pC = (char*) pI;
-    memcpy(pC, &(pCpd->response), sizeof(RESPONSE_PARAMS));
-    pC = pC + sizeof(RESPONSE_PARAMS);
-    len = strlen(CPD_MSG_TAIL);
-    strncpy(pC, CPD_MSG_TAIL, len);
-    pC = pC + len;
-    len  = (int) (pC - pB);
+    len = cpdGpsCommPutResponse(pCpd, &(pB[CPD_MSG_HEAD_SIZE]), size);
+    if (len <= 0) {
+        free((void *) pB);
+        return CPD_ERROR;
+    }
+    len = cpdGpsMsgFrame(&(pCpd->gpsCommBuffer), pB, CPD_MSG_HEADER_FROM_GPS, CPD_MSG_TYPE_POS_MEAS_RESP, len);
 
     pSs = &(pCpd->scGps);
     result = cpdSocketWriteToAll(pSs, pB, len);
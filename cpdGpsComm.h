@@ -16,22 +16,52 @@
 #define CPD_MSG_HEADER_FROM_GPS     "\r\nGTCP\r\n"
 #define CPD_MSG_TAIL                "\r\nEOM\r\n"
 
+/*
+ * Binary framing, CPD_MSG_FRAMING_V2: <CPD_MSG2_HEADER><data>, no tail.
+ * Both framings have 16 byte header, data of a message being formatted is always at CPD_MSG_HEAD_SIZE.
+ */
+#define CPD_MSG2_MAGIC              (0x324750C9U)   /* 0xC9 'P' 'G' '2' in memory */
+#define CPD_MSG2_MAGIC_FIRST        ((char) 0xC9)
+#define CPD_MSG2_VERSION            (2)
+#define CPD_MSG_HEAD_SIZE           (16)
+
+typedef struct {
+    unsigned int    magic;
+    unsigned short  version;
+    unsigned short  type;           /* CPD_MSG_TYPE_E */
+    unsigned int    length;         /* of data */
+    unsigned int    crc;            /* CRC32C of magic, version, type, length and data */
+} CPD_MSG2_HEADER, *pCPD_MSG2_HEADER;
+
 typedef enum {
     CPD_MSG_TYPE_NONE,
     CPD_MSG_TYPE_QUERRY,
     CPD_MSG_TYPE_MEAS_ABORT_REQ,
     CPD_MSG_TYPE_POS_MEAS_REQ,
-    CPD_MSG_TYPE_POS_MEAS_RESP
+    CPD_MSG_TYPE_POS_MEAS_RESP,
+    CPD_MSG_TYPE_FRAMING_REQ,       /* data: int, highest CPD_MSG_FRAMING_xx CPDD can send and receive */
+    CPD_MSG_TYPE_FRAMING_RESP,      /* data: int, CPD_MSG_FRAMING_xx used from now on */
+    CPD_MSG_TYPE_RING_REQ,          /* data: int, GPS_RING_VERSION, memfd and doorbells passed with it */
+    CPD_MSG_TYPE_RING_RESP,         /* data: int, CPD_OK when GPS mapped the rings */
+    CPD_MSG_TYPE_AIDING_RESEND      /* data: int, left out ephemeris GPS side doesn't have, CPDD sends all again */
 } CPD_MSG_TYPE_E;
 
 
 int cpdGpsCommMsgReader(void * , char *, int , int );
+int cpdGpsCommHandleMessage(pCPD_CONTEXT , int , char *, int );
+int cpdGpsMsgFindHeadTail(pGPS_COMM_BUFFER );
+int cpdGpsMsgFrame(pGPS_COMM_BUFFER , char *, const char *, int , int );
+int cpdGpsCommNegotiate(pCPD_CONTEXT );
 int cpdFormatAndSendMsg_MeasAbort(pCPD_CONTEXT );
 int cpdIsNumberOfResponsesSufficientForRequest(pCPD_CONTEXT );
 int cpdCalcRequredTimneToServiceRequest(pCPD_CONTEXT );
 int isCpdSessionActive(pCPD_CONTEXT );
+int cpdRequestIsActive(pREQUEST_PARAMS );
+int cpdRequestIsFulfilled(pREQUEST_PARAMS );
+int cpdRequestTimeRequired(pREQUEST_PARAMS );
 int cpdSendAbortToGps(pCPD_CONTEXT );
 int cpdFormatAndSendMsgToGps(pCPD_CONTEXT );
+int cpdFormatAndSendRequestToGps(pCPD_CONTEXT , pREQUEST_PARAMS );
 int cpdFormatAndSendMsgToCpd(pCPD_CONTEXT );
 int cpdSendStopToGPS(pCPD_CONTEXT );
 
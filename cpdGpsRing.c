@@ -0,0 +1,385 @@
+/*
+ * hardware/Intel/cp_daemon/cpdGpsRing.c
+ *
+ * Shared memory transport between CPDD and GPS library.
+ * CPDD creates one memfd with a single-producer single-consumer ring per direction and an eventfd doorbell
+ * for each of them, and passes all three descriptors to GPS over the already open local socket (RING_REQ).
+ * GPS maps the rings and answers with RING_RESP, from then on requests and responses are built in place in the
+ * ring and handled straight from it by the receiving ring thread. Control messages stay on the socket.
+ * Socket is used when rings can't be set up, GPS library doesn't know about them, or a ring is full.
+ *
+ * Martin Junkar 09/18/2011
+ *
+ */
+
+#include <stdio.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/eventfd.h>
+#define LOG_TAG "CPDD_GR"
+
+#include "cpd.h"
+#include "cpdUtil.h"
+#include "cpdDebug.h"
+#include "cpdSocketServer.h"
+#include "cpdGpsComm.h"
+#include "cpdGpsRing.h"
+
+#ifndef MFD_CLOEXEC
+#define MFD_CLOEXEC                 (0x0001U)
+#endif
+
+#define GPS_RING_MAP_SIZE           (2 * (sizeof(GPS_RING_HEADER) + GPS_RING_SIZE))
+#define GPS_RING_MSG_SPACE(len)     (sizeof(GPS_RING_MSG) + (((unsigned int) (len) + 7) & ~7U))
+#define GPS_RING_DATA(pHdr)         ((char *) ((pHdr) + 1))
+
+
+static int cpdGpsRingMemfd(void)
+{
+#ifdef __NR_memfd_create
+    return syscall(__NR_memfd_create, "cpdGpsRing", MFD_CLOEXEC);
+#else
+    /* kernel headers too old, socket is used */
+    errno = ENOSYS;
+    return CPD_ERROR;
+#endif
+}
+
+/*
+ * Handle all messages producer made visible, in place. Returns CPD_ERROR if ring is corrupted.
+ * Framing and ring control messages are skipped, handling them here would stop or restart this thread from itself.
+ */
+static int cpdGpsRingConsume(pCPD_CONTEXT pCpd)
+{
+    pGPS_RING pR = &(pCpd->gpsRing);
+    pGPS_RING_HEADER pHdr = pR->pRx;
+    pGPS_RING_MSG pMsg;
+    unsigned int head, tail, offset, space;
+
+    tail = pHdr->tail;
+    head = __atomic_load_n(&(pHdr->head), __ATOMIC_ACQUIRE);
+    if ((head - tail) > GPS_RING_SIZE) {
+        return CPD_ERROR;
+    }
+    while (tail != head) {
+        offset = tail & (GPS_RING_SIZE - 1);
+        if ((head - tail) < sizeof(GPS_RING_MSG)) {
+            return CPD_ERROR;
+        }
+        pMsg = (pGPS_RING_MSG) &(GPS_RING_DATA(pHdr)[offset]);
+        if (pMsg->length == GPS_RING_WRAP) {
+            tail = tail + (GPS_RING_SIZE - offset);
+            continue;
+        }
+        space = GPS_RING_MSG_SPACE(pMsg->length);
+        if ((pMsg->length > GPS_RING_SIZE) || ((offset + space) > GPS_RING_SIZE) || (space > (head - tail))) {
+            return CPD_ERROR;
+        }
+        if (pMsg->type >= CPD_MSG_TYPE_FRAMING_REQ) {
+            pR->nRejected++;
+            LOGE("%u: %s(), control message %u in ring dropped", getMsecTime(), __FUNCTION__, pMsg->type);
+        }
+        else {
+            /* counted first, handler may wake up someone waiting for this message */
+            pR->nRx++;
+            pthread_mutex_lock(&(pR->dispatchLock));
+            cpdGpsCommHandleMessage(pCpd, pMsg->type, (char *) (pMsg + 1), pMsg->length);
+            pthread_mutex_unlock(&(pR->dispatchLock));
+        }
+        tail = tail + space;
+        /* message space goes back to producer only after it was handled */
+        __atomic_store_n(&(pHdr->tail), tail, __ATOMIC_RELEASE);
+    }
+    return CPD_OK;
+}
+
+static void *cpdGpsRingRxThread(void *pArg)
+{
+    pCPD_CONTEXT pCpd = (pCPD_CONTEXT) pArg;
+    pGPS_RING pR = &(pCpd->gpsRing);
+    unsigned long long bell;
+
+    LOGV("%u: %s()", getMsecTime(), __FUNCTION__);
+    pR->rxThreadState = THREAD_STATE_RUNNING;
+    while (pR->rxThreadState == THREAD_STATE_RUNNING) {
+        if (read(pR->rxBell, &bell, sizeof(bell)) != sizeof(bell)) {
+            if ((errno != EINTR) && (errno != EAGAIN)) {
+                LOGE("%s(), doorbell read failed, %d", __FUNCTION__, errno);
+                usleep(100000);
+            }
+        }
+        if (pR->rxThreadState != THREAD_STATE_RUNNING) {
+            break;
+        }
+        if (cpdGpsRingConsume(pCpd) == CPD_ERROR) {
+            LOGE("%u: %s(), ring corrupted, %u", getMsecTime(), __FUNCTION__, pR->pRx->head);
+            CPD_LOG(CPD_LOG_ID_TXT, "\n%u: %s(), ring corrupted", getMsecTime(), __FUNCTION__);
+            break;
+        }
+    }
+    pR->rxThreadState = THREAD_STATE_TERMINATED;
+    LOGV("%u: EXIT %s()", getMsecTime(), __FUNCTION__);
+    return NULL;
+}
+
+/*
+ * Map <pFds>[0] and start receiving from ring <rxIndex>, send to the other one.
+ */
+static int cpdGpsRingMap(pCPD_CONTEXT pCpd, int rxIndex)
+{
+    pGPS_RING pR = &(pCpd->gpsRing);
+    pGPS_RING_HEADER pA, pB;
+
+    pR->pMap = mmap(NULL, GPS_RING_MAP_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, pR->fds[0], 0);
+    if (pR->pMap == MAP_FAILED) {
+        pR->pMap = NULL;
+        return CPD_ERROR;
+    }
+    pA = (pGPS_RING_HEADER) pR->pMap;
+    pB = (pGPS_RING_HEADER) &(pR->pMap[sizeof(GPS_RING_HEADER) + GPS_RING_SIZE]);
+    pR->pRx = (rxIndex == 0) ? pA : pB;
+    pR->pTx = (rxIndex == 0) ? pB : pA;
+    pR->rxBell = pR->fds[1 + rxIndex];
+    pR->txBell = pR->fds[2 - rxIndex];
+    pR->nTx = 0;
+    pR->nRx = 0;
+    pR->nFull = 0;
+    pR->nRejected = 0;
+    pR->nAborted = 0;
+    pR->rxThreadState = THREAD_STATE_STARTING;
+    if (pthread_create(&(pR->rxThread), NULL, cpdGpsRingRxThread, (void *) pCpd) != 0) {
+        pR->rxThreadState = THREAD_STATE_CANT_RUN;
+        return CPD_ERROR;
+    }
+    return CPD_OK;
+}
+
+/*
+ * CPDD: socket to GPS was (re)opened, create rings and offer them to GPS.
+ * Messages go through socket until GPS accepts.
+ */
+int cpdGpsRingOffer(pCPD_CONTEXT pCpd)
+{
+    pGPS_RING pR = &(pCpd->gpsRing);
+    pGPS_RING_HEADER pHdr;
+    char pB[CPD_MSG_HEAD_SIZE + sizeof(int) + 16];
+    int version = GPS_RING_VERSION;
+    int result = CPD_ERROR;
+    int len;
+    int i;
+
+    cpdGpsRingClose(pCpd);
+    pR->fds[0] = cpdGpsRingMemfd();
+    pR->fds[1] = eventfd(0, EFD_CLOEXEC);
+    pR->fds[2] = eventfd(0, EFD_CLOEXEC);
+    if ((pR->fds[0] >= 0) && (pR->fds[1] >= 0) && (pR->fds[2] >= 0) &&
+        (ftruncate(pR->fds[0], GPS_RING_MAP_SIZE) == 0) &&
+        (cpdGpsRingMap(pCpd, 1) == CPD_OK)) {
+        for (i = 0; i < 2; i++) {
+            pHdr = (pGPS_RING_HEADER) &(pR->pMap[i * (sizeof(GPS_RING_HEADER) + GPS_RING_SIZE)]);
+            pHdr->magic = GPS_RING_MAGIC;
+            pHdr->version = GPS_RING_VERSION;
+            pHdr->size = GPS_RING_SIZE;
+        }
+        pR->socketIndex = 0;
+        memcpy(&(pB[CPD_MSG_HEAD_SIZE]), &version, sizeof(int));
+        len = cpdGpsMsgFrame(&(pCpd->gpsCommBuffer), pB, CPD_MSG_HEADER_TO_GPS, CPD_MSG_TYPE_RING_REQ, sizeof(int));
+        result = cpdSocketWriteFds(&(pCpd->scGps.clients[0]), pB, len, pR->fds, GPS_RING_N_FDS);
+    }
+    if (result <= CPD_NOK) {
+        LOGE("%u: %s(), shared memory not available, %d", getMsecTime(), __FUNCTION__, errno);
+        cpdGpsRingClose(pCpd);
+    }
+    CPD_LOG(CPD_LOG_ID_TXT, "\n%u: %s()=%d", getMsecTime(), __FUNCTION__, result);
+    LOGD("%u: %s()=%d", getMsecTime(), __FUNCTION__, result);
+    return result;
+}
+
+/*
+ * GPS: map rings CPDD offered with <pFds> on scGps client <socketIndex>, messages are sent through them
+ * after CPDD got the answer, see cpdGpsRingEnable(). Takes ownership of the descriptors.
+ */
+int cpdGpsRingAttach(pCPD_CONTEXT pCpd, int socketIndex, int *pFds, int nFds)
+{
+    pGPS_RING pR = &(pCpd->gpsRing);
+    pGPS_RING_HEADER pHdr;
+    struct stat st;
+    int result = CPD_OK;
+    int i;
+
+    cpdGpsRingClose(pCpd);
+    for (i = 0; i < nFds; i++) {
+        if (i < GPS_RING_N_FDS) {
+            pR->fds[i] = pFds[i];
+        }
+        else {
+            close(pFds[i]);
+        }
+    }
+    if ((nFds < GPS_RING_N_FDS) || (fstat(pR->fds[0], &st) != 0) || (st.st_size < (off_t) GPS_RING_MAP_SIZE) ||
+        (cpdGpsRingMap(pCpd, 0) != CPD_OK)) {
+        result = CPD_ERROR;
+    }
+    for (i = 0; (i < 2) && (result == CPD_OK); i++) {
+        pHdr = (i == 0) ? pR->pRx : pR->pTx;
+        if ((pHdr->magic != GPS_RING_MAGIC) || (pHdr->version != GPS_RING_VERSION) || (pHdr->size != GPS_RING_SIZE)) {
+            result = CPD_ERROR;
+        }
+    }
+    if (result == CPD_OK) {
+        pthread_mutex_lock(&(pR->lock));
+        pR->socketIndex = socketIndex;
+        pthread_mutex_unlock(&(pR->lock));
+    }
+    else {
+        cpdGpsRingClose(pCpd);
+    }
+    CPD_LOG(CPD_LOG_ID_TXT, "\n%u: %s(%d)=%d", getMsecTime(), __FUNCTION__, nFds, result);
+    LOGD("%u: %s(%d)=%d", getMsecTime(), __FUNCTION__, nFds, result);
+    return result;
+}
+
+/*
+ * Both sides have the rings mapped, send through them from now on.
+ */
+void cpdGpsRingEnable(pCPD_CONTEXT pCpd)
+{
+    pGPS_RING pR = &(pCpd->gpsRing);
+
+    pthread_mutex_lock(&(pR->lock));
+    if ((pR->pMap != NULL) && (pR->socketIndex >= 0)) {
+        pR->state = CPD_OK;
+    }
+    pthread_mutex_unlock(&(pR->lock));
+    LOGD("%u: %s()=%d", getMsecTime(), __FUNCTION__, pR->state);
+}
+
+/*
+ * Stop using rings, go back to socket. Not called from message handlers, ring thread is joined.
+ */
+void cpdGpsRingClose(pCPD_CONTEXT pCpd)
+{
+    pGPS_RING pR = &(pCpd->gpsRing);
+    unsigned long long bell = 1;
+    int i;
+
+    pthread_mutex_lock(&(pR->lock));
+    pR->state = CPD_NOK;
+    pR->socketIndex = CPD_ERROR;
+    if ((pR->rxThreadState == THREAD_STATE_STARTING) || (pR->rxThreadState == THREAD_STATE_RUNNING) ||
+        (pR->rxThreadState == THREAD_STATE_TERMINATED)) {
+        if (pR->rxThreadState != THREAD_STATE_TERMINATED) {
+            pR->rxThreadState = THREAD_STATE_TERMINATE;
+        }
+        pthread_mutex_unlock(&(pR->lock));
+        /* release the thread from read() */
+        write(pR->rxBell, &bell, sizeof(bell));
+        pthread_join(pR->rxThread, NULL);
+        pthread_mutex_lock(&(pR->lock));
+    }
+    pR->rxThreadState = THREAD_STATE_OFF;
+    if (pR->pMap != NULL) {
+        CPD_LOG(CPD_LOG_ID_TXT, "\n%u: %s(), %u sent, %u received, %u sent through socket when full, %u rejected, %u aborted",
+                getMsecTime(), __FUNCTION__, pR->nTx, pR->nRx, pR->nFull, pR->nRejected, pR->nAborted);
+        LOGD("%u: %s(), %u sent, %u received, %u full, %u rejected, %u aborted", getMsecTime(), __FUNCTION__,
+                pR->nTx, pR->nRx, pR->nFull, pR->nRejected, pR->nAborted);
+        munmap(pR->pMap, GPS_RING_MAP_SIZE);
+        pR->pMap = NULL;
+    }
+    pR->pTx = NULL;
+    pR->pRx = NULL;
+    for (i = 0; i < GPS_RING_N_FDS; i++) {
+        if (pR->fds[i] >= 0) {
+            close(pR->fds[i]);
+            pR->fds[i] = CPD_ERROR;
+        }
+    }
+    pR->txBell = CPD_ERROR;
+    pR->rxBell = CPD_ERROR;
+    pthread_mutex_unlock(&(pR->lock));
+}
+
+/*
+ * Reserve room for <dataSize> bytes of message <type> in the ring to the other side.
+ * Returns where data is to be written, followed by cpdGpsRingCommit() or cpdGpsRingAbort(),
+ * or NULL when socket has to be used.
+ */
+char *cpdGpsRingReserve(pCPD_CONTEXT pCpd, int type, int dataSize)
+{
+    pGPS_RING pR = &(pCpd->gpsRing);
+    pGPS_RING_MSG pMsg;
+    unsigned int head, tail, offset, space;
+    unsigned int pad = 0;
+
+    if ((pR->state != CPD_OK) || (dataSize < 0)) {
+        return NULL;
+    }
+    space = GPS_RING_MSG_SPACE(dataSize);
+    pthread_mutex_lock(&(pR->lock));
+    if ((pR->state != CPD_OK) || (space > (GPS_RING_SIZE / 2)) ||
+        (pCpd->scGps.clients[pR->socketIndex].fd == CPD_ERROR)) {
+        /* other side is gone when its socket was closed */
+        pthread_mutex_unlock(&(pR->lock));
+        return NULL;
+    }
+    head = pR->pTx->head;
+    tail = __atomic_load_n(&(pR->pTx->tail), __ATOMIC_ACQUIRE);
+    offset = head & (GPS_RING_SIZE - 1);
+    if ((offset + space) > GPS_RING_SIZE) {
+        /* messages are contiguous, skip the end of ring */
+        pad = GPS_RING_SIZE - offset;
+    }
+    if (((head - tail) + pad + space) > GPS_RING_SIZE) {
+        pR->nFull++;
+        pthread_mutex_unlock(&(pR->lock));
+        return NULL;
+    }
+    if (pad > 0) {
+        pMsg = (pGPS_RING_MSG) &(GPS_RING_DATA(pR->pTx)[offset]);
+        pMsg->length = GPS_RING_WRAP;
+        head = head + pad;
+        offset = 0;
+    }
+    pMsg = (pGPS_RING_MSG) &(GPS_RING_DATA(pR->pTx)[offset]);
+    pMsg->length = (unsigned int) dataSize;
+    pMsg->type = (unsigned int) type;
+    pR->txHead = head;
+    return (char *) (pMsg + 1);
+}
+
+/*
+ * Make message built after cpdGpsRingReserve() visible to the other side and ring its doorbell.
+ * <dataSize> bytes were written, not more than reserved.
+ */
+void cpdGpsRingCommit(pCPD_CONTEXT pCpd, int dataSize)
+{
+    pGPS_RING pR = &(pCpd->gpsRing);
+    pGPS_RING_MSG pMsg;
+    unsigned long long bell = 1;
+
+    pMsg = (pGPS_RING_MSG) &(GPS_RING_DATA(pR->pTx)[pR->txHead & (GPS_RING_SIZE - 1)]);
+    if ((dataSize >= 0) && ((unsigned int) dataSize < pMsg->length)) {
+        pMsg->length = (unsigned int) dataSize;
+    }
+    __atomic_store_n(&(pR->pTx->head), pR->txHead + GPS_RING_MSG_SPACE(pMsg->length), __ATOMIC_RELEASE);
+    pR->nTx++;
+    write(pR->txBell, &bell, sizeof(bell));
+    pthread_mutex_unlock(&(pR->lock));
+}
+
+/*
+ * Drop message reserved by cpdGpsRingReserve(), data could not be put. Head is not moved, the other side
+ * doesn't see anything of it.
+ */
+void cpdGpsRingAbort(pCPD_CONTEXT pCpd)
+{
+    pGPS_RING pR = &(pCpd->gpsRing);
+
+    pR->nAborted++;
+    pthread_mutex_unlock(&(pR->lock));
+}
@@ -0,0 +1,21 @@
+/*
+ * hardware/Intel/cp_daemon/cpdGpsRing.h
+ *
+ * Header file for cpdGpsRing.c.
+ *
+ * Martin Junkar 09/18/2011
+ *
+ */
+
+#ifndef _CPDGPSRING_H_
+#define _CPDGPSRING_H_
+#include "cpd.h"
+
+int cpdGpsRingOffer(pCPD_CONTEXT pCpd);
+int cpdGpsRingAttach(pCPD_CONTEXT pCpd, int socketIndex, int *pFds, int nFds);
+void cpdGpsRingEnable(pCPD_CONTEXT pCpd);
+void cpdGpsRingClose(pCPD_CONTEXT pCpd);
+char *cpdGpsRingReserve(pCPD_CONTEXT pCpd, int type, int dataSize);
+void cpdGpsRingCommit(pCPD_CONTEXT pCpd, int dataSize);
+void cpdGpsRingAbort(pCPD_CONTEXT pCpd);
+#endif
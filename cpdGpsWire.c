@@ -0,0 +1,415 @@
+/*
+ * hardware/Intel/cp_daemon/cpdGpsWire.c
+ *
+ * Compact encoding of REQUEST_PARAMS and RESPONSE_PARAMS exchanged with GPS.
+ * <GPS_WIRE_MAGIC><CPD_MSG_VERSION> followed by <unsigned short tag><unsigned short length><data> for each
+ * populated field of the structure. Fields are described by tables below, built with offsetof() and sizeof()
+ * from the structure definitions in cpd.h, tag is index in the table + 1:
+ * - fixed part is sent when any of its bytes is not 0,
+ * - array is sent up to its item count,
+ * - union sends only the arm its type selects,
+ * - items a pointer points to are sent inline and point to GPS_WIRE storage on the receiving side.
+ * Everything not sent is 0 after decoding. Unknown tags are skipped, so fields can be added at the end of tables.
+ *
+ * Martin Junkar 09/18/2011
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stddef.h>
+#include <time.h>
+#include <pthread.h>
+#define LOG_TAG "CPDD_GW"
+
+#include "cpd.h"
+#include "cpdUtil.h"
+#include "cpdGpsWire.h"
+#include "cpdDebug.h"
+
+typedef enum {
+    GPS_WIRE_KIND_FIXED,
+    GPS_WIRE_KIND_ARRAY,
+    GPS_WIRE_KIND_UNION,
+    GPS_WIRE_KIND_POINTER
+} GPS_WIRE_KIND_E;
+
+typedef struct {
+    GPS_WIRE_KIND_E         kind;
+    unsigned int            offset;
+    unsigned int            size;           /* FIXED, UNION: of the field, ARRAY, POINTER: of one item */
+    unsigned int            countOffset;    /* ARRAY, POINTER: int item count, UNION: int type of the arm */
+    unsigned int            maxItems;       /* ARRAY: of the array, POINTER: of the storage */
+    int                     selectOffset;   /* POINTER: int which has to be <selectValue>, -1 for none */
+    int                     selectValue;
+    unsigned int            storeOffset;    /* POINTER: storage in GPS_WIRE */
+    const unsigned short    *pArmSizes;     /* UNION: size of each arm, by type */
+    int                     nArms;
+} GPS_WIRE_FIELD, *pGPS_WIRE_FIELD;
+
+typedef struct {
+    const char              *pName;
+    const GPS_WIRE_FIELD    *pFields;
+    int                     nFields;
+    unsigned int            size;
+} GPS_WIRE_STRUCT;
+
+#define GPS_WIRE_HEAD_SIZE              (2 * sizeof(unsigned int))
+#define GPS_WIRE_TAG_SIZE               (2 * sizeof(unsigned short))
+#define GPS_WIRE_MEMBER(t, m)           (((t *) 0)->m)
+#define GPS_WIRE_N(a)                   ((int) (sizeof(a) / sizeof((a)[0])))
+
+#define GPS_WIRE_FIXED(t, m) \
+    { GPS_WIRE_KIND_FIXED, offsetof(t, m), sizeof(GPS_WIRE_MEMBER(t, m)), 0, 0, -1, 0, 0, NULL, 0 }
+#define GPS_WIRE_ARRAY(t, m, count) \
+    { GPS_WIRE_KIND_ARRAY, offsetof(t, m), sizeof(GPS_WIRE_MEMBER(t, m)[0]), offsetof(t, count), \
+      GPS_WIRE_N(GPS_WIRE_MEMBER(t, m)), -1, 0, 0, NULL, 0 }
+#define GPS_WIRE_UNION(t, m, type, arms) \
+    { GPS_WIRE_KIND_UNION, offsetof(t, m), sizeof(GPS_WIRE_MEMBER(t, m)), offsetof(t, type), 0, -1, 0, 0, \
+      arms, GPS_WIRE_N(arms) }
+#define GPS_WIRE_POINTER(t, m, count, select, value, store) \
+    { GPS_WIRE_KIND_POINTER, offsetof(t, m), sizeof(GPS_WIRE_MEMBER(t, m)[0]), offsetof(t, count), \
+      GPS_WIRE_N(GPS_WIRE_MEMBER(GPS_WIRE, store)), select, value, offsetof(GPS_WIRE, store), NULL, 0 }
+
+static const unsigned short gpsWireShapeArms[] = {
+    0,                                  /* SHAPE_TYPE_NONE */
+    sizeof(POINT),
+    sizeof(POINT_UNCERT_CIRCLE),
+    sizeof(POINT_UNCERT_ELLIPSE),
+    sizeof(POLYGON),
+    sizeof(POINT_ALT),
+    sizeof(POINT_ALT_UNCERTELLIPSE),
+    sizeof(ARC)
+};
+
+static const unsigned short gpsWirePosMeasArms[] = {
+    0,                                  /* POS_MEAS_NONE */
+    sizeof(RRLP_MEAS),
+    sizeof(RRC_MEAS),
+    0,                                  /* POS_MEAS_ABORT */
+    0                                   /* POS_MEAS_STOP_GPS */
+};
+
+#define GPS_WIRE_GA(m)                  assist_data.GPS_assist.m
+#define GPS_WIRE_RLP(m)                 assist_data.GPS_assist.location_parameters.m
+#define GPS_WIRE_SLP(m)                 location.location_parameters.m
+
+static const GPS_WIRE_FIELD gpsWireRequest[] = {
+    GPS_WIRE_FIXED(REQUEST_PARAMS, flag),
+    GPS_WIRE_FIXED(REQUEST_PARAMS, assist_data.flag),
+    GPS_WIRE_FIXED(REQUEST_PARAMS, GPS_WIRE_GA(flag)),
+    GPS_WIRE_FIXED(REQUEST_PARAMS, GPS_WIRE_GA(status_health)),
+    GPS_WIRE_FIXED(REQUEST_PARAMS, GPS_WIRE_GA(BTS_clock_drift)),
+    GPS_WIRE_FIXED(REQUEST_PARAMS, GPS_WIRE_GA(ref_time.isSet)),
+    GPS_WIRE_FIXED(REQUEST_PARAMS, GPS_WIRE_GA(ref_time.GPS_time)),
+    GPS_WIRE_FIXED(REQUEST_PARAMS, GPS_WIRE_GA(ref_time.GSM_time)),
+    GPS_WIRE_ARRAY(REQUEST_PARAMS, GPS_WIRE_GA(ref_time.GPS_TOW_assist_arr), GPS_WIRE_GA(ref_time.GPS_TOW_assist_arr_items)),
+    GPS_WIRE_FIXED(REQUEST_PARAMS, GPS_WIRE_RLP(time)),
+    GPS_WIRE_FIXED(REQUEST_PARAMS, GPS_WIRE_RLP(direction)),
+    GPS_WIRE_FIXED(REQUEST_PARAMS, GPS_WIRE_RLP(shape_type)),
+    GPS_WIRE_UNION(REQUEST_PARAMS, GPS_WIRE_RLP(shape_data), GPS_WIRE_RLP(shape_type), gpsWireShapeArms),
+    GPS_WIRE_POINTER(REQUEST_PARAMS, GPS_WIRE_RLP(shape_data.polygon.pCoordinates), GPS_WIRE_RLP(shape_data.polygon.nItems),
+                     offsetof(REQUEST_PARAMS, GPS_WIRE_RLP(shape_type)), SHAPE_TYPE_POLYGON, requestPolygon),
+    GPS_WIRE_FIXED(REQUEST_PARAMS, GPS_WIRE_RLP(velocity_data)),
+    GPS_WIRE_FIXED(REQUEST_PARAMS, GPS_WIRE_GA(DGPS_corrections)),
+    GPS_WIRE_ARRAY(REQUEST_PARAMS, GPS_WIRE_GA(nav_model_elem_arr), GPS_WIRE_GA(nav_model_elem_arr_items)),
+    GPS_WIRE_FIXED(REQUEST_PARAMS, GPS_WIRE_GA(ionospheric_model)),
+    GPS_WIRE_FIXED(REQUEST_PARAMS, GPS_WIRE_GA(UTC_model)),
+    GPS_WIRE_FIXED(REQUEST_PARAMS, GPS_WIRE_GA(almanac.wna)),
+    GPS_WIRE_POINTER(REQUEST_PARAMS, GPS_WIRE_GA(almanac.pAlm_elem), GPS_WIRE_GA(almanac.alm_elem_nb_items),
+                     -1, 0, requestAlmElem),
+    GPS_WIRE_FIXED(REQUEST_PARAMS, GPS_WIRE_GA(acqu_assist)),
+    GPS_WIRE_FIXED(REQUEST_PARAMS, GPS_WIRE_GA(acqu_assist_nb_items)),
+    GPS_WIRE_FIXED(REQUEST_PARAMS, GPS_WIRE_GA(GPS_rt_integrity)),
+    GPS_WIRE_FIXED(REQUEST_PARAMS, assist_data.msr_assist_data),
+    GPS_WIRE_FIXED(REQUEST_PARAMS, assist_data.system_info_assist_data),
+    GPS_WIRE_FIXED(REQUEST_PARAMS, assist_data.more_assist_data),
+    GPS_WIRE_FIXED(REQUEST_PARAMS, assist_data.ext_container),
+    GPS_WIRE_FIXED(REQUEST_PARAMS, assist_data.rel98_assist_data_ext),
+    GPS_WIRE_FIXED(REQUEST_PARAMS, assist_data.rel5_assist_data_ext),
+    GPS_WIRE_FIXED(REQUEST_PARAMS, assist_data.rel7_assist_data_ext),
+    GPS_WIRE_FIXED(REQUEST_PARAMS, assist_data.nav_model_mirrored),
+    GPS_WIRE_FIXED(REQUEST_PARAMS, posMeas.flag),
+    GPS_WIRE_UNION(REQUEST_PARAMS, posMeas.posMeas_u, posMeas.flag, gpsWirePosMeasArms),
+    GPS_WIRE_FIXED(REQUEST_PARAMS, rs),
+    GPS_WIRE_FIXED(REQUEST_PARAMS, dbgStats),
+    GPS_WIRE_FIXED(REQUEST_PARAMS, status)
+};
+
+static const GPS_WIRE_FIELD gpsWireResponse[] = {
+    GPS_WIRE_FIXED(RESPONSE_PARAMS, flag),
+    GPS_WIRE_FIXED(RESPONSE_PARAMS, GPS_WIRE_SLP(time)),
+    GPS_WIRE_FIXED(RESPONSE_PARAMS, GPS_WIRE_SLP(direction)),
+    GPS_WIRE_FIXED(RESPONSE_PARAMS, GPS_WIRE_SLP(shape_type)),
+    GPS_WIRE_UNION(RESPONSE_PARAMS, GPS_WIRE_SLP(shape_data), GPS_WIRE_SLP(shape_type), gpsWireShapeArms),
+    GPS_WIRE_POINTER(RESPONSE_PARAMS, GPS_WIRE_SLP(shape_data.polygon.pCoordinates), GPS_WIRE_SLP(shape_data.polygon.nItems),
+                     offsetof(RESPONSE_PARAMS, GPS_WIRE_SLP(shape_type)), SHAPE_TYPE_POLYGON, responsePolygon),
+    GPS_WIRE_FIXED(RESPONSE_PARAMS, GPS_WIRE_SLP(velocity_data)),
+    GPS_WIRE_FIXED(RESPONSE_PARAMS, location.time_of_fix),
+    GPS_WIRE_FIXED(RESPONSE_PARAMS, GPS_meas.tow_msec),
+    GPS_WIRE_ARRAY(RESPONSE_PARAMS, GPS_meas.meas_params_arr, GPS_meas.meas_params_arr_items),
+    GPS_WIRE_FIXED(RESPONSE_PARAMS, GPS_assist_req),
+    GPS_WIRE_FIXED(RESPONSE_PARAMS, pos_err),
+    GPS_WIRE_FIXED(RESPONSE_PARAMS, dbgStats)
+};
+
+static const GPS_WIRE_STRUCT gpsWireStructs[] = {
+    { "request", gpsWireRequest, GPS_WIRE_N(gpsWireRequest), sizeof(REQUEST_PARAMS) },
+    { "response", gpsWireResponse, GPS_WIRE_N(gpsWireResponse), sizeof(RESPONSE_PARAMS) }
+};
+
+
+static int cpdGpsWireGetInt(const char *pBase, unsigned int offset)
+{
+    int value;
+
+    memcpy(&value, &(pBase[offset]), sizeof(int));
+    return value;
+}
+
+static int cpdGpsWireIsZero(const char *p, unsigned int size)
+{
+    unsigned int i;
+
+    for (i = 0; i < size; i++) {
+        if (p[i] != 0) {
+            return CPD_NOK;
+        }
+    }
+    return CPD_OK;
+}
+
+static unsigned long long cpdGpsWireNs(void)
+{
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return ((unsigned long long) t.tv_sec * 1000000000ULL) + t.tv_nsec;
+}
+
+static void cpdGpsWireCount(pCPD_CONTEXT pCpd, int kind, int encoded, unsigned int bytes, unsigned long long ns)
+{
+    pGPS_WIRE_STATS pS = &(pCpd->gpsWire.stats[kind]);
+
+    pthread_mutex_lock(&(pCpd->gpsWire.lock));
+    if (encoded == CPD_OK) {
+        pS->nEncoded++;
+        pS->bytesRaw += gpsWireStructs[kind].size;
+        pS->bytesWire += bytes;
+        pS->encodeNs += ns;
+    }
+    else {
+        pS->nDecoded++;
+        pS->decodeNs += ns;
+    }
+    pthread_mutex_unlock(&(pCpd->gpsWire.lock));
+}
+
+/*
+ * Largest encoded <kind>, GPS_WIRE_REQUEST or GPS_WIRE_RESPONSE.
+ */
+int cpdGpsWireMaxSize(int kind)
+{
+    const GPS_WIRE_STRUCT *pSt = &(gpsWireStructs[kind]);
+    int size;
+    int i;
+
+    size = GPS_WIRE_HEAD_SIZE + pSt->size + (pSt->nFields * GPS_WIRE_TAG_SIZE);
+    for (i = 0; i < pSt->nFields; i++) {
+        if (pSt->pFields[i].kind == GPS_WIRE_KIND_POINTER) {
+            size += pSt->pFields[i].maxItems * pSt->pFields[i].size;
+        }
+    }
+    return size;
+}
+
+/*
+ * Encode structure <pStruct> of <kind> to <pB>, which has room for <size> bytes.
+ * Returns length of encoded data, CPD_ERROR if it doesn't fit.
+ */
+int cpdGpsWireEncode(pCPD_CONTEXT pCpd, int kind, const void *pStruct, char *pB, int size)
+{
+    const GPS_WIRE_STRUCT *pSt = &(gpsWireStructs[kind]);
+    const GPS_WIRE_FIELD *pF;
+    const char *pBase = (const char *) pStruct;
+    const char *p;
+    unsigned long long t0 = cpdGpsWireNs();
+    unsigned int head[2];
+    unsigned short tag[2];
+    unsigned int len;
+    int n, k;
+    int i;
+    int pos;
+
+    if (size < (int) GPS_WIRE_HEAD_SIZE) {
+        return CPD_ERROR;
+    }
+    head[0] = GPS_WIRE_MAGIC;
+    head[1] = CPD_MSG_VERSION;
+    memcpy(pB, head, sizeof(head));
+    pos = GPS_WIRE_HEAD_SIZE;
+    for (i = 0; i < pSt->nFields; i++) {
+        pF = &(pSt->pFields[i]);
+        p = &(pBase[pF->offset]);
+        len = 0;
+        switch (pF->kind) {
+            case GPS_WIRE_KIND_FIXED:
+                if (cpdGpsWireIsZero(p, pF->size) == CPD_NOK) {
+                    len = pF->size;
+                }
+                break;
+            case GPS_WIRE_KIND_ARRAY:
+                n = cpdGpsWireGetInt(pBase, pF->countOffset);
+                if (n > 0) {
+                    len = ((n < (int) pF->maxItems) ? n : (int) pF->maxItems) * pF->size;
+                }
+                break;
+            case GPS_WIRE_KIND_UNION:
+                k = cpdGpsWireGetInt(pBase, pF->countOffset);
+                if ((k >= 0) && (k < pF->nArms)) {
+                    len = pF->pArmSizes[k];
+                }
+                break;
+            case GPS_WIRE_KIND_POINTER:
+                if ((pF->selectOffset >= 0) && (cpdGpsWireGetInt(pBase, pF->selectOffset) != pF->selectValue)) {
+                    break;
+                }
+                memcpy(&p, p, sizeof(p));
+                n = cpdGpsWireGetInt(pBase, pF->countOffset);
+                if ((p != NULL) && (n > 0)) {
+                    len = ((n < (int) pF->maxItems) ? n : (int) pF->maxItems) * pF->size;
+                }
+                break;
+        }
+        if (len == 0) {
+            continue;
+        }
+        if ((pos + (int) (GPS_WIRE_TAG_SIZE + len)) > size) {
+            return CPD_ERROR;
+        }
+        tag[0] = (unsigned short) (i + 1);
+        tag[1] = (unsigned short) len;
+        memcpy(&(pB[pos]), tag, sizeof(tag));
+        memcpy(&(pB[pos + GPS_WIRE_TAG_SIZE]), p, len);
+        pos = pos + GPS_WIRE_TAG_SIZE + len;
+    }
+    cpdGpsWireCount(pCpd, kind, CPD_OK, pos, cpdGpsWireNs() - t0);
+    return pos;
+}
+
+/*
+ * Data of a message is encoded, not a raw structure.
+ */
+int cpdGpsWireIsEncoded(const char *pB, int len)
+{
+    unsigned int magic;
+
+    if (len < (int) GPS_WIRE_HEAD_SIZE) {
+        return CPD_NOK;
+    }
+    memcpy(&magic, pB, sizeof(magic));
+    return (magic == GPS_WIRE_MAGIC) ? CPD_OK : CPD_NOK;
+}
+
+/*
+ * Decode <len> bytes at <pB> to structure <pStruct> of <kind>. Arrays sent inline are kept in GPS_WIRE until
+ * the next message of the same kind is decoded. Returns CPD_ERROR if data is damaged.
+ */
+int cpdGpsWireDecode(pCPD_CONTEXT pCpd, int kind, const char *pB, int len, void *pStruct)
+{
+    const GPS_WIRE_STRUCT *pSt = &(gpsWireStructs[kind]);
+    const GPS_WIRE_FIELD *pF;
+    char *pBase = (char *) pStruct;
+    char *pStore;
+    unsigned long long t0 = cpdGpsWireNs();
+    unsigned long long seen = 0;
+    unsigned int head[2];
+    unsigned short tag[2];
+    unsigned int n;
+    int i;
+    int pos;
+
+    memset(pStruct, 0, pSt->size);
+    if (cpdGpsWireIsEncoded(pB, len) != CPD_OK) {
+        return CPD_ERROR;
+    }
+    memcpy(head, pB, sizeof(head));
+    /* version is the first member of both structures */
+    memcpy(pBase, &(head[1]), sizeof(int));
+    pos = GPS_WIRE_HEAD_SIZE;
+    while (pos < len) {
+        if ((pos + (int) GPS_WIRE_TAG_SIZE) > len) {
+            return CPD_ERROR;
+        }
+        memcpy(tag, &(pB[pos]), sizeof(tag));
+        pos = pos + GPS_WIRE_TAG_SIZE;
+        if ((pos + tag[1]) > len) {
+            return CPD_ERROR;
+        }
+        i = tag[0] - 1;
+        if ((i < 0) || (i >= pSt->nFields)) {
+            /* from newer version */
+            pos = pos + tag[1];
+            continue;
+        }
+        pF = &(pSt->pFields[i]);
+        switch (pF->kind) {
+            case GPS_WIRE_KIND_FIXED:
+            case GPS_WIRE_KIND_UNION:
+                memcpy(&(pBase[pF->offset]), &(pB[pos]), (tag[1] < pF->size) ? tag[1] : pF->size);
+                break;
+            case GPS_WIRE_KIND_ARRAY:
+                n = tag[1] / pF->size;
+                n = (n < pF->maxItems) ? n : pF->maxItems;
+                memcpy(&(pBase[pF->offset]), &(pB[pos]), n * pF->size);
+                memcpy(&(pBase[pF->countOffset]), &n, sizeof(int));
+                break;
+            case GPS_WIRE_KIND_POINTER:
+                n = tag[1] / pF->size;
+                n = (n < pF->maxItems) ? n : pF->maxItems;
+                pStore = &(((char *) &(pCpd->gpsWire))[pF->storeOffset]);
+                memcpy(pStore, &(pB[pos]), n * pF->size);
+                memcpy(&(pBase[pF->offset]), &pStore, sizeof(pStore));
+                memcpy(&(pBase[pF->countOffset]), &n, sizeof(int));
+                seen |= 1ULL << i;
+                break;
+        }
+        pos = pos + tag[1];
+    }
+    /* pointer which came in union arm means nothing here */
+    for (i = 0; i < pSt->nFields; i++) {
+        pF = &(pSt->pFields[i]);
+        if ((pF->kind != GPS_WIRE_KIND_POINTER) || ((seen & (1ULL << i)) != 0)) {
+            continue;
+        }
+        if ((pF->selectOffset < 0) || (cpdGpsWireGetInt(pBase, pF->selectOffset) == pF->selectValue)) {
+            memset(&(pBase[pF->offset]), 0, sizeof(void *));
+            memset(&(pBase[pF->countOffset]), 0, sizeof(int));
+        }
+    }
+    cpdGpsWireCount(pCpd, kind, CPD_NOK, len, cpdGpsWireNs() - t0);
+    return CPD_OK;
+}
+
+void cpdGpsWireStats(pCPD_CONTEXT pCpd)
+{
+    pGPS_WIRE_STATS pS;
+    int kind;
+
+    pthread_mutex_lock(&(pCpd->gpsWire.lock));
+    for (kind = GPS_WIRE_REQUEST; kind <= GPS_WIRE_RESPONSE; kind++) {
+        pS = &(pCpd->gpsWire.stats[kind]);
+        if (pS->nEncoded > 0) {
+            CPD_LOG(CPD_LOG_ID_TXT, "\n%u: %s(), %s: %u encoded, %llu of %llu bytes sent, %llu ns avg",
+                    getMsecTime(), __FUNCTION__, gpsWireStructs[kind].pName, pS->nEncoded, pS->bytesWire, pS->bytesRaw,
+                    pS->encodeNs / pS->nEncoded);
+            LOGD("%u: %s(), %s: %u encoded, %llu of %llu bytes", getMsecTime(), __FUNCTION__,
+                    gpsWireStructs[kind].pName, pS->nEncoded, pS->bytesWire, pS->bytesRaw);
+        }
+        if (pS->nDecoded > 0) {
+            CPD_LOG(CPD_LOG_ID_TXT, "\n%u: %s(), %s: %u decoded, %llu ns avg",
+                    getMsecTime(), __FUNCTION__, gpsWireStructs[kind].pName, pS->nDecoded, pS->decodeNs / pS->nDecoded);
+        }
+    }
+    pthread_mutex_unlock(&(pCpd->gpsWire.lock));
+}
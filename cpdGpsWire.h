@@ -0,0 +1,19 @@
+/*
+ * hardware/Intel/cp_daemon/cpdGpsWire.h
+ *
+ * Header file for cpdGpsWire.c.
+ *
+ * Martin Junkar 09/18/2011
+ *
+ */
+
+#ifndef _CPDGPSWIRE_H_
+#define _CPDGPSWIRE_H_
+#include "cpd.h"
+
+int cpdGpsWireMaxSize(int kind);
+int cpdGpsWireEncode(pCPD_CONTEXT pCpd, int kind, const void *pStruct, char *pB, int size);
+int cpdGpsWireIsEncoded(const char *pB, int len);
+int cpdGpsWireDecode(pCPD_CONTEXT pCpd, int kind, const char *pB, int len, void *pStruct);
+void cpdGpsWireStats(pCPD_CONTEXT pCpd);
+#endif
@@ -19,6 +19,7 @@
 
 #include "cpd.h"
 #include "cpdUtil.h"
+#include "cpdRingBuffer.h"
 
 void cpdDeInit(void);
 
@@ -27,6 +28,7 @@ CPD_CONTEXT cpdContext;
 pCPD_CONTEXT cpdInit(void)
 {
     int result = CPD_OK;
+    pthread_mutexattr_t attr;
 /*
     LOGD("%u: %s()", getMsecTime(), __FUNCTION__);
 */
@@ -35,24 +37,28 @@ pCPD_CONTEXT cpdInit(void)
 
     cpdContext.modemInfo.modemReadThreadState = THREAD_STATE_OFF;
     snprintf((char*) (cpdContext.modemInfo.modemName), MODEM_NAME_MAX_LEN, "%s" , MODEM_NAME);
-    cpdContext.modemInfo.pModemRxBuffer = NULL;
+    cpdContext.modemInfo.modemRxRing.pBuffer = NULL;
+    cpdContext.modemInfo.modemRxRing.fd = CPD_ERROR;
     cpdContext.modemInfo.pModemTxBuffer = NULL;
     cpdContext.modemInfo.modemFd = 0;
+    cpdContext.modemInfo.atTokenizer.urcStart = CPD_ERROR;
+    cpdContext.modemInfo.atTokenizer.urcEnd = CPD_ERROR;
     pthread_mutex_init(&(cpdContext.modemInfo.modemFdLock), NULL);
-
-
-    cpdContext.xmlRxBuffer.pXmlBuffer = NULL;
-
-    cpdContext.xmlRxBuffer.pXmlBuffer = malloc(XML_RX_BUFFER_SIZE);
-    if (cpdContext.xmlRxBuffer.pXmlBuffer != NULL) {
-        cpdContext.xmlRxBuffer.xmlBufferSize = XML_RX_BUFFER_SIZE;
-        memset(cpdContext.xmlRxBuffer.pXmlBuffer, 0, cpdContext.xmlRxBuffer.xmlBufferSize);
-        cpdContext.xmlRxBuffer.maxAge = XML_MAX_DATA_AGE_CPOS;
-    }
-    else {
-        cpdDeInit();
-        result = CPD_NOK;
-    }
+    pthread_mutex_init(&(cpdContext.modemInfo.atEngine.lock), NULL);
+    pthread_cond_init(&(cpdContext.modemInfo.atEngine.done), NULL);
+
+    cpdContext.xmlRxParser.pCtxt = NULL;
+    cpdContext.xmlRxParser.pDict = NULL;
+    cpdContext.xmlRxParser.receiving = CPD_NOK;
+    cpdContext.xmlRxParser.maxAge = XML_MAX_DATA_AGE_CPOS;
+    cpdContext.xmlRxParser.decodeMode = XML_DECODE_SAX;
+    cpdContext.xmlRxParser.pVerify = NULL;
+    cpdContext.xmlArena.pBase = NULL;
+    cpdContext.xmlArena.size = XML_ARENA_SIZE;
+    cpdContext.xmlArena.enabled = CPD_NOK;
+    cpdContext.xmlArena.active = CPD_NOK;
+    pthread_mutex_init(&(cpdContext.xmlArena.lock), NULL);
+    cpdContext.xmlTxTemplate.valid = CPD_NOK;
 
 
     cpdContext.gpsCommBuffer.pRxBuffer = NULL;
@@ -63,16 +69,63 @@ pCPD_CONTEXT cpdInit(void)
     cpdContext.gpsCommBuffer.pRxBuffer = malloc(GPS_COMM_RX_BUFFER_SIZE);
     if (cpdContext.gpsCommBuffer.pRxBuffer != NULL) {
         cpdContext.gpsCommBuffer.rxBufferIndex = 0;
+        cpdContext.gpsCommBuffer.rxBufferStart = 0;
         cpdContext.gpsCommBuffer.rxBufferSize = GPS_COMM_RX_BUFFER_SIZE;
         memset(cpdContext.gpsCommBuffer.pRxBuffer, 0, cpdContext.gpsCommBuffer.rxBufferSize);
     }
     cpdContext.gpsCommBuffer.rxBufferCmdStart = CPD_ERROR;
     cpdContext.gpsCommBuffer.rxBufferCmdEnd = CPD_ERROR;
+    cpdContext.gpsCommBuffer.rxBufferCmdNext = CPD_ERROR;
+    cpdContext.gpsCommBuffer.txFraming = CPD_MSG_FRAMING_TEXT;
+    cpdContext.gpsCommBuffer.txPacked = CPD_NOK;
+    cpdContext.gpsCommBuffer.txMirrored = CPD_NOK;
 
     cpdContext.scIndexToGps = CPD_ERROR;
 
     cpdContext.systemMonitor.pmfd = -1;
 
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&(cpdContext.responseSender.lock), &attr);
+    pthread_mutex_init(&(cpdContext.sessionTable.lock), &attr);
+    pthread_mutexattr_destroy(&attr);
+    pthread_cond_init(&(cpdContext.responseSender.wake), NULL);
+    cpdContext.responseSender.senderThreadState = THREAD_STATE_OFF;
+
+    pthread_mutex_init(&(cpdContext.sessionScheduler.lock), NULL);
+    cpdContext.sessionScheduler.fd = CPD_ERROR;
+    cpdContext.sessionScheduler.timerThreadState = THREAD_STATE_OFF;
+
+    cpdContext.sessionTable.gpsMethod = GPP_METHOD_TYPE_NONE;
+    cpdContext.sessionTable.stopPending = CPD_NOK;
+    cpdContext.sessionTable.gpsRunning = CPD_NOK;
+
+    pthread_mutex_init(&(cpdContext.lastFix.lock), NULL);
+    cpdContext.lastFix.maxAge = LAST_FIX_MAX_AGE;
+    cpdContext.lastFix.refine = CPD_NOK;
+
+    pthread_mutex_init(&(cpdContext.assistStore.lock), NULL);
+    cpdContext.assistStore.pFileName = CPD_ASSIST_STORE_FILE;
+    cpdContext.assistStore.fd = CPD_ERROR;
+    cpdContext.assistStore.current = CPD_ERROR;
+    cpdContext.assistStore.dirty = CPD_NOK;
+    cpdContext.assistStore.flushing = CPD_NOK;
+    cpdContext.assistStore.flushThreadState = THREAD_STATE_OFF;
+    pthread_cond_init(&(cpdContext.assistStore.wake), NULL);
+
+    pthread_mutex_init(&(cpdContext.aidingCache.lock), NULL);
+
+    pthread_mutex_init(&(cpdContext.gpsRing.lock), NULL);
+    pthread_mutex_init(&(cpdContext.gpsRing.dispatchLock), NULL);
+    cpdContext.gpsRing.state = CPD_NOK;
+    cpdContext.gpsRing.socketIndex = CPD_ERROR;
+    cpdContext.gpsRing.fds[0] = CPD_ERROR;
+    cpdContext.gpsRing.fds[1] = CPD_ERROR;
+    cpdContext.gpsRing.fds[2] = CPD_ERROR;
+    cpdContext.gpsRing.rxThreadState = THREAD_STATE_OFF;
+
+    pthread_mutex_init(&(cpdContext.gpsWire.lock), NULL);
+
     if (result == CPD_OK) {
         cpdContext.initialized = result;
         return &cpdContext;
@@ -88,15 +141,10 @@ void cpdDeInit(void)
     if (cpdContext.initialized != CPD_OK) {
         return;
     }
-    if (cpdContext.modemInfo.pModemRxBuffer != NULL) {
-        free(cpdContext.modemInfo.pModemRxBuffer);
-    }
+    cpdRingBufferFree(&(cpdContext.modemInfo.modemRxRing));
     if (cpdContext.modemInfo.pModemTxBuffer != NULL) {
         free(cpdContext.modemInfo.pModemTxBuffer);
     }
-    if (cpdContext.xmlRxBuffer.pXmlBuffer != NULL) {
-        free(cpdContext.xmlRxBuffer.pXmlBuffer);
-    }
     return;
 }
 
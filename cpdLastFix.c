@@ -0,0 +1,156 @@
+/*
+ * hardware/Intel/cp_daemon/cpdLastFix.c
+ *
+ * Cache of the last location reported by GPS.
+ * MS-based request is answered from the cache at once if the cached fix is younger than the response time
+ * of the request and its uncertainty, grown by LAST_FIX_DRIFT for every second of its age, meets the requested
+ * horizontal and vertical accuracy. Requests without accuracy or response time accept any fix up to maxAge.
+ *
+ * Martin Junkar 09/18/2011
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#define LOG_TAG "CPDD_LF"
+
+#include "cpd.h"
+#include "cpdUtil.h"
+#include "cpdLastFix.h"
+#include "cpdDebug.h"
+
+
+/*
+ * Horizontal uncertainty of location in m, CPD_ERROR if its shape has none.
+ */
+static int cpdLastFixHorUncert(pLOCATION pLocation)
+{
+    pSHAPE_DATA_U pShape = &(pLocation->location_parameters.shape_data);
+
+    switch (pLocation->location_parameters.shape_type) {
+    case SHAPE_TYPE_POINT_UNCERT_CIRCLE:
+        return (int) pShape->point_uncert_circle.uncert_circle;
+    case SHAPE_TYPE_POINT_UNCERT_ELLIPSE:
+        return (int) pShape->point_uncert_ellipse.uncert_semi_major;
+    case SHAPE_TYPE_POINT_ALT_UNCERT_ELLIPSE:
+        return pShape->point_alt_uncertellipse.uncert_semi_major;
+    default:
+        break;
+    }
+    return CPD_ERROR;
+}
+
+/*
+ * Location received from GPS replaces the cached one, if its uncertainty is known.
+ */
+void cpdLastFixStore(pCPD_CONTEXT pCpd, pLOCATION pLocation)
+{
+    pLAST_FIX_CACHE pLf = &(pCpd->lastFix);
+    int horUncert;
+
+    horUncert = cpdLastFixHorUncert(pLocation);
+    if (horUncert < 0) {
+        return;
+    }
+    pthread_mutex_lock(&(pLf->lock));
+    memcpy(&(pLf->location), pLocation, sizeof(LOCATION));
+    pLf->horUncert = horUncert;
+    pLf->vertUncert = CPD_ERROR;
+    if (pLocation->location_parameters.shape_type == SHAPE_TYPE_POINT_ALT_UNCERT_ELLIPSE) {
+        pLf->vertUncert = pLocation->location_parameters.shape_data.point_alt_uncertellipse.uncert_alt;
+    }
+    pLf->fixedAt = getMsecMonotonic();
+    pLf->valid = CPD_OK;
+    pthread_mutex_unlock(&(pLf->lock));
+}
+
+/*
+ * Copy cached location to pLocation if it satisfies accuracy and response time of pRequest->rs.
+ * Returns CPD_OK on hit, CPD_NOK if request has to wait for GPS.
+ */
+int cpdLastFixLookup(pCPD_CONTEXT pCpd, pREQUEST_PARAMS pRequest, pLOCATION pLocation)
+{
+    pLAST_FIX_CACHE pLf = &(pCpd->lastFix);
+    pREQUEST_SUMM pRs = &(pRequest->rs);
+    unsigned int maxAge;
+    unsigned int age = 0;
+    unsigned int saved = 0;
+    int drift;
+    int result = CPD_NOK;
+
+    pthread_mutex_lock(&(pLf->lock));
+    if (pLf->maxAge == 0) {
+        pthread_mutex_unlock(&(pLf->lock));
+        return CPD_NOK;
+    }
+    pLf->nLookups++;
+    maxAge = pLf->maxAge;
+    if ((pRs->rep_resp_time_seconds > 0) && ((unsigned int) pRs->rep_resp_time_seconds * 1000 < maxAge)) {
+        maxAge = (unsigned int) pRs->rep_resp_time_seconds * 1000;
+    }
+    if (pLf->valid == CPD_OK) {
+        age = getMsecMonotonic() - pLf->fixedAt;
+    }
+    drift = (int) ((age * LAST_FIX_DRIFT) / 1000);
+    if ((pLf->valid != CPD_OK) || (age > maxAge)) {
+        pLf->nStale++;
+    }
+    else if (((pRs->rep_hor_acc > 0) && (pLf->horUncert + drift > pRs->rep_hor_acc)) ||
+             ((pRs->rep_vert_accuracy > 0) &&
+              ((pLf->vertUncert < 0) || (pLf->vertUncert + drift > pRs->rep_vert_accuracy)))) {
+        pLf->nInaccurate++;
+    }
+    else {
+        memcpy(pLocation, &(pLf->location), sizeof(LOCATION));
+        /* the session would have waited for GPS about as long as the sessions before it */
+        if (pLf->nTtff > 0) {
+            saved = (unsigned int) (pLf->ttffTotal / pLf->nTtff);
+        }
+        else if (pRs->rep_resp_time_seconds > 0) {
+            saved = (unsigned int) pRs->rep_resp_time_seconds * 1000;
+        }
+        pLf->savedTotal += saved;
+        pLf->nHits++;
+        result = CPD_OK;
+    }
+    pthread_mutex_unlock(&(pLf->lock));
+
+    LOGD("%u: %s(%u), age %u ms, hit=%d, %u ms saved", getMsecTime(), __FUNCTION__,
+            pRequest->dbgStats.posRequestId, age, (result == CPD_OK), saved);
+    return result;
+}
+
+/*
+ * Session received its first location from GPS <ttff> ms after the request.
+ */
+void cpdLastFixFirstFix(pCPD_CONTEXT pCpd, unsigned int ttff)
+{
+    pLAST_FIX_CACHE pLf = &(pCpd->lastFix);
+
+    pthread_mutex_lock(&(pLf->lock));
+    pLf->nTtff++;
+    pLf->ttffTotal += ttff;
+    pthread_mutex_unlock(&(pLf->lock));
+}
+
+void cpdLastFixStats(pCPD_CONTEXT pCpd)
+{
+    pLAST_FIX_CACHE pLf = &(pCpd->lastFix);
+    unsigned int hitRate = 0;
+    unsigned int ttff = 0;
+
+    pthread_mutex_lock(&(pLf->lock));
+    if (pLf->nLookups > 0) {
+        hitRate = (pLf->nHits * 100) / pLf->nLookups;
+    }
+    if (pLf->nTtff > 0) {
+        ttff = (unsigned int) (pLf->ttffTotal / pLf->nTtff);
+    }
+    CPD_LOG(CPD_LOG_ID_TXT,
+            "\n%u: Last fix: %u lookups, %u hits (%u%%), %u stale, %u inaccurate, TTFF %u ms average, %llu ms saved",
+            getMsecTime(), pLf->nLookups, pLf->nHits, hitRate, pLf->nStale, pLf->nInaccurate, ttff, pLf->savedTotal);
+    LOGD("%u: %s(), %u lookups, %u hits (%u%%), TTFF %u ms, %llu ms saved", getMsecTime(), __FUNCTION__,
+            pLf->nLookups, pLf->nHits, hitRate, ttff, pLf->savedTotal);
+    pthread_mutex_unlock(&(pLf->lock));
+}
@@ -0,0 +1,18 @@
+/*
+ * hardware/Intel/cp_daemon/cpdLastFix.h
+ *
+ * Header file for cpdLastFix.c.
+ *
+ * Martin Junkar 09/18/2011
+ *
+ */
+
+#ifndef _CPDLASTFIX_H_
+#define _CPDLASTFIX_H_
+#include "cpd.h"
+
+void cpdLastFixStore(pCPD_CONTEXT pCpd, pLOCATION pLocation);
+int cpdLastFixLookup(pCPD_CONTEXT pCpd, pREQUEST_PARAMS pRequest, pLOCATION pLocation);
+void cpdLastFixFirstFix(pCPD_CONTEXT pCpd, unsigned int ttff);
+void cpdLastFixStats(pCPD_CONTEXT pCpd);
+#endif
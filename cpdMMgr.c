@@ -52,6 +52,7 @@ int cpdProcessModemUp(mmgr_cli_event_t *ev)
     LOGI("\tModem status received: MODEM_UP\n");
     LOGI("\tModem THREAD_STATE_OFF\n");
     pCpd->modemInfo.modemReadThreadState = THREAD_STATE_OFF;
+    pCpd->modemInfo.modemUpAt = getMsecTime();
     if(pCpd->pfSystemMonitorStart != NULL)
     {
         CPD_LOG(CPD_LOG_ID_TXT, "\tStarting SystemMonitor!\n");
@@ -124,13 +124,10 @@ int modemWrite(int fd, void *pBuffer, int len)
 }
 
 /*
- * Read data from modem (file).
- * Returns number of bytes read.
- * This is blocking read function. Implements pool() mechanism to block until there is data available of if there is an error on <fd>
- * Return valur 0 is a valid return reason
- * Return values < 0 are errors.
+ * Same as modemRead(), but blocks at most <timeout> ms, -1 is no timeout.
+ * Returns 0 if there was no data in <timeout> ms.
  */
-int modemRead(int fd, void *pBuffer, int len)
+int modemReadTimeout(int fd, void *pBuffer, int len, int timeout)
 {
     int result = -3;
     int ret;
@@ -143,11 +140,14 @@ int modemRead(int fd, void *pBuffer, int len)
 //    p.events = POLLERR | POLLHUP | POLLNVAL | POLLIN | POLLPRI;
     p.events = POLLERR | POLLHUP | POLLIN;
     p.revents = 0;
-    ret = poll( &p, 1, -1);
+    ret = poll( &p, 1, timeout);
     if (ret < 0) {
         LOGE("POLL error, %d", ret);
         return result-100;
     }
+    if (ret == 0) {
+        return 0;
+    }
     if ((p.revents & (POLLERR | POLLHUP)) != 0) {
         LOGE("POLL event error, %d, %04X", ret, p.revents);
         return result-200;
@@ -167,3 +167,15 @@ int modemRead(int fd, void *pBuffer, int len)
     return result;
 }
 
+/*
+ * Read data from modem (file).
+ * Returns number of bytes read.
+ * This is blocking read function. Implements pool() mechanism to block until there is data available of if there is an error on <fd>
+ * Return valur 0 is a valid return reason
+ * Return values < 0 are errors.
+ */
+int modemRead(int fd, void *pBuffer, int len)
+{
+    return modemReadTimeout(fd, pBuffer, len, -1);
+}
+
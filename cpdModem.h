@@ -12,4 +12,5 @@ int modemClose(int *fd);
 int modemOpen(char * name, int openOptions);
 int modemWrite(int fd, void *pBuffer, int len);
 int modemRead(int fd, void *pBuffer, int len);
+int modemReadTimeout(int fd, void *pBuffer, int len, int timeout);
 
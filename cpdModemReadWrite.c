@@ -22,6 +22,7 @@
 #include <unistd.h>
 #include <termios.h>
 #include <sys/poll.h>
+#include <sys/time.h>
 
 #define LOG_TAG "CPDD_MRW"
 #define LOG_NDEBUG 1    /* control debug logging */
@@ -31,13 +32,17 @@
 #include "cpdUtil.h"
 #include "cpdXmlParser.h"
 #include "cpdInit.h"
+#include "cpdAtTokenizer.h"
+#include "cpdRingBuffer.h"
+#include "cpdScan.h"
 
 /* for debug logging */
 #include "cpdDebug.h"
 #include "cpdSocketServer.h"
 
 
-#define TEMP_RX_BUFF_SIZE   256
+/* minimum free space in Rx buffer before reading from modem */
+#define MODEM_RX_MIN_READ_SIZE  256
 
 #define AT_RESPONSE_TIMEOUT 300UL
 
@@ -85,23 +90,14 @@ static void cpdModemReadThreadSignalHandler(int sig)
 
 
 /*
- * Send AT Commands to modem.
- * Return value is number of bytes sent.
+ * Write AT command to modem, and to all pass-through sockets.
+ * Return value is number of bytes written.
  */
-int cpdModemSendCommand(pCPD_CONTEXT pCpd, const char *pB, int len, unsigned int waitForResponse)
+static int cpdModemWriteCommand(pCPD_CONTEXT pCpd, const char *pB, int len)
 {
-    int result = 0;
+    int result;
     unsigned int t0;
 
-    if ((pB == NULL) || (len <= 0)) {
-        return result;
-    }
-    pCpd->modemInfo.haveResponse = 0;
-    pCpd->modemInfo.responseValue = AT_RESPONSE_NONE;
-    if (waitForResponse > 0) {
-        pCpd->modemInfo.waitingForResponse = 1;
-    }
-
     result = modemWrite(pCpd->modemInfo.modemFd, (void *) pB, len);
     if(result < 0) {
         if(pCpd->pfSystemMonitorStart != NULL) {
@@ -125,229 +121,332 @@ int cpdModemSendCommand(pCPD_CONTEXT pCpd, const char *pB, int len, unsigned int
         /* pass-through message, this is quick-fix implementation, change later */
         r = cpdSocketWriteToAll(&(pCpd->ssModemComm), (char *) pB, result);
     }
-    if (waitForResponse > 0) {
-        if (result != len) {
-            result = 0;
-            pCpd->modemInfo.waitingForResponse = 0;
-        }
-        else {
-            while ((pCpd->modemInfo.haveResponse == 0) &&
-                    (pCpd->modemInfo.responseValue == AT_RESPONSE_NONE)) {
-                if (getMsecDt(t0) > waitForResponse) {
-                    break;
-                }
-                usleep(10000);
-            }
-            if (pCpd->modemInfo.haveResponse == 0) {
-                CPD_LOG(CPD_LOG_ID_TXT, "\r\n%u: !!! ModemResponseTimeout, %u, %u\n", getMsecTime(), getMsecDt(t0), waitForResponse);
-                LOGE("%u: !!! ModemResponseTimeout, %u, %u", getMsecTime(), getMsecDt(t0), waitForResponse);
-            }
-            else {
-                CPD_LOG(CPD_LOG_ID_TXT, "\r\n%u: ModemResponse, %u, %u\n", getMsecTime(), pCpd->modemInfo.haveResponse, pCpd->modemInfo.responseValue);
-                LOGV("%u: ModemResponse, %u, %u", getMsecTime(), pCpd->modemInfo.haveResponse, pCpd->modemInfo.responseValue);
-            }
-        }
-    }
     return result;
 }
 
-int cpdModemSocketWriteToAllExcpet(pSOCKET_SERVER pSS, char *pB, int len, int noWrite)
-{
-    int rr;
-    int i;
-    pCPD_CONTEXT pCpd = cpdGetContext();
-    int result = 0;
-    unsigned int t0;
-
-    if ((pB == NULL) || (len <= 0) || (pCpd == NULL)) {
-        return result;
-    }
-    pCpd->modemInfo.haveResponse = 0;
-    pCpd->modemInfo.responseValue = AT_RESPONSE_NONE;
+static void cpdModemCommandDispatch(pCPD_CONTEXT pCpd);
 
-    result = modemWrite(pCpd->modemInfo.modemFd, pB, len);
-    t0 = getMsecTime();
-    CPD_LOG(CPD_LOG_ID_TXT, "\r\nTx, %09u,[", t0);
-    CPD_LOG_DATA(CPD_LOG_ID_MODEM_RXTX | CPD_LOG_ID_MODEM_TX | CPD_LOG_ID_TXT , pB,  len);
-    CPD_LOG(CPD_LOG_ID_TXT, "]\r\n");
-    {
-        int r;
-        /* pass-through message to other sockets */
-        r = cpdSocketWriteToAllExcpet(pSS, pB, result, noWrite);
-    }
-    result = CPD_OK;
-    return result;
+/*
+ * Complete AT command written to modem with <response>, call its callback and write next queued command.
+ * <id> 0 completes any command in flight, otherwise only command with this id.
+ */
+static void cpdModemCommandFinish(pCPD_CONTEXT pCpd, unsigned int id, int response)
+{
+    pAT_ENGINE pE = &(pCpd->modemInfo.atEngine);
+    AT_COMMAND cmd;
+    unsigned int latency;
+
+    pthread_mutex_lock(&(pE->lock));
+    if ((pE->inFlight == 0) || ((id != 0) && (pE->queue[pE->head].id != id))) {
+        pthread_mutex_unlock(&(pE->lock));
+        return;
+    }
+    cmd = pE->queue[pE->head];
+    pE->head = (pE->head + 1) % AT_COMMAND_QUEUE_SIZE;
+    pE->count--;
+    pE->inFlight = 0;
+    pE->busy = 1;
+    pthread_mutex_unlock(&(pE->lock));
+
+    latency = getMsecDt(cmd.sentAt);
+    CPD_LOG(CPD_LOG_ID_TXT, "\r\n%u: ModemResponse, %u, %d, %u ms\n", getMsecTime(), cmd.id, response, latency);
+    LOGV("%u: ModemResponse, %u, %d, %u ms", getMsecTime(), cmd.id, response, latency);
+    if (cmd.pfDone != NULL) {
+        cmd.pfDone(cmd.pArg, response, latency);
+    }
+
+    pthread_mutex_lock(&(pE->lock));
+    pE->busy = 0;
+    pthread_mutex_unlock(&(pE->lock));
+    cpdModemCommandDispatch(pCpd);
 }
 
+/*
+ * Complete AT command in flight, called from modem read thread when response is received.
+ */
+static void cpdModemCommandComplete(pCPD_CONTEXT pCpd, int response)
+{
+    cpdModemCommandFinish(pCpd, 0, response);
+}
 
-int cpdModemFindOk(char *pB, int len)
+/*
+ * Write the oldest queued command to modem, unless there is a command in flight already.
+ */
+static void cpdModemCommandDispatch(pCPD_CONTEXT pCpd)
 {
-    int result = -1;
-    char pStr[8];
-    char *pS = NULL;
+    pAT_ENGINE pE = &(pCpd->modemInfo.atEngine);
+    const char *pB;
+    int len;
+    unsigned int id;
 
-    if (pB == NULL) {
-        return result;
+    pthread_mutex_lock(&(pE->lock));
+    if ((pE->inFlight != 0) || (pE->busy != 0) || (pE->count == 0)) {
+        pthread_mutex_unlock(&(pE->lock));
+        return;
     }
-    /* is there OK anywhere? */
-    snprintf(pStr, 7, "%s%s", AT_CMD_OK, AT_CMD_CRLF);
-    pS = strstr(pB, pStr);
-    if (pS != NULL){
-        result = (int) (pS - pB);
-        if (result > len) {
-            result = -1;
-        }
+    /* response can arrive before write returns, command is in flight from now on */
+    pE->inFlight = 1;
+    pE->queue[pE->head].sentAt = getMsecTime();
+    id = pE->queue[pE->head].id;
+    pB = pE->queue[pE->head].pCmd;
+    len = pE->queue[pE->head].len;
+    pthread_mutex_unlock(&(pE->lock));
+
+    if (cpdModemWriteCommand(pCpd, pB, len) != len) {
+        cpdModemCommandFinish(pCpd, id, AT_RESPONSE_NONE);
     }
-    return result;
 }
 
-int cpdModemFindError(char *pB, int len)
+static int cpdModemCommandIsPending(pCPD_CONTEXT pCpd)
 {
-    int result = -1;
-    char pStr[16];
-    char *pS = NULL;
+    int pending;
 
-    if (pB == NULL) {
-        return result;
-    }
+    pthread_mutex_lock(&(pCpd->modemInfo.atEngine.lock));
+    pending = pCpd->modemInfo.atEngine.inFlight;
+    pthread_mutex_unlock(&(pCpd->modemInfo.atEngine.lock));
+    return pending;
+}
 
-    /* is there ERROR anywhere? */
-    snprintf(pStr, 15, "%s%s", AT_CMD_ERROR, AT_CMD_CRLF);
-    pS = strstr(pB, pStr);
-    if (pS != NULL){
-        result = (int) (pS - pB);
-        if (result > len) {
-            result = -1;
-        }
-    }
-    return result;
+/*
+ * Time out AT command in flight if there was no response to it.
+ * Returns ms left until command in flight times out, -1 if there is no command in flight.
+ */
+static int cpdModemCommandCheckTimeout(pCPD_CONTEXT pCpd)
+{
+    pAT_ENGINE pE = &(pCpd->modemInfo.atEngine);
+    unsigned int id;
+    unsigned int dT;
+    unsigned int timeout;
+
+    pthread_mutex_lock(&(pE->lock));
+    if (pE->inFlight == 0) {
+        pthread_mutex_unlock(&(pE->lock));
+        return CPD_ERROR;
+    }
+    id = pE->queue[pE->head].id;
+    timeout = pE->queue[pE->head].timeout;
+    dT = getMsecDt(pE->queue[pE->head].sentAt);
+    pthread_mutex_unlock(&(pE->lock));
+
+    if (dT < timeout) {
+        return (int) (timeout - dT);
+    }
+    CPD_LOG(CPD_LOG_ID_TXT, "\r\n%u: !!! ModemResponseTimeout, %u, %u, %u\n", getMsecTime(), id, dT, timeout);
+    LOGE("%u: !!! ModemResponseTimeout, %u, %u, %u", getMsecTime(), id, dT, timeout);
+    cpdModemCommandFinish(pCpd, id, AT_RESPONSE_NONE);
+    return 0;
 }
 
+/*
+ * Complete all queued commands with AT_RESPONSE_NONE, modem connection was (re)opened.
+ */
+static void cpdModemCommandFlush(pCPD_CONTEXT pCpd)
+{
+    pAT_ENGINE pE = &(pCpd->modemInfo.atEngine);
+    AT_COMMAND cmd;
+
+    pthread_mutex_lock(&(pE->lock));
+    while (pE->count > 0) {
+        cmd = pE->queue[pE->head];
+        pE->head = (pE->head + 1) % AT_COMMAND_QUEUE_SIZE;
+        pE->count--;
+        pthread_mutex_unlock(&(pE->lock));
+        if (cmd.pfDone != NULL) {
+            cmd.pfDone(cmd.pArg, AT_RESPONSE_NONE, 0);
+        }
+        pthread_mutex_lock(&(pE->lock));
+    }
+    pE->inFlight = 0;
+    pthread_mutex_unlock(&(pE->lock));
+}
 
-int cpdModemFindCharX(char *pB, int len, char findMe)
+/*
+ * Queue AT command for modem, without waiting for response.
+ * <pB> must stay valid until <pfDone> is called, <pfDone> may be NULL.
+ * Command is written to modem when all commands queued before it are completed; <pfDone> is called
+ * from modem read thread when response is received, or from the thread that detects timeout or error.
+ * returns: CPD_OK if command was queued, CPD_NOK if queue is full.
+ */
+int cpdModemSubmitCommand(pCPD_CONTEXT pCpd, const char *pB, int len, int waitFor, unsigned int timeout,
+                                fAT_COMMAND_DONE *pfDone, void *pArg)
 {
-    int result = -1;
-    char *pS = NULL;
+    pAT_ENGINE pE = &(pCpd->modemInfo.atEngine);
+    pAT_COMMAND pCmd;
 
-    if (len <= 0) {
-        return result;
+    if ((pB == NULL) || (len <= 0)) {
+        return CPD_NOK;
     }
-    if (pB == NULL) {
-        return result;
+    pthread_mutex_lock(&(pE->lock));
+    if (pE->count >= AT_COMMAND_QUEUE_SIZE) {
+        pthread_mutex_unlock(&(pE->lock));
+        LOGE("%s(), queue full", __FUNCTION__);
+        return CPD_NOK;
     }
+    pCmd = &(pE->queue[(pE->head + pE->count) % AT_COMMAND_QUEUE_SIZE]);
+    pE->nextId++;
+    if (pE->nextId == 0) {
+        pE->nextId++;
+    }
+    pCmd->id = pE->nextId;
+    pCmd->pCmd = pB;
+    pCmd->len = len;
+    pCmd->waitFor = waitFor;
+    pCmd->timeout = timeout;
+    pCmd->sentAt = 0;
+    pCmd->pfDone = pfDone;
+    pCmd->pArg = pArg;
+    pE->count++;
+    pthread_mutex_unlock(&(pE->lock));
+
+    cpdModemCommandDispatch(pCpd);
+    return CPD_OK;
+}
 
-    pS = strchr(pB, findMe);
-    if (pS != NULL){
-        result = (int) (pS - pB);
-        if (result > len) {
-            result = -1;
-        }
-    }
-    return result;
+int cpdModemCommandQueueFree(pCPD_CONTEXT pCpd)
+{
+    int n;
+
+    pthread_mutex_lock(&(pCpd->modemInfo.atEngine.lock));
+    n = AT_COMMAND_QUEUE_SIZE - pCpd->modemInfo.atEngine.count;
+    pthread_mutex_unlock(&(pCpd->modemInfo.atEngine.lock));
+    return n;
 }
 
+static void cpdModemCommandWaitDone(void *pArg, int response, unsigned int latency)
+{
+    pAT_COMMAND_WAIT pWait = (pAT_COMMAND_WAIT) pArg;
+    pAT_ENGINE pE = &(cpdGetContext()->modemInfo.atEngine);
+
+    pthread_mutex_lock(&(pE->lock));
+    pWait->response = response;
+    pWait->latency = latency;
+    pWait->done = 1;
+    pthread_cond_broadcast(&(pE->done));
+    pthread_mutex_unlock(&(pE->lock));
+}
 
-int modem_find_str(char *pB, int len, char *findMe, int lenStr)
+/*
+ * Send AT Commands to modem.
+ * If <timeout> is not 0, command is queued and caller waits until it completes: final result (OK, ERROR)
+ * or <waitFor> response is received, or there was no response <timeout> ms after the command was written.
+ * <pWait> (may be NULL) is set to response received and response time.
+ * Return value is number of bytes sent, 0 if command could not be sent or there was no response.
+ */
+int cpdModemSendCommandWait(pCPD_CONTEXT pCpd, const char *pB, int len, int waitFor, unsigned int timeout, pAT_COMMAND_WAIT pWait)
 {
-    int result = -1;
-    char *pS = NULL;
+    pAT_ENGINE pE = &(pCpd->modemInfo.atEngine);
+    AT_COMMAND_WAIT wait;
+    struct timeval now;
+    struct timespec deadline;
+    int left;
 
-    if (len <= 0) {
-        return result;
+    memset(&wait, 0, sizeof(wait));
+    wait.response = AT_RESPONSE_NONE;
+    if (pWait != NULL) {
+        *pWait = wait;
     }
-    if (pB == NULL) {
-        return result;
+    if ((pB == NULL) || (len <= 0)) {
+        return 0;
+    }
+    if (timeout == 0) {
+        return cpdModemWriteCommand(pCpd, pB, len);
+    }
+    if (cpdModemSubmitCommand(pCpd, pB, len, waitFor, timeout, cpdModemCommandWaitDone, &wait) != CPD_OK) {
+        return 0;
     }
 
-    pS = strstr(pB, findMe);
-    if (pS != NULL){
-        result = (int) (pS - pB);
-        if (result > len) {
-            result = -1;
+    pthread_mutex_lock(&(pE->lock));
+    while (wait.done == 0) {
+        pthread_mutex_unlock(&(pE->lock));
+        /* read thread times out commands too, but it may be blocked in read */
+        left = cpdModemCommandCheckTimeout(pCpd);
+        if (left < 0) {
+            left = (int) timeout;
+        }
+        gettimeofday(&now, NULL);
+        deadline.tv_sec = now.tv_sec + (left / 1000);
+        deadline.tv_nsec = (now.tv_usec * 1000L) + ((left % 1000) * 1000000L);
+        if (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_sec++;
+            deadline.tv_nsec = deadline.tv_nsec - 1000000000L;
+        }
+        pthread_mutex_lock(&(pE->lock));
+        if (wait.done == 0) {
+            pthread_cond_timedwait(&(pE->done), &(pE->lock), &deadline);
         }
     }
-    return result;
-}
+    pthread_mutex_unlock(&(pE->lock));
 
+    if (pWait != NULL) {
+        *pWait = wait;
+    }
+    return (wait.response != AT_RESPONSE_NONE) ? len : 0;
+}
 
+/*
+ * Send AT Commands to modem, wait up to <waitForResponse> ms for final result.
+ * Return value is number of bytes sent.
+ */
+int cpdModemSendCommand(pCPD_CONTEXT pCpd, const char *pB, int len, unsigned int waitForResponse)
+{
+    return cpdModemSendCommandWait(pCpd, pB, len, AT_RESPONSE_OK, waitForResponse, NULL);
+}
 
-int modem_find_Esc(char *pB, int len)
+int cpdModemSocketWriteToAllExcpet(pSOCKET_SERVER pSS, char *pB, int len, int noWrite)
 {
-    int result = -1;
+    int rr;
     int i;
+    pCPD_CONTEXT pCpd = cpdGetContext();
+    int result = 0;
+    unsigned int t0;
 
-    if (pB == NULL) {
+    if ((pB == NULL) || (len <= 0) || (pCpd == NULL)) {
         return result;
     }
-
-    for (i = 0; i < len; i++)
+    result = modemWrite(pCpd->modemInfo.modemFd, pB, len);
+    t0 = getMsecTime();
+    CPD_LOG(CPD_LOG_ID_TXT, "\r\nTx, %09u,[", t0);
+    CPD_LOG_DATA(CPD_LOG_ID_MODEM_RXTX | CPD_LOG_ID_MODEM_TX | CPD_LOG_ID_TXT , pB,  len);
+    CPD_LOG(CPD_LOG_ID_TXT, "]\r\n");
     {
-        if (pB[i] == AT_CMD_ESC_CHR) {
-            if (result < 0) {
-                result = i;
-                CPD_LOG(CPD_LOG_ID_TXT, "\nESC at %d\n", result);
-                break;
-            }
-        }
+        int r;
+        /* pass-through message to other sockets */
+        r = cpdSocketWriteToAllExcpet(pSS, pB, result, noWrite);
     }
+    result = CPD_OK;
     return result;
 }
 
 
-int modem_find_CtrlZ(char *pB, int len)
+int cpdModemFindCharX(char *pB, int len, char findMe)
 {
-    int result = -1;
-    int i;
-
-    if (pB == NULL) {
-        return result;
-    }
-
-    for (i = 0; i < len; i++)
-    {
-        if (pB[i] == AT_CMD_CTRL_Z_CHR) {
-            if (result < 0) {
-                result = i;
-                CPD_LOG(CPD_LOG_ID_TXT, "\nCtrl-Z at %d\n", result);
-                break;
-            }
-        }
-    }
-    return result;
+    return cpdScanFindChar(pB, len, findMe);
 }
 
-int modem_find_any_unsol_response(char *pB, int len)
+
+int modem_find_str(char *pB, int len, char *findMe, int lenStr)
 {
-    int result = CPD_ERROR;
-    char unsolResponse[64];
-    snprintf(unsolResponse, 63, "%s%c", AT_CMD_CPOSR,AT_CMD_COL_CHR);
-    result = modem_find_str(pB, len, unsolResponse, strlen(unsolResponse));
-    if (result > 1) {
-        if (!((pB[result - 2] == '\r') && (pB[result - 1] == '\n'))) {
-            result = CPD_ERROR;
-        }
-    }
-    if (result >= 0) {
-        if (result > len) {
-            result = CPD_ERROR;
-        }
-    }
-    //TODO: add other responses here and find the first one..
-    return result;
+    return cpdScanFindString(pB, len, findMe, lenStr);
 }
 
+/*
+ * Release <left> bytes from the start of Rx data.
+ * Nothing is moved, Rx ring buffer just advances its tail.
+ */
 int cpdModemMoveRxBufferLeft(pCPD_CONTEXT pCpd, int left)
 {
-    if (left < 0) {
-        return pCpd->modemInfo.modemRxBufferIndex;
+    int used = cpdRingBufferUsed(&(pCpd->modemInfo.modemRxRing));
+
+    if (left <= 0) {
+        return used;
     }
 
-    if (left > pCpd->modemInfo.modemRxBufferIndex) {
-        left = pCpd->modemInfo.modemRxBufferIndex;
+    if (left > used) {
+        left = used;
     }
-    memmove((pCpd->modemInfo.pModemRxBuffer), (pCpd->modemInfo.pModemRxBuffer + left), pCpd->modemInfo.modemRxBufferIndex);
-    pCpd->modemInfo.modemRxBufferIndex = pCpd->modemInfo.modemRxBufferIndex - left;
-    return pCpd->modemInfo.modemRxBufferIndex;
+    used = cpdRingBufferRelease(&(pCpd->modemInfo.modemRxRing), left);
+    cpdAtTokenizerRebase(&(pCpd->modemInfo.atTokenizer), left);
+    return used;
 }
 
 /*
@@ -381,20 +480,21 @@ int cpdModemProcessOkResponse(pCPD_CONTEXT pCpd, int iOk, int iOkLen)
     int i, j;
     int iCol = -1;
     char *pName, *pValue;
+    char *pRx = cpdRingBufferData(&(pCpd->modemInfo.modemRxRing));
     int result = CPD_NOK;
     /* null-terminate response string */
     i = iOk;
     for (j = 0; j < iOkLen; j++) {
-        pCpd->modemInfo.pModemRxBuffer[i++] = 0;
+        pRx[i++] = 0;
     }
 
-    utilStripResponse(pCpd->modemInfo.pModemRxBuffer);
-    iCol = cpdModemFindCharX(pCpd->modemInfo.pModemRxBuffer, iOk, AT_CMD_COL_CHR);
+    utilStripResponse(pRx);
+    iCol = cpdModemFindCharX(pRx, iOk, AT_CMD_COL_CHR);
 
-    pName = pCpd->modemInfo.pModemRxBuffer;
+    pName = pRx;
     if (iCol > 0) {
-        pCpd->modemInfo.pModemRxBuffer[iCol] = 0;
-        pValue = &(pCpd->modemInfo.pModemRxBuffer[iCol + 1]);
+        pRx[iCol] = 0;
+        pValue = &(pRx[iCol + 1]);
         utilStripResponse(pValue);
     }
     else {
@@ -418,13 +518,6 @@ int cpdModemProcessOkResponse(pCPD_CONTEXT pCpd, int iOk, int iOkLen)
             getMsecTime(), pCpd->modemInfo.registeredForCPOSR, pCpd->modemInfo.registeredForCPOSRat);
     }
 
-    if (pCpd->modemInfo.waitingForResponse != 0){
-        pCpd->modemInfo.haveResponse    = 1;
-        pCpd->modemInfo.responseValue = AT_RESPONSE_OK;
-        pCpd->modemInfo.waitingForResponse = 0;
-    }
-
-
     cpdModemMoveRxBufferLeft(pCpd, iOk + iOkLen);
     return result;
 }
@@ -432,18 +525,13 @@ int cpdModemProcessOkResponse(pCPD_CONTEXT pCpd, int iOk, int iOkLen)
 int cpdModemProcessErrorResponse(pCPD_CONTEXT pCpd, int iError, int iErrorLen)
 {
     int i, j;
+    char *pRx = cpdRingBufferData(&(pCpd->modemInfo.modemRxRing));
     i = iError;
     for (j = 0; j < iErrorLen; j++) {
-        pCpd->modemInfo.pModemRxBuffer[i++] = 0;
-    }
-    CPD_LOG(CPD_LOG_ID_TXT, "\n%u,ERROR @ %d, message:%s\n", getMsecTime(), iError, pCpd->modemInfo.pModemRxBuffer);
-    LOGE("%u,MODEM ERROR @ %d, message:%s\n", getMsecTime(), iError, pCpd->modemInfo.pModemRxBuffer);
-
-    if (pCpd->modemInfo.waitingForResponse != 0){
-        pCpd->modemInfo.haveResponse    = 1;
-        pCpd->modemInfo.responseValue = AT_RESPONSE_ERROR;
-        pCpd->modemInfo.waitingForResponse = 0;
+        pRx[i++] = 0;
     }
+    CPD_LOG(CPD_LOG_ID_TXT, "\n%u,ERROR @ %d, message:%s\n", getMsecTime(), iError, pRx);
+    LOGE("%u,MODEM ERROR @ %d, message:%s\n", getMsecTime(), iError, pRx);
 
     cpdModemMoveRxBufferLeft(pCpd, iError + iErrorLen);
     return 0;
@@ -451,136 +539,108 @@ int cpdModemProcessErrorResponse(pCPD_CONTEXT pCpd, int iError, int iErrorLen)
 
 /*
  * Process "unsolicited" modem respnse CPOSR: <xml>
-  * Check if response is just plain CPOSR status reponse, if so, process it accordingly.
+ * URC is [iUsolResp, iEnd) in Rx buffer, followed by iEndLen bytes of terminator.
+ * URC is removed from Rx buffer even if XML parser doesn't accept it, so it can't block the Rx path.
  */
-int cpdModemProcessUnsolResponse(pCPD_CONTEXT pCpd, int iUsolResp, int iCrLf2x)
+int cpdModemProcessUnsolResponse(pCPD_CONTEXT pCpd, int iUsolResp, int iEnd, int iEndLen)
 {
     int result = CPD_NOK;
-    int i, j;
     int iCol = -1;
-    int iCrLf2xLen;
-    int iOk = -1;
-    int iXml = -1;
     char *pName, *pValue;
+    char *pRx = cpdRingBufferData(&(pCpd->modemInfo.modemRxRing));
 
+    /* null-terminate response string */
+    pRx[iEnd] = 0;
 
-    /* check if this is just a response to +CPOSR? comand */
-    iOk = cpdModemFindOk(pCpd->modemInfo.pModemRxBuffer, pCpd->modemInfo.modemRxBufferIndex);
-    iXml = cpdModemFindCharX(pCpd->modemInfo.pModemRxBuffer, iCrLf2x, XML_START_CHAR);
-
-    if (iOk > 0) {
-        if ((iXml < 0) || (iXml > iOk)) {
-            if (pCpd->modemInfo.receivingXml != CPD_OK) {
-                result = cpdModemProcessOkResponse(pCpd, iOk, 4);
-                return result;
-            }
-        }
-    }
-    iCrLf2xLen = strlen(AT_UNSOL_RESPONSE_END1);
-    if ((pCpd->modemInfo.pModemRxBuffer[iCrLf2x] == AT_CMD_ESC_CHR) ||
-        (pCpd->modemInfo.pModemRxBuffer[iCrLf2x] == AT_CMD_CTRL_Z_CHR)) {
-        iCrLf2xLen = 1;
-    }
-    i = iCrLf2x;
-    for (j = 0; j < iCrLf2xLen; j++) {
-        if (pCpd->modemInfo.pModemRxBuffer[i] <= ' ') {
-            pCpd->modemInfo.pModemRxBuffer[i] = 0;
-        }
-        i++;
-    }
-
-    iCol = cpdModemFindCharX(pCpd->modemInfo.pModemRxBuffer, iCrLf2x, AT_CMD_COL_CHR);
-    pName = pCpd->modemInfo.pModemRxBuffer;
+    pName = &(pRx[iUsolResp]);
+    iCol = cpdModemFindCharX(pName, iEnd - iUsolResp, AT_CMD_COL_CHR);
     if (iCol > 0) {
-        pCpd->modemInfo.pModemRxBuffer[iCol] = 0;
-        utilStripResponse(pName);
-        pValue = &(pCpd->modemInfo.pModemRxBuffer[iCol + 2]);
-    }
-    else {
-        pValue = NULL;
-    }
-    if (pValue != NULL) {
+        pValue = &(pName[iCol + 1]);
+        while (*pValue == ' ') {
+            pValue++;
+        }
         result = cpdXmlParse(pCpd, pValue, strlen(pValue));
     }
 
-    if (result == CPD_OK) {
-        cpdModemMoveRxBufferLeft(pCpd, iCrLf2x + iCrLf2xLen);
-    }
-
+    cpdModemMoveRxBufferLeft(pCpd, iEnd + iEndLen);
     return result;
 }
 
 
-
-
+/*
+ * Pass tokens found in Rx buffer to response handlers.
+ * Tokenizer continues from where it stopped on the previous call, so every received byte is scanned only once.
+ */
 int cpdModemProcessRxData(pCPD_CONTEXT pCpd)
 {
-    int iOk = -1;
-    int iError = -1;
-    int iCtrlZ = -1;
-    int iEsc = -1;
-    int iRing = -1;
-    int iColumn = -1;
-    int iTermLen = 1;
-
-    while (pCpd->modemInfo.modemRxBufferIndex > 0) {
-
-        iOk = cpdModemFindOk(pCpd->modemInfo.pModemRxBuffer, pCpd->modemInfo.modemRxBufferIndex);
-        iError = cpdModemFindError(pCpd->modemInfo.pModemRxBuffer, pCpd->modemInfo.modemRxBufferIndex);
-        iCtrlZ = modem_find_CtrlZ(pCpd->modemInfo.pModemRxBuffer, pCpd->modemInfo.modemRxBufferIndex);
-        iEsc = modem_find_Esc(pCpd->modemInfo.pModemRxBuffer, pCpd->modemInfo.modemRxBufferIndex);
-        iRing = modem_find_str(pCpd->modemInfo.pModemRxBuffer, pCpd->modemInfo.modemRxBufferIndex, AT_CMD_RING AT_CMD_CRLF, strlen(AT_CMD_RING AT_CMD_CRLF));
-
-        if (((iOk < 0) && (iRing >= 0)) ||
-            ((iOk > iRing) && (iRing >= 0))) {
-            iOk = iRing;
-        }
-
-        if ((iOk < 0) && (iError < 0) && (iCtrlZ < 0) && (iEsc < 0)) {
-            /* no more complete responses in the buffer */
-            break;
-        }
-
-        if ((iOk >= 0) || (iCtrlZ >= 0)) {
-            if (iOk < 0) {
-                iOk = iCtrlZ;
-            }
-            else {
-                iTermLen = 4;
-            }
-            if ((iError < 0) || (iError > iOk)) {
-                cpdModemProcessOkResponse(pCpd, iOk, iTermLen);
-                iOk = -1;
-            }
-        }
-
-        if ((iError >= 0) || ((iEsc >= 0))) {
-            if (iError < 0) {
-                iError = iEsc;
-            }
-            else {
-                iTermLen = 7;
-            }
-
-            if ((iOk < 0) || (iOk > iError)) {
-                cpdModemProcessErrorResponse(pCpd, iError, iTermLen);
-                iError = -1;
-            }
+    AT_TOKEN token;
+
+    while (cpdAtTokenizerNext(&(pCpd->modemInfo.atTokenizer), cpdRingBufferData(&(pCpd->modemInfo.modemRxRing)),
+                                cpdRingBufferUsed(&(pCpd->modemInfo.modemRxRing)), &token) == CPD_OK) {
+        switch (token.type) {
+            case AT_TOKEN_OK:
+                cpdModemProcessOkResponse(pCpd, token.start, token.len);
+                cpdModemCommandComplete(pCpd, AT_RESPONSE_OK);
+                break;
+            case AT_TOKEN_ERROR:
+                cpdModemProcessErrorResponse(pCpd, token.start, token.len);
+                cpdModemCommandComplete(pCpd, AT_RESPONSE_ERROR);
+                break;
+            /* Ctrl-Z, ESC terminate data sent to modem (echo), they are not final result of the command */
+            case AT_TOKEN_CTRL_Z:
+                cpdModemProcessOkResponse(pCpd, token.start, token.len);
+                break;
+            case AT_TOKEN_ESC:
+                cpdModemProcessErrorResponse(pCpd, token.start, token.len);
+                break;
+            case AT_TOKEN_RING:
+                CPD_LOG(CPD_LOG_ID_TXT, "\n !!! RING !!! @ %d", token.start);
+                /* do not drop response text of a command in progress */
+                if (cpdModemCommandIsPending(pCpd) == 0) {
+                    cpdModemMoveRxBufferLeft(pCpd, token.start + token.len);
+                }
+                break;
+            case AT_TOKEN_URC_START:
+                CPD_LOG(CPD_LOG_ID_TXT, "\n%u: URC @ %d", getMsecTime(), token.urcStart);
+                break;
+            case AT_TOKEN_URC_END:
+                /*
+                 * +CPOSR without XML, while waiting for command response, is response to +CPOSR? command,
+                 * leave it in the buffer to be processed with OK.
+                 */
+                if ((token.urcHasXml == 0) &&
+                    (cpdModemCommandIsPending(pCpd) != 0) &&
+                    (pCpd->modemInfo.receivingXml != CPD_OK)) {
+                    break;
+                }
+                cpdModemProcessUnsolResponse(pCpd, token.urcStart, token.start, token.len);
+                break;
+            default:
+                break;
         }
     }
 
-    return CPD_OK; /* TBD */
+    return CPD_OK;
 }
 
 static int cpdCheckIfReceivedWaitForString(pCPD_CONTEXT pCpd)
 {
     int result = CPD_NOK;
     int index;
+    int waitFor;
+
+    pthread_mutex_lock(&(pCpd->modemInfo.atEngine.lock));
+    waitFor = (pCpd->modemInfo.atEngine.inFlight != 0) ?
+        pCpd->modemInfo.atEngine.queue[pCpd->modemInfo.atEngine.head].waitFor : AT_RESPONSE_NONE;
+    pthread_mutex_unlock(&(pCpd->modemInfo.atEngine.lock));
+    if (waitFor <= AT_RESPONSE_OK) {
+        return result;
+    }
     CPD_LOG(CPD_LOG_ID_TXT, "\n%u: %s()\n", getMsecTime(), __FUNCTION__);
     LOGV("%u: %s()", getMsecTime(), __FUNCTION__);
-    switch (pCpd->modemInfo.waitForThisResponse) {
+    switch (waitFor) {
         case AT_RESPONSE_CRLF:
-            index = modem_find_str(pCpd->modemInfo.pModemRxBuffer, pCpd->modemInfo.modemRxBufferIndex, AT_CMD_CRLF, strlen(AT_CMD_CRLF));
+            index = modem_find_str(cpdRingBufferData(&(pCpd->modemInfo.modemRxRing)), cpdRingBufferUsed(&(pCpd->modemInfo.modemRxRing)), AT_CMD_CRLF, strlen(AT_CMD_CRLF));
             if (index >= 0) {
                 result = CPD_OK;
             }
@@ -592,8 +652,7 @@ static int cpdCheckIfReceivedWaitForString(pCPD_CONTEXT pCpd)
             break;
     }
     if (result == CPD_OK) {
-        pCpd->modemInfo.haveResponse = result;
-        pCpd->modemInfo.waitForThisResponse = AT_RESPONSE_NONE;
+        cpdModemCommandComplete(pCpd, waitFor);
     }
     CPD_LOG(CPD_LOG_ID_TXT, "\n%u: %s()=%d", getMsecTime(), __FUNCTION__, result);
     LOGD("%u: %s()=%d", getMsecTime(), __FUNCTION__, result);
@@ -601,159 +660,57 @@ static int cpdCheckIfReceivedWaitForString(pCPD_CONTEXT pCpd)
 }
 
 /*
- * Copy received data into buffer and do first-pass of checking buffer for any useful data.
+ * Get space for at least <len> bytes of new data in Rx ring buffer.
+ * If there is not enough free space, the oldest data is dropped.
+ * Returns pointer to free space, <*pAvailable> is set to number of bytes that can be written there.
  */
-int cpdModemReadAndCopyData(pCPD_CONTEXT pCpd, char *pRxBuffer, int len)
+static char *cpdModemGetRxSpace(pCPD_CONTEXT pCpd, int len, int *pAvailable)
 {
-    int i;
-    int available = 0;
-    int iOk = -1;
-    int iError = -1;
-    int iCtrlZ = -1;
-    int iEsc = -1;
-    int iCrLf2x = -1;
-    int iUsolResp = -1;
-    int iUsolResp2 = -1;
-    int iRing = -1;
-    int tryAgain = 0;
-    char pStr[64];
-
-    if (pCpd->modemInfo.pModemRxBuffer == NULL) {
-        return CPD_NOK;
-    }
-
-    /* copy data into the main buffer */
-    available = pCpd->modemInfo.modemRxBufferSize - pCpd->modemInfo.modemRxBufferIndex - 1;
-
-    if (len > available) {
-        cpdModemMoveRxBufferLeft(pCpd, (len - available));
-    }
-    memcpy((pCpd->modemInfo.pModemRxBuffer + pCpd->modemInfo.modemRxBufferIndex), pRxBuffer, len);
-    pCpd->modemInfo.modemRxBufferIndex =  pCpd->modemInfo.modemRxBufferIndex + len;
-    pCpd->modemInfo.pModemRxBuffer[pCpd->modemInfo.modemRxBufferIndex] = 0;
+    char *pB;
 
-    if (pCpd->modemInfo.waitForThisResponse > AT_RESPONSE_OK) {
-        cpdCheckIfReceivedWaitForString(pCpd);
+    pB = cpdRingBufferWriteSpace(&(pCpd->modemInfo.modemRxRing), pAvailable);
+    if (*pAvailable < len) {
+        LOGW("%s(), Rx buffer full, dropping %d bytes", __FUNCTION__, len - *pAvailable);
+        cpdModemMoveRxBufferLeft(pCpd, len - *pAvailable);
+        pB = cpdRingBufferWriteSpace(&(pCpd->modemInfo.modemRxRing), pAvailable);
     }
+    return pB;
+}
 
-    while (pCpd->modemInfo.modemRxBufferIndex > 0) {
-        tryAgain = 0;
-        iOk = cpdModemFindOk(pCpd->modemInfo.pModemRxBuffer, pCpd->modemInfo.modemRxBufferIndex);
-
-        iError = cpdModemFindError(pCpd->modemInfo.pModemRxBuffer, pCpd->modemInfo.modemRxBufferIndex);
-
-        iCtrlZ = modem_find_CtrlZ(pCpd->modemInfo.pModemRxBuffer, pCpd->modemInfo.modemRxBufferIndex);
+/*
+ * <len> bytes of new data were written into Rx ring buffer, process all complete responses.
+ */
+static int cpdModemProcessNewRxData(pCPD_CONTEXT pCpd, int len)
+{
+    cpdRingBufferCommit(&(pCpd->modemInfo.modemRxRing), len);
 
-        iEsc = modem_find_Esc(pCpd->modemInfo.pModemRxBuffer, pCpd->modemInfo.modemRxBufferIndex);
+    cpdCheckIfReceivedWaitForString(pCpd);
 
-        iRing = modem_find_str(pCpd->modemInfo.pModemRxBuffer, pCpd->modemInfo.modemRxBufferIndex, AT_CMD_RING AT_CMD_CRLF, strlen(AT_CMD_RING AT_CMD_CRLF));
-        if (iRing >= 0) {
-            CPD_LOG(CPD_LOG_ID_TXT, "\n !!! RING !!! @ %d", iRing) ;
-        }
+    return cpdModemProcessRxData(pCpd);
+}
 
-        iUsolResp = modem_find_any_unsol_response(pCpd->modemInfo.pModemRxBuffer, pCpd->modemInfo.modemRxBufferIndex);
-        /*
-        CPD_LOG(CPD_LOG_ID_TXT , "\niOk=%d, iError=%d, iCtrlZ=%d, iEsc=%d, iRing=%d, iUsolResp=%d, tryAgain=%d",
-            iOk, iError, iCtrlZ, iEsc, iRing, iUsolResp, tryAgain);
-        */
-        if (iUsolResp >= 0) {
-            if ((iOk >= 0) && (iOk < iUsolResp)) {
-                iUsolResp = -1;
 /*
-                CPD_LOG(CPD_LOG_ID_TXT , "\niOk=%d, iError=%d, iCtrlZ=%d, iEsc=%d, iRing=%d, iUsolResp=%d, tryAgain=%d",
-                    iOk, iError, iCtrlZ, iEsc, iRing, iUsolResp, tryAgain);
-*/
-            }
-            if ((iError >= 0) && (iError < iUsolResp)) {
-                iUsolResp = -1;
-                /*
-                CPD_LOG(CPD_LOG_ID_TXT , "\niOk=%d, iError=%d, iCtrlZ=%d, iEsc=%d, iRing=%d, iUsolResp=%d, tryAgain=%d",
-                    iOk, iError, iCtrlZ, iEsc, iRing, iUsolResp, tryAgain);
-*/
-            }
-            if ((iCtrlZ >= 0) && (iCtrlZ < iUsolResp)) {
-                iUsolResp = -1;
-                /*
-                CPD_LOG(CPD_LOG_ID_TXT , "\niOk=%d, iError=%d, iCtrlZ=%d, iEsc=%d, iRing=%d, iUsolResp=%d, tryAgain=%d",
-                    iOk, iError, iCtrlZ, iEsc, iRing, iUsolResp, tryAgain);
-                */
-            }
-            if ((iRing >= 0) && (iRing < iUsolResp)) {
-                iUsolResp = -1;
-                /*
-                CPD_LOG(CPD_LOG_ID_TXT , "\niOk=%d, iError=%d, iCtrlZ=%d, iEsc=%d, iRing=%d, iUsolResp=%d, tryAgain=%d",
-                    iOk, iError, iCtrlZ, iEsc, iRing, iUsolResp, tryAgain);
-                    */
-            }
-        }
-
-        if (iUsolResp >= 0) {
-            /*
-                    CPD_LOG(CPD_LOG_ID_TXT, "\nProcessing iUsolResp @ %d", iUsolResp) ;
-                    */
-            iCrLf2x = modem_find_str(&(pCpd->modemInfo.pModemRxBuffer[iUsolResp]), (pCpd->modemInfo.modemRxBufferIndex - iUsolResp), AT_UNSOL_RESPONSE_END1, strlen(AT_UNSOL_RESPONSE_END1));
-            if (iCrLf2x < 0) {
-                iCrLf2x = modem_find_str(&(pCpd->modemInfo.pModemRxBuffer[iUsolResp]), (pCpd->modemInfo.modemRxBufferIndex - iUsolResp), AT_UNSOL_RESPONSE_END2, strlen(AT_UNSOL_RESPONSE_END2));
-            }
-            if (iCrLf2x > 0) {
-                iCrLf2x = iCrLf2x + iUsolResp;
-/*                CPD_LOG(CPD_LOG_ID_TXT, "\n1.Found iCrLf2x @ %d = %02X",iCrLf2x, pCpd->modemInfo.pModemRxBuffer[iCrLf2x]) ; */
-                iUsolResp2 = modem_find_any_unsol_response(&(pCpd->modemInfo.pModemRxBuffer[iUsolResp+1]), pCpd->modemInfo.modemRxBufferIndex - (iUsolResp+1));
-                if (iUsolResp2 >= 0) {
-                    iUsolResp2 = iUsolResp2 + iUsolResp + 1;
-                    if (iCrLf2x > iUsolResp2) {
-                        /*
-                                    CPD_LOG(CPD_LOG_ID_TXT, "\n!.Found iCrLf2x @ %d = %02X, iUsolResp2 = %d",iCrLf2x, pCpd->modemInfo.pModemRxBuffer[iCrLf2x], iUsolResp2) ;
-                                    */
-                    }
-               }
-            }
-            if ((iCrLf2x < 0) && ((iCtrlZ > iUsolResp) || (iEsc > iUsolResp))) {
-                if ((iCtrlZ >= 0) && ((iCtrlZ < iEsc) || (iEsc < 0))){
-                    iCrLf2x = iCtrlZ;
-                    iCtrlZ = -1;
-                    iEsc = -1;
-                }
-                if ((iEsc >= 0) && ((iEsc < iCtrlZ)  || (iCtrlZ < 0))){
-                    iCrLf2x = iEsc;
-                    iCtrlZ = -1;
-                    iEsc = -1;
-                }
-            }
-
-            if (iCrLf2x >= 0) {
-                if ((iUsolResp < iOk) && (iOk >= 0)) {
-                    iOk = -1;
-                }
-                if ((iUsolResp < iError) && (iError >= 0)) {
-                    iError = -1;
-                }
-                if ((iUsolResp < iCtrlZ) && (iCtrlZ >= 0)) {
-                    iCtrlZ = -1;
-                }
-                if ((iUsolResp < iEsc) && (iEsc >= 0)) {
-                    iEsc = -1;
-                }
-                if ((iUsolResp < iRing) && (iRing >= 0)) {
-                    iRing = -1;
-                }
-                if ((iOk < 0) && (iError < 0) && (iCtrlZ < 0) && (iEsc < 0)) {
-                    cpdModemProcessUnsolResponse(pCpd, iUsolResp, iCrLf2x);
-                    tryAgain = 1;
-                }
-            }
-        }
+ * Copy received data into buffer and process all complete responses in it.
+ * Modem read thread receives data directly into Rx buffer, this is used for data coming from other sources.
+ */
+int cpdModemReadAndCopyData(pCPD_CONTEXT pCpd, char *pRxBuffer, int len)
+{
+    int available = 0;
+    char *pB;
 
+    if ((pCpd->modemInfo.modemRxRing.pBuffer == NULL) || (len <= 0)) {
+        return CPD_NOK;
+    }
 
-        if ((iOk >= 0) || (iError >= 0) || (iCtrlZ >= 0) || (iEsc >= 0) || (iRing >= 0)) {
-            cpdModemProcessRxData(pCpd);
-            tryAgain = 1;
-        }
-        if (tryAgain == 0) {
-            break;
-        }
+    pB = cpdModemGetRxSpace(pCpd, len, &available);
+    if (len > available) {
+        /* can't be more than the whole buffer */
+        pRxBuffer = pRxBuffer + (len - available);
+        len = available;
     }
-    return CPD_OK;
+    memcpy(pB, pRxBuffer, len);
+
+    return cpdModemProcessNewRxData(pCpd, len);
 }
 
 
@@ -761,7 +718,9 @@ int cpdModemReadAndCopyData(pCPD_CONTEXT pCpd, char *pRxBuffer, int len)
 void *cpdModemReadThreadLoop(void *arg)
 {
     int fd = 0;
-    char pRxBuffer[TEMP_RX_BUFF_SIZE];
+    char *pRxBuffer;
+    int available;
+    int timeout;
     int result, i, r;
     struct sigaction sigact;
     pCPD_CONTEXT pCpd = (pCPD_CONTEXT) arg;
@@ -786,8 +745,11 @@ void *cpdModemReadThreadLoop(void *arg)
             pCpd->modemInfo.modemReadThreadState);
 
     while (pCpd->modemInfo.modemReadThreadState == THREAD_STATE_RUNNING) {
-        pRxBuffer[0] = 0;
-        result = modemRead(pCpd->modemInfo.modemFd, pRxBuffer, TEMP_RX_BUFF_SIZE - 1);
+        /* read directly into Rx ring buffer */
+        pRxBuffer = cpdModemGetRxSpace(pCpd, MODEM_RX_MIN_READ_SIZE, &available);
+        /* don't block longer than AT command in flight is allowed to wait for response */
+        timeout = cpdModemCommandCheckTimeout(pCpd);
+        result = modemReadTimeout(pCpd->modemInfo.modemFd, pRxBuffer, available, timeout);
         /* return value will be negative only on real error, not on empty buffer */
         if (result < 0) {
             CPD_LOG(CPD_LOG_ID_TXT , "\n%u: !!!Error %d reading from fd=%d Closing fd!\n", getMsecTime(), result, pCpd->modemInfo.modemFd);
@@ -805,7 +767,7 @@ void *cpdModemReadThreadLoop(void *arg)
         /* don't waste time with null responses */
         if (result > 0)
         {
-            pRxBuffer[result] = 0;
+            pRxBuffer[result] = 0;  /* for pass-through and logging, data is not committed yet */
             pCpd->modemInfo.lastDataReceived = getMsecTime();
             /* pass-through message */
             r = cpdSocketWriteToAll(&(pCpd->ssModemComm), pRxBuffer, result);
@@ -814,11 +776,11 @@ void *cpdModemReadThreadLoop(void *arg)
             CPD_LOG_DATA(CPD_LOG_ID_MODEM_RXTX | CPD_LOG_ID_MODEM_RX | CPD_LOG_ID_TXT, pRxBuffer, result);
             CPD_LOG(CPD_LOG_ID_TXT, "]\r\n");
             /* process received data */
-            r = cpdModemReadAndCopyData(pCpd, pRxBuffer, result);
+            r = cpdModemProcessNewRxData(pCpd, result);
         }
 
         /* no data, don't try reading again, but wait.. */
-        if (result == 0) {
+        if ((result == 0) && (timeout < 0)) {
 //            CPD_LOG(CPD_LOG_ID_TXT, "\r\n%09u,!!! 0 read from modem", getMsecTime());
             usleep(MODEM_POOL_INTERVAL * 1000UL);
         }
@@ -830,45 +792,74 @@ void *cpdModemReadThreadLoop(void *arg)
 }
 
 
+/*
+ * Called when the last command of +CPOSR registration sequence completes,
+ * <latency> is the time modem took to answer it.
+ */
+static void cpdModemInitForCPDone(void *pArg, int response, unsigned int latency)
+{
+    pCPD_CONTEXT pCpd = (pCPD_CONTEXT) pArg;
+
+    pCpd->modemInfo.initForCPPending = 0;
+    if ((pCpd->modemInfo.registeredForCPOSR == CPD_OK) && (pCpd->modemInfo.modemUpAt != 0)) {
+        pCpd->modemInfo.cposrRegistrationTime = pCpd->modemInfo.registeredForCPOSRat - pCpd->modemInfo.modemUpAt;
+        pCpd->modemInfo.modemUpAt = 0;
+        CPD_LOG(CPD_LOG_ID_TXT | CPD_LOG_ID_CONSOLE, "\n CPOSR registered : %u ms from modem up, last command %u ms",
+            pCpd->modemInfo.cposrRegistrationTime, latency);
+        LOGD("CPOSR registered : %u ms from modem up, last command %u ms", pCpd->modemInfo.cposrRegistrationTime, latency);
+    }
+    CPD_LOG(CPD_LOG_ID_TXT, "\n %u:%s() = %d, %d, %u ms, last command %u ms", getMsecTime(), __FUNCTION__,
+        pCpd->modemInfo.registeredForCPOSR, response, getMsecDt(pCpd->modemInfo.initForCPStartedAt), latency);
+    LOGD("%u:%s() = %d, %d, %u ms, last command %u ms", getMsecTime(), __FUNCTION__,
+        pCpd->modemInfo.registeredForCPOSR, response, getMsecDt(pCpd->modemInfo.initForCPStartedAt), latency);
+}
+
 /*
  * Register CPD with modem to receive CPOSR <XML> responses from modem.
- * returns: CPD_OK if modem accepts registration,
- *             CPD_NOK otherwise.
+ * Registration commands are queued, function does not wait for modem responses.
+ * returns: CPD_NOK, CPD is registered only when the last command completes with +CPOSR: 1.
  */
 int cpdModemInitForCP(pCPD_CONTEXT pCpd)
 {
-    int result = CPD_ERROR;
-    int r;
+    /* AT+CPOSR=1 must be followed by AT+CPOSR?, registration state is taken from its response */
+    const char *pCmds[] = {
+        pCmdAt,
+        /* these comands are sent as part of debug procedure, remove later, not needed for real CPD operation */
+        pCmdXgendata, pCmdCsqQ, pCmdCregQ, pCmdXratQ, pCmdCopsQ,
+        /* end debug commands */
+        pCmdCposr1, pCmdCposrQ
+    };
+    int n = sizeof(pCmds) / sizeof(pCmds[0]);
+    int result = CPD_NOK;
+    int i;
+
     CPD_LOG(CPD_LOG_ID_TXT, "\n%u:%s()", getMsecTime(), __FUNCTION__);
     LOGV("%u:%s()", getMsecTime(), __FUNCTION__);
 
-    r = cpdModemSendCommand(pCpd, pCmdAt, strlen(pCmdAt), AT_RESPONSE_TIMEOUT);
-    /* these comands are sent as part of debug procedure, remove later, not needed for real CPD operation */
-    r = cpdModemSendCommand(pCpd, pCmdXgendata, strlen(pCmdXgendata), AT_RESPONSE_TIMEOUT);
-    r = cpdModemSendCommand(pCpd, pCmdCsqQ, strlen(pCmdCsqQ), AT_RESPONSE_TIMEOUT);
-    r = cpdModemSendCommand(pCpd, pCmdCregQ, strlen(pCmdCregQ), AT_RESPONSE_TIMEOUT);
-    r = cpdModemSendCommand(pCpd, pCmdXratQ, strlen(pCmdXratQ), AT_RESPONSE_TIMEOUT);
-    r = cpdModemSendCommand(pCpd, pCmdCopsQ, strlen(pCmdCopsQ), AT_RESPONSE_TIMEOUT);
-    /* end debug commands */
+    if (pCpd->modemInfo.initForCPPending != 0) {
+        CPD_LOG(CPD_LOG_ID_TXT, "\n %u:%s(), registration in progress", getMsecTime(), __FUNCTION__);
+        return CPD_NOK;
+    }
+    if (cpdModemCommandQueueFree(pCpd) < n) {
+        LOGE("%u:%s(), AT command queue full", getMsecTime(), __FUNCTION__);
+        return CPD_NOK;
+    }
     pCpd->modemInfo.registeredForCPOSR = 0;
     pCpd->modemInfo.registeredForCPOSRat = 0;
     pCpd->modemInfo.receivedCPOSRat = 0;
     pCpd->modemInfo.processingCPOSRat = 0;
     pCpd->modemInfo.sendingCPOSat = 0;
+    pCpd->modemInfo.initForCPPending = 1;
+    pCpd->modemInfo.initForCPStartedAt = getMsecTime();
 
-    r = cpdModemSendCommand(pCpd, pCmdCposr1, strlen(pCmdCposr1), AT_RESPONSE_TIMEOUT);
-    r = cpdModemSendCommand(pCpd, pCmdCposrQ, strlen(pCmdCposrQ), AT_RESPONSE_TIMEOUT);
+    for (i = 0; i < n; i++) {
+        cpdModemSubmitCommand(pCpd, pCmds[i], strlen(pCmds[i]), AT_RESPONSE_OK, AT_RESPONSE_TIMEOUT,
+            (i == (n - 1)) ? cpdModemInitForCPDone : NULL, pCpd);
+    }
 
     // MUX debug code, turn MUX logging ON:
 //    r = cpdModemSendCommand(pCpd, pCmdMuxDebugOn, strlen(pCmdMuxDebugOn), AT_RESPONSE_TIMEOUT);
 
-    /* TODO: define error and handling here.. */
-    if (pCpd->modemInfo.registeredForCPOSR == CPD_OK) {
-        result = CPD_OK;
-    }
-    else {
-        result = CPD_NOK;
-    }
     CPD_LOG(CPD_LOG_ID_TXT, "\n %u:%s() = %d", getMsecTime(), __FUNCTION__, result);
     LOGD("%u:%s() = %d", getMsecTime(), __FUNCTION__, result);
     return result;
@@ -894,12 +885,8 @@ int cpdModemOpen(pCPD_CONTEXT pCpd)
         return result;
     }
 
-    if (pCpd->modemInfo.pModemRxBuffer == NULL) {
-        pCpd->modemInfo.pModemRxBuffer = malloc(MODEM_RX_BUFFER_SIZE);
-        if (pCpd->modemInfo.pModemRxBuffer != NULL) {
-            pCpd->modemInfo.modemRxBufferSize = MODEM_RX_BUFFER_SIZE;
-        }
-        else {
+    if (pCpd->modemInfo.modemRxRing.pBuffer == NULL) {
+        if (cpdRingBufferInit(&(pCpd->modemInfo.modemRxRing), MODEM_RX_BUFFER_SIZE) != CPD_OK) {
             LOGE("%u: %s()=%d, RxBuff==NULL", getMsecTime(), __FUNCTION__,  result);
             return result;
         }
@@ -919,8 +906,8 @@ int cpdModemOpen(pCPD_CONTEXT pCpd)
     if ((pCpd->modemInfo.modemReadThreadState == THREAD_STATE_OFF) ||
         (pCpd->modemInfo.modemReadThreadState == THREAD_STATE_TERMINATED)) {
 
-        memset(pCpd->modemInfo.pModemRxBuffer, 0, pCpd->modemInfo.modemRxBufferSize);
-        pCpd->modemInfo.modemRxBufferIndex = 0;
+        cpdRingBufferReset(&(pCpd->modemInfo.modemRxRing));
+        cpdAtTokenizerReset(&(pCpd->modemInfo.atTokenizer));
         memset(pCpd->modemInfo.pModemTxBuffer, 0, pCpd->modemInfo.modemTxBufferSize);
         pCpd->modemInfo.modemTxBufferIndex = 0;
 
@@ -942,8 +929,11 @@ int cpdModemOpen(pCPD_CONTEXT pCpd)
         pCpd->modemInfo.registeredForCPOSR = 0;
         pCpd->modemInfo.receivedCPOSRat = 0;
         pCpd->modemInfo.registeredForCPOSRat = 0;
-        pCpd->modemInfo.waitForThisResponse = 0;
+        cpdModemCommandFlush(pCpd);
 
+        if (pCpd->modemInfo.modemUpAt == 0) {
+            pCpd->modemInfo.modemUpAt = pCpd->modemInfo.keepOpenCtrl.lastOpenAt;
+        }
         if (pCpd->modemInfo.modemFd > CPD_ERROR) {
             pCpd->modemInfo.modemReadThreadState = THREAD_STATE_STARTING;
             result = pthread_create(&(pCpd->modemInfo.modemReadThread), NULL, cpdModemReadThreadLoop, (void *) pCpd);
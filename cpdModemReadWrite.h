@@ -11,8 +11,12 @@
 #ifndef _CPDMODEM_RW_H_
 #define _CPDMODEM_RW_H_
 int cpdModemSendCommand(pCPD_CONTEXT , const char *, int , unsigned int );
+int cpdModemSendCommandWait(pCPD_CONTEXT , const char *, int , int , unsigned int , pAT_COMMAND_WAIT );
+int cpdModemSubmitCommand(pCPD_CONTEXT , const char *, int , int , unsigned int , fAT_COMMAND_DONE *, void *);
+int cpdModemCommandQueueFree(pCPD_CONTEXT );
 int cpdModemSocketWriteToAllExcpet(pSOCKET_SERVER , char *, int , int );
 void *cpdModemReadThreadLoop(void *);
+int cpdModemReadAndCopyData(pCPD_CONTEXT , char *, int );
 int cpdModemOpen(pCPD_CONTEXT );
 int cpdModemInitForCP(pCPD_CONTEXT );
 int cpdModemClose(pCPD_CONTEXT );
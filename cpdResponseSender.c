@@ -0,0 +1,369 @@
+/*
+ * hardware/Intel/cp_daemon/cpdResponseSender.c
+ *
+ * Sends responses received from GPS to modem.
+ * GPS socket reader only copies the response into the queue, one worker thread formats and sends the queued response
+ * which is due first, so response waiting for retry doesn't hold back responses of other sessions.
+ * Send which fails is retried with interval growing from RESPONSE_SENDER_FIRST_RETRY up to
+ * RESPONSE_SENDER_MAX_RETRY, until the time allowed for the request runs out.
+ * Responses of a session are dropped when the session ends.
+ *
+ * Martin Junkar 09/18/2011
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sys/time.h>
+#define LOG_TAG "CPDD_RS"
+
+#include "cpd.h"
+#include "cpdUtil.h"
+#include "cpdGpsComm.h"
+#include "cpdXmlFormatter.h"
+#include "cpdResponseSender.h"
+#include "cpdSession.h"
+#include "cpdDebug.h"
+
+/* getMsecTime() values wrap around, <a> is later than <b> */
+#define RESPONSE_SENDER_AFTER(a, b)     (((int) ((a) - (b))) > 0)
+
+
+static void cpdResponseSenderRemove(pRESPONSE_SENDER pRs, int i)
+{
+    pRs->count--;
+    if (i < pRs->count) {
+        memmove(&(pRs->jobs[i]), &(pRs->jobs[i + 1]), (pRs->count - i) * sizeof(RESPONSE_JOB));
+    }
+}
+
+static int cpdResponseSenderFind(pRESPONSE_SENDER pRs, unsigned int serial)
+{
+    int i;
+
+    for (i = 0; i < pRs->count; i++) {
+        if (pRs->jobs[i].serial == serial) {
+            return i;
+        }
+    }
+    return CPD_ERROR;
+}
+
+/*
+ * Time until the response to <pRequest> is still useful.
+ * Response which is already late gets one attempt.
+ */
+static unsigned int cpdResponseSenderDeadline(pREQUEST_PARAMS pRequest, unsigned int now)
+{
+    int seconds;
+    unsigned int deadline;
+
+    seconds = cpdRequestTimeRequired(pRequest);
+    if (seconds < 0) {
+        return now + RESPONSE_SENDER_DEADLINE;
+    }
+    deadline = pRequest->status.requestReceivedAt + ((unsigned int) seconds) * 1000UL;
+    if (!RESPONSE_SENDER_AFTER(deadline, now + CPOS_MIN_INTERVAL + RESPONSE_SENDER_FIRST_RETRY)) {
+        deadline = now + CPOS_MIN_INTERVAL + RESPONSE_SENDER_FIRST_RETRY;
+    }
+    return deadline;
+}
+
+static void cpdResponseSenderExpire(pRESPONSE_SENDER pRs, unsigned int now)
+{
+    int i;
+
+    for (i = pRs->count - 1; i >= 0; i--) {
+        if (RESPONSE_SENDER_AFTER(now, pRs->jobs[i].deadline)) {
+            CPD_LOG(CPD_LOG_ID_TXT, "\n%u: response %u of request %u expired after %d attempts", now,
+                    pRs->jobs[i].serial, pRs->jobs[i].sessionId, pRs->jobs[i].nAttempts);
+            LOGD("%u: response %u of request %u expired after %d attempts", now,
+                    pRs->jobs[i].serial, pRs->jobs[i].sessionId, pRs->jobs[i].nAttempts);
+            cpdResponseSenderRemove(pRs, i);
+            pRs->nExpired++;
+        }
+    }
+}
+
+/*
+ * Earliest time <pJob> can be sent, modem gets at most one response per CPOS_MIN_INTERVAL.
+ */
+static unsigned int cpdResponseSenderDueAt(pCPD_CONTEXT pCpd, pRESPONSE_JOB pJob)
+{
+    unsigned int due = pJob->nextAttemptAt;
+    unsigned int sentAt = pCpd->modemInfo.sendingCPOSat;
+
+    if ((sentAt != 0) && RESPONSE_SENDER_AFTER(sentAt + CPOS_MIN_INTERVAL, due)) {
+        due = sentAt + CPOS_MIN_INTERVAL;
+    }
+    return due;
+}
+
+/*
+ * Index of the job due first, the older one of jobs due at the same time. <pWakeAt> is set to the earliest time
+ * a job is due or expires.
+ */
+static int cpdResponseSenderNext(pCPD_CONTEXT pCpd, unsigned int *pWakeAt)
+{
+    pRESPONSE_SENDER pRs = &(pCpd->responseSender);
+    unsigned int due, wakeAt, nextDue = 0;
+    int i;
+    int next = 0;
+
+    for (i = 0; i < pRs->count; i++) {
+        due = cpdResponseSenderDueAt(pCpd, &(pRs->jobs[i]));
+        wakeAt = due;
+        if (RESPONSE_SENDER_AFTER(due, pRs->jobs[i].deadline + 1)) {
+            wakeAt = pRs->jobs[i].deadline + 1;
+        }
+        if ((i == 0) || RESPONSE_SENDER_AFTER(nextDue, due)) {
+            next = i;
+            nextDue = due;
+        }
+        if ((i == 0) || RESPONSE_SENDER_AFTER(*pWakeAt, wakeAt)) {
+            *pWakeAt = wakeAt;
+        }
+    }
+    return next;
+}
+
+static void cpdResponseSenderWait(pRESPONSE_SENDER pRs, unsigned int msec)
+{
+    struct timeval tv;
+    struct timespec ts;
+
+    gettimeofday(&tv, NULL);
+    ts.tv_sec = tv.tv_sec + (msec / 1000);
+    ts.tv_nsec = (tv.tv_usec + (msec % 1000) * 1000L) * 1000L;
+    if (ts.tv_nsec >= 1000000000L) {
+        ts.tv_sec++;
+        ts.tv_nsec = ts.tv_nsec - 1000000000L;
+    }
+    pthread_cond_timedwait(&(pRs->wake), &(pRs->lock), &ts);
+}
+
+/*
+ * Result of cpdSendCpPositionResponse() for job <serial>, called with the lock held.
+ * Job may be gone already, if it was cancelled or replaced while being sent.
+ */
+static void cpdResponseSenderDone(pCPD_CONTEXT pCpd, unsigned int serial, int result)
+{
+    pRESPONSE_SENDER pRs = &(pCpd->responseSender);
+    pRESPONSE_JOB pJob;
+    int i;
+
+    i = cpdResponseSenderFind(pRs, serial);
+    if (i == CPD_ERROR) {
+        return;
+    }
+    pJob = &(pRs->jobs[i]);
+    if (result == CPD_NOK) {
+        pRs->nRetries++;
+        pJob->nextAttemptAt = getMsecTime() + pJob->retryInterval;
+        CPD_LOG(CPD_LOG_ID_TXT, "\n%u: response %u of request %u not sent, attempt %d, retry in %u ms", getMsecTime(),
+                serial, pJob->sessionId, pJob->nAttempts, pJob->retryInterval);
+        pJob->retryInterval = pJob->retryInterval * 2;
+        if (pJob->retryInterval > RESPONSE_SENDER_MAX_RETRY) {
+            pJob->retryInterval = RESPONSE_SENDER_MAX_RETRY;
+        }
+        return;
+    }
+    if (result == CPD_OK) {
+        pRs->nDone++;
+    }
+    else {
+        pRs->nFailed++;
+        LOGE("%u: response %u of request %u can't be formatted", getMsecTime(), serial, pJob->sessionId);
+    }
+    cpdResponseSenderRemove(pRs, i);
+}
+
+static void *cpdResponseSenderThread(void *pArg)
+{
+    pCPD_CONTEXT pCpd = (pCPD_CONTEXT) pArg;
+    pRESPONSE_SENDER pRs = &(pCpd->responseSender);
+    pRESPONSE_JOB pJob;
+    unsigned int now, wakeAt = 0, serial;
+    int result;
+
+    LOGV("%u: %s()", getMsecTime(), __FUNCTION__);
+    pthread_mutex_lock(&(pRs->lock));
+    if (pRs->senderThreadState == THREAD_STATE_STARTING) {
+        pRs->senderThreadState = THREAD_STATE_RUNNING;
+    }
+    while (pRs->senderThreadState == THREAD_STATE_RUNNING) {
+        now = getMsecTime();
+        cpdResponseSenderExpire(pRs, now);
+        if (pRs->count == 0) {
+            pthread_cond_wait(&(pRs->wake), &(pRs->lock));
+            continue;
+        }
+        pJob = &(pRs->jobs[cpdResponseSenderNext(pCpd, &wakeAt)]);
+        if (RESPONSE_SENDER_AFTER(cpdResponseSenderDueAt(pCpd, pJob), now)) {
+            cpdResponseSenderWait(pRs, wakeAt - now);
+            continue;
+        }
+        serial = pJob->serial;
+        pJob->nAttempts++;
+        pRs->sending = serial;
+        memcpy(&(pCpd->response), &(pJob->response), sizeof(RESPONSE_PARAMS));
+        /* lock is released after formatting, GPS can deliver the next response while this one is sent */
+        result = cpdSessionSendResponse(pCpd, pJob->sessionId, &(pRs->lock));
+        pthread_mutex_lock(&(pRs->lock));
+        pRs->sending = 0;
+        cpdResponseSenderDone(pCpd, serial, result);
+    }
+    pRs->count = 0;
+    pRs->senderThreadState = THREAD_STATE_TERMINATED;
+    pthread_mutex_unlock(&(pRs->lock));
+    LOGV("%u: EXIT %s()", getMsecTime(), __FUNCTION__);
+    return NULL;
+}
+
+int cpdResponseSenderStart(pCPD_CONTEXT pCpd)
+{
+    pRESPONSE_SENDER pRs = &(pCpd->responseSender);
+    int result = CPD_OK;
+
+    pthread_mutex_lock(&(pRs->lock));
+    if ((pRs->senderThreadState == THREAD_STATE_OFF) ||
+        (pRs->senderThreadState == THREAD_STATE_TERMINATED)) {
+        pRs->count = 0;
+        pRs->sending = 0;
+        pRs->senderThreadState = THREAD_STATE_STARTING;
+        if (pthread_create(&(pRs->senderThread), NULL, cpdResponseSenderThread, (void *) pCpd) != 0) {
+            pRs->senderThreadState = THREAD_STATE_OFF;
+            result = CPD_NOK;
+        }
+    }
+    pthread_mutex_unlock(&(pRs->lock));
+    CPD_LOG(CPD_LOG_ID_TXT, "\n%u: %s()=%d", getMsecTime(), __FUNCTION__, result);
+    LOGD("%u: %s()=%d", getMsecTime(), __FUNCTION__, result);
+    return result;
+}
+
+/*
+ * Stop the worker, waits for the response being sent, responses still in the queue are dropped.
+ */
+void cpdResponseSenderStop(pCPD_CONTEXT pCpd)
+{
+    pRESPONSE_SENDER pRs = &(pCpd->responseSender);
+
+    pthread_mutex_lock(&(pRs->lock));
+    if ((pRs->senderThreadState != THREAD_STATE_STARTING) &&
+        (pRs->senderThreadState != THREAD_STATE_RUNNING)) {
+        pthread_mutex_unlock(&(pRs->lock));
+        return;
+    }
+    pRs->senderThreadState = THREAD_STATE_TERMINATE;
+    pthread_cond_signal(&(pRs->wake));
+    pthread_mutex_unlock(&(pRs->lock));
+    pthread_join(pRs->senderThread, NULL);
+    CPD_LOG(CPD_LOG_ID_TXT, "\n%u: %s(), queued %u, done %u, failed %u, retries %u, replaced %u, dropped %u, cancelled %u, expired %u",
+            getMsecTime(), __FUNCTION__, pRs->nQueued, pRs->nDone, pRs->nFailed, pRs->nRetries,
+            pRs->nReplaced, pRs->nDropped, pRs->nCancelled, pRs->nExpired);
+    LOGD("%u: %s(), queued %u, done %u, retries %u, cancelled %u, expired %u", getMsecTime(), __FUNCTION__,
+            pRs->nQueued, pRs->nDone, pRs->nRetries, pRs->nCancelled, pRs->nExpired);
+}
+
+/*
+ * Queue pCpd->response for session of request <pRequest>.
+ * Response waiting for the same session and of the same type is replaced, there is no point sending older fix.
+ * When the queue is full the oldest response of the same session is dropped, the oldest one of any session
+ * only if this session has none.
+ * Without worker thread response is sent right away.
+ */
+int cpdResponseSenderQueue(pCPD_CONTEXT pCpd, pREQUEST_PARAMS pRequest)
+{
+    pRESPONSE_SENDER pRs = &(pCpd->responseSender);
+    pRESPONSE_JOB pJob = NULL;
+    unsigned int now;
+    int i;
+
+    if (pCpd->response.flag == (RESPONSE_FLAG_E) CPD_ERROR) {
+        LOGE("%u: %s(), invalid response", getMsecTime(), __FUNCTION__);
+        return CPD_NOK;
+    }
+    pthread_mutex_lock(&(pRs->lock));
+    if ((pRs->senderThreadState != THREAD_STATE_STARTING) &&
+        (pRs->senderThreadState != THREAD_STATE_RUNNING)) {
+        pthread_mutex_unlock(&(pRs->lock));
+        return cpdSessionSendResponse(pCpd, pRequest->dbgStats.posRequestId, NULL);
+    }
+    now = getMsecTime();
+    cpdResponseSenderExpire(pRs, now);
+    for (i = 0; i < pRs->count; i++) {
+        if ((pRs->jobs[i].serial != pRs->sending) &&
+            (pRs->jobs[i].sessionId == pRequest->dbgStats.posRequestId) &&
+            (pRs->jobs[i].response.flag == pCpd->response.flag)) {
+            pJob = &(pRs->jobs[i]);
+            pRs->nReplaced++;
+            break;
+        }
+    }
+    if (pJob == NULL) {
+        if (pRs->count == RESPONSE_SENDER_QUEUE_SIZE) {
+            for (i = 0; i < pRs->count; i++) {
+                if ((pRs->jobs[i].serial != pRs->sending) &&
+                    (pRs->jobs[i].sessionId == pRequest->dbgStats.posRequestId)) {
+                    break;
+                }
+            }
+            if (i == pRs->count) {
+                i = 0;
+            }
+            LOGD("%u: %s(), queue full, response %u of request %u dropped", now, __FUNCTION__,
+                    pRs->jobs[i].serial, pRs->jobs[i].sessionId);
+            cpdResponseSenderRemove(pRs, i);
+            pRs->nDropped++;
+        }
+        pJob = &(pRs->jobs[pRs->count]);
+        pRs->count++;
+        pRs->nQueued++;
+        if (pRs->nQueued == 0) {
+            pRs->nQueued++;
+        }
+        pJob->serial = pRs->nQueued;
+        pJob->sessionId = pRequest->dbgStats.posRequestId;
+        pJob->queuedAt = now;
+        pJob->deadline = cpdResponseSenderDeadline(pRequest, now);
+        pJob->nextAttemptAt = now;
+        pJob->retryInterval = RESPONSE_SENDER_FIRST_RETRY;
+        pJob->nAttempts = 0;
+    }
+    memcpy(&(pJob->response), &(pCpd->response), sizeof(RESPONSE_PARAMS));
+    CPD_LOG(CPD_LOG_ID_TXT, "\n%u: %s(), response %u of request %u, flag %d, %d queued, deadline in %d ms", now,
+            __FUNCTION__, pJob->serial, pJob->sessionId, pJob->response.flag, pRs->count, (int) (pJob->deadline - now));
+    pthread_cond_signal(&(pRs->wake));
+    pthread_mutex_unlock(&(pRs->lock));
+    return CPD_OK;
+}
+
+/*
+ * Drop responses of session <sessionId>, session has ended.
+ * Response which is being sent right now is finished by the worker, it's not needed if it has to be retried.
+ * Returns number of dropped responses.
+ */
+int cpdResponseSenderCancel(pCPD_CONTEXT pCpd, unsigned int sessionId)
+{
+    pRESPONSE_SENDER pRs = &(pCpd->responseSender);
+    int i;
+    int n = 0;
+
+    pthread_mutex_lock(&(pRs->lock));
+    for (i = pRs->count - 1; i >= 0; i--) {
+        if ((pRs->jobs[i].sessionId == sessionId) && (pRs->jobs[i].serial != pRs->sending)) {
+            cpdResponseSenderRemove(pRs, i);
+            n++;
+        }
+    }
+    pRs->nCancelled = pRs->nCancelled + n;
+    pthread_mutex_unlock(&(pRs->lock));
+    if (n > 0) {
+        CPD_LOG(CPD_LOG_ID_TXT, "\n%u: %s(%u), %d responses dropped", getMsecTime(), __FUNCTION__, sessionId, n);
+        LOGD("%u: %s(%u), %d responses dropped", getMsecTime(), __FUNCTION__, sessionId, n);
+    }
+    return n;
+}
@@ -0,0 +1,18 @@
+/*
+ * hardware/Intel/cp_daemon/cpdResponseSender.h
+ *
+ * Header file for cpdResponseSender.c.
+ *
+ * Martin Junkar 09/18/2011
+ *
+ */
+
+#ifndef _CPDRESPONSESENDER_H_
+#define _CPDRESPONSESENDER_H_
+#include "cpd.h"
+
+int cpdResponseSenderStart(pCPD_CONTEXT pCpd);
+void cpdResponseSenderStop(pCPD_CONTEXT pCpd);
+int cpdResponseSenderQueue(pCPD_CONTEXT pCpd, pREQUEST_PARAMS pRequest);
+int cpdResponseSenderCancel(pCPD_CONTEXT pCpd, unsigned int sessionId);
+#endif
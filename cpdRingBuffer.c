@@ -0,0 +1,171 @@
+/*
+ *  hardware/Intel/cp_daemon/cpdRingBuffer.c
+ *
+ * Ring buffer for received data.
+ * Buffer memory (ashmem region) is mapped twice, back-to-back, so unread data is always visible as one
+ * contiguous block, even when it wraps around the end of the buffer.
+ * Reader receives data directly into the buffer, consumed data is released by moving the tail counter.
+ * If buffer can't be mapped twice, plain malloc() buffer is used instead, and unread data is moved
+ * to the start of the buffer before new data is written into it.
+ *
+ * Martin Junkar 09/18/2011
+ *
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <cutils/ashmem.h>
+
+#define LOG_TAG "CPDD_RB"
+
+#include "cpd.h"
+#include "cpdRingBuffer.h"
+
+#define RING_BUFFER_NAME    "cpd_rx_ring"
+
+
+/*
+ * Allocate ring buffer, <size> must be power of 2.
+ * Buffer is mirrored if size is multiple of page size and shared memory is available.
+ */
+int cpdRingBufferInit(pRING_BUFFER pR, unsigned int size)
+{
+    int result = CPD_NOK;
+    long pageSize = sysconf(_SC_PAGESIZE);
+    char *pMap;
+
+    memset(pR, 0, sizeof(RING_BUFFER));
+    pR->fd = CPD_ERROR;
+    if ((size == 0) || ((size & (size - 1)) != 0)) {
+        LOGE("%s(), invalid size %u", __FUNCTION__, size);
+        return CPD_ERROR;
+    }
+    pR->size = size;
+    pR->mirrored = CPD_NOK;
+
+    if ((pageSize > 0) && ((size % pageSize) == 0)) {
+        pR->fd = ashmem_create_region(RING_BUFFER_NAME, size);
+        if (pR->fd >= 0) {
+            /* reserve address space for both copies, then map the same region into both halves */
+            pMap = mmap(NULL, 2 * size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (pMap != MAP_FAILED) {
+                if ((mmap(pMap, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, pR->fd, 0) == pMap) &&
+                    (mmap(pMap + size, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, pR->fd, 0) == (pMap + size))) {
+                    pR->pBuffer = pMap;
+                    pR->mirrored = CPD_OK;
+                }
+                else {
+                    munmap(pMap, 2 * size);
+                }
+            }
+            if (pR->mirrored != CPD_OK) {
+                close(pR->fd);
+                pR->fd = CPD_ERROR;
+            }
+        }
+    }
+    if (pR->pBuffer == NULL) {
+        pR->pBuffer = malloc(size);
+    }
+    if (pR->pBuffer != NULL) {
+        pR->pBuffer[0] = 0;
+        result = CPD_OK;
+    }
+    LOGD("%s(%u)=%d, mirrored=%d", __FUNCTION__, size, result, pR->mirrored);
+    return result;
+}
+
+void cpdRingBufferFree(pRING_BUFFER pR)
+{
+    if (pR->pBuffer != NULL) {
+        if (pR->mirrored == CPD_OK) {
+            munmap(pR->pBuffer, 2 * pR->size);
+            close(pR->fd);
+        }
+        else {
+            free(pR->pBuffer);
+        }
+    }
+    pR->pBuffer = NULL;
+    pR->fd = CPD_ERROR;
+    pR->mirrored = CPD_NOK;
+    pR->head = 0;
+    pR->tail = 0;
+}
+
+void cpdRingBufferReset(pRING_BUFFER pR)
+{
+    pR->head = 0;
+    pR->tail = 0;
+    if (pR->pBuffer != NULL) {
+        pR->pBuffer[0] = 0;
+    }
+}
+
+/*
+ * Pointer to unread data, cpdRingBufferUsed() bytes are available as one contiguous block.
+ * Data is always followed by null-terminator.
+ */
+char *cpdRingBufferData(pRING_BUFFER pR)
+{
+    return pR->pBuffer + (pR->tail & (pR->size - 1));
+}
+
+int cpdRingBufferUsed(pRING_BUFFER pR)
+{
+    return (int) (pR->head - pR->tail);
+}
+
+/*
+ * Pointer to free space for new data, <*pLen> is set to number of bytes that can be written there.
+ * One byte is kept free for null-terminator.
+ */
+char *cpdRingBufferWriteSpace(pRING_BUFFER pR, int *pLen)
+{
+    unsigned int used = pR->head - pR->tail;
+
+    if ((pR->mirrored != CPD_OK) && (pR->tail > 0)) {
+        memmove(pR->pBuffer, pR->pBuffer + pR->tail, used);
+        pR->tail = 0;
+        pR->head = used;
+    }
+    *pLen = (int) (pR->size - used - 1);
+    return pR->pBuffer + (pR->head & (pR->size - 1));
+}
+
+/*
+ * <len> bytes were written into space returned by cpdRingBufferWriteSpace().
+ */
+void cpdRingBufferCommit(pRING_BUFFER pR, int len)
+{
+    if (len <= 0) {
+        return;
+    }
+    pR->head = pR->head + len;
+    pR->pBuffer[pR->head & (pR->size - 1)] = 0;
+}
+
+/*
+ * Release <len> bytes from the start of unread data.
+ * Returns number of unread bytes left in the buffer.
+ */
+int cpdRingBufferRelease(pRING_BUFFER pR, int len)
+{
+    unsigned int used = pR->head - pR->tail;
+
+    if (len <= 0) {
+        return (int) used;
+    }
+    if ((unsigned int) len >= used) {
+        pR->head = 0;
+        pR->tail = 0;
+        pR->pBuffer[0] = 0;
+        return 0;
+    }
+    pR->tail = pR->tail + len;
+    return (int) (used - len);
+}
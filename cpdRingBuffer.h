@@ -0,0 +1,25 @@
+/*
+ *  hardware/Intel/cp_daemon/cpdRingBuffer.h
+ *
+ * Ring buffer for received data - header file.
+ *
+ * Martin Junkar 09/18/2011
+ *
+ *
+ */
+
+#ifndef _CPDRINGBUFFER_H_
+#define _CPDRINGBUFFER_H_
+
+#include "cpd.h"
+
+int cpdRingBufferInit(pRING_BUFFER , unsigned int );
+void cpdRingBufferFree(pRING_BUFFER );
+void cpdRingBufferReset(pRING_BUFFER );
+char *cpdRingBufferData(pRING_BUFFER );
+int cpdRingBufferUsed(pRING_BUFFER );
+char *cpdRingBufferWriteSpace(pRING_BUFFER , int *);
+void cpdRingBufferCommit(pRING_BUFFER , int );
+int cpdRingBufferRelease(pRING_BUFFER , int );
+
+#endif /* _CPDRINGBUFFER_H_ */
@@ -0,0 +1,244 @@
+/*
+ *  hardware/Intel/cp_daemon/cpdScan.c
+ *
+ * Delimiter scanner for modem and GPS data streams.
+ * Finds the first byte from a small set of delimiters (CR, LF, ESC, Ctrl-Z, '<', ...) in a buffer,
+ * or positions of all of them in one pass.
+ * Buffer is compared against all delimiters 16 bytes at the time with SSE2 (32 bytes with AVX2 builds),
+ * remaining bytes and non-x86 builds use plain byte loop.
+ * All functions are bounded by <len>, buffer does not need to be null-terminated.
+ *
+ * Martin Junkar 09/18/2011
+ *
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "cpdScan.h"
+
+
+static int cpdScanFindScalar(const char *pB, int len, const SCAN_SET *pSet)
+{
+    int i, k;
+
+    for (i = 0; i < len; i++) {
+        for (k = 0; k < pSet->n; k++) {
+            if (pB[i] == pSet->c[k]) {
+                return i;
+            }
+        }
+    }
+    return -1;
+}
+
+/*
+ * Bytes pB[i..len) of cpdScanFindAll(), <n> positions were already found.
+ */
+static int cpdScanFindAllScalar(const char *pB, int i, int len, const SCAN_SET *pSet, int *pPositions, int n, int max)
+{
+    int k;
+
+    for (; (i < len) && (n < max); i++) {
+        for (k = 0; k < pSet->n; k++) {
+            if (pB[i] == pSet->c[k]) {
+                pPositions[n] = i;
+                n++;
+                break;
+            }
+        }
+    }
+    return n;
+}
+
+/*
+ * Find first byte in pB[0..len) which is in pSet.
+ * returns: index of the byte, -1 if there is none.
+ */
+int cpdScanFind(const char *pB, int len, const SCAN_SET *pSet)
+{
+    int i = 0;
+    int r;
+
+    if ((pB == NULL) || (len <= 0) || (pSet == NULL)) {
+        return -1;
+    }
+
+#if defined(__AVX2__)
+    if (len >= 32) {
+        __m256i set32[SCAN_SET_MAX];
+        __m256i v32, m32;
+        unsigned int mask;
+        int k;
+        for (k = 0; k < pSet->n; k++) {
+            set32[k] = _mm256_set1_epi8(pSet->c[k]);
+        }
+        for (; (i + 32) <= len; i += 32) {
+            v32 = _mm256_loadu_si256((const __m256i *) &(pB[i]));
+            m32 = _mm256_setzero_si256();
+            for (k = 0; k < pSet->n; k++) {
+                m32 = _mm256_or_si256(m32, _mm256_cmpeq_epi8(v32, set32[k]));
+            }
+            mask = (unsigned int) _mm256_movemask_epi8(m32);
+            if (mask != 0) {
+                return i + __builtin_ctz(mask);
+            }
+        }
+    }
+#endif
+#if defined(__SSE2__)
+    if ((len - i) >= 16) {
+        __m128i set16[SCAN_SET_MAX];
+        __m128i v16, m16;
+        unsigned int mask;
+        int k;
+        for (k = 0; k < pSet->n; k++) {
+            set16[k] = _mm_set1_epi8(pSet->c[k]);
+        }
+        for (; (i + 16) <= len; i += 16) {
+            v16 = _mm_loadu_si128((const __m128i *) &(pB[i]));
+            m16 = _mm_setzero_si128();
+            for (k = 0; k < pSet->n; k++) {
+                m16 = _mm_or_si128(m16, _mm_cmpeq_epi8(v16, set16[k]));
+            }
+            mask = (unsigned int) _mm_movemask_epi8(m16);
+            if (mask != 0) {
+                return i + __builtin_ctz(mask);
+            }
+        }
+    }
+#endif
+
+    r = cpdScanFindScalar(&(pB[i]), len - i, pSet);
+    if (r >= 0) {
+        r = r + i;
+    }
+    return r;
+}
+
+/*
+ * Find all bytes in pB[0..len) which are in pSet, their indexes are stored in ascending order to
+ * pPositions[0..max). For callers which handle every delimiter of a block, one pass instead of calling
+ * cpdScanFind() after each of them.
+ * returns: number of stored indexes, search stops when <max> are found.
+ */
+int cpdScanFindAll(const char *pB, int len, const SCAN_SET *pSet, int *pPositions, int max)
+{
+    int i = 0;
+    int n = 0;
+
+    if ((pB == NULL) || (len <= 0) || (pSet == NULL) || (pPositions == NULL) || (max <= 0)) {
+        return 0;
+    }
+
+#if defined(__AVX2__)
+    if (len >= 32) {
+        __m256i set32[SCAN_SET_MAX];
+        __m256i v32, m32;
+        unsigned int mask;
+        int k;
+        for (k = 0; k < pSet->n; k++) {
+            set32[k] = _mm256_set1_epi8(pSet->c[k]);
+        }
+        for (; (i + 32) <= len; i += 32) {
+            v32 = _mm256_loadu_si256((const __m256i *) &(pB[i]));
+            m32 = _mm256_setzero_si256();
+            for (k = 0; k < pSet->n; k++) {
+                m32 = _mm256_or_si256(m32, _mm256_cmpeq_epi8(v32, set32[k]));
+            }
+            mask = (unsigned int) _mm256_movemask_epi8(m32);
+            while (mask != 0) {
+                pPositions[n] = i + __builtin_ctz(mask);
+                n++;
+                if (n == max) {
+                    return n;
+                }
+                mask = mask & (mask - 1);
+            }
+        }
+    }
+#endif
+#if defined(__SSE2__)
+    if ((len - i) >= 16) {
+        __m128i set16[SCAN_SET_MAX];
+        __m128i v16, m16;
+        unsigned int mask;
+        int k;
+        for (k = 0; k < pSet->n; k++) {
+            set16[k] = _mm_set1_epi8(pSet->c[k]);
+        }
+        for (; (i + 16) <= len; i += 16) {
+            v16 = _mm_loadu_si128((const __m128i *) &(pB[i]));
+            m16 = _mm_setzero_si128();
+            for (k = 0; k < pSet->n; k++) {
+                m16 = _mm_or_si128(m16, _mm_cmpeq_epi8(v16, set16[k]));
+            }
+            mask = (unsigned int) _mm_movemask_epi8(m16);
+            while (mask != 0) {
+                pPositions[n] = i + __builtin_ctz(mask);
+                n++;
+                if (n == max) {
+                    return n;
+                }
+                mask = mask & (mask - 1);
+            }
+        }
+    }
+#endif
+
+    return cpdScanFindAllScalar(pB, i, len, pSet, pPositions, n, max);
+}
+
+/*
+ * Find first <findMe> in pB[0..len).
+ */
+int cpdScanFindChar(const char *pB, int len, char findMe)
+{
+    const char *pS;
+
+    if ((pB == NULL) || (len <= 0)) {
+        return -1;
+    }
+    pS = memchr(pB, findMe, len);
+    if (pS == NULL) {
+        return -1;
+    }
+    return (int) (pS - pB);
+}
+
+/*
+ * Find first occurrence of pStr[0..lenStr) in pB[0..len).
+ * Candidates are located with the scanner on the first char of pStr, then compared.
+ */
+int cpdScanFindString(const char *pB, int len, const char *pStr, int lenStr)
+{
+    SCAN_SET set;
+    int i = 0;
+    int r;
+
+    if ((pB == NULL) || (pStr == NULL) || (lenStr <= 0) || (len < lenStr)) {
+        return -1;
+    }
+    set.n = 1;
+    set.c[0] = pStr[0];
+    while (i <= (len - lenStr)) {
+        r = cpdScanFind(&(pB[i]), len - lenStr + 1 - i, &set);
+        if (r < 0) {
+            break;
+        }
+        i = i + r;
+        if (memcmp(&(pB[i]), pStr, lenStr) == 0) {
+            return i;
+        }
+        i++;
+    }
+    return -1;
+}
@@ -0,0 +1,26 @@
+/*
+ *  hardware/Intel/cp_daemon/cpdScan.h
+ *
+ * Delimiter scanner for modem and GPS data streams - header file.
+ *
+ * Martin Junkar 09/18/2011
+ *
+ *
+ */
+
+#ifndef _CPDSCAN_H_
+#define _CPDSCAN_H_
+
+#define SCAN_SET_MAX    (8)
+
+typedef struct {
+    int     n;
+    char    c[SCAN_SET_MAX];
+} SCAN_SET, *pSCAN_SET;
+
+int cpdScanFind(const char *, int , const SCAN_SET *);
+int cpdScanFindAll(const char *, int , const SCAN_SET *, int *, int );
+int cpdScanFindChar(const char *, int , char );
+int cpdScanFindString(const char *, int , const char *, int );
+
+#endif /* _CPDSCAN_H_ */
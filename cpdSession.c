@@ -0,0 +1,475 @@
+/*
+ * hardware/Intel/cp_daemon/cpdSession.c
+ *
+ * Table of positioning sessions requested by network.
+ * Every RRLP/RRC request opens a session with its own copy of the request, status, deadlines and queued responses.
+ * Request is passed to GPS only if GPS isn't running already for a session of the same method, responses from GPS
+ * are given to every session they satisfy. GPS is stopped when the last session ends.
+ * MS-based session is answered from the last fix cache when it can be, see cpdLastFix.c.
+ *
+ * Martin Junkar 09/18/2011
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#define LOG_TAG "CPDD_SS"
+
+#include "cpd.h"
+#include "cpdUtil.h"
+#include "cpdGpsComm.h"
+#include "cpdXmlFormatter.h"
+#include "cpdResponseSender.h"
+#include "cpdSessionTimer.h"
+#include "cpdLastFix.h"
+#include "cpdSession.h"
+#include "cpdDebug.h"
+
+
+static GPP_METHOD_TYPE_E cpdSessionMethod(pREQUEST_PARAMS pRequest)
+{
+    if (pRequest->posMeas.flag == POS_MEAS_RRLP) {
+        return pRequest->posMeas.posMeas_u.rrlp_meas.method_type;
+    }
+    if (pRequest->posMeas.flag == POS_MEAS_RRC) {
+        return (GPP_METHOD_TYPE_E) pRequest->posMeas.posMeas_u.rrc_meas.rep_quant.RRC_method_type;
+    }
+    return GPP_METHOD_TYPE_NONE;
+}
+
+static int cpdSessionFind(pSESSION_TABLE pSt, unsigned int sessionId)
+{
+    int i;
+
+    for (i = 0; i < pSt->count; i++) {
+        if (pSt->sessions[i].sessionId == sessionId) {
+            return i;
+        }
+    }
+    return CPD_ERROR;
+}
+
+static void cpdSessionRemove(pSESSION_TABLE pSt, int i)
+{
+    pSt->count--;
+    if (i < pSt->count) {
+        memmove(&(pSt->sessions[i]), &(pSt->sessions[i + 1]), (pSt->count - i) * sizeof(CPD_SESSION));
+    }
+    memset(&(pSt->sessions[pSt->count]), 0, sizeof(CPD_SESSION));
+}
+
+static int cpdSessionIsAssisted(GPP_METHOD_TYPE_E method)
+{
+    return ((method == GPP_METHOD_TYPE_MS_ASSISTED) || (method == GPP_METHOD_TYPE_MS_ASSISTED_NO_ACCURACY));
+}
+
+/*
+ * Location is reported to MS-based sessions, measurements to MS-assisted ones, everything else to all sessions.
+ */
+static int cpdSessionWantsResponse(pCPD_SESSION pS, RESPONSE_FLAG_E flag)
+{
+    int assisted;
+
+    assisted = cpdSessionIsAssisted(pS->method);
+    if (flag == RESPONSE_FLAG_POS_MEAS) {
+        return assisted ? CPD_NOK : CPD_OK;
+    }
+    if (flag == RESPONSE_FLAG_GPS_MEAS) {
+        return assisted ? CPD_OK : CPD_NOK;
+    }
+    return CPD_OK;
+}
+
+/*
+ * Stricter of two requirements, a value <= 0 means any.
+ */
+static int cpdSessionStricter(int a, int b)
+{
+    if (a <= 0) {
+        return b;
+    }
+    if ((b <= 0) || (a < b)) {
+        return a;
+    }
+    return b;
+}
+
+/*
+ * GPS runs with <pRun>, new session needs <pRequest>. If any of accuracy, response time or reporting interval
+ * of the new session is stricter, <pRequest> is changed to the stricter of both in every field, so one GPS run
+ * still serves all sessions. Returns CPD_OK if request has to be sent to GPS again.
+ */
+static int cpdSessionTighten(pREQUEST_PARAMS pRequest, pREQUEST_SUMM pRun)
+{
+    pREQUEST_SUMM pRs = &(pRequest->rs);
+
+    if ((cpdSessionStricter(pRs->rep_hor_acc, pRun->rep_hor_acc) == pRun->rep_hor_acc) &&
+        (cpdSessionStricter(pRs->rep_vert_accuracy, pRun->rep_vert_accuracy) == pRun->rep_vert_accuracy) &&
+        (cpdSessionStricter(pRs->rep_resp_time_seconds, pRun->rep_resp_time_seconds) == pRun->rep_resp_time_seconds) &&
+        (cpdSessionStricter(pRs->rep_interval_seconds, pRun->rep_interval_seconds) == pRun->rep_interval_seconds)) {
+        return CPD_NOK;
+    }
+    pRs->rep_hor_acc = cpdSessionStricter(pRs->rep_hor_acc, pRun->rep_hor_acc);
+    pRs->rep_vert_accuracy = cpdSessionStricter(pRs->rep_vert_accuracy, pRun->rep_vert_accuracy);
+    pRs->rep_resp_time_seconds = cpdSessionStricter(pRs->rep_resp_time_seconds, pRun->rep_resp_time_seconds);
+    pRs->rep_interval_seconds = cpdSessionStricter(pRs->rep_interval_seconds, pRun->rep_interval_seconds);
+    /* GPS library takes them from the request as network sent it */
+    if (pRequest->posMeas.flag == POS_MEAS_RRLP) {
+        pRequest->posMeas.posMeas_u.rrlp_meas.accurancy = pRs->rep_hor_acc;
+        pRequest->posMeas.posMeas_u.rrlp_meas.resp_time_seconds = pRs->rep_resp_time_seconds;
+    }
+    else if (pRequest->posMeas.flag == POS_MEAS_RRC) {
+        pRequest->posMeas.posMeas_u.rrc_meas.rep_quant.hor_acc = pRs->rep_hor_acc;
+        pRequest->posMeas.posMeas_u.rrc_meas.rep_quant.vert_accuracy = pRs->rep_vert_accuracy;
+        if (pRequest->posMeas.posMeas_u.rrc_meas.rep_crit.period_rep_crit.rep_amount == 0) {
+            pRequest->posMeas.posMeas_u.rrc_meas.rep_crit.period_rep_crit.rep_interval_long = pRs->rep_interval_seconds;
+        }
+    }
+    return CPD_OK;
+}
+
+/*
+ * Stop GPS, no session needs it any more. Remembered as pending if stop can't be sent.
+ */
+static int cpdSessionStopGps(pCPD_CONTEXT pCpd)
+{
+    pSESSION_TABLE pSt = &(pCpd->sessionTable);
+    int result;
+
+    result = cpdSendAbortToGps(pCpd);
+    pthread_mutex_lock(&(pSt->lock));
+    if (pSt->count == 0) {
+        pSt->stopPending = (result == CPD_OK) ? CPD_NOK : CPD_OK;
+    }
+    pthread_mutex_unlock(&(pSt->lock));
+    return result;
+}
+
+/*
+ * Open session for pCpd->request, called when request was received from network and its status was set.
+ * Oldest session is ended when the table is full.
+ * Session answered from the last fix cache gets the cached location at once. GPS is still needed, unless
+ * the session is fulfilled by that single response and refining it is not enabled.
+ * Session which joins GPS running for the same method and needs better accuracy, shorter response time or
+ * interval makes pCpd->request the stricter of both, it's sent to GPS again.
+ * Returns CPD_OK if request has to be passed to GPS, CPD_NOK if GPS already runs for the same method
+ * or it's not needed.
+ */
+int cpdSessionOpen(pCPD_CONTEXT pCpd)
+{
+    pSESSION_TABLE pSt = &(pCpd->sessionTable);
+    pCPD_SESSION pS;
+    unsigned int sessionId = pCpd->request.dbgStats.posRequestId;
+    unsigned int evicted = 0;
+    GPP_METHOD_TYPE_E method;
+    LOCATION location;
+    int hit = CPD_NOK;
+    int single;
+    int result = CPD_OK;
+
+    method = cpdSessionMethod(&(pCpd->request));
+    if (!cpdSessionIsAssisted(method)) {
+        hit = cpdLastFixLookup(pCpd, &(pCpd->request), &location);
+    }
+    pthread_mutex_lock(&(pSt->lock));
+    if (pSt->count == CPD_MAX_SESSIONS) {
+        evicted = pSt->sessions[0].sessionId;
+        cpdSessionRemove(pSt, 0);
+        pSt->nEvicted++;
+    }
+    pS = &(pSt->sessions[pSt->count]);
+    pSt->count++;
+    pS->sessionId = sessionId;
+    pS->method = method;
+    pS->nFixes = 0;
+    memcpy(&(pS->request), &(pCpd->request), sizeof(REQUEST_PARAMS));
+    pSt->nOpened++;
+    /* would the response from the cache fulfil the session */
+    pS->request.status.nResponsesSent = 1;
+    single = cpdRequestIsFulfilled(&(pS->request));
+    pS->request.status.nResponsesSent = pCpd->request.status.nResponsesSent;
+    if ((hit == CPD_OK) && (single == CPD_OK) && (pCpd->lastFix.refine != CPD_OK)) {
+        pS->nFixes = 1;
+        result = CPD_NOK;
+    }
+    else if ((pSt->gpsRunning == CPD_OK) && (pSt->gpsMethod == method) && (pSt->stopPending != CPD_OK)) {
+        /* GPS keeps running, its fixes are given to this session as well */
+        pSt->nShared++;
+        result = CPD_NOK;
+        if (cpdSessionTighten(&(pCpd->request), &(pSt->gpsRs)) == CPD_OK) {
+            memcpy(&(pSt->gpsRs), &(pCpd->request.rs), sizeof(REQUEST_SUMM));
+            pSt->nTightened++;
+            result = CPD_OK;
+        }
+    }
+    else {
+        pSt->gpsRunning = CPD_OK;
+        pSt->gpsMethod = method;
+        pSt->stopPending = CPD_NOK;
+        memcpy(&(pSt->gpsRs), &(pCpd->request.rs), sizeof(REQUEST_SUMM));
+    }
+    pthread_mutex_unlock(&(pSt->lock));
+
+    if (evicted != 0) {
+        LOGD("%u: %s(), table full, session %u ended", getMsecTime(), __FUNCTION__, evicted);
+        cpdResponseSenderCancel(pCpd, evicted);
+        cpdSessionTimerCancel(pCpd, evicted);
+    }
+    cpdSessionTimerArm(pCpd, &(pCpd->request));
+    if (hit == CPD_OK) {
+        pthread_mutex_lock(&(pCpd->responseSender.lock));
+        memset(&(pCpd->response), 0, sizeof(RESPONSE_PARAMS));
+        pCpd->response.version = CPD_MSG_VERSION;
+        pCpd->response.flag = RESPONSE_FLAG_POS_MEAS;
+        memcpy(&(pCpd->response.location), &location, sizeof(LOCATION));
+        cpdResponseSenderQueue(pCpd, &(pCpd->request));
+        pthread_mutex_unlock(&(pCpd->responseSender.lock));
+    }
+    CPD_LOG(CPD_LOG_ID_TXT, "\n%u: %s(%u), method %d, %d sessions, %s%s", getMsecTime(), __FUNCTION__, sessionId,
+            method, pSt->count, (hit == CPD_OK) ? "answered from last fix, " : "",
+            (result == CPD_OK) ? "request sent to GPS" : "GPS not started or shared");
+    LOGD("%u: %s(%u), method %d, %d sessions, cached=%d, GPS started=%d", getMsecTime(), __FUNCTION__, sessionId,
+            method, pSt->count, (hit == CPD_OK), (result == CPD_OK));
+    return result;
+}
+
+/*
+ * Session joined GPS which runs already: assistance received with its request is still passed to GPS.
+ * Returns CPD_OK if it was sent.
+ */
+int cpdSessionForwardAssistance(pCPD_CONTEXT pCpd, pASSIST_DATA pAssistData)
+{
+    pSESSION_TABLE pSt = &(pCpd->sessionTable);
+    pREQUEST_PARAMS pRequest;
+    int running;
+    int result = CPD_NOK;
+
+    pthread_mutex_lock(&(pSt->lock));
+    running = ((pSt->gpsRunning == CPD_OK) && (pSt->stopPending != CPD_OK)) ? CPD_OK : CPD_NOK;
+    pthread_mutex_unlock(&(pSt->lock));
+    if ((running != CPD_OK) || (pAssistData->flag == 0)) {
+        return CPD_NOK;
+    }
+    pRequest = malloc(sizeof(REQUEST_PARAMS));
+    if (pRequest == NULL) {
+        return CPD_NOK;
+    }
+    memset(pRequest, 0, sizeof(REQUEST_PARAMS));
+    pRequest->flag = REQUEST_FLAG_ASSIST_DATA;
+    memcpy(&(pRequest->assist_data), pAssistData, sizeof(ASSIST_DATA));
+    if (cpdFormatAndSendRequestToGps(pCpd, pRequest) > CPD_NOK) {
+        pthread_mutex_lock(&(pSt->lock));
+        pSt->nAssistForwarded++;
+        pthread_mutex_unlock(&(pSt->lock));
+        result = CPD_OK;
+    }
+    free(pRequest);
+    CPD_LOG(CPD_LOG_ID_TXT, "\n%u: %s(), flag 0x%x, result %d", getMsecTime(), __FUNCTION__, pAssistData->flag, result);
+    LOGD("%u: %s(), result %d", getMsecTime(), __FUNCTION__, result);
+    return result;
+}
+
+/*
+ * End session <sessionId>, it was fulfilled or timed out. GPS is stopped when no session is left.
+ * Returns CPD_NOK if GPS should be stopped, but stop could not be sent.
+ */
+int cpdSessionEnd(pCPD_CONTEXT pCpd, unsigned int sessionId)
+{
+    pSESSION_TABLE pSt = &(pCpd->sessionTable);
+    int i;
+    int stop = CPD_NOK;
+    int result = CPD_OK;
+
+    pthread_mutex_lock(&(pSt->lock));
+    i = cpdSessionFind(pSt, sessionId);
+    if (i != CPD_ERROR) {
+        cpdSessionRemove(pSt, i);
+    }
+    if ((pSt->count == 0) && (((i != CPD_ERROR) && (pSt->gpsRunning == CPD_OK)) || (pSt->stopPending == CPD_OK))) {
+        /* new session can't share GPS which is being stopped */
+        pSt->gpsRunning = CPD_NOK;
+        pSt->gpsMethod = GPP_METHOD_TYPE_NONE;
+        pSt->stopPending = CPD_OK;
+        stop = CPD_OK;
+    }
+    pthread_mutex_unlock(&(pSt->lock));
+
+    if (i != CPD_ERROR) {
+        cpdResponseSenderCancel(pCpd, sessionId);
+        cpdSessionTimerCancel(pCpd, sessionId);
+        if (sessionId == pCpd->request.dbgStats.posRequestId) {
+            pCpd->request.posMeas.flag = POS_MEAS_NONE;
+            pCpd->request.assist_data.flag = CPD_NOK;
+            pCpd->request.flag = CPD_NOK;
+        }
+        CPD_LOG(CPD_LOG_ID_TXT, "\n%u: %s(%u), %d sessions left", getMsecTime(), __FUNCTION__, sessionId, pSt->count);
+        LOGD("%u: %s(%u), %d sessions left", getMsecTime(), __FUNCTION__, sessionId, pSt->count);
+    }
+    if (stop == CPD_OK) {
+        result = cpdSessionStopGps(pCpd);
+    }
+    return result;
+}
+
+/*
+ * Network aborted positioning. CPOS abort has no session id, every session is ended.
+ * Abort itself is passed to GPS by the caller. Returns number of ended sessions.
+ */
+int cpdSessionEndAll(pCPD_CONTEXT pCpd)
+{
+    pSESSION_TABLE pSt = &(pCpd->sessionTable);
+    unsigned int ids[CPD_MAX_SESSIONS];
+    int i, n;
+
+    pthread_mutex_lock(&(pSt->lock));
+    n = pSt->count;
+    for (i = 0; i < n; i++) {
+        ids[i] = pSt->sessions[i].sessionId;
+    }
+    memset(pSt->sessions, 0, sizeof(pSt->sessions));
+    pSt->count = 0;
+    pSt->gpsRunning = CPD_NOK;
+    pSt->gpsMethod = GPP_METHOD_TYPE_NONE;
+    pSt->stopPending = CPD_NOK;
+    pthread_mutex_unlock(&(pSt->lock));
+
+    for (i = 0; i < n; i++) {
+        cpdResponseSenderCancel(pCpd, ids[i]);
+        cpdSessionTimerCancel(pCpd, ids[i]);
+    }
+    CPD_LOG(CPD_LOG_ID_TXT, "\n%u: %s(), %d sessions ended", getMsecTime(), __FUNCTION__, n);
+    LOGD("%u: %s(), %d sessions ended", getMsecTime(), __FUNCTION__, n);
+    return n;
+}
+
+/*
+ * Copy of the request of session <sessionId>, CPD_NOK if there is no such session.
+ */
+int cpdSessionGetRequest(pCPD_CONTEXT pCpd, unsigned int sessionId, pREQUEST_PARAMS pRequest)
+{
+    pSESSION_TABLE pSt = &(pCpd->sessionTable);
+    int i;
+
+    pthread_mutex_lock(&(pSt->lock));
+    i = cpdSessionFind(pSt, sessionId);
+    if (i != CPD_ERROR) {
+        memcpy(pRequest, &(pSt->sessions[i].request), sizeof(REQUEST_PARAMS));
+    }
+    pthread_mutex_unlock(&(pSt->lock));
+    return (i != CPD_ERROR) ? CPD_OK : CPD_NOK;
+}
+
+/*
+ * Response to session <sessionId> was accepted by modem, session is ended when it's fulfilled.
+ */
+static void cpdSessionResponseSent(pCPD_CONTEXT pCpd, pREQUEST_PARAMS pRequest)
+{
+    pSESSION_TABLE pSt = &(pCpd->sessionTable);
+    unsigned int sessionId = pRequest->dbgStats.posRequestId;
+    int fulfilled = CPD_NOK;
+    int i;
+
+    pthread_mutex_lock(&(pSt->lock));
+    i = cpdSessionFind(pSt, sessionId);
+    if (i != CPD_ERROR) {
+        pSt->sessions[i].request.status.nResponsesSent = pRequest->status.nResponsesSent;
+        pSt->sessions[i].request.status.responseSentToModemAt = pRequest->status.responseSentToModemAt;
+        fulfilled = cpdRequestIsFulfilled(&(pSt->sessions[i].request));
+    }
+    pthread_mutex_unlock(&(pSt->lock));
+    if (sessionId == pCpd->request.dbgStats.posRequestId) {
+        pCpd->request.status.nResponsesSent = pRequest->status.nResponsesSent;
+        pCpd->request.status.responseSentToModemAt = pRequest->status.responseSentToModemAt;
+    }
+    if (fulfilled == CPD_OK) {
+        cpdSessionEnd(pCpd, sessionId);
+    }
+}
+
+/*
+ * Format pCpd->response for session <sessionId> and send it to modem, see cpdSendCpPositionResponse().
+ * <pResponseLock> is released once the response is formatted. Response to a session which ended is not needed.
+ */
+int cpdSessionSendResponse(pCPD_CONTEXT pCpd, unsigned int sessionId, pthread_mutex_t *pResponseLock)
+{
+    REQUEST_PARAMS request;
+    unsigned int nSent;
+    int result;
+
+    if (cpdSessionGetRequest(pCpd, sessionId, &request) != CPD_OK) {
+        if (pResponseLock != NULL) {
+            pthread_mutex_unlock(pResponseLock);
+        }
+        return CPD_OK;
+    }
+    nSent = request.status.nResponsesSent;
+    result = cpdSendCpPositionResponse(pCpd, &request, pResponseLock);
+    if ((result == CPD_OK) && (request.status.nResponsesSent != nSent)) {
+        cpdSessionResponseSent(pCpd, &request);
+    }
+    return result;
+}
+
+/*
+ * pfMessageHandlerInCpd, response received from GPS in pCpd->response is queued for every session it satisfies.
+ */
+int cpdSessionFanOut(pCPD_CONTEXT pCpd)
+{
+    pSESSION_TABLE pSt = &(pCpd->sessionTable);
+    unsigned int ids[CPD_MAX_SESSIONS];
+    int i, j, n = 0;
+    int result = CPD_NOK;
+
+    if (pCpd->response.flag == (RESPONSE_FLAG_E) CPD_ERROR) {
+        LOGE("%u: %s(), invalid response", getMsecTime(), __FUNCTION__);
+        return CPD_NOK;
+    }
+    /* response sender lock first, it guards pCpd->response */
+    pthread_mutex_lock(&(pCpd->responseSender.lock));
+    if (pCpd->response.flag == RESPONSE_FLAG_POS_MEAS) {
+        cpdLastFixStore(pCpd, &(pCpd->response.location));
+    }
+    pthread_mutex_lock(&(pSt->lock));
+    for (i = 0; i < pSt->count; i++) {
+        if (cpdSessionWantsResponse(&(pSt->sessions[i]), pCpd->response.flag) == CPD_OK) {
+            if ((pCpd->response.flag == RESPONSE_FLAG_POS_MEAS) && (pSt->sessions[i].nFixes == 0)) {
+                cpdLastFixFirstFix(pCpd, getMsecDt(pSt->sessions[i].request.status.requestReceivedAt));
+            }
+            pSt->sessions[i].nFixes++;
+            pSt->sessions[i].request.status.responseFromGpsReceivedAt = getMsecTime();
+            ids[n] = pSt->sessions[i].sessionId;
+            n++;
+        }
+    }
+    if (n > 1) {
+        pSt->nFannedOut++;
+    }
+    /* session may end while its response is queued, when sender has no worker to pass it to */
+    for (i = 0; i < n; i++) {
+        j = cpdSessionFind(pSt, ids[i]);
+        if ((j != CPD_ERROR) && (cpdResponseSenderQueue(pCpd, &(pSt->sessions[j].request)) == CPD_OK)) {
+            result = CPD_OK;
+        }
+    }
+    pthread_mutex_unlock(&(pSt->lock));
+    pthread_mutex_unlock(&(pCpd->responseSender.lock));
+    CPD_LOG(CPD_LOG_ID_TXT, "\n%u: %s(), response flag %d given to %d of %d sessions", getMsecTime(), __FUNCTION__,
+            pCpd->response.flag, n, pSt->count);
+    return result;
+}
+
+/*
+ * Number of open sessions.
+ */
+int cpdSessionCount(pCPD_CONTEXT pCpd)
+{
+    pSESSION_TABLE pSt = &(pCpd->sessionTable);
+    int n;
+
+    pthread_mutex_lock(&(pSt->lock));
+    n = pSt->count;
+    pthread_mutex_unlock(&(pSt->lock));
+    return n;
+}
@@ -0,0 +1,22 @@
+/*
+ * hardware/Intel/cp_daemon/cpdSession.h
+ *
+ * Header file for cpdSession.c.
+ *
+ * Martin Junkar 09/18/2011
+ *
+ */
+
+#ifndef _CPDSESSION_H_
+#define _CPDSESSION_H_
+#include "cpd.h"
+
+int cpdSessionOpen(pCPD_CONTEXT pCpd);
+int cpdSessionForwardAssistance(pCPD_CONTEXT pCpd, pASSIST_DATA pAssistData);
+int cpdSessionEnd(pCPD_CONTEXT pCpd, unsigned int sessionId);
+int cpdSessionEndAll(pCPD_CONTEXT pCpd);
+int cpdSessionGetRequest(pCPD_CONTEXT pCpd, unsigned int sessionId, pREQUEST_PARAMS pRequest);
+int cpdSessionSendResponse(pCPD_CONTEXT pCpd, unsigned int sessionId, pthread_mutex_t *pResponseLock);
+int cpdSessionFanOut(pCPD_CONTEXT pCpd);
+int cpdSessionCount(pCPD_CONTEXT pCpd);
+#endif
@@ -0,0 +1,351 @@
+/*
+ * hardware/Intel/cp_daemon/cpdSessionTimer.c
+ *
+ * Deadlines of the positioning sessions.
+ * When session is opened its deadlines are added to the timer table: response due, periodic report
+ * interval, total timeout (1.8 x time required by request) and no-fix timeout.
+ * One thread blocks on a timerfd armed for the earliest deadline (CLOCK_MONOTONIC), so every deadline is handled
+ * when it expires, without polling the session state.
+ *
+ * Martin Junkar 09/18/2011
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/timerfd.h>
+#define LOG_TAG "CPDD_TM"
+
+#include "cpd.h"
+#include "cpdUtil.h"
+#include "cpdGpsComm.h"
+#include "cpdSessionTimer.h"
+#include "cpdSession.h"
+#include "cpdDebug.h"
+
+static const char *sessionTimerNames[SESSION_TIMER_COUNT] = {
+    "none", "response due", "report", "total timeout", "no fix"
+};
+
+
+static unsigned long long cpdSessionTimerNow(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((unsigned long long) ts.tv_sec * 1000000ULL) + (ts.tv_nsec / 1000);
+}
+
+/*
+ * Arm timerfd for the earliest deadline, disarm it when there is none. Called with the lock held.
+ */
+static void cpdSessionTimerRearm(pSESSION_SCHEDULER pSs)
+{
+    struct itimerspec its;
+    unsigned long long earliest = 0;
+    int i;
+
+    for (i = 0; i < pSs->count; i++) {
+        if ((earliest == 0) || (pSs->timers[i].deadline < earliest)) {
+            earliest = pSs->timers[i].deadline;
+        }
+    }
+    if ((pSs->fd < 0) || (earliest == pSs->armedFor)) {
+        return;
+    }
+    memset(&its, 0, sizeof(its));
+    if (earliest != 0) {
+        its.it_value.tv_sec = earliest / 1000000ULL;
+        its.it_value.tv_nsec = (earliest % 1000000ULL) * 1000L;
+    }
+    if (timerfd_settime(pSs->fd, TFD_TIMER_ABSTIME, &its, NULL) != 0) {
+        LOGE("%s(), timerfd_settime() failed, %d", __FUNCTION__, errno);
+        return;
+    }
+    pSs->armedFor = earliest;
+}
+
+static void cpdSessionTimerAdd(pSESSION_SCHEDULER pSs, SESSION_TIMER_E type, unsigned int sessionId,
+                               unsigned long long deadline, unsigned int interval)
+{
+    pSESSION_TIMER pT;
+
+    if (pSs->count >= SESSION_TIMER_MAX) {
+        LOGE("%s(%d), no free timer", __FUNCTION__, type);
+        return;
+    }
+    pT = &(pSs->timers[pSs->count]);
+    pSs->count++;
+    pT->type = type;
+    pT->sessionId = sessionId;
+    pT->deadline = deadline;
+    pT->interval = interval;
+}
+
+/*
+ * End the session, GPS is stopped if it was the last one. <pT> is armed again to retry if stop could not be sent.
+ */
+static int cpdSessionTimerEnd(pCPD_CONTEXT pCpd, pSESSION_TIMER pT)
+{
+    LOGD("%u: Ending session %u, %s", getMsecTime(), pT->sessionId, sessionTimerNames[pT->type]);
+    CPD_LOG(CPD_LOG_ID_TXT, "\n%u: Ending session %u, %s", getMsecTime(), pT->sessionId, sessionTimerNames[pT->type]);
+    if (cpdSessionEnd(pCpd, pT->sessionId) == CPD_OK) {
+        return CPD_NOK;
+    }
+    pT->interval = CPD_SYSTEMMONITOR_INTERVAL_ACTIVE_SESSION;
+    return CPD_OK;
+}
+
+/*
+ * Deadline <pT> expired, <late> us ago. Returns CPD_OK if <pT> shall be armed again, <pT->interval> after its deadline.
+ */
+static int cpdSessionTimerHandle(pCPD_CONTEXT pCpd, pSESSION_TIMER pT, unsigned int late)
+{
+    pSESSION_SCHEDULER pSs = &(pCpd->sessionScheduler);
+    REQUEST_PARAMS request;
+    int sufficient;
+
+    CPD_LOG(CPD_LOG_ID_TXT, "\n%u: session %u, %s, %u us late", getMsecTime(), pT->sessionId, sessionTimerNames[pT->type], late);
+    LOGD("%u: session %u, %s, %u us late", getMsecTime(), pT->sessionId, sessionTimerNames[pT->type], late);
+    if (cpdSessionGetRequest(pCpd, pT->sessionId, &request) != CPD_OK) {
+        /* session ended, only stop of GPS which failed is retried */
+        if ((pT->type == SESSION_TIMER_TOTAL_TIMEOUT) || (pT->type == SESSION_TIMER_NO_FIX)) {
+            return cpdSessionTimerEnd(pCpd, pT);
+        }
+        return CPD_NOK;
+    }
+    sufficient = cpdRequestIsFulfilled(&request);
+    switch (pT->type) {
+        case SESSION_TIMER_RESPONSE_DUE:
+            if (sufficient != CPD_OK) {
+                pSs->nLate++;
+            }
+            break;
+        case SESSION_TIMER_REPORT:
+            if ((request.status.responseSentToModemAt == 0) ||
+                (getMsecDt(request.status.responseSentToModemAt) > pT->interval)) {
+                pSs->nMissedReports++;
+            }
+            return CPD_OK;
+        case SESSION_TIMER_TOTAL_TIMEOUT:
+            return cpdSessionTimerEnd(pCpd, pT);
+        case SESSION_TIMER_NO_FIX:
+            if (request.status.nResponsesSent == 0) {
+                return cpdSessionTimerEnd(pCpd, pT);
+            }
+            break;
+        default:
+            break;
+    }
+    return CPD_NOK;
+}
+
+static void *cpdSessionTimerThread(void *pArg)
+{
+    pCPD_CONTEXT pCpd = (pCPD_CONTEXT) pArg;
+    pSESSION_SCHEDULER pSs = &(pCpd->sessionScheduler);
+    SESSION_TIMER fired[SESSION_TIMER_MAX];
+    unsigned int late[SESSION_TIMER_MAX];
+    unsigned long long expirations;
+    unsigned long long now;
+    int nFired, i;
+
+    LOGV("%u: %s()", getMsecTime(), __FUNCTION__);
+    pthread_mutex_lock(&(pSs->lock));
+    if (pSs->timerThreadState == THREAD_STATE_STARTING) {
+        pSs->timerThreadState = THREAD_STATE_RUNNING;
+    }
+    while (pSs->timerThreadState == THREAD_STATE_RUNNING) {
+        pthread_mutex_unlock(&(pSs->lock));
+        /* blocks until the deadline timerfd is armed for, re-arming from other threads moves it */
+        if (read(pSs->fd, &expirations, sizeof(expirations)) != sizeof(expirations)) {
+            if ((errno != EINTR) && (errno != EAGAIN)) {
+                LOGE("%s(), timerfd read failed, %d", __FUNCTION__, errno);
+                usleep(100000);
+            }
+        }
+        pthread_mutex_lock(&(pSs->lock));
+        now = cpdSessionTimerNow();
+        pSs->armedFor = 0;
+        nFired = 0;
+        for (i = pSs->count - 1; i >= 0; i--) {
+            if (pSs->timers[i].deadline > now) {
+                continue;
+            }
+            fired[nFired] = pSs->timers[i];
+            late[nFired] = (unsigned int) (now - pSs->timers[i].deadline);
+            nFired++;
+            pSs->count--;
+            pSs->timers[i] = pSs->timers[pSs->count];
+        }
+        if (pSs->timerThreadState != THREAD_STATE_RUNNING) {
+            break;
+        }
+        for (i = 0; i < nFired; i++) {
+            pSs->nFired[fired[i].type]++;
+            pSs->totalLateness = pSs->totalLateness + late[i];
+            if (late[i] > pSs->maxLateness) {
+                pSs->maxLateness = late[i];
+            }
+        }
+        pthread_mutex_unlock(&(pSs->lock));
+        /* handlers may talk to GPS, timers can be added or cancelled meanwhile */
+        for (i = 0; i < nFired; i++) {
+            if (cpdSessionTimerHandle(pCpd, &(fired[i]), late[i]) == CPD_OK) {
+                fired[i].deadline = fired[i].deadline + fired[i].interval * 1000ULL;
+            }
+            else {
+                fired[i].type = SESSION_TIMER_NONE;
+            }
+        }
+        pthread_mutex_lock(&(pSs->lock));
+        for (i = 0; i < nFired; i++) {
+            if (fired[i].type != SESSION_TIMER_NONE) {
+                cpdSessionTimerAdd(pSs, fired[i].type, fired[i].sessionId, fired[i].deadline, fired[i].interval);
+            }
+        }
+        cpdSessionTimerRearm(pSs);
+    }
+    pSs->count = 0;
+    pSs->timerThreadState = THREAD_STATE_TERMINATED;
+    pthread_mutex_unlock(&(pSs->lock));
+    LOGV("%u: EXIT %s()", getMsecTime(), __FUNCTION__);
+    return NULL;
+}
+
+int cpdSessionTimerStart(pCPD_CONTEXT pCpd)
+{
+    pSESSION_SCHEDULER pSs = &(pCpd->sessionScheduler);
+    int result = CPD_OK;
+
+    pthread_mutex_lock(&(pSs->lock));
+    if ((pSs->timerThreadState == THREAD_STATE_OFF) ||
+        (pSs->timerThreadState == THREAD_STATE_TERMINATED)) {
+        if (pSs->fd < 0) {
+            pSs->fd = timerfd_create(CLOCK_MONOTONIC, 0);
+        }
+        pSs->count = 0;
+        pSs->armedFor = 0;
+        pSs->timerThreadState = THREAD_STATE_STARTING;
+        if ((pSs->fd < 0) ||
+            (pthread_create(&(pSs->timerThread), NULL, cpdSessionTimerThread, (void *) pCpd) != 0)) {
+            pSs->timerThreadState = THREAD_STATE_CANT_RUN;
+            result = CPD_NOK;
+        }
+    }
+    pthread_mutex_unlock(&(pSs->lock));
+    CPD_LOG(CPD_LOG_ID_TXT, "\n%u: %s()=%d", getMsecTime(), __FUNCTION__, result);
+    LOGD("%u: %s()=%d", getMsecTime(), __FUNCTION__, result);
+    return result;
+}
+
+void cpdSessionTimerStop(pCPD_CONTEXT pCpd)
+{
+    pSESSION_SCHEDULER pSs = &(pCpd->sessionScheduler);
+    struct itimerspec its;
+
+    pthread_mutex_lock(&(pSs->lock));
+    if ((pSs->timerThreadState != THREAD_STATE_STARTING) &&
+        (pSs->timerThreadState != THREAD_STATE_RUNNING)) {
+        pthread_mutex_unlock(&(pSs->lock));
+        return;
+    }
+    pSs->timerThreadState = THREAD_STATE_TERMINATE;
+    /* expire right away to release the thread from read() */
+    memset(&its, 0, sizeof(its));
+    its.it_value.tv_nsec = 1;
+    timerfd_settime(pSs->fd, 0, &its, NULL);
+    pthread_mutex_unlock(&(pSs->lock));
+    pthread_join(pSs->timerThread, NULL);
+    close(pSs->fd);
+    pSs->fd = CPD_ERROR;
+    CPD_LOG(CPD_LOG_ID_TXT, "\n%u: %s(), %u sessions, %u timers fired, late by %u us average, %u us max",
+            getMsecTime(), __FUNCTION__, pSs->nSessions,
+            pSs->nFired[SESSION_TIMER_RESPONSE_DUE] + pSs->nFired[SESSION_TIMER_REPORT] +
+            pSs->nFired[SESSION_TIMER_TOTAL_TIMEOUT] + pSs->nFired[SESSION_TIMER_NO_FIX],
+            cpdSessionTimerLateness(pCpd), pSs->maxLateness);
+}
+
+/*
+ * Average time timers fired after their deadlines, in us.
+ */
+unsigned int cpdSessionTimerLateness(pCPD_CONTEXT pCpd)
+{
+    pSESSION_SCHEDULER pSs = &(pCpd->sessionScheduler);
+    unsigned int n;
+
+    n = pSs->nFired[SESSION_TIMER_RESPONSE_DUE] + pSs->nFired[SESSION_TIMER_REPORT] +
+        pSs->nFired[SESSION_TIMER_TOTAL_TIMEOUT] + pSs->nFired[SESSION_TIMER_NO_FIX];
+    if (n == 0) {
+        return 0;
+    }
+    return (unsigned int) (pSs->totalLateness / n);
+}
+
+/*
+ * Session of <pRequest> was opened, add its deadlines. Timers the session had already are replaced.
+ * Called after request.status.requestReceivedAt was set.
+ */
+void cpdSessionTimerArm(pCPD_CONTEXT pCpd, pREQUEST_PARAMS pRequest)
+{
+    pSESSION_SCHEDULER pSs = &(pCpd->sessionScheduler);
+    unsigned int sessionId = pRequest->dbgStats.posRequestId;
+    unsigned long long t0;
+    unsigned int interval = 0;
+    int tRequired;
+    int i;
+
+    tRequired = cpdRequestTimeRequired(pRequest);
+    if ((pRequest->posMeas.flag == POS_MEAS_RRC) &&
+        (pRequest->posMeas.posMeas_u.rrc_meas.rep_crit.period_rep_crit.rep_interval_long > 0)) {
+        interval = pRequest->posMeas.posMeas_u.rrc_meas.rep_crit.period_rep_crit.rep_interval_long * 1000U;
+    }
+
+    pthread_mutex_lock(&(pSs->lock));
+    /* deadlines count from the time request was received */
+    t0 = cpdSessionTimerNow() - getMsecDt(pRequest->status.requestReceivedAt) * 1000ULL;
+    for (i = pSs->count - 1; i >= 0; i--) {
+        if (pSs->timers[i].sessionId == sessionId) {
+            pSs->count--;
+            pSs->timers[i] = pSs->timers[pSs->count];
+        }
+    }
+    pSs->nSessions++;
+    if (tRequired > 0) {
+        cpdSessionTimerAdd(pSs, SESSION_TIMER_RESPONSE_DUE, sessionId, t0 + tRequired * 1000000ULL, 0);
+        cpdSessionTimerAdd(pSs, SESSION_TIMER_TOTAL_TIMEOUT, sessionId, t0 + tRequired * SESSION_TIMEOUT_MARGIN * 1000ULL, 0);
+    }
+    if (interval > 0) {
+        cpdSessionTimerAdd(pSs, SESSION_TIMER_REPORT, sessionId, t0 + interval * 1000ULL, interval);
+    }
+    cpdSessionTimerAdd(pSs, SESSION_TIMER_NO_FIX, sessionId, t0 + SESSION_TIMEOUT_NO_FIX * 1000ULL, 0);
+    cpdSessionTimerRearm(pSs);
+    pthread_mutex_unlock(&(pSs->lock));
+    CPD_LOG(CPD_LOG_ID_TXT, "\n%u: %s(%u), tRequired=%d s, report interval %u ms, %d timers", getMsecTime(),
+            __FUNCTION__, sessionId, tRequired, interval, pSs->count);
+    LOGD("%u: %s(%u), tRequired=%d s", getMsecTime(), __FUNCTION__, sessionId, tRequired);
+}
+
+/*
+ * Session <sessionId> ended, its deadlines don't matter any more.
+ */
+void cpdSessionTimerCancel(pCPD_CONTEXT pCpd, unsigned int sessionId)
+{
+    pSESSION_SCHEDULER pSs = &(pCpd->sessionScheduler);
+    int i;
+
+    pthread_mutex_lock(&(pSs->lock));
+    for (i = pSs->count - 1; i >= 0; i--) {
+        if (pSs->timers[i].sessionId == sessionId) {
+            pSs->count--;
+            pSs->timers[i] = pSs->timers[pSs->count];
+        }
+    }
+    cpdSessionTimerRearm(pSs);
+    pthread_mutex_unlock(&(pSs->lock));
+}
@@ -0,0 +1,19 @@
+/*
+ * hardware/Intel/cp_daemon/cpdSessionTimer.h
+ *
+ * Header file for cpdSessionTimer.c.
+ *
+ * Martin Junkar 09/18/2011
+ *
+ */
+
+#ifndef _CPDSESSIONTIMER_H_
+#define _CPDSESSIONTIMER_H_
+#include "cpd.h"
+
+int cpdSessionTimerStart(pCPD_CONTEXT pCpd);
+void cpdSessionTimerStop(pCPD_CONTEXT pCpd);
+void cpdSessionTimerArm(pCPD_CONTEXT pCpd, pREQUEST_PARAMS pRequest);
+void cpdSessionTimerCancel(pCPD_CONTEXT pCpd, unsigned int sessionId);
+unsigned int cpdSessionTimerLateness(pCPD_CONTEXT pCpd);
+#endif
@@ -0,0 +1,2787 @@
+/*
+ *  hardware/Intel/cp_daemon/cpdSimChecks.c
+ *
+ * Checks and benchmarks of CPDD modules, run by CP DAEMON simulator (cpd.c) when selected on command line.
+ * This is NOT production code!For testing and development only.
+ *
+ * Martin Junkar 09/18/2011
+ *
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <string.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <arpa/inet.h>
+#include <termios.h>
+#include <math.h>
+#include <sys/poll.h>
+#include <libxml/xmlmemory.h>
+#include <libxml/tree.h>
+
+#define LOG_NDEBUG 0    /* control debug logging */
+#define LOG_TAG "CPD_SC"
+
+
+#include "cpd.h"
+#include "cpdInit.h"
+#include "cpdModem.h"
+#include "cpdUtil.h"
+#include "cpdModemReadWrite.h"
+#include "cpdAtTokenizer.h"
+#include "cpdRingBuffer.h"
+#include "cpdGpsComm.h"
+#include "cpdXmlParser.h"
+#include "cpdXmlNames.h"
+#include "cpdXmlFormatter.h"
+#include "cpdXmlArena.h"
+#include "cpdGppCodec.h"
+#include "cpdResponseSender.h"
+#include "cpdSessionTimer.h"
+#include "cpdSession.h"
+#include "cpdLastFix.h"
+#include "cpdAssistStore.h"
+#include "cpdAidingCache.h"
+#include "cpdGpsRing.h"
+#include "cpdGpsWire.h"
+#include "cpdSocketServer.h"
+#include "cpdScan.h"
+#include "cpdSimChecks.h"
+
+#include "cpdDebug.h"
+
+extern int cpdXmlFormatResponse(pCPD_CONTEXT , xmlBuffer *);
+extern int cpdXmlEmitLocation(pCPD_CONTEXT , char *, int );
+extern int cpdXmlEmitMeasurements(pCPD_CONTEXT , char *, int );
+
+/*
+ * Modem Rx capture replayed when no file is given: command results, +CPOSR URCs carrying abort, each
+ * part is also replayed on its own and must give its own events. Modem echo is off except for the first
+ * command, like after cpdModemInitForCP().
+ */
+#define MODEM_CAPTURE_ABORT_T   "<?xml version=\"1.0\" ?><pos><pos_meas><meas_abort/></pos_meas></pos>"
+#define MODEM_CAPTURE_REGISTER_T        "AT+CPOSR=1\r\r\nOK\r\n"
+#define MODEM_CAPTURE_URC_T             "\r\n+CPOSR: " MODEM_CAPTURE_ABORT_T "\r\n\r\n"
+#define MODEM_CAPTURE_URC_LINES_T       "\r\n+CPOSR: <?xml version=\"1.0\" ?>\r\n<pos>\r\n<pos_meas>\r\n<meas_abort/>\r\n" \
+                                        "</pos_meas>\r\n</pos>\r\n\r\n"
+#define MODEM_CAPTURE_URC_OK_BODY_T     "\r\n+CPOSR: <?xml version=\"1.0\" ?><pos><!-- OK -->\r\nOK <!-- ERROR -->\r\n" \
+                                        "<pos_meas><meas_abort/></pos_meas></pos>\r\n\r\n"
+#define MODEM_CAPTURE_URC_PENDING_T     "\r\n+CPOSR: " MODEM_CAPTURE_ABORT_T "\r\n\r\n\r\nOK\r\n"
+#define MODEM_CAPTURE_URC_RESULT_T      "\r\n+CPOSR: " MODEM_CAPTURE_ABORT_T "\r\nOK\r\n"
+#define MODEM_CAPTURE_RING_PENDING_T    "\r\n+CPOSR: 1\r\n\r\nRING\r\n\r\nOK\r\n"
+#define MODEM_CAPTURE_ERROR_T           "\r\nRING\r\n\r\nERROR\r\n"
+
+typedef struct {
+    const char  *pName;
+    const char  *pRx;
+    const char  *pEvents;       /* O, E: command completed with OK, ERROR; U: +CPOSR request passed on */
+    int         registered;     /* +CPOSR registration read from command response, CPD_ERROR if there is none */
+} MODEM_REPLAY_CASE_T;
+
+static const MODEM_REPLAY_CASE_T modemReplayCases_t[] = {
+    { "command with echo", MODEM_CAPTURE_REGISTER_T, "O", CPD_ERROR },
+    { "URC", MODEM_CAPTURE_URC_T, "U", CPD_ERROR },
+    { "URC split across lines", MODEM_CAPTURE_URC_LINES_T, "U", CPD_ERROR },
+    { "OK inside +CPOSR body", MODEM_CAPTURE_URC_OK_BODY_T, "U", CPD_ERROR },
+    { "URC while command is pending", MODEM_CAPTURE_URC_PENDING_T, "UO", CPD_ERROR },
+    { "final result right after URC", MODEM_CAPTURE_URC_RESULT_T, "UO", CPD_ERROR },
+    { "RING while command is pending", MODEM_CAPTURE_RING_PENDING_T, "O", 1 },
+    { "RING before ERROR", MODEM_CAPTURE_ERROR_T, "E", CPD_ERROR }
+};
+
+static const char modemCapture_t[] =
+    MODEM_CAPTURE_REGISTER_T MODEM_CAPTURE_URC_T MODEM_CAPTURE_URC_LINES_T MODEM_CAPTURE_URC_OK_BODY_T
+    MODEM_CAPTURE_URC_PENDING_T MODEM_CAPTURE_URC_RESULT_T MODEM_CAPTURE_RING_PENDING_T MODEM_CAPTURE_ERROR_T;
+
+/* read sizes replayed, 1 byte splits every URC and final result across reads */
+static const int modemReplayChunks_t[] = { 1, 2, 7, 64, 255 };
+
+#define MODEM_REPLAY_EVENTS_T   (256)
+
+static char modemReplayEvents_t[MODEM_REPLAY_EVENTS_T];
+static int nModemReplayEvents_t = 0;
+static int modemReplayResubmit_t = 0;
+
+static void cpdModemReplayEvent_t(char event)
+{
+    if (nModemReplayEvents_t < (MODEM_REPLAY_EVENTS_T - 1)) {
+        modemReplayEvents_t[nModemReplayEvents_t++] = event;
+        modemReplayEvents_t[nModemReplayEvents_t] = 0;
+    }
+}
+
+/*
+ * Command completion: record the result and queue the next command, so there is always one in flight.
+ */
+static void cpdModemReplayDone_t(void *pArg, int response, unsigned int latency)
+{
+    static const char cmd[] = "AT\r";
+
+    (void) latency;
+    cpdModemReplayEvent_t((response == AT_RESPONSE_OK) ? 'O' : ((response == AT_RESPONSE_ERROR) ? 'E' : '?'));
+    if (modemReplayResubmit_t != 0) {
+        cpdModemSubmitCommand((pCPD_CONTEXT) pArg, cmd, sizeof(cmd) - 1, AT_RESPONSE_OK, 60000,
+                              cpdModemReplayDone_t, pArg);
+    }
+}
+
+static int cpdModemReplayRequest_t(void *pArg)
+{
+    (void) pArg;
+    cpdModemReplayEvent_t('U');
+    return CPD_OK;
+}
+
+/*
+ * Baseline scanner: whole capture split into lines, the way the Rx buffer was searched before
+ * the tokenizer. Final results complete commands, +CPOSR runs to an empty line, final result or next +CPOSR,
+ * and is passed on if it holds a whole <pos> with <pos_meas>. Returns number of events.
+ */
+static int cpdModemReplayBaseline_t(const char *pB, int len, char *pEvents, int size)
+{
+    static const char urcPrefix[] = AT_CMD_CPOSR ":";
+    int n = 0;
+    int start = 0;
+    int end;
+    int i;
+    int urcStart = CPD_ERROR;
+    int urcEnd = 0;
+    int isOk, isError, isUrc;
+
+    for (i = 0; (i < len) && (n < (size - 2)); i++) {
+        if (pB[i] != AT_CMD_LF_CHR) {
+            continue;
+        }
+        end = i;
+        while ((end > start) && (pB[end - 1] == AT_CMD_CR_CHR)) {
+            end--;
+        }
+        isOk = ((end - start) == 2) && (memcmp(&(pB[start]), AT_CMD_OK, 2) == 0);
+        isError = ((end - start) == 5) && (memcmp(&(pB[start]), AT_CMD_ERROR, 5) == 0);
+        isUrc = ((end - start) >= (int) sizeof(urcPrefix) - 1) &&
+                (memcmp(&(pB[start]), urcPrefix, sizeof(urcPrefix) - 1) == 0);
+        if (urcStart >= 0) {
+            if ((end == start) || isOk || isError || isUrc) {
+                if ((cpdScanFindString(&(pB[urcStart]), urcEnd - urcStart, "<pos_meas", 9) >= 0) &&
+                    (cpdScanFindString(&(pB[urcStart]), urcEnd - urcStart, "</pos>", 6) >= 0)) {
+                    pEvents[n++] = 'U';
+                }
+                urcStart = CPD_ERROR;
+            }
+            else {
+                urcEnd = end;
+            }
+        }
+        if (isUrc) {
+            urcStart = start;
+            urcEnd = end;
+        }
+        else if (isOk) {
+            pEvents[n++] = 'O';
+        }
+        else if (isError) {
+            pEvents[n++] = 'E';
+        }
+        start = i + 1;
+    }
+    pEvents[n] = 0;
+    return n;
+}
+
+/*
+ * Replay <len> bytes of <pB> through modem Rx path in reads of <chunk> bytes, with a command always in flight.
+ * Events are left in modemReplayEvents_t. Returns number of bytes left in Rx buffer.
+ */
+static int cpdModemReplayRun_t(pCPD_CONTEXT pCpd, const char *pB, int len, int chunk)
+{
+    static const char cmd[] = "AT\r";
+    char pRxBuffer[256];
+    char pEvents[MODEM_REPLAY_EVENTS_T];
+    int i, k;
+    int left;
+
+    cpdRingBufferRelease(&(pCpd->modemInfo.modemRxRing), cpdRingBufferUsed(&(pCpd->modemInfo.modemRxRing)));
+    cpdAtTokenizerReset(&(pCpd->modemInfo.atTokenizer));
+    nModemReplayEvents_t = 0;
+    modemReplayEvents_t[0] = 0;
+    modemReplayResubmit_t = 1;
+    cpdModemSubmitCommand(pCpd, cmd, sizeof(cmd) - 1, AT_RESPONSE_OK, 60000, cpdModemReplayDone_t, pCpd);
+
+    for (i = 0; i < len; i = i + k) {
+        k = ((len - i) < chunk) ? (len - i) : chunk;
+        memcpy(pRxBuffer, &(pB[i]), k);
+        cpdModemReadAndCopyData(pCpd, pRxBuffer, k);
+    }
+    left = cpdRingBufferUsed(&(pCpd->modemInfo.modemRxRing));
+
+    /* complete the command still in flight, its result is not part of the replay */
+    memcpy(pEvents, modemReplayEvents_t, sizeof(pEvents));
+    k = nModemReplayEvents_t;
+    modemReplayResubmit_t = 0;
+    for (i = 0; (i < AT_COMMAND_QUEUE_SIZE) && (cpdModemCommandQueueFree(pCpd) < AT_COMMAND_QUEUE_SIZE); i++) {
+        cpdModemReadAndCopyData(pCpd, "\r\nOK\r\n", 6);
+    }
+    memcpy(modemReplayEvents_t, pEvents, sizeof(pEvents));
+    nModemReplayEvents_t = k;
+    return left;
+}
+
+/*
+ * Replay recorded modem Rx traffic (raw dump of gsmtty data) through modem Rx path, built-in capture if
+ * no file is given. Parts of the built-in capture must give their events: URC split across reads,
+ * OK inside +CPOSR body, URC and RING while command is pending. Replay in reads of every size must give
+ * the same command and URC events as the baseline scanner, time spent in the modem read thread chunk size
+ * is reported.
+ */
+int cpdModemReplay_t(pCPD_CONTEXT pCpd, int n, char *pFileName)
+{
+    const MODEM_REPLAY_CASE_T *pCase;
+    fCPD_SEND_MSG_TO *pfHandler = pCpd->pfCposrMessageHandlerInCpd;
+    char pBaseline[MODEM_REPLAY_EVENTS_T];
+    char *pCapture = NULL;
+    const char *pRx = modemCapture_t;
+    FILE *pF;
+    long len = sizeof(modemCapture_t) - 1;
+    int modemFd = pCpd->modemInfo.modemFd;
+    int errors = 0;
+    int left;
+    unsigned int c, k;
+    unsigned int t0;
+
+    (void) n;
+
+    if (pFileName != NULL) {
+        pF = fopen(pFileName, "rb");
+        if (pF == NULL) {
+            CPD_LOG(CPD_LOG_ID_TXT | CPD_LOG_ID_CONSOLE, "\nCan't open %s, %d", pFileName, errno);
+            return CPD_NOK;
+        }
+        fseek(pF, 0, SEEK_END);
+        len = ftell(pF);
+        fseek(pF, 0, SEEK_SET);
+        pCapture = (len > 0) ? malloc(len) : NULL;
+        if ((pCapture == NULL) || (fread(pCapture, 1, len, pF) != (size_t) len)) {
+            CPD_LOG(CPD_LOG_ID_TXT | CPD_LOG_ID_CONSOLE, "\nCan't read %s", pFileName);
+            fclose(pF);
+            free(pCapture);
+            return CPD_NOK;
+        }
+        fclose(pF);
+        pRx = pCapture;
+    }
+    if (pCpd->modemInfo.modemRxRing.pBuffer == NULL) {
+        if (cpdRingBufferInit(&(pCpd->modemInfo.modemRxRing), MODEM_RX_BUFFER_SIZE) != CPD_OK) {
+            free(pCapture);
+            return CPD_NOK;
+        }
+    }
+    /* commands go nowhere, +CPOSR requests are only counted */
+    pCpd->modemInfo.modemFd = open("/dev/null", O_WRONLY);
+    pCpd->pfCposrMessageHandlerInCpd = cpdModemReplayRequest_t;
+
+    if (pFileName == NULL) {
+        for (k = 0; k < sizeof(modemReplayCases_t) / sizeof(modemReplayCases_t[0]); k++) {
+            pCase = &(modemReplayCases_t[k]);
+            for (c = 0; c < sizeof(modemReplayChunks_t) / sizeof(modemReplayChunks_t[0]); c++) {
+                pCpd->modemInfo.registeredForCPOSR = CPD_ERROR;
+                left = cpdModemReplayRun_t(pCpd, pCase->pRx, strlen(pCase->pRx), modemReplayChunks_t[c]);
+                cpdModemReplayBaseline_t(pCase->pRx, strlen(pCase->pRx), pBaseline, sizeof(pBaseline));
+                if ((strcmp(modemReplayEvents_t, pCase->pEvents) != 0) || (strcmp(pBaseline, pCase->pEvents) != 0) ||
+                    (left != 0) || (pCpd->modemInfo.registeredForCPOSR != pCase->registered)) {
+                    CPD_LOG(CPD_LOG_ID_TXT | CPD_LOG_ID_CONSOLE,
+                            "\n%s, %d byte reads: events %s, baseline %s, expected %s, %d bytes left, registered %d",
+                            pCase->pName, modemReplayChunks_t[c], modemReplayEvents_t, pBaseline, pCase->pEvents, left,
+                            pCpd->modemInfo.registeredForCPOSR);
+                    errors++;
+                }
+            }
+        }
+    }
+
+    cpdModemReplayBaseline_t(pRx, len, pBaseline, sizeof(pBaseline));
+    for (c = 0; c < sizeof(modemReplayChunks_t) / sizeof(modemReplayChunks_t[0]); c++) {
+        t0 = getMsecTime();
+        left = cpdModemReplayRun_t(pCpd, pRx, len, modemReplayChunks_t[c]);
+        if (strcmp(modemReplayEvents_t, pBaseline) != 0) {
+            CPD_LOG(CPD_LOG_ID_TXT | CPD_LOG_ID_CONSOLE, "\n%d byte reads: events %s, baseline %s",
+                    modemReplayChunks_t[c], modemReplayEvents_t, pBaseline);
+            errors++;
+        }
+        CPD_LOG(CPD_LOG_ID_TXT | CPD_LOG_ID_CONSOLE, "\n%u: Replay %s in %d byte reads, %ld bytes in %u ms, %d events, %d bytes left in Rx buffer",
+                getMsecTime(), (pFileName != NULL) ? pFileName : "built-in capture", modemReplayChunks_t[c], len,
+                getMsecDt(t0), nModemReplayEvents_t, left);
+    }
+
+    close(pCpd->modemInfo.modemFd);
+    pCpd->modemInfo.modemFd = modemFd;
+    pCpd->pfCposrMessageHandlerInCpd = pfHandler;
+    free(pCapture);
+    CPD_LOG(CPD_LOG_ID_TXT | CPD_LOG_ID_CONSOLE, "\nModem replay errors: %d", errors);
+    return (errors == 0) ? CPD_OK : CPD_NOK;
+}
+
+/*
+ * Representative assist_data document: reference location, reference time with TOW assist
+ * and navigation model, for GPS_MAX_N_SVS satellites.
+ */
+static int cpdXmlBenchmarkDoc_t(char *pB, int size)
+{
+    int i;
+    int n;
+
+    n = snprintf(pB, size,
+        "<?xml version=\"1.0\" ?>\r\n<pos><assist_data><GPS_assist>"
+        "<ref_time><GPS_time><GPS_TOW_msec>345678900</GPS_TOW_msec><GPS_week>1723</GPS_week></GPS_time>");
+    for (i = 0; (i < GPS_MAX_N_SVS) && (n < size); i++) {
+        n += snprintf(&(pB[n]), size - n,
+            "<GPS_TOW_assist><sat_id>%d</sat_id><tlm_word>%d</tlm_word><anti_sp>0</anti_sp>"
+            "<alert>0</alert><tlm_res>%d</tlm_res></GPS_TOW_assist>",
+            i * 2 + 1, 1000 + i, i & 3);
+    }
+    if (n < size) {
+        n += snprintf(&(pB[n]), size - n,
+            "</ref_time><location_parameters><shape_data><ellipsoid_point_alt_uncertellipse>"
+            "<coordinate><latitude><north>0</north><degrees>3456789</degrees></latitude>"
+            "<longitude>-5678901</longitude></coordinate>"
+            "<altitude><height_above_surface>1</height_above_surface><height>120</height></altitude>"
+            "<uncert_semi_major>18</uncert_semi_major><uncert_semi_minor>18</uncert_semi_minor>"
+            "<orient_major>0</orient_major><confidence>68</confidence><uncert_alt>20</uncert_alt>"
+            "</ellipsoid_point_alt_uncertellipse></shape_data></location_parameters>");
+    }
+    for (i = 0; (i < GPS_MAX_N_SVS) && (n < size); i++) {
+        n += snprintf(&(pB[n]), size - n,
+            "<nav_model_elem><sat_id>%d</sat_id><sat_status literal=\"NS_NN\"/><ephem_and_clock>"
+            "<l2_code>1</l2_code><ura>0</ura><sv_health>0</sv_health><iodc>%d</iodc><l2p_flag>0</l2p_flag>"
+            "<esr1>0</esr1><esr2>0</esr2><esr3>0</esr3><esr4>0</esr4><tgd>-11</tgd><toc>%d</toc>"
+            "<af2>0</af2><af1>-%d</af1><af0>%d</af0><crs>-%d</crs><delta_n>%d</delta_n><m0>%d</m0>"
+            "<cuc>-%d</cuc><ecc>%d</ecc><cus>%d</cus><power_half>2702%06d</power_half><toe>%d</toe>"
+            "<fit_flag>0</fit_flag><aoda>%d</aoda><cic>-%d</cic><omega0>-%d</omega0><cis>%d</cis>"
+            "<i0>%d</i0><crc>%d</crc><omega>-%d</omega><omega_dot>-%d</omega_dot><idot>%d</idot>"
+            "</ephem_and_clock></nav_model_elem>",
+            i * 2 + 1, 100 + i, 12600 + i, 12 + i, 123456 + i, 1600 + i, 11000 + i, 123456789 + i,
+            900 + i, 4567890 + i, 7000 + i, 123456 + i, 12600 + i, 20 + i, 30 + i, 987654321 + i,
+            40 + i, 654321987 + i, 6000 + i, 876543210 + i, 22000 + i, 100 + i);
+    }
+    if (n < size) {
+        n += snprintf(&(pB[n]), size - n, "</GPS_assist></assist_data></pos>");
+    }
+    return (n < size) ? n : CPD_ERROR;
+}
+
+/*
+ * libxml2 allocator wrappers counting allocations made while benchmark runs.
+ * Allocations are passed to allocator which was installed before (XML arena or malloc).
+ */
+static unsigned int xmlBenchmarkAllocs = 0;
+static xmlFreeFunc pfXmlBenchmarkFree;
+static xmlMallocFunc pfXmlBenchmarkMalloc;
+static xmlReallocFunc pfXmlBenchmarkRealloc;
+static xmlStrdupFunc pfXmlBenchmarkStrdup;
+
+static void *cpdXmlBenchmarkMalloc_t(size_t size)
+{
+    xmlBenchmarkAllocs++;
+    return pfXmlBenchmarkMalloc(size);
+}
+
+static void *cpdXmlBenchmarkRealloc_t(void *p, size_t size)
+{
+    xmlBenchmarkAllocs++;
+    return pfXmlBenchmarkRealloc(p, size);
+}
+
+static char *cpdXmlBenchmarkStrdup_t(const char *s)
+{
+    xmlBenchmarkAllocs++;
+    return pfXmlBenchmarkStrdup(s);
+}
+
+static void cpdXmlBenchmarkAllocsStart_t(void)
+{
+    xmlMemGet(&pfXmlBenchmarkFree, &pfXmlBenchmarkMalloc, &pfXmlBenchmarkRealloc, &pfXmlBenchmarkStrdup);
+    xmlMemSetup(pfXmlBenchmarkFree, cpdXmlBenchmarkMalloc_t, cpdXmlBenchmarkRealloc_t, cpdXmlBenchmarkStrdup_t);
+}
+
+static void cpdXmlBenchmarkAllocsStop_t(void)
+{
+    xmlMemSetup(pfXmlBenchmarkFree, pfXmlBenchmarkMalloc, pfXmlBenchmarkRealloc, pfXmlBenchmarkStrdup);
+}
+
+/*
+ * Push <pDoc> into parser in the same chunk size as modem replay, CPD_OK if request was decoded.
+ */
+static int cpdXmlBenchmarkPush_t(pCPD_CONTEXT pCpd, char *pDoc, int len)
+{
+    char pChunk[256];
+    int j, k;
+
+    memset(&(pCpd->request), 0, sizeof(REQUEST_PARAMS));
+    for (j = 0; j < len; j = j + k) {
+        k = ((len - j) < (int) sizeof(pChunk) - 1) ? (len - j) : (int) sizeof(pChunk) - 1;
+        memcpy(pChunk, &(pDoc[j]), k);
+        pChunk[k] = 0;
+        cpdXmlParse(pCpd, pChunk, k);
+    }
+    return (pCpd->request.flag != REQUEST_FLAG_NONE) ? CPD_OK : CPD_NOK;
+}
+
+/*
+ * Decode XML document <n> times with each decoder and report time per document.
+ * Document is read from <pFileName>, representative assist_data document is used if no file is given.
+ * Cold parse releases parser context and libxml2 before each document, the way every message was parsed
+ * before the context was kept, warm parse reuses context and dictionary.
+ */
+int cpdXmlBenchmark_t(pCPD_CONTEXT pCpd, int n, char *pFileName)
+{
+    static const XML_DECODE_MODE_E modes[] = { XML_DECODE_DOM, XML_DECODE_SAX, XML_DECODE_VERIFY };
+    static const char *pModeNames[] = { "DOM", "SAX", "VERIFY" };
+    static const char *pParseNames[] = { "warm", "cold" };
+    char *pDoc;
+    FILE *pF;
+    int len = 0;
+    int i, m;
+    int nOk;
+    unsigned int t0, dt;
+
+    pDoc = malloc(XML_RX_MAX_DOC_SIZE);
+    if (pDoc == NULL) {
+        return CPD_NOK;
+    }
+    if (pFileName != NULL) {
+        pF = fopen(pFileName, "rb");
+        if (pF == NULL) {
+            CPD_LOG(CPD_LOG_ID_TXT | CPD_LOG_ID_CONSOLE, "\nCan't open %s, %d", pFileName, errno);
+            free(pDoc);
+            return CPD_NOK;
+        }
+        len = fread(pDoc, 1, XML_RX_MAX_DOC_SIZE, pF);
+        fclose(pF);
+    }
+    else {
+        len = cpdXmlBenchmarkDoc_t(pDoc, XML_RX_MAX_DOC_SIZE);
+    }
+    if (len <= 0) {
+        free(pDoc);
+        return CPD_NOK;
+    }
+
+    cpdXmlBenchmarkAllocsStart_t();
+    pCpd->xmlRxParser.verifyErrors = 0;
+    for (m = 0; m < (int) (sizeof(modes) / sizeof(modes[0])); m++) {
+        pCpd->xmlRxParser.decodeMode = modes[m];
+        nOk = 0;
+        xmlBenchmarkAllocs = 0;
+        t0 = getMsecTime();
+        for (i = 0; i < n; i++) {
+            if (cpdXmlBenchmarkPush_t(pCpd, pDoc, len) == CPD_OK) {
+                nOk++;
+            }
+        }
+        dt = getMsecDt(t0);
+        CPD_LOG(CPD_LOG_ID_TXT | CPD_LOG_ID_CONSOLE, "\n%s: %d bytes, %d/%d decoded, %u ms, %u us/doc, %u allocs/doc",
+                pModeNames[m], len, nOk, n, dt, (n > 0) ? (unsigned int) ((dt * 1000ULL) / n) : 0,
+                (n > 0) ? xmlBenchmarkAllocs / n : 0);
+    }
+    pCpd->xmlRxParser.decodeMode = XML_DECODE_SAX;
+    for (m = 0; m < (int) (sizeof(pParseNames) / sizeof(pParseNames[0])); m++) {
+        nOk = 0;
+        xmlBenchmarkAllocs = 0;
+        t0 = getMsecTime();
+        for (i = 0; i < n; i++) {
+            if (m == 1) {
+                cpdXmlParserClose(pCpd);
+            }
+            if (cpdXmlBenchmarkPush_t(pCpd, pDoc, len) == CPD_OK) {
+                nOk++;
+            }
+        }
+        dt = getMsecDt(t0);
+        CPD_LOG(CPD_LOG_ID_TXT | CPD_LOG_ID_CONSOLE, "\nSAX %s: %d/%d decoded, %u us/doc, %u allocs/doc",
+                pParseNames[m], nOk, n, (n > 0) ? (unsigned int) ((dt * 1000ULL) / n) : 0,
+                (n > 0) ? xmlBenchmarkAllocs / n : 0);
+    }
+    cpdXmlBenchmarkAllocsStop_t();
+    CPD_LOG(CPD_LOG_ID_TXT | CPD_LOG_ID_CONSOLE, "\nSAX/DOM mismatches: %u", pCpd->xmlRxParser.verifyErrors);
+    pCpd->xmlRxParser.decodeMode = XML_DECODE_SAX;
+    free(pDoc);
+    return (pCpd->xmlRxParser.verifyErrors == 0) ? CPD_OK : CPD_NOK;
+}
+
+/*
+ * Location used by format benchmark, <set> selects values: typical fix, zeros, negative and too long numbers.
+ */
+static COORDINATE xmlFormatPolygon_t[3];
+
+static void cpdXmlFormatLocation_t(pCPD_CONTEXT pCpd, SHAPE_TYPE_E shape, int set)
+{
+    static const double degrees[] = { 37.12345, 0.0, -1.0e10, 89.999 };
+    static const double longitude[] = { -122.12345, 0.0, 1.0e10, -179.999 };
+    static const long values[] = { 7, 0, -123456789L, 1234567890L };
+    pLOCATION pLoc = &(pCpd->response.location);
+    pSHAPE_DATA_U pShape = &(pLoc->location_parameters.shape_data);
+    pCOORDINATE pCoordinate = NULL;
+    unsigned int i;
+    long v = values[set];
+
+    memset(&(pCpd->response), 0, sizeof(RESPONSE_PARAMS));
+    pCpd->response.flag = RESPONSE_FLAG_POS_MEAS;
+    pLoc->time_of_fix = (set == 2) ? -2147483647 : 123456 * set;
+    pLoc->location_parameters.shape_type = shape;
+    switch (shape) {
+    case SHAPE_TYPE_POINT:
+        pCoordinate = &(pShape->point.coordinate);
+        break;
+    case SHAPE_TYPE_POINT_UNCERT_CIRCLE:
+        pCoordinate = &(pShape->point_uncert_circle.coordinate);
+        pShape->point_uncert_circle.uncert_circle = v;
+        break;
+    case SHAPE_TYPE_POINT_UNCERT_ELLIPSE:
+        pCoordinate = &(pShape->point_uncert_ellipse.coordinate);
+        pShape->point_uncert_ellipse.uncert_semi_major = v;
+        pShape->point_uncert_ellipse.uncert_semi_minor = v / 2;
+        pShape->point_uncert_ellipse.orient_major = v + 1;
+        pShape->point_uncert_ellipse.confidence = 68;
+        break;
+    case SHAPE_TYPE_POLYGON:
+        pShape->polygon.pCoordinates = xmlFormatPolygon_t;
+        pShape->polygon.nItems = set % 4;
+        for (i = 0; i < sizeof(xmlFormatPolygon_t) / sizeof(xmlFormatPolygon_t[0]); i++) {
+            xmlFormatPolygon_t[i].latitude.north = i & 1;
+            xmlFormatPolygon_t[i].latitude.degrees = degrees[set] + i;
+            xmlFormatPolygon_t[i].longitude = longitude[set] - i;
+        }
+        break;
+    case SHAPE_TYPE_POINT_ALT:
+        pCoordinate = &(pShape->point_alt.coordinate);
+        pShape->point_alt.altitude.height_above_surface = set & 1;
+        pShape->point_alt.altitude.height = (int) v;
+        break;
+    case SHAPE_TYPE_POINT_ALT_UNCERT_ELLIPSE:
+        pCoordinate = &(pShape->point_alt_uncertellipse.coordinate);
+        pShape->point_alt_uncertellipse.altitude.height_above_surface = set & 1;
+        pShape->point_alt_uncertellipse.altitude.height = (int) v;
+        pShape->point_alt_uncertellipse.uncert_semi_major = (int) v;
+        pShape->point_alt_uncertellipse.uncert_semi_minor = (int) v / 2;
+        pShape->point_alt_uncertellipse.orient_major = (int) v + 1;
+        pShape->point_alt_uncertellipse.confidence = 68;
+        pShape->point_alt_uncertellipse.uncert_alt = (int) v * 3;
+        break;
+    case SHAPE_TYPE_ARC:
+        pCoordinate = &(pShape->ellips_arc.coordinate);
+        pShape->ellips_arc.inner_rad = (int) v;
+        pShape->ellips_arc.uncert_rad = (int) v + 1;
+        pShape->ellips_arc.offset_angle = (int) v + 2;
+        pShape->ellips_arc.included_angle = (int) v + 3;
+        pShape->ellips_arc.confidence = 68;
+        break;
+    default:
+        break;
+    }
+    if (pCoordinate != NULL) {
+        pCoordinate->latitude.north = set & 1;
+        pCoordinate->latitude.degrees = degrees[set];
+        pCoordinate->longitude = longitude[set];
+    }
+}
+
+/*
+ * MS-assisted measurements of <nItems> satellites used by format benchmark, <set> selects values as above.
+ */
+static void cpdXmlFormatMeasurements_t(pCPD_CONTEXT pCpd, unsigned int nItems, int set)
+{
+    static const int values[] = { 7, 0, -123456789, 1234567890 };
+    pGPS_MEAS pMeas = &(pCpd->response.GPS_meas);
+    unsigned int i;
+
+    memset(&(pCpd->response), 0, sizeof(RESPONSE_PARAMS));
+    pCpd->response.flag = RESPONSE_FLAG_GPS_MEAS;
+    pMeas->tow_msec = 123456UL * set;
+    pMeas->meas_params_arr_items = nItems;
+    for (i = 0; i < nItems; i++) {
+        pMeas->meas_params_arr[i].sat_id = (unsigned char) (i + 1);
+        pMeas->meas_params_arr[i].carr2_noise = 40 + i;
+        pMeas->meas_params_arr[i].dopl = values[set] - (int) i;
+        pMeas->meas_params_arr[i].whole_chips = (values[set] + (int) i * 97) & 1023;
+        pMeas->meas_params_arr[i].fract_chips = values[set] / 3;
+        pMeas->meas_params_arr[i].multi_path = (MULTIPATH_E) ((i + set) % 5);
+        pMeas->meas_params_arr[i].psr_rms_err = values[set] + (int) i;
+    }
+}
+
+/*
+ * Uncertainty of location set by cpdXmlFormatLocation_t() must be in <pXml> as given to the shape, whatever
+ * formatter wrote it. Integers are cut to 8 characters like cpdXmlNodeAddChildInt() does.
+ * Returns number of values which are not.
+ */
+static int cpdXmlFormatUncert_t(SHAPE_TYPE_E shape, int set, const char *pXml)
+{
+    static const long values[] = { 7, 0, -123456789L, 1234567890L };
+    const char *pNames[4];
+    int expected[4];
+    char number[12];
+    char pElement[64];
+    long v = values[set];
+    int i, n = 0;
+    int errors = 0;
+
+    switch (shape) {
+    case SHAPE_TYPE_POINT_UNCERT_CIRCLE:
+        pNames[n] = "uncert_circle";
+        expected[n++] = (int) v;
+        break;
+    case SHAPE_TYPE_POINT_UNCERT_ELLIPSE:
+    case SHAPE_TYPE_POINT_ALT_UNCERT_ELLIPSE:
+        pNames[n] = "uncert_semi_major";
+        expected[n++] = cpdGppHorizontalUncertToK((int) v);
+        pNames[n] = "uncert_semi_minor";
+        expected[n++] = cpdGppHorizontalUncertToK((int) v / 2);
+        pNames[n] = "orient_major";
+        expected[n++] = (int) v + 1;
+        if (shape == SHAPE_TYPE_POINT_ALT_UNCERT_ELLIPSE) {
+            pNames[n] = "uncert_alt";
+            expected[n++] = cpdGppVerticalUncertToK((int) v * 3);
+        }
+        break;
+    default:
+        break;
+    }
+    for (i = 0; i < n; i++) {
+        snprintf(number, 9, "%d", expected[i]);
+        snprintf(pElement, sizeof(pElement), "<%s>%s</%s>", pNames[i], number, pNames[i]);
+        if (strstr(pXml, pElement) == NULL) {
+            CPD_LOG(CPD_LOG_ID_TXT | CPD_LOG_ID_CONSOLE, "\nShape %d, set %d: %s missing", shape, set, pElement);
+            errors++;
+        }
+    }
+    return errors;
+}
+
+/*
+ * Golden check of location and measurement templates: every shape and number of satellites with
+ * every value set must give the same text as the document saved by libxml2, and uncertainty must be the one
+ * the shape was given, so a field both formatters read wrong is found too. Returns number of differences.
+ */
+static int cpdXmlFormatCompare_t(pCPD_CONTEXT pCpd)
+{
+    char pXml[XML_TX_MAX_DOC_SIZE];
+    xmlBuffer *pXmlBuffer;
+    int shape, set;
+    int errors = 0;
+    int len;
+
+    for (shape = SHAPE_TYPE_NONE; shape <= SHAPE_TYPE_ARC + 1; shape++) {
+        for (set = 0; set < 4; set++) {
+            cpdXmlFormatLocation_t(pCpd, (SHAPE_TYPE_E) shape, set);
+            pXmlBuffer = xmlBufferCreate();
+            len = cpdXmlEmitLocation(pCpd, pXml, sizeof(pXml));
+            if ((cpdXmlFormatResponse(pCpd, pXmlBuffer) != CPD_OK) || (len != xmlBufferLength(pXmlBuffer)) ||
+                (memcmp(pXml, xmlBufferContent(pXmlBuffer), len) != 0)) {
+                if (errors == 0) {
+                    CPD_LOG(CPD_LOG_ID_TXT | CPD_LOG_ID_CONSOLE, "\nShape %d, set %d:\n%s\ntemplate, %d bytes:\n%s",
+                            shape, set, (char *) xmlBufferContent(pXmlBuffer), len, (len > 0) ? pXml : "");
+                }
+                errors++;
+            }
+            else if (len > 0) {
+                errors += cpdXmlFormatUncert_t((SHAPE_TYPE_E) shape, set, pXml);
+            }
+            xmlBufferFree(pXmlBuffer);
+        }
+    }
+    for (shape = 0; shape <= GPS_MAX_N_SVS; shape++) {
+        for (set = 0; set < 4; set++) {
+            cpdXmlFormatMeasurements_t(pCpd, shape, set);
+            pXmlBuffer = xmlBufferCreate();
+            len = cpdXmlEmitMeasurements(pCpd, pXml, sizeof(pXml));
+            if ((cpdXmlFormatResponse(pCpd, pXmlBuffer) != CPD_OK) || (len != xmlBufferLength(pXmlBuffer)) ||
+                (memcmp(pXml, xmlBufferContent(pXmlBuffer), len) != 0)) {
+                if (errors == 0) {
+                    CPD_LOG(CPD_LOG_ID_TXT | CPD_LOG_ID_CONSOLE, "\n%d satellites, set %d:\n%s\ntemplate, %d bytes:\n%s",
+                            shape, set, (char *) xmlBufferContent(pXmlBuffer), len, (len > 0) ? pXml : "");
+                }
+                errors++;
+            }
+            xmlBufferFree(pXmlBuffer);
+        }
+    }
+    CPD_LOG(CPD_LOG_ID_TXT | CPD_LOG_ID_CONSOLE, "\nTemplate/document differences: %d", errors);
+    return errors;
+}
+
+/*
+ * Check of periodic response template: value sets of each shape are patched one after another into
+ * the same template, every patched text must be the same as text written from scratch.
+ * Returns number of differences.
+ */
+static int cpdXmlPatchCompare_t(pCPD_CONTEXT pCpd)
+{
+    char pXml[XML_TX_MAX_DOC_SIZE];
+    char *pPatched;
+    int shape, k;
+    int errors = 0;
+    int len;
+
+    pCpd->xmlTxTemplate.valid = CPD_NOK;
+    for (shape = SHAPE_TYPE_NONE; shape <= SHAPE_TYPE_ARC + 1; shape++) {
+        for (k = 0; k < 12; k++) {
+            cpdXmlFormatLocation_t(pCpd, (SHAPE_TYPE_E) shape, (k * 3) % 4);
+            len = cpdXmlEmitLocation(pCpd, pXml, sizeof(pXml));
+            pPatched = cpdXmlPatchLocation(pCpd, pCpd->request.dbgStats.posRequestId);
+            if ((len <= 0) || (pPatched == NULL) || (strcmp(pXml, pPatched) != 0)) {
+                if (errors == 0) {
+                    CPD_LOG(CPD_LOG_ID_TXT | CPD_LOG_ID_CONSOLE, "\nShape %d, set %d:\n%s\npatched:\n%s",
+                            shape, (k * 3) % 4, (len > 0) ? pXml : "", (pPatched != NULL) ? pPatched : "");
+                }
+                errors++;
+            }
+        }
+    }
+    CPD_LOG(CPD_LOG_ID_TXT | CPD_LOG_ID_CONSOLE, "\nPatched/written differences: %d, %u templates, %u patched",
+            errors, pCpd->xmlTxTemplate.nBuilt, pCpd->xmlTxTemplate.nPatched);
+    pCpd->xmlTxTemplate.valid = CPD_NOK;
+    return errors;
+}
+
+/*
+ * Format location response <n> times: document tree with libxml2 allocations passed to malloc(),
+ * document tree with allocations from XML arena, template and periodic response patched in place,
+ * with time and longitude changing for each fix.
+ * MS-assisted measurements of GPS_MAX_N_SVS satellites are formatted through document tree and template.
+ * Arena high water marks are reported to size XML_ARENA_SIZE.
+ */
+int cpdXmlFormatBenchmark_t(pCPD_CONTEXT pCpd, int n, char *pFileName)
+{
+    static const char *pModeNames[] = { "malloc", "arena", "template", "patched", "GPS_meas malloc", "GPS_meas template" };
+    pXML_ARENA pArena = &(pCpd->xmlArena);
+    xmlBuffer *pXmlBuffer;
+    char pXml[XML_TX_MAX_DOC_SIZE];
+    int i, m, len;
+    int nOk;
+    int errors;
+    int enabled = pArena->enabled;
+    unsigned int arenaAllocs;
+    unsigned int t0, dt;
+
+    (void) pFileName;
+
+    errors = cpdXmlFormatCompare_t(pCpd) + cpdXmlPatchCompare_t(pCpd);
+    cpdXmlFormatLocation_t(pCpd, SHAPE_TYPE_POINT_ALT_UNCERT_ELLIPSE, 0);
+
+    cpdXmlBenchmarkAllocsStart_t();
+    for (m = 0; m < (int) (sizeof(pModeNames) / sizeof(pModeNames[0])); m++) {
+        if ((m == 1) && (pArena->pBase == NULL)) {
+            CPD_LOG(CPD_LOG_ID_TXT | CPD_LOG_ID_CONSOLE, "\nXML arena is not used");
+            continue;
+        }
+        pArena->enabled = (m == 1) ? CPD_OK : CPD_NOK;
+        if (m == 4) {
+            cpdXmlFormatMeasurements_t(pCpd, GPS_MAX_N_SVS, 0);
+        }
+        nOk = 0;
+        len = 0;
+        xmlBenchmarkAllocs = 0;
+        arenaAllocs = pArena->nAllocs;
+        t0 = getMsecTime();
+        for (i = 0; i < n; i++) {
+            if ((m == 2) || (m == 5)) {
+                len = (m == 2) ? cpdXmlEmitLocation(pCpd, pXml, sizeof(pXml)) : cpdXmlEmitMeasurements(pCpd, pXml, sizeof(pXml));
+                if (len > 0) {
+                    nOk++;
+                }
+                continue;
+            }
+            if (m == 3) {
+                pCpd->response.location.time_of_fix = 123456 + i;
+                pCpd->response.location.location_parameters.shape_data.point_alt_uncertellipse.coordinate.longitude += 0.00001;
+                if (cpdXmlPatchLocation(pCpd, pCpd->request.dbgStats.posRequestId) != NULL) {
+                    len = pCpd->xmlTxTemplate.len;
+                    nOk++;
+                }
+                continue;
+            }
+            cpdXmlArenaBegin(pCpd);
+            pXmlBuffer = xmlBufferCreate();
+            if (cpdXmlFormatResponse(pCpd, pXmlBuffer) == CPD_OK) {
+                nOk++;
+                len = xmlBufferLength(pXmlBuffer);
+            }
+            xmlBufferFree(pXmlBuffer);
+            cpdXmlArenaEnd(pCpd);
+        }
+        dt = getMsecDt(t0);
+        CPD_LOG(CPD_LOG_ID_TXT | CPD_LOG_ID_CONSOLE, "\n%s: %d bytes, %d/%d formatted, %u ns/doc, %u allocs/doc, %u malloc/doc",
+                pModeNames[m], len, nOk, n, (n > 0) ? (unsigned int) ((dt * 1000000ULL) / n) : 0,
+                (n > 0) ? xmlBenchmarkAllocs / n : 0,
+                (n > 0) ? (xmlBenchmarkAllocs - (pArena->nAllocs - arenaAllocs)) / n : 0);
+    }
+    cpdXmlBenchmarkAllocsStop_t();
+    pArena->enabled = enabled;
+    CPD_LOG(CPD_LOG_ID_TXT | CPD_LOG_ID_CONSOLE, "\nXML arena: %u bytes, high water %u, biggest request %u, %u passed to malloc",
+            pArena->size, pArena->highWater, pArena->maxRequest, pArena->nFallbacks);
+    return (errors == 0) ? CPD_OK : CPD_NOK;
+}
+
+/*
+ * Find <pName> in <pNames> the way xmlStrcmp() chains in XML converters did, before cpdXmlNameLookup().
+ */
+static int cpdXmlNameChain_t(const xmlChar *pName, const char **pNames, int count)
+{
+    int i;
+
+    for (i = 0; i < count; i++) {
+        if (!xmlStrcmp(pName, (const xmlChar *) pNames[i])) {
+            return i;
+        }
+    }
+    return CPD_ERROR;
+}
+
+/*
+ * Look up each of <count> names from <first> <n> times with string compare chain and with name table.
+ */
+static int cpdXmlNamesBenchmarkSet_t(const char *pSetName, XML_NAME_E first, int count, int n)
+{
+    const char *pNames[XML_NAME_COUNT];
+    int i, j;
+    int errors = 0;
+    volatile int sum = 0;
+    unsigned int t0, dtChain, dtHash;
+
+    for (i = 0; i < count; i++) {
+        pNames[i] = cpdXmlNameString((XML_NAME_E) (first + i));
+        if (cpdXmlNameLookup((const xmlChar *) pNames[i]) != (XML_NAME_E) (first + i)) {
+            CPD_LOG(CPD_LOG_ID_TXT | CPD_LOG_ID_CONSOLE, "\nName lookup failed for %s", pNames[i]);
+            errors++;
+        }
+    }
+    t0 = getMsecTime();
+    for (j = 0; j < n; j++) {
+        for (i = 0; i < count; i++) {
+            sum = sum + cpdXmlNameChain_t((const xmlChar *) pNames[i], pNames, count);
+        }
+    }
+    dtChain = getMsecDt(t0);
+    t0 = getMsecTime();
+    for (j = 0; j < n; j++) {
+        for (i = 0; i < count; i++) {
+            sum = sum + cpdXmlNameLookup((const xmlChar *) pNames[i]);
+        }
+    }
+    dtHash = getMsecDt(t0);
+    CPD_LOG(CPD_LOG_ID_TXT | CPD_LOG_ID_CONSOLE, "\n%s: %d names, chain %u ns/name, hash %u ns/name",
+            pSetName, count,
+            (unsigned int) ((dtChain * 1000000ULL) / ((unsigned long long) n * count)),
+            (unsigned int) ((dtHash * 1000000ULL) / ((unsigned long long) n * count)));
+    return errors;
+}
+
+/*
+ * Name lookup microbenchmark: rep_interval_long literals (longest converter chain) and the whole pos.xsd vocabulary.
+ */
+int cpdXmlNamesBenchmark_t(pCPD_CONTEXT pCpd, int n, char *pFileName)
+{
+    int errors = 0;
+
+    (void) pCpd;
+    (void) pFileName;
+
+    if (n <= 0) {
+        return CPD_NOK;
+    }
+    errors += cpdXmlNamesBenchmarkSet_t("rep_interval_long", XML_NAME_ril0, XML_NAME_ril64 - XML_NAME_ril0 + 1, n);
+    errors += cpdXmlNamesBenchmarkSet_t("all names", XML_NAME_NONE + 1, XML_NAME_COUNT - 1, n);
+    if (cpdXmlNameLookup((const xmlChar *) "ril0-2") != XML_NAME_NONE) {
+        errors++;
+    }
+    CPD_LOG(CPD_LOG_ID_TXT | CPD_LOG_ID_CONSOLE, "\nName lookup errors: %d", errors);
+    return (errors == 0) ? CPD_OK : CPD_NOK;
+}
+
+/*
+ * 3GPP uncertainty conversions as they were computed for every value, before cpdGppCodec.c tables.
+ */
+static int cpdGppUncertToM_t(int k, double c, double x1)
+{
+    return (int) (c * (pow(x1, k) - 1.0));
+}
+
+static int cpdGppUncertToK_t(int m, int maxM, int maxK, double c, double x1)
+{
+    int k;
+
+    m = (m < 0) ? 0 : ((m > maxM) ? maxM : m);
+    k = (int) ((log10((m / c) + 1.0) / log10(x1)) + 0.5);
+    return (k > maxK) ? maxK : k;
+}
+
+/*
+ * Check one uncertainty table against the formula for every K, that every metre gets the nearest K
+ * that every K decodes to metres which encode back to the same K and that metres out of range are limited.
+ */
+static int cpdGppUncertCheck_t(const char *pName, int (*pToM)(int), int (*pToK)(int), int maxM, int maxK, double c, double x1)
+{
+    int i, m, k;
+    int errors = 0;
+    int roundTrip = 0;
+    int formula = 0;
+
+    for (i = -2; i <= maxK + 2; i++) {
+        if (pToM(i) != cpdGppUncertToM_t((i < 0) ? 0 : ((i > maxK) ? maxK : i), c, x1)) {
+            CPD_LOG(CPD_LOG_ID_TXT | CPD_LOG_ID_CONSOLE, "\n%s: K=%d decoded to %d m", pName, i, pToM(i));
+            errors++;
+        }
+        if ((i >= 0) && (i <= maxK)) {
+            if (pToK(pToM(i)) != i) {
+                CPD_LOG(CPD_LOG_ID_TXT | CPD_LOG_ID_CONSOLE, "\n%s: K=%d -> %d m -> K=%d", pName, i, pToM(i), pToK(pToM(i)));
+                errors++;
+            }
+            else {
+                roundTrip++;
+            }
+        }
+    }
+    if ((pToM(maxK) > maxM) || (pToK(maxM + 1) != maxK) || (pToK(0x7FFFFFFF) != maxK) || (pToK(-1) != 0)) {
+        CPD_LOG(CPD_LOG_ID_TXT | CPD_LOG_ID_CONSOLE, "\n%s: K=%d is %d m, %d m encoded to K=%d", pName,
+                maxK, pToM(maxK), 0x7FFFFFFF, pToK(0x7FFFFFFF));
+        errors++;
+    }
+    /* every metre is encoded into the nearest code */
+    for (i = -10; i <= maxM + 10; i++) {
+        m = (i < 0) ? 0 : ((i > maxM) ? maxM : i);
+        k = pToK(i);
+        if ((k < 0) || (k > maxK) || ((k > 0) && (abs(pToM(k - 1) - m) < abs(pToM(k) - m))) ||
+            ((k < maxK) && (abs(pToM(k + 1) - m) < abs(pToM(k) - m)))) {
+            CPD_LOG(CPD_LOG_ID_TXT | CPD_LOG_ID_CONSOLE, "\n%s: %d m encoded to K=%d", pName, i, k);
+            errors++;
+        }
+        if (abs(k - cpdGppUncertToK_t(i, maxM, maxK, c, x1)) > 1) {
+            formula++;
+        }
+    }
+    if (roundTrip != (maxK + 1)) {
+        errors++;
+    }
+    CPD_LOG(CPD_LOG_ID_TXT | CPD_LOG_ID_CONSOLE, "\n%s: K 0..%d, %d m max, %d codes round trip, %d errors, %d metres off formula by more than 1",
+            pName, maxK, maxM, roundTrip, errors, formula);
+    return errors;
+}
+
+/*
+ * Check every 3GPP latitude and longitude value: decoded degrees must encode back to the same value,
+ * or to the one below when the truncated product falls just under it.
+ */
+static int cpdGppCoordinateCheck_t(void)
+{
+    long k;
+    long d;
+    int errors = 0;
+    unsigned int below = 0;
+
+    for (k = -8388607L; k <= 8388607L; k++) {
+        /* south for negative <k>, latitude itself is always positive */
+        d = ((k < 0) ? -k : k) - cpdGppLatitudeToK(k < 0, cpdGppLatitudeToDegrees(k < 0, (k < 0) ? -k : k));
+        d = (d < 0) ? -d : d;
+        if (d == 1) {
+            below++;
+        }
+        else if (d != 0) {
+            errors++;
+        }
+        d = k - cpdGppLongitudeToK(cpdGppLongitudeToDegrees(k));
+        d = (d < 0) ? -d : d;
+        if (d == 1) {
+            below++;
+        }
+        else if (d != 0) {
+            errors++;
+        }
+    }
+    if ((cpdGppLatitudeToK(0, 1.0e10) != 8388607L) || (cpdGppLongitudeToK(-1.0e10) != -8388608L)) {
+        errors++;
+    }
+    CPD_LOG(CPD_LOG_ID_TXT | CPD_LOG_ID_CONSOLE, "\nLatitude/longitude: %u values one below after round trip, %d errors",
+            below, errors);
+    return errors;
+}
+
+#define GPP_UNCERT_BENCHMARK_M_T    (4095)  /* beyond one table read */
+
+/*
+ * Exhaustive check of cpdGppCodec.c and time of <n> encodings and decodings of metres 0..GPP_UNCERT_BENCHMARK_M_T,
+ * with formulas and with tables.
+ */
+int cpdGppCodecBenchmark_t(pCPD_CONTEXT pCpd, int n, char *pFileName)
+{
+    volatile unsigned int sum = 0;
+    int errors = 0;
+    int i, j;
+    unsigned int t0, dtFormula, dtTable;
+
+    (void) pCpd;
+    (void) pFileName;
+
+    errors += cpdGppUncertCheck_t("horizontal", cpdGppHorizontalUncertToM, cpdGppHorizontalUncertToK,
+                                  GPP_LL_UNCERT_MAX_M, GPP_LL_UNCERT_MAX_K, GPP_LL_UNCERT_C, GPP_LL_UNCERT_1X);
+    errors += cpdGppUncertCheck_t("vertical", cpdGppVerticalUncertToM, cpdGppVerticalUncertToK,
+                                  GPP_ALT_UNCERT_MAX_M, GPP_ALT_UNCERT_MAX_K, GPP_ALT_UNCERT_C, GPP_ALT_UNCERT_1X);
+    errors += cpdGppCoordinateCheck_t();
+    if ((cpdGppConfidence(-1) != 0) || (cpdGppConfidence(68) != 68) || (cpdGppConfidence(128) != 100)) {
+        errors++;
+    }
+
+    t0 = getMsecTime();
+    for (j = 0; j < n; j++) {
+        for (i = 0; i <= GPP_UNCERT_BENCHMARK_M_T; i++) {
+            sum = sum + cpdGppUncertToM_t(cpdGppUncertToK_t(i, GPP_LL_UNCERT_MAX_M, GPP_LL_UNCERT_MAX_K,
+                                                            GPP_LL_UNCERT_C, GPP_LL_UNCERT_1X),
+                                          GPP_LL_UNCERT_C, GPP_LL_UNCERT_1X);
+        }
+    }
+    dtFormula = getMsecDt(t0);
+    t0 = getMsecTime();
+    for (j = 0; j < n; j++) {
+        for (i = 0; i <= GPP_UNCERT_BENCHMARK_M_T; i++) {
+            sum = sum + cpdGppHorizontalUncertToM(cpdGppHorizontalUncertToK(i));
+        }
+    }
+    dtTable = getMsecDt(t0);
+    if (n > 0) {
+        CPD_LOG(CPD_LOG_ID_TXT | CPD_LOG_ID_CONSOLE, "\nEncode + decode: formula %u ns/value, table %u ns/value",
+                (unsigned int) ((dtFormula * 1000000ULL) / ((unsigned long long) n * (GPP_UNCERT_BENCHMARK_M_T + 1))),
+                (unsigned int) ((dtTable * 1000000ULL) / ((unsigned long long) n * (GPP_UNCERT_BENCHMARK_M_T + 1))));
+    }
+    CPD_LOG(CPD_LOG_ID_TXT | CPD_LOG_ID_CONSOLE, "\n3GPP codec errors: %d", errors);
+    return (errors == 0) ? CPD_OK : CPD_NOK;
+}
+
+/*
+ * Modem for response sender check: AT+CPOS is answered with prompt, XML terminated with Ctrl-Z
+ * with ERROR while responseSenderRejects_t is not 0 (< 0 rejects all), otherwise with OK.
+ */
+static int responseSenderRejects_t = 0;
+static int responseSenderModemFd_t = CPD_ERROR;
+
+static void *cpdResponseSenderModem_t(void *pArg)
+{
+    pCPD_CONTEXT pCpd = (pCPD_CONTEXT) pArg;
+    char pB[1024];
+    int n, i;
+
+    while ((n = read(responseSenderModemFd_t, pB, sizeof(pB))) > 0) {
+        for (i = 0; i < n; i++) {
+            if (pB[i] == '\r') {
+                cpdModemReadAndCopyData(pCpd, "\r\n> ", 4);
+            }
+            else if (pB[i] == AT_CMD_CTRL_Z_CHR) {
+                if (responseSenderRejects_t != 0) {
+                    if (responseSenderRejects_t > 0) {
+                        responseSenderRejects_t--;
+                    }
+                    cpdModemReadAndCopyData(pCpd, "\r\nERROR\r\n", 9);
+                }
+                else {
+                    cpdModemReadAndCopyData(pCpd, "\r\nOK\r\n", 6);
+                }
+            }
+        }
+    }
+    return NULL;
+}
+
+static void cpdResponseSenderRequest_t(pCPD_CONTEXT pCpd, POS_MEAS_E flag, int seconds, unsigned int age)
+{
+    memset(&(pCpd->request), 0, sizeof(REQUEST_PARAMS));
+    pCpd->request.flag = REQUEST_FLAG_POS_MEAS;
+    pCpd->request.posMeas.flag = flag;
+    if (flag == POS_MEAS_RRLP) {
+        pCpd->request.posMeas.posMeas_u.rrlp_meas.method_type = GPP_METHOD_TYPE_MS_BASED;
+        pCpd->request.posMeas.posMeas_u.rrlp_meas.resp_time_seconds = seconds;
+        pCpd->request.posMeas.posMeas_u.rrlp_meas.mult_sets = MULT_SETS_ONE;
+    }
+    pCpd->request.dbgStats.posRequestId = pCpd->responseSender.nQueued + 100;
+    pCpd->request.status.requestReceivedAt = getMsecTime() - age;
+    pCpd->modemInfo.sentCPOSok = CPD_NOK;
+    cpdSessionOpen(pCpd);
+}
+
+static void cpdResponseSenderQueue_t(pCPD_CONTEXT pCpd, int set)
+{
+    pthread_mutex_lock(&(pCpd->responseSender.lock));
+    cpdXmlFormatLocation_t(pCpd, SHAPE_TYPE_POINT_ALT_UNCERT_ELLIPSE, set);
+    cpdSessionFanOut(pCpd);
+    pthread_mutex_unlock(&(pCpd->responseSender.lock));
+}
+
+static int cpdResponseSenderWait_t(pCPD_CONTEXT pCpd, unsigned int timeout)
+{
+    unsigned int t0 = getMsecTime();
+
+    while ((pCpd->responseSender.count > 0) && (getMsecDt(t0) < timeout)) {
+        usleep(10000);
+    }
+    return pCpd->responseSender.count;
+}
+
+static int cpdResponseSenderModemOpen_t(pCPD_CONTEXT pCpd, pthread_t *pModemThread, int *fds)
+{
+    if (pCpd->modemInfo.modemRxRing.pBuffer == NULL) {
+        if (cpdRingBufferInit(&(pCpd->modemInfo.modemRxRing), MODEM_RX_BUFFER_SIZE) != CPD_OK) {
+            return CPD_NOK;
+        }
+    }
+    if (pipe(fds) != 0) {
+        return CPD_NOK;
+    }
+    responseSenderModemFd_t = fds[0];
+    pCpd->modemInfo.modemFd = fds[1];
+    pthread_create(pModemThread, NULL, cpdResponseSenderModem_t, (void *) pCpd);
+    return CPD_OK;
+}
+
+static void cpdResponseSenderModemClose_t(pCPD_CONTEXT pCpd, pthread_t modemThread, int *fds)
+{
+    pCpd->modemInfo.modemFd = 0;
+    close(fds[1]);
+    pthread_join(modemThread, NULL);
+    close(fds[0]);
+}
+
+/*
+ * Response sender with modem which rejects some responses:
+ * single response accepted on the third attempt, periodic responses replacing each other and cancelled,
+ * late response rejected until its deadline, response of another session sent while one waits for retry,
+ * full queue drops response of the same session.
+ */
+int cpdResponseSenderCheck_t(pCPD_CONTEXT pCpd, int n, char *pFileName)
+{
+    pRESPONSE_SENDER pRs = &(pCpd->responseSender);
+    REQUEST_PARAMS request;
+    pthread_t modemThread;
+    int fds[2];
+    int errors = 0;
+    int i;
+    unsigned int t0, count;
+
+    (void) n;
+    (void) pFileName;
+
+    if (cpdResponseSenderModemOpen_t(pCpd, &modemThread, fds) != CPD_OK) {
+        return CPD_NOK;
+    }
+    cpdResponseSenderStart(pCpd);
+    /* every response of this check comes from GPS */
+    pCpd->lastFix.maxAge = 0;
+
+    /* single response, modem rejects it twice */
+    cpdResponseSenderRequest_t(pCpd, POS_MEAS_RRLP, 10, 0);
+    responseSenderRejects_t = 2;
+    t0 = getMsecTime();
+    cpdResponseSenderQueue_t(pCpd, 0);
+    if ((cpdResponseSenderWait_t(pCpd, 8000) != 0) || (pRs->nDone != 1) || (pRs->nRetries != 2) ||
+        (pCpd->request.flag != CPD_NOK)) {
+        errors++;
+    }
+    CPD_LOG(CPD_LOG_ID_TXT | CPD_LOG_ID_CONSOLE, "\nSingle response: %u ms, %u retries, request flag %d",
+            getMsecDt(t0), pRs->nRetries, pCpd->request.flag);
+
+    /* periodic responses, newer fixes replace the one waiting for retry, then request is aborted */
+    cpdResponseSenderRequest_t(pCpd, POS_MEAS_RRC, 0, 0);
+    responseSenderRejects_t = CPD_ERROR;
+    cpdResponseSenderQueue_t(pCpd, 0);
+    usleep(50000);
+    cpdResponseSenderQueue_t(pCpd, 1);
+    cpdResponseSenderQueue_t(pCpd, 3);
+    cpdSessionEnd(pCpd, pCpd->request.dbgStats.posRequestId);
+    if ((pRs->nReplaced != 2) || (pRs->nCancelled != 1) || (pRs->count != 0)) {
+        errors++;
+    }
+    CPD_LOG(CPD_LOG_ID_TXT | CPD_LOG_ID_CONSOLE, "\nPeriodic responses: %u queued, %u replaced, %u cancelled",
+            pRs->nQueued, pRs->nReplaced, pRs->nCancelled);
+
+    /* late response, 2 s left of 3 s allowed, modem rejects everything */
+    cpdResponseSenderRequest_t(pCpd, POS_MEAS_RRLP, 2, 1000);
+    t0 = getMsecTime();
+    cpdResponseSenderQueue_t(pCpd, 2);
+    if ((cpdResponseSenderWait_t(pCpd, 5000) != 0) || (pRs->nExpired != 1) || (getMsecDt(t0) < 1500)) {
+        errors++;
+    }
+    CPD_LOG(CPD_LOG_ID_TXT | CPD_LOG_ID_CONSOLE, "\nLate response: expired after %u ms, %u retries",
+            getMsecDt(t0), pRs->nRetries);
+
+    /* response rejected once waits RESPONSE_SENDER_MAX_RETRY, response of another session goes first */
+    cpdResponseSenderRequest_t(pCpd, POS_MEAS_RRLP, 10, 0);
+    memcpy(&request, &(pCpd->request), sizeof(REQUEST_PARAMS));
+    responseSenderRejects_t = 1;
+    count = pRs->nRetries;
+    t0 = getMsecTime();
+    pthread_mutex_lock(&(pRs->lock));
+    cpdXmlFormatLocation_t(pCpd, SHAPE_TYPE_POINT_ALT_UNCERT_ELLIPSE, 0);
+    cpdResponseSenderQueue(pCpd, &request);
+    pthread_mutex_unlock(&(pRs->lock));
+    while ((pRs->nRetries == count) && (getMsecDt(t0) < 2000)) {
+        usleep(10000);
+    }
+    pthread_mutex_lock(&(pRs->lock));
+    if ((pRs->count != 1) || (pRs->jobs[0].sessionId != request.dbgStats.posRequestId)) {
+        errors++;
+    }
+    pRs->jobs[0].nextAttemptAt = getMsecTime() + RESPONSE_SENDER_MAX_RETRY;
+    pRs->jobs[0].retryInterval = RESPONSE_SENDER_MAX_RETRY;
+    pthread_mutex_unlock(&(pRs->lock));
+    cpdResponseSenderRequest_t(pCpd, POS_MEAS_RRLP, 10, 0);
+    count = pRs->nDone;
+    t0 = getMsecTime();
+    pthread_mutex_lock(&(pRs->lock));
+    cpdXmlFormatLocation_t(pCpd, SHAPE_TYPE_POINT_ALT_UNCERT_ELLIPSE, 1);
+    cpdResponseSenderQueue(pCpd, &(pCpd->request));
+    pthread_mutex_unlock(&(pRs->lock));
+    while ((pRs->nDone == count) && (getMsecDt(t0) < RESPONSE_SENDER_MAX_RETRY)) {
+        usleep(10000);
+    }
+    pthread_mutex_lock(&(pRs->lock));
+    if ((pRs->nDone != count + 1) || (pRs->count != 1) || (pRs->jobs[0].sessionId != request.dbgStats.posRequestId)) {
+        errors++;
+    }
+    pthread_mutex_unlock(&(pRs->lock));
+    CPD_LOG(CPD_LOG_ID_TXT | CPD_LOG_ID_CONSOLE, "\nOther session: sent after %u ms, %d waiting for retry",
+            getMsecDt(t0), pRs->count);
+    if ((cpdResponseSenderWait_t(pCpd, 2 * RESPONSE_SENDER_MAX_RETRY) != 0) || (pRs->nDone != count + 2)) {
+        errors++;
+    }
+
+    /* full queue: measurements of a session with queued fix drop its fix, not the oldest response */
+    count = pRs->nDropped;
+    pthread_mutex_lock(&(pRs->lock));
+    for (i = 0; i < RESPONSE_SENDER_QUEUE_SIZE - 1; i++) {
+        request.dbgStats.posRequestId = 200 + i;
+        cpdXmlFormatLocation_t(pCpd, SHAPE_TYPE_POINT_ALT_UNCERT_ELLIPSE, i);
+        cpdResponseSenderQueue(pCpd, &request);
+    }
+    request.dbgStats.posRequestId = 200;
+    cpdXmlFormatMeasurements_t(pCpd, 4, 0);
+    cpdResponseSenderQueue(pCpd, &request);
+    request.dbgStats.posRequestId = 201;
+    cpdResponseSenderQueue(pCpd, &request);
+    if ((pRs->nDropped != count + 1) || (pRs->count != RESPONSE_SENDER_QUEUE_SIZE) ||
+        (pRs->jobs[0].sessionId != 200) || (pRs->jobs[0].response.flag != RESPONSE_FLAG_POS_MEAS) ||
+        (pRs->jobs[1].sessionId != 202) || (pRs->jobs[3].sessionId != 201)) {
+        errors++;
+    }
+    CPD_LOG(CPD_LOG_ID_TXT | CPD_LOG_ID_CONSOLE, "\nFull queue: %u dropped, oldest of request %u kept",
+            pRs->nDropped - count, pRs->jobs[0].sessionId);
+    pthread_mutex_unlock(&(pRs->lock));
+    /* these requests have no session, their responses are done without modem */
+    if (cpdResponseSenderWait_t(pCpd, 2000) != 0) {
+        errors++;
+    }
+
+    cpdResponseSenderStop(pCpd);
+    cpdResponseSenderModemClose_t(pCpd, modemThread, fds);
+    CPD_LOG(CPD_LOG_ID_TXT | CPD_LOG_ID_CONSOLE, "\nResponse sender errors: %d", errors);
+    return (errors == 0) ? CPD_OK : CPD_NOK;
+}
+
+/*
+ * Number of threads of the process, from /proc/self/status, CPD_ERROR if it can't be read.
+ */
+static int cpdThreads_t(void)
+{
+    FILE *pF;
+    char line[64];
+    int n = CPD_ERROR;
+
+    pF = fopen("/proc/self/status", "r");
+    if (pF == NULL) {
+        return n;
+    }
+    while (fgets(line, sizeof(line), pF) != NULL) {
+        if (strncmp(line, "Threads:", 8) == 0) {
+            n = atoi(&(line[8]));
+            break;
+        }
+    }
+    fclose(pF);
+    return n;
+}
+
+/*
+ * Session timers of periodic request, 2 reports 1 s apart: response due after 3 s, report every second,
+ * session ends on total timeout after 5.4 s (GPS stop is retried every second, there is no GPS).
+ * Reports how late timers fired and number of threads.
+ */
+int cpdSessionTimerCheck_t(pCPD_CONTEXT pCpd, int n, char *pFileName)
+{
+    pSESSION_SCHEDULER pSs = &(pCpd->sessionScheduler);
+    int errors = 0;
+    int threads;
+
+    (void) n;
+    (void) pFileName;
+
+    cpdSessionTimerStart(pCpd);
+    memset(&(pCpd->request), 0, sizeof(REQUEST_PARAMS));
+    pCpd->request.flag = REQUEST_FLAG_POS_MEAS;
+    pCpd->request.posMeas.flag = POS_MEAS_RRC;
+    pCpd->request.posMeas.posMeas_u.rrc_meas.rep_crit.type = REP_CRIT_PERIOD;
+    pCpd->request.posMeas.posMeas_u.rrc_meas.rep_crit.period_rep_crit.rep_amount = 2;
+    pCpd->request.posMeas.posMeas_u.rrc_meas.rep_crit.period_rep_crit.rep_interval_long = 1;
+    pCpd->request.dbgStats.posRequestId = 1;
+    pCpd->request.status.requestReceivedAt = getMsecTime();
+    cpdSessionOpen(pCpd);
+    threads = cpdThreads_t();
+    usleep(7600000);
+    cpdSessionTimerStop(pCpd);
+
+    CPD_LOG(CPD_LOG_ID_TXT | CPD_LOG_ID_CONSOLE, "\nFired: response due %u, report %u, total timeout %u, no fix %u",
+            pSs->nFired[SESSION_TIMER_RESPONSE_DUE], pSs->nFired[SESSION_TIMER_REPORT],
+            pSs->nFired[SESSION_TIMER_TOTAL_TIMEOUT], pSs->nFired[SESSION_TIMER_NO_FIX]);
+    CPD_LOG(CPD_LOG_ID_TXT | CPD_LOG_ID_CONSOLE, "\nLate by %u us average, %u us max, %u late sessions, %u missed reports",
+            cpdSessionTimerLateness(pCpd), pSs->maxLateness, pSs->nLate, pSs->nMissedReports);
+    CPD_LOG(CPD_LOG_ID_TXT | CPD_LOG_ID_CONSOLE, "\n%d threads while session was open", threads);
+    if ((pSs->nFired[SESSION_TIMER_RESPONSE_DUE] != 1) || (pSs->nFired[SESSION_TIMER_REPORT] != 5) ||
+        (pSs->nFired[SESSION_TIMER_TOTAL_TIMEOUT] != 3) || (pSs->nFired[SESSION_TIMER_NO_FIX] != 0) ||
+        (pSs->nLate != 1) || (pSs->nMissedReports != 5) || (cpdSessionCount(pCpd) != 0)) {
+        errors++;
+    }
+    CPD_LOG(CPD_LOG_ID_TXT | CPD_LOG_ID_CONSOLE, "\nSession timer errors: %d", errors);
+    return (errors == 0) ? CPD_OK : CPD_NOK;
+}
+
+static int cpdSessionRequest_t(pCPD_CONTEXT pCpd, POS_MEAS_E flag, GPP_METHOD_TYPE_E method, int horAcc)
+{
+    static unsigned int sessionId = 200;
+
+    memset(&(pCpd->request), 0, sizeof(REQUEST_PARAMS));
+    pCpd->request.flag = REQUEST_FLAG_POS_MEAS;
+    pCpd->request.posMeas.flag = flag;
+    if (flag == POS_MEAS_RRLP) {
+        pCpd->request.posMeas.posMeas_u.rrlp_meas.method_type = method;
+        pCpd->request.posMeas.posMeas_u.rrlp_meas.accurancy = horAcc;
+        pCpd->request.posMeas.posMeas_u.rrlp_meas.resp_time_seconds = 10;
+        pCpd->request.posMeas.posMeas_u.rrlp_meas.mult_sets = MULT_SETS_ONE;
+    }
+    else {
+        pCpd->request.posMeas.posMeas_u.rrc_meas.rep_quant.RRC_method_type = method;
+    }
+    pCpd->request.rs.rep_hor_acc = horAcc;
+    sessionId++;
+    pCpd->request.dbgStats.posRequestId = sessionId;
+    pCpd->request.status.requestReceivedAt = getMsecTime();
+    return cpdSessionOpen(pCpd);
+}
+
+/*
+ * Concurrent sessions: periodic MS-based session, single MS-based session sharing its GPS run and
+ * MS-assisted session which restarts GPS. Location is given to both MS-based sessions, measurements to the
+ * MS-assisted one, fulfilled sessions end, abort ends the rest. Full table ends the oldest session.
+ * Session which needs better accuracy than GPS runs with sends the request again.
+ */
+int cpdSessionCheck_t(pCPD_CONTEXT pCpd, int n, char *pFileName)
+{
+    pSESSION_TABLE pSt = &(pCpd->sessionTable);
+    pRESPONSE_SENDER pRs = &(pCpd->responseSender);
+    pthread_t modemThread;
+    int fds[2];
+    int errors = 0;
+    int i;
+    unsigned int t0;
+
+    (void) n;
+    (void) pFileName;
+
+    if (cpdResponseSenderModemOpen_t(pCpd, &modemThread, fds) != CPD_OK) {
+        return CPD_NOK;
+    }
+    cpdResponseSenderStart(pCpd);
+    responseSenderRejects_t = 0;
+    pCpd->lastFix.maxAge = 0;
+    t0 = getMsecTime();
+
+    if ((cpdSessionRequest_t(pCpd, POS_MEAS_RRC, GPP_METHOD_TYPE_MS_BASED, 0) != CPD_OK) ||
+        (cpdSessionRequest_t(pCpd, POS_MEAS_RRLP, GPP_METHOD_TYPE_MS_BASED, 0) != CPD_NOK) ||
+        (cpdSessionRequest_t(pCpd, POS_MEAS_RRLP, GPP_METHOD_TYPE_MS_ASSISTED, 0) != CPD_OK)) {
+        errors++;
+    }
+    /* location for both MS-based sessions, the single one ends */
+    cpdResponseSenderQueue_t(pCpd, 0);
+    if ((cpdResponseSenderWait_t(pCpd, 5000) != 0) || (pRs->nDone != 2) || (pSt->nFannedOut != 1) ||
+        (cpdSessionCount(pCpd) != 2)) {
+        errors++;
+    }
+    CPD_LOG(CPD_LOG_ID_TXT | CPD_LOG_ID_CONSOLE, "\nLocation: %u responses sent, %d sessions left",
+            pRs->nDone, cpdSessionCount(pCpd));
+    /* measurements only for the MS-assisted session */
+    pthread_mutex_lock(&(pCpd->responseSender.lock));
+    cpdXmlFormatMeasurements_t(pCpd, 4, 0);
+    cpdSessionFanOut(pCpd);
+    pthread_mutex_unlock(&(pCpd->responseSender.lock));
+    if ((cpdResponseSenderWait_t(pCpd, 5000) != 0) || (pRs->nDone != 3) || (cpdSessionCount(pCpd) != 1)) {
+        errors++;
+    }
+    CPD_LOG(CPD_LOG_ID_TXT | CPD_LOG_ID_CONSOLE, "\nMeasurements: %u responses sent in %u ms, %d sessions left",
+            pRs->nDone, getMsecDt(t0), cpdSessionCount(pCpd));
+    if (cpdSessionEndAll(pCpd) != 1) {
+        errors++;
+    }
+
+    /* full table, the oldest session is ended, the rest share the first GPS run */
+    for (i = 0; i <= CPD_MAX_SESSIONS; i++) {
+        cpdSessionRequest_t(pCpd, POS_MEAS_RRC, GPP_METHOD_TYPE_MS_BASED, 0);
+    }
+    if ((pSt->nEvicted != 1) || (pSt->nShared != 1 + CPD_MAX_SESSIONS) || (cpdSessionEndAll(pCpd) != CPD_MAX_SESSIONS)) {
+        errors++;
+    }
+    CPD_LOG(CPD_LOG_ID_TXT | CPD_LOG_ID_CONSOLE, "\nSessions: %u opened, %u shared GPS, %u fanned out, %u evicted",
+            pSt->nOpened, pSt->nShared, pSt->nFannedOut, pSt->nEvicted);
+
+    /* stricter session sends the request again, looser one only shares the GPS run */
+    if ((cpdSessionRequest_t(pCpd, POS_MEAS_RRLP, GPP_METHOD_TYPE_MS_BASED, 100) != CPD_OK) ||
+        (cpdSessionRequest_t(pCpd, POS_MEAS_RRLP, GPP_METHOD_TYPE_MS_BASED, 50) != CPD_OK) ||
+        (pCpd->request.posMeas.posMeas_u.rrlp_meas.accurancy != 50) ||
+        (cpdSessionRequest_t(pCpd, POS_MEAS_RRLP, GPP_METHOD_TYPE_MS_BASED, 200) != CPD_NOK) ||
+        (cpdSessionRequest_t(pCpd, POS_MEAS_RRLP, GPP_METHOD_TYPE_MS_BASED, 0) != CPD_NOK) ||
+        (pSt->nTightened != 1) || (pSt->gpsRs.rep_hor_acc != 50)) {
+        errors++;
+    }
+    CPD_LOG(CPD_LOG_ID_TXT | CPD_LOG_ID_CONSOLE, "\nQoS: %u requests sent again, GPS runs with %d m",
+            pSt->nTightened, pSt->gpsRs.rep_hor_acc);
+    cpdSessionEndAll(pCpd);
+
+    cpdResponseSenderStop(pCpd);
+    cpdResponseSenderModemClose_t(pCpd, modemThread, fds);
+    CPD_LOG(CPD_LOG_ID_TXT | CPD_LOG_ID_CONSOLE, "\nSession errors: %d", errors);
+    return (errors == 0) ? CPD_OK : CPD_NOK;
+}
+
+static int cpdLastFixRequest_t(pCPD_CONTEXT pCpd, int horAcc, int seconds)
+{
+    static unsigned int sessionId = 300;
+
+    memset(&(pCpd->request), 0, sizeof(REQUEST_PARAMS));
+    pCpd->request.flag = REQUEST_FLAG_POS_MEAS;
+    pCpd->request.posMeas.flag = POS_MEAS_RRLP;
+    pCpd->request.posMeas.posMeas_u.rrlp_meas.method_type = GPP_METHOD_TYPE_MS_BASED;
+    pCpd->request.posMeas.posMeas_u.rrlp_meas.accurancy = horAcc;
+    pCpd->request.posMeas.posMeas_u.rrlp_meas.resp_time_seconds = seconds;
+    pCpd->request.posMeas.posMeas_u.rrlp_meas.mult_sets = MULT_SETS_ONE;
+    pCpd->request.rs.method_type = GPP_METHOD_TYPE_MS_BASED;
+    pCpd->request.rs.rep_hor_acc = horAcc;
+    pCpd->request.rs.rep_resp_time_seconds = seconds;
+    pCpd->request.rs.rep_amount = MULT_SETS_ONE;
+    sessionId++;
+    pCpd->request.dbgStats.posRequestId = sessionId;
+    pCpd->request.status.requestReceivedAt = getMsecTime();
+    return cpdSessionOpen(pCpd);
+}
+
+/*
+ * Last fix cache: first request waits 200 ms for GPS, the next one is answered from the cache without GPS,
+ * with refining enabled GPS is started as well. Request for better accuracy and request whose response time
+ * is shorter than age of the fix wait for GPS.
+ */
+int cpdLastFixCheck_t(pCPD_CONTEXT pCpd, int n, char *pFileName)
+{
+    pLAST_FIX_CACHE pLf = &(pCpd->lastFix);
+    pRESPONSE_SENDER pRs = &(pCpd->responseSender);
+    pthread_t modemThread;
+    int fds[2];
+    int errors = 0;
+    unsigned int t0;
+
+    (void) n;
+    (void) pFileName;
+
+    if (cpdResponseSenderModemOpen_t(pCpd, &modemThread, fds) != CPD_OK) {
+        return CPD_NOK;
+    }
+    cpdResponseSenderStart(pCpd);
+    responseSenderRejects_t = 0;
+
+    /* empty cache, location from GPS after 200 ms, 7 m uncertainty */
+    t0 = getMsecTime();
+    if (cpdLastFixRequest_t(pCpd, 50, 10) != CPD_OK) {
+        errors++;
+    }
+    usleep(200000);
+    cpdResponseSenderQueue_t(pCpd, 0);
+    if ((cpdResponseSenderWait_t(pCpd, 5000) != 0) || (pRs->nDone != 1) || (cpdSessionCount(pCpd) != 0)) {
+        errors++;
+    }
+    CPD_LOG(CPD_LOG_ID_TXT | CPD_LOG_ID_CONSOLE, "\nFrom GPS: response sent in %u ms", getMsecDt(t0));
+    /* GPS stop blocks the sender for a second, there is no GPS */
+    usleep(1100000);
+
+    /* answered from the cache, GPS is not started */
+    t0 = getMsecTime();
+    if (cpdLastFixRequest_t(pCpd, 50, 10) != CPD_NOK) {
+        errors++;
+    }
+    if ((cpdResponseSenderWait_t(pCpd, 5000) != 0) || (pRs->nDone != 2) || (cpdSessionCount(pCpd) != 0)) {
+        errors++;
+    }
+    CPD_LOG(CPD_LOG_ID_TXT | CPD_LOG_ID_CONSOLE, "\nFrom cache: response sent in %u ms", getMsecDt(t0));
+
+    /* answered from the cache, GPS refines the cached fix */
+    pLf->refine = CPD_OK;
+    if (cpdLastFixRequest_t(pCpd, 50, 10) != CPD_OK) {
+        errors++;
+    }
+    if ((cpdResponseSenderWait_t(pCpd, 5000) != 0) || (pRs->nDone != 3)) {
+        errors++;
+    }
+    pLf->refine = CPD_NOK;
+
+    /* 5 m accuracy can't be met, 1 s response time is shorter than age of the fix */
+    if (cpdLastFixRequest_t(pCpd, 5, 10) != CPD_OK) {
+        errors++;
+    }
+    cpdSessionEndAll(pCpd);
+    usleep(1100000);
+    if (cpdLastFixRequest_t(pCpd, 50, 1) != CPD_OK) {
+        errors++;
+    }
+    cpdSessionEndAll(pCpd);
+
+    if ((pLf->nLookups != 5) || (pLf->nHits != 2) || (pLf->nStale != 2) || (pLf->nInaccurate != 1) ||
+        (pLf->nTtff != 1) || (pLf->savedTotal < 2 * 200)) {
+        errors++;
+    }
+    CPD_LOG(CPD_LOG_ID_TXT | CPD_LOG_ID_CONSOLE, "\nLast fix: %u lookups, %u hits, %u stale, %u inaccurate, %llu ms saved",
+            pLf->nLookups, pLf->nHits, pLf->nStale, pLf->nInaccurate, pLf->savedTotal);
+    cpdLastFixStats(pCpd);
+
+    cpdResponseSenderStop(pCpd);
+    cpdResponseSenderModemClose_t(pCpd, modemThread, fds);
+    CPD_LOG(CPD_LOG_ID_TXT | CPD_LOG_ID_CONSOLE, "\nLast fix errors: %d", errors);
+    return (errors == 0) ? CPD_OK : CPD_NOK;
+}
+
+/*
+ * Wait until flush thread synced the store, returns number of errors.
+ */
+static int cpdAssistStoreFlushed_t(pASSIST_STORE pAs)
+{
+    int flushed = CPD_NOK;
+    int i;
+
+    for (i = 0; (i < 100) && (flushed != CPD_OK); i++) {
+        pthread_mutex_lock(&(pAs->lock));
+        flushed = ((pAs->dirty != CPD_OK) && (pAs->flushing != CPD_OK)) ? CPD_OK : CPD_NOK;
+        pthread_mutex_unlock(&(pAs->lock));
+        if (flushed != CPD_OK) {
+            usleep(10000);
+        }
+    }
+    return (flushed == CPD_OK) ? 0 : 1;
+}
+
+/*
+ * Assistance data store in <pFileName>: representative assist_data document is stored, the same document again
+ * changes nothing, new ephemeris of one SV is written to the other slot once the current one was flushed,
+ * and over the current one while it's being flushed. Store is reopened and
+ * completes empty request with reference time, location and ephemeris of 12 SVs. Damaged newest slot falls back
+ * to the previous generation, store of other version is dropped.
+ */
+int cpdAssistStoreCheck_t(pCPD_CONTEXT pCpd, int n, char *pFileName)
+{
+    pASSIST_STORE pAs = &(pCpd->assistStore);
+    ASSIST_DATA assistData;
+    char *pDoc;
+    char *pToe;
+    int len;
+    int merged;
+    int k;
+    int errors = 0;
+    unsigned int t0, dt;
+
+    (void) n;
+
+    pDoc = malloc(XML_RX_MAX_DOC_SIZE);
+    if (pDoc == NULL) {
+        return CPD_NOK;
+    }
+    len = cpdXmlBenchmarkDoc_t(pDoc, XML_RX_MAX_DOC_SIZE);
+    unlink(pFileName);
+    pAs->pFileName = pFileName;
+    if ((cpdAssistStoreOpen(pCpd) != CPD_OK) || (pAs->current != CPD_ERROR)) {
+        errors++;
+    }
+
+    t0 = getMsecTime();
+    cpdXmlBenchmarkPush_t(pCpd, pDoc, len);
+    dt = getMsecDt(t0);
+    errors += cpdAssistStoreFlushed_t(pAs);
+    cpdXmlBenchmarkPush_t(pCpd, pDoc, len);
+    pToe = strstr(pDoc, "<toe>12600<");
+    if (pToe != NULL) {
+        pToe[9] = '9';
+    }
+    cpdXmlBenchmarkPush_t(pCpd, pDoc, len);
+    errors += cpdAssistStoreFlushed_t(pAs);
+    CPD_LOG(CPD_LOG_ID_TXT | CPD_LOG_ID_CONSOLE, "\nStored: %u updates, %u unchanged, %u flushes, first message %u ms",
+            pAs->nUpdates, pAs->nUnchanged, pAs->nFlushes, dt);
+    if ((pToe == NULL) || (pAs->nUpdates != 2) || (pAs->nUnchanged != 1) || (pAs->nFlushes != 2) ||
+        (pAs->current == CPD_ERROR) || (pAs->pSlots[pAs->current].generation != 2)) {
+        errors++;
+    }
+
+    /* current slot not on disk yet is rewritten, the other one stays valid */
+    pthread_mutex_lock(&(pAs->lock));
+    pAs->flushing = CPD_OK;
+    pthread_mutex_unlock(&(pAs->lock));
+    if (pToe != NULL) {
+        pToe[9] = '8';
+    }
+    cpdXmlBenchmarkPush_t(pCpd, pDoc, len);
+    errors += cpdAssistStoreFlushed_t(pAs);
+    k = (pAs->current == 0) ? 1 : 0;
+    if ((pAs->nUpdates != 3) || (pAs->pSlots[pAs->current].generation != 2) ||
+        (pAs->pSlots[k].generation != 1) || (pAs->pSlots[k].magic != ASSIST_STORE_MAGIC)) {
+        CPD_LOG(CPD_LOG_ID_TXT | CPD_LOG_ID_CONSOLE, "\nRewritten: generation %u, other slot %u",
+                pAs->pSlots[pAs->current].generation, pAs->pSlots[k].generation);
+        errors++;
+    }
+
+    /* restart */
+    cpdAssistStoreClose(pCpd);
+    cpdAssistStoreOpen(pCpd);
+    memset(&assistData, 0, sizeof(ASSIST_DATA));
+    merged = cpdAssistStoreMerge(pCpd, &assistData);
+    CPD_LOG(CPD_LOG_ID_TXT | CPD_LOG_ID_CONSOLE, "\nReopened: generation %u, %d items, week %d, TOW %ld ms, %d SVs",
+            (pAs->current != CPD_ERROR) ? pAs->pSlots[pAs->current].generation : 0, merged,
+            assistData.GPS_assist.ref_time.GPS_time.GPS_week, assistData.GPS_assist.ref_time.GPS_time.GPS_TOW_msec,
+            assistData.GPS_assist.nav_model_elem_arr_items);
+    if ((merged != 2 + GPS_MAX_N_SVS) || (assistData.flag != merged) || (assistData.GPS_assist.ref_time.GPS_time.GPS_week != 1723) ||
+        (assistData.GPS_assist.ref_time.GPS_time.GPS_TOW_msec < 345678900) ||
+        (assistData.GPS_assist.location_parameters.shape_type != SHAPE_TYPE_POINT_ALT_UNCERT_ELLIPSE) ||
+        (assistData.GPS_assist.nav_model_elem_arr[GPS_MAX_N_SVS - 1].sat_id != 2 * GPS_MAX_N_SVS)) {
+        errors++;
+    }
+
+    /* damaged newest slot */
+    pAs->pSlots[pAs->current].data.ephemeris[0].ephem_and_clock.toe ^= 1;
+    cpdAssistStoreClose(pCpd);
+    cpdAssistStoreOpen(pCpd);
+    if ((pAs->current == CPD_ERROR) || (pAs->pSlots[pAs->current].generation != 1)) {
+        errors++;
+    }
+    CPD_LOG(CPD_LOG_ID_TXT | CPD_LOG_ID_CONSOLE, "\nDamaged: generation %u used",
+            (pAs->current != CPD_ERROR) ? pAs->pSlots[pAs->current].generation : 0);
+
+    /* other version */
+    pAs->pSlots[0].version = ASSIST_STORE_VERSION + 1;
+    pAs->pSlots[1].version = ASSIST_STORE_VERSION + 1;
+    cpdAssistStoreClose(pCpd);
+    cpdAssistStoreOpen(pCpd);
+    memset(&assistData, 0, sizeof(ASSIST_DATA));
+    if ((pAs->current != CPD_ERROR) || (cpdAssistStoreMerge(pCpd, &assistData) != 0)) {
+        errors++;
+    }
+
+    cpdAssistStoreClose(pCpd);
+    unlink(pFileName);
+    free(pDoc);
+    CPD_LOG(CPD_LOG_ID_TXT | CPD_LOG_ID_CONSOLE, "\nAssistance store errors: %d", errors);
+    return (errors == 0) ? CPD_OK : CPD_NOK;
+}
+
+/*
+ * nav_model_elem of SV <satId> in <pAssistData>, NULL if it's not there.
+ */
+static pNAV_MODEL_ELEM cpdAidingFind_t(pASSIST_DATA pAssistData, int satId)
+{
+    int i;
+
+    for (i = 0; i < pAssistData->GPS_assist.nav_model_elem_arr_items; i++) {
+        if (pAssistData->GPS_assist.nav_model_elem_arr[i].sat_id == satId) {
+            return &(pAssistData->GPS_assist.nav_model_elem_arr[i]);
+        }
+    }
+    return NULL;
+}
+
+/*
+ * Ephemeris cache: representative assist_data document is sent to GPS twice, second time all 12 SVs are left
+ * out and GPS side restores them from its mirror. New toe of one SV sends only that SV. Apply latency is
+ * measured over <n> restores.
+ */
+int cpdAidingCacheCheck_t(pCPD_CONTEXT pCpd, int n, char *pFileName)
+{
+    pAIDING_CACHE pAc = &(pCpd->aidingCache);
+    ASSIST_DATA sent;
+    ASSIST_DATA wire;
+    unsigned long long sending;
+    pNAV_MODEL_ELEM pElem;
+    char *pDoc;
+    int len;
+    int i, k;
+    int errors = 0;
+
+    (void) pFileName;
+
+    pDoc = malloc(XML_RX_MAX_DOC_SIZE);
+    if (pDoc == NULL) {
+        return CPD_NOK;
+    }
+    len = cpdXmlBenchmarkDoc_t(pDoc, XML_RX_MAX_DOC_SIZE);
+    cpdXmlBenchmarkPush_t(pCpd, pDoc, len);
+    memcpy(&sent, &(pCpd->request.assist_data), sizeof(ASSIST_DATA));
+    cpdAidingReset(pCpd);
+    pAc->nSent = 0;
+    pAc->nLeftOut = 0;
+    pAc->bytesSaved = 0;
+
+    /* first time everything is sent, but only a request which was written marks ephemeris sent */
+    memcpy(&wire, &sent, sizeof(ASSIST_DATA));
+    k = cpdAidingStrip(pCpd, &wire, &sending);
+    cpdAidingApply(pCpd, &wire);
+    if ((k != 0) || (wire.nav_model_mirrored != 0) || (memcmp(&wire, &sent, sizeof(ASSIST_DATA)) != 0) ||
+        (pAc->nSent != 0)) {
+        errors++;
+    }
+    memcpy(&wire, &sent, sizeof(ASSIST_DATA));
+    k = cpdAidingStrip(pCpd, &wire, &sending);
+    cpdAidingSent(pCpd, &sent, sending);
+    if ((k != 0) || (pAc->nSent != GPS_MAX_N_SVS)) {
+        errors++;
+    }
+
+    /* the same ephemeris again */
+    memcpy(&wire, &sent, sizeof(ASSIST_DATA));
+    k = cpdAidingStrip(pCpd, &wire, &sending);
+    CPD_LOG(CPD_LOG_ID_TXT | CPD_LOG_ID_CONSOLE, "\nResent: %d of %d SVs left out, %d sent, %llu bytes saved",
+            k, sent.GPS_assist.nav_model_elem_arr_items, wire.GPS_assist.nav_model_elem_arr_items, pAc->bytesSaved);
+    if ((k != GPS_MAX_N_SVS) || (sending != 0) || (wire.GPS_assist.nav_model_elem_arr_items != 0) ||
+        (pAc->bytesSaved != GPS_MAX_N_SVS * sizeof(NAV_MODEL_ELEM))) {
+        errors++;
+    }
+    k = cpdAidingApply(pCpd, &wire);
+    if ((k != 0) || (wire.nav_model_mirrored != 0) ||
+        (wire.GPS_assist.nav_model_elem_arr_items != sent.GPS_assist.nav_model_elem_arr_items)) {
+        errors++;
+    }
+    for (i = 0; i < sent.GPS_assist.nav_model_elem_arr_items; i++) {
+        pElem = cpdAidingFind_t(&wire, sent.GPS_assist.nav_model_elem_arr[i].sat_id);
+        if ((pElem == NULL) || (memcmp(pElem, &(sent.GPS_assist.nav_model_elem_arr[i]), sizeof(NAV_MODEL_ELEM)) != 0)) {
+            errors++;
+        }
+    }
+
+    /* new ephemeris of one SV */
+    sent.GPS_assist.nav_model_elem_arr[3].ephem_and_clock.toe += 16;
+    memcpy(&wire, &sent, sizeof(ASSIST_DATA));
+    k = cpdAidingStrip(pCpd, &wire, &sending);
+    cpdAidingSent(pCpd, &sent, sending);
+    CPD_LOG(CPD_LOG_ID_TXT | CPD_LOG_ID_CONSOLE, "\nNew toe: %d left out, SV %d sent",
+            k, wire.GPS_assist.nav_model_elem_arr[0].sat_id);
+    if ((k != GPS_MAX_N_SVS - 1) || (wire.GPS_assist.nav_model_elem_arr_items != 1) ||
+        (wire.GPS_assist.nav_model_elem_arr[0].sat_id != sent.GPS_assist.nav_model_elem_arr[3].sat_id)) {
+        errors++;
+    }
+    cpdAidingApply(pCpd, &wire);
+    pElem = cpdAidingFind_t(&wire, sent.GPS_assist.nav_model_elem_arr[3].sat_id);
+    if ((wire.GPS_assist.nav_model_elem_arr_items != GPS_MAX_N_SVS) || (pElem == NULL) ||
+        (pElem->ephem_and_clock.toe != sent.GPS_assist.nav_model_elem_arr[3].ephem_and_clock.toe)) {
+        errors++;
+    }
+
+    /* request with new ephemeris of one SV is lost: it's sent again with the next one */
+    sent.GPS_assist.nav_model_elem_arr[3].ephem_and_clock.toe += 16;
+    memcpy(&wire, &sent, sizeof(ASSIST_DATA));
+    cpdAidingStrip(pCpd, &wire, &sending);
+    memcpy(&wire, &sent, sizeof(ASSIST_DATA));
+    k = cpdAidingStrip(pCpd, &wire, &sending);
+    cpdAidingSent(pCpd, &sent, sending);
+    if ((k != GPS_MAX_N_SVS - 1) || (wire.GPS_assist.nav_model_elem_arr_items != 1)) {
+        errors++;
+    }
+
+    /* reconnected CPDD: GPS side drops its mirror, the one new SV alone is not passed to GPS library */
+    cpdAidingMirrorReset(pCpd);
+    k = pAc->nMissing;
+    if ((cpdAidingApply(pCpd, &wire) != GPS_MAX_N_SVS - 1) || ((int) pAc->nMissing - k != GPS_MAX_N_SVS - 1) ||
+        (wire.GPS_assist.nav_model_elem_arr_items != 0) || (wire.nav_model_mirrored != 0)) {
+        errors++;
+    }
+    pAc->nMissing = k;
+
+    /* CPDD asked to send all again, or reconnected GPS, gets everything */
+    cpdAidingReset(pCpd);
+    memcpy(&wire, &sent, sizeof(ASSIST_DATA));
+    if (cpdAidingStrip(pCpd, &wire, &sending) != 0) {
+        errors++;
+    }
+    cpdAidingSent(pCpd, &sent, sending);
+
+    pAc->nApplied = 0;
+    pAc->applyUsTotal = 0;
+    pAc->applyUsMax = 0;
+    /* every request restores all 12 SVs */
+    cpdAidingApply(pCpd, &wire);
+    memcpy(&sent, &wire, sizeof(ASSIST_DATA));
+    cpdAidingStrip(pCpd, &sent, &sending);
+    for (i = 0; i < n; i++) {
+        memcpy(&wire, &sent, sizeof(ASSIST_DATA));
+        cpdAidingApply(pCpd, &wire);
+    }
+    CPD_LOG(CPD_LOG_ID_TXT | CPD_LOG_ID_CONSOLE, "\nApply: %u restores, %llu us avg, %u us max, %u missing",
+            pAc->nApplied, (pAc->nApplied > 0) ? pAc->applyUsTotal / pAc->nApplied : 0, pAc->applyUsMax, pAc->nMissing);
+    if ((pAc->nApplied != (unsigned int) n) || (pAc->nMissing != 0)) {
+        errors++;
+    }
+    cpdAidingStats(pCpd);
+
+    free(pDoc);
+    CPD_LOG(CPD_LOG_ID_TXT | CPD_LOG_ID_CONSOLE, "\nAiding cache errors: %d", errors);
+    return (errors == 0) ? CPD_OK : CPD_NOK;
+}
+
+static unsigned int gpsFramingHandled_t = 0;
+static unsigned int gpsFramingNextId_t = 0;
+static unsigned int gpsFramingOutOfOrder_t = 0;
+
+/*
+ * Messages of the stream carry their index in dbgStats.posRequestId, each has to come once and in order.
+ */
+static void cpdGpsFramingOrder_t(unsigned int id)
+{
+    if (id != gpsFramingNextId_t) {
+        gpsFramingOutOfOrder_t++;
+    }
+    gpsFramingNextId_t = id + 1;
+    gpsFramingHandled_t++;
+}
+
+static int cpdGpsFramingCountRequest_t(void *pArg)
+{
+    cpdGpsFramingOrder_t(((pCPD_CONTEXT) pArg)->request.dbgStats.posRequestId);
+    return CPD_OK;
+}
+
+static int cpdGpsFramingCountResponse_t(void *pArg)
+{
+    cpdGpsFramingOrder_t(((pCPD_CONTEXT) pArg)->response.dbgStats.posRequestId);
+    return CPD_OK;
+}
+
+/*
+ * Stream of <n> requests and <n> responses in <framing>, offsets of messages are written to <pOffsets>.
+ * Returns length of the stream.
+ */
+static int cpdGpsFramingStream_t(pCPD_CONTEXT pCpd, char *pStream, int *pOffsets, int n, int framing)
+{
+    pGPS_COMM_BUFFER pGpsComm = &(pCpd->gpsCommBuffer);
+    pREQUEST_PARAMS pRequest;
+    pRESPONSE_PARAMS pResponse;
+    int len = 0;
+    int i;
+
+    pGpsComm->txFraming = framing;
+    for (i = 0; i < 2 * n; i++) {
+        pOffsets[i] = len;
+        if ((i & 1) == 0) {
+            memset(&(pStream[len]), 0, CPD_MSG_HEAD_SIZE + sizeof(REQUEST_PARAMS));
+            pRequest = (pREQUEST_PARAMS) &(pStream[len + CPD_MSG_HEAD_SIZE]);
+            pRequest->version = CPD_MSG_VERSION;
+            pRequest->flag = REQUEST_FLAG_ASSIST_DATA;
+            pRequest->dbgStats.posRequestId = i;
+            len += cpdGpsMsgFrame(pGpsComm, &(pStream[len]), CPD_MSG_HEADER_TO_GPS, CPD_MSG_TYPE_POS_MEAS_REQ,
+                                  sizeof(REQUEST_PARAMS));
+        }
+        else {
+            memset(&(pStream[len]), 0, CPD_MSG_HEAD_SIZE + sizeof(RESPONSE_PARAMS));
+            pResponse = (pRESPONSE_PARAMS) &(pStream[len + CPD_MSG_HEAD_SIZE]);
+            pResponse->version = CPD_MSG_VERSION;
+            pResponse->flag = CPD_OK;
+            pResponse->dbgStats.posRequestId = i;
+            len += cpdGpsMsgFrame(pGpsComm, &(pStream[len]), CPD_MSG_HEADER_FROM_GPS, CPD_MSG_TYPE_POS_MEAS_RESP,
+                                  sizeof(RESPONSE_PARAMS));
+        }
+    }
+    pGpsComm->txFraming = CPD_MSG_FRAMING_TEXT;
+    return len;
+}
+
+/*
+ * Pass <len> bytes of <pStream> to GPS message reader in random fragments of 1..<maxFragment> bytes, the way
+ * socket delivers them. Returns number of handled messages.
+ */
+static unsigned int cpdGpsFramingFeed_t(pCPD_CONTEXT pCpd, char *pStream, int len, int maxFragment)
+{
+    pGPS_COMM_BUFFER pGpsComm = &(pCpd->gpsCommBuffer);
+    int j, k;
+
+    pGpsComm->rxBufferIndex = 0;
+    pGpsComm->rxBufferStart = 0;
+    pGpsComm->rxBufferCmdStart = CPD_ERROR;
+    pGpsComm->rxBufferCmdNext = CPD_ERROR;
+    pGpsComm->nRxText = 0;
+    pGpsComm->nRxV2 = 0;
+    pGpsComm->nResync = 0;
+    pGpsComm->nCrcErrors = 0;
+    pGpsComm->bytesDropped = 0;
+    pGpsComm->nRxReads = 0;
+    pGpsComm->maxRxPerRead = 0;
+    gpsFramingHandled_t = 0;
+    gpsFramingNextId_t = 0;
+    gpsFramingOutOfOrder_t = 0;
+    srand(maxFragment);
+    for (j = 0; j < len; j = j + k) {
+        k = 1 + (rand() % maxFragment);
+        if (k > len - j) {
+            k = len - j;
+        }
+        cpdGpsCommMsgReader(NULL, &(pStream[j]), k, 0);
+    }
+    return gpsFramingHandled_t;
+}
+
+/*
+ * Stream of <n> encoded requests and <n> encoded responses in <framing>, with 0..GPS_MAX_N_SVS satellites each,
+ * so messages are of many lengths. Returns length of the stream, which has room for <size> bytes.
+ */
+static int cpdGpsReassemblyStream_t(pCPD_CONTEXT pCpd, char *pStream, int size, int n, int framing)
+{
+    pGPS_COMM_BUFFER pGpsComm = &(pCpd->gpsCommBuffer);
+    pGPS_ASSIST pGa = &(pCpd->request.assist_data.GPS_assist);
+    pGPS_MEAS pMeas = &(pCpd->response.GPS_meas);
+    int tailLen = strlen(CPD_MSG_TAIL);
+    int len = 0;
+    int dataSize;
+    int i, k;
+
+    pGpsComm->txFraming = framing;
+    for (i = 0; i < 2 * n; i++) {
+        if ((i & 1) == 0) {
+            memset(&(pCpd->request), 0, sizeof(REQUEST_PARAMS));
+            pCpd->request.version = CPD_MSG_VERSION;
+            pCpd->request.flag = REQUEST_FLAG_ASSIST_DATA;
+            pCpd->request.dbgStats.posRequestId = i;
+            pGa->nav_model_elem_arr_items = (i / 2) % (GPS_MAX_N_SVS + 1);
+            for (k = 0; k < pGa->nav_model_elem_arr_items; k++) {
+                pGa->nav_model_elem_arr[k].sat_id = k + 1;
+                pGa->nav_model_elem_arr[k].ephem_and_clock.toe = i;
+            }
+            dataSize = cpdGpsWireEncode(pCpd, GPS_WIRE_REQUEST, &(pCpd->request), &(pStream[len + CPD_MSG_HEAD_SIZE]),
+                                        size - len - CPD_MSG_HEAD_SIZE - tailLen);
+            if (dataSize <= 0) {
+                break;
+            }
+            len += cpdGpsMsgFrame(pGpsComm, &(pStream[len]), CPD_MSG_HEADER_TO_GPS, CPD_MSG_TYPE_POS_MEAS_REQ, dataSize);
+        }
+        else {
+            memset(&(pCpd->response), 0, sizeof(RESPONSE_PARAMS));
+            pCpd->response.version = CPD_MSG_VERSION;
+            pCpd->response.flag = RESPONSE_FLAG_GPS_MEAS;
+            pCpd->response.dbgStats.posRequestId = i;
+            pMeas->meas_params_arr_items = (i / 2) % (GPS_MAX_N_SVS + 1);
+            for (k = 0; k < (int) pMeas->meas_params_arr_items; k++) {
+                pMeas->meas_params_arr[k].sat_id = (unsigned char) (k + 1);
+                pMeas->meas_params_arr[k].dopl = i;
+            }
+            dataSize = cpdGpsWireEncode(pCpd, GPS_WIRE_RESPONSE, &(pCpd->response), &(pStream[len + CPD_MSG_HEAD_SIZE]),
+                                        size - len - CPD_MSG_HEAD_SIZE - tailLen);
+            if (dataSize <= 0) {
+                break;
+            }
+            len += cpdGpsMsgFrame(pGpsComm, &(pStream[len]), CPD_MSG_HEADER_FROM_GPS, CPD_MSG_TYPE_POS_MEAS_RESP, dataSize);
+        }
+    }
+    pGpsComm->txFraming = CPD_MSG_FRAMING_TEXT;
+    return len;
+}
+
+/*
+ * Reassembly of messages split and coalesced at random: the stream is fed in fragments from single bytes to
+ * many messages longer than the receive buffer. Every message has to be handled once and in order, with no
+ * bytes dropped. Returns number of errors.
+ */
+static int cpdGpsReassemblyStress_t(pCPD_CONTEXT pCpd, char *pStream, int size, int n)
+{
+    static const int framings[] = { CPD_MSG_FRAMING_TEXT, CPD_MSG_FRAMING_V2 };
+    static const char *pFramingNames[] = { "text", "v2" };
+    static const int fragments[] = { 1, 64, 1460, SOCKET_RX_BUFFER_SIZE - 4, 4 * GPS_COMM_RX_BUFFER_SIZE };
+    pGPS_COMM_BUFFER pGpsComm = &(pCpd->gpsCommBuffer);
+    unsigned int handled;
+    unsigned int t0, dt;
+    int errors = 0;
+    int len;
+    int nf;
+    int m, f;
+
+    for (m = 0; m < (int) (sizeof(framings) / sizeof(framings[0])); m++) {
+        for (f = 0; f < (int) (sizeof(fragments) / sizeof(fragments[0])); f++) {
+            /* a read per byte is slow, fewer messages are enough */
+            nf = (fragments[f] < 16) ? ((n + 9) / 10) : n;
+            len = cpdGpsReassemblyStream_t(pCpd, pStream, size, nf, framings[m]);
+            t0 = getMsecTime();
+            handled = cpdGpsFramingFeed_t(pCpd, pStream, len, fragments[f]);
+            dt = getMsecDt(t0);
+            if (dt == 0) {
+                dt = 1;
+            }
+            CPD_LOG(CPD_LOG_ID_TXT | CPD_LOG_ID_CONSOLE,
+                    "\n%s split 1..%d: %u/%d messages, %u reads, %u max per read, %u out of order, %u dropped, %u msg/s",
+                    pFramingNames[m], fragments[f], handled, 2 * nf, pGpsComm->nRxReads, pGpsComm->maxRxPerRead,
+                    gpsFramingOutOfOrder_t, pGpsComm->bytesDropped, (unsigned int) ((handled * 1000ULL) / dt));
+            if ((handled != (unsigned int) (2 * nf)) || (gpsFramingOutOfOrder_t != 0) || (pGpsComm->nResync != 0) ||
+                (pGpsComm->bytesDropped != 0) || (pGpsComm->rxBufferIndex != 0)) {
+                errors++;
+            }
+        }
+    }
+    return errors;
+}
+
+/*
+ * Framing of messages between CPDD and GPS: <n> requests and <n> responses in each framing are received in
+ * random fragments, messages and MB per second are reported. Encoded messages of many lengths are reassembled
+ * from fragments of every size. Damaged payload of binary message and damaged tail of text message lose only
+ * that message, damaged binary header only that message. Framing answer from GPS switches sent messages to
+ * binary framing.
+ */
+int cpdGpsFramingBenchmark_t(pCPD_CONTEXT pCpd, int n, char *pFileName)
+{
+    static const int framings[] = { CPD_MSG_FRAMING_TEXT, CPD_MSG_FRAMING_V2 };
+    static const char *pFramingNames[] = { "text", "v2" };
+    pGPS_COMM_BUFFER pGpsComm = &(pCpd->gpsCommBuffer);
+    fCPD_SEND_MSG_TO *pfInCpd = pCpd->pfMessageHandlerInCpd;
+    fCPD_SEND_MSG_TO *pfInGps = pCpd->pfMessageHandlerInGps;
+    char pB[CPD_MSG_HEAD_SIZE + sizeof(int) + 16];
+    char *pStream;
+    int *pOffsets;
+    int framing = CPD_MSG_FRAMING_V2;
+    int size;
+    int len;
+    int m;
+    unsigned int handled;
+    unsigned int t0, dt;
+    int errors = 0;
+
+    (void) pFileName;
+
+    if (n < 8) {
+        n = 8;
+    }
+    size = 2 * n * (CPD_MSG_HEAD_SIZE + sizeof(REQUEST_PARAMS) + 16);
+    pStream = malloc(size);
+    pOffsets = malloc(2 * n * sizeof(int));
+    if ((pStream == NULL) || (pOffsets == NULL)) {
+        free(pStream);
+        free(pOffsets);
+        return CPD_NOK;
+    }
+    pCpd->pfMessageHandlerInCpd = cpdGpsFramingCountResponse_t;
+    pCpd->pfMessageHandlerInGps = cpdGpsFramingCountRequest_t;
+
+    for (m = 0; m < (int) (sizeof(framings) / sizeof(framings[0])); m++) {
+        len = cpdGpsFramingStream_t(pCpd, pStream, pOffsets, n, framings[m]);
+        t0 = getMsecTime();
+        handled = cpdGpsFramingFeed_t(pCpd, pStream, len, 512);
+        dt = getMsecDt(t0);
+        if (dt == 0) {
+            dt = 1;
+        }
+        CPD_LOG(CPD_LOG_ID_TXT | CPD_LOG_ID_CONSOLE, "\n%s: %u/%d messages, %d bytes, %u ms, %u msg/s, %u KB/s",
+                pFramingNames[m], handled, 2 * n, len, dt, (unsigned int) ((handled * 1000ULL) / dt),
+                (unsigned int) (((unsigned long long) len * 1000ULL) / 1024 / dt));
+        if ((handled != (unsigned int) (2 * n)) || (gpsFramingOutOfOrder_t != 0) || (pGpsComm->nResync != 0) ||
+            (pGpsComm->bytesDropped != 0)) {
+            errors++;
+        }
+    }
+
+    errors += cpdGpsReassemblyStress_t(pCpd, pStream, size, n);
+
+    /* damaged messages */
+    len = cpdGpsFramingStream_t(pCpd, pStream, pOffsets, n, CPD_MSG_FRAMING_V2);
+    pStream[pOffsets[3] + CPD_MSG_HEAD_SIZE + 100] ^= 0x10;
+    pStream[pOffsets[6]] ^= 0x01;
+    handled = cpdGpsFramingFeed_t(pCpd, pStream, len, 512);
+    CPD_LOG(CPD_LOG_ID_TXT | CPD_LOG_ID_CONSOLE, "\nv2 damaged: %u/%d messages, %u resync, %u CRC errors, %u bytes dropped",
+            handled, 2 * n, pGpsComm->nResync, pGpsComm->nCrcErrors, pGpsComm->bytesDropped);
+    if ((handled != (unsigned int) (2 * n - 2)) || (pGpsComm->nCrcErrors != 1) || (pGpsComm->nResync == 0)) {
+        errors++;
+    }
+    len = cpdGpsFramingStream_t(pCpd, pStream, pOffsets, n, CPD_MSG_FRAMING_TEXT);
+    pStream[pOffsets[5] - 3] ^= 0x01;
+    handled = cpdGpsFramingFeed_t(pCpd, pStream, len, 512);
+    CPD_LOG(CPD_LOG_ID_TXT | CPD_LOG_ID_CONSOLE, "\ntext damaged: %u/%d messages, %u resync, %u bytes dropped",
+            handled, 2 * n, pGpsComm->nResync, pGpsComm->bytesDropped);
+    if (handled != (unsigned int) (2 * n - 1)) {
+        errors++;
+    }
+
+    /* GPS agreed on binary framing */
+    pGpsComm->txFraming = CPD_MSG_FRAMING_TEXT;
+    memcpy(&(pB[CPD_MSG_HEAD_SIZE]), &framing, sizeof(int));
+    len = cpdGpsMsgFrame(pGpsComm, pB, CPD_MSG_HEADER_FROM_GPS, CPD_MSG_TYPE_FRAMING_RESP, sizeof(int));
+    cpdGpsFramingFeed_t(pCpd, pB, len, 512);
+    if (pGpsComm->txFraming != CPD_MSG_FRAMING_V2) {
+        errors++;
+    }
+    pGpsComm->txFraming = CPD_MSG_FRAMING_TEXT;
+
+    pCpd->pfMessageHandlerInCpd = pfInCpd;
+    pCpd->pfMessageHandlerInGps = pfInGps;
+    free(pStream);
+    free(pOffsets);
+    CPD_LOG(CPD_LOG_ID_TXT | CPD_LOG_ID_CONSOLE, "\nGPS framing errors: %d", errors);
+    return (errors == 0) ? CPD_OK : CPD_NOK;
+}
+
+#define GPS_RING_SOCKET_T   "cpdGps_t.sock"
+static pthread_mutex_t gpsRingLock_t = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t gpsRingCond_t = PTHREAD_COND_INITIALIZER;
+static unsigned int gpsRingResponses_t = 0;
+static unsigned int gpsRingResponseId_t = 0;
+
+static int cpdGpsRingEcho_t(void *pArg)
+{
+    pCPD_CONTEXT pCpd = (pCPD_CONTEXT) pArg;
+
+    memset(&(pCpd->response), 0, sizeof(RESPONSE_PARAMS));
+    pCpd->response.flag = CPD_OK;
+    pCpd->response.dbgStats.posRequestId = pCpd->request.dbgStats.posRequestId;
+    return cpdFormatAndSendMsgToCpd(pCpd);
+}
+
+static int cpdGpsRingResponse_t(void *pArg)
+{
+    pCPD_CONTEXT pCpd = (pCPD_CONTEXT) pArg;
+
+    pthread_mutex_lock(&gpsRingLock_t);
+    gpsRingResponseId_t = pCpd->response.dbgStats.posRequestId;
+    gpsRingResponses_t++;
+    pthread_cond_signal(&gpsRingCond_t);
+    pthread_mutex_unlock(&gpsRingLock_t);
+    return CPD_OK;
+}
+
+/*
+ * GPS side of the benchmark, runs in child process until killed.
+ */
+static void cpdGpsRingServer_t(pCPD_CONTEXT pCpd)
+{
+    pCpd->scGps.type = SOCKET_SERVER_TYPE_SERVER_LOCAL;
+    pCpd->scGps.maxConnections = 1;
+    pCpd->scGps.pfReadCallback = &cpdGpsCommMsgReader;
+    snprintf(pCpd->scGps.localSocketname, sizeof(pCpd->scGps.localSocketname), "%s", GPS_RING_SOCKET_T);
+    pCpd->pfMessageHandlerInGps = cpdGpsRingEcho_t;
+    if ((cpdSocketServerInit(&(pCpd->scGps)) != CPD_OK) || (cpdSocketServerOpen(&(pCpd->scGps)) != CPD_OK)) {
+        _exit(1);
+    }
+    while (1) {
+        sleep(1);
+    }
+}
+
+/*
+ * Send <n> requests one at a time and wait for each response, round trip times are reported.
+ */
+static int cpdGpsRingRoundTrips_t(pCPD_CONTEXT pCpd, const char *pName, int n)
+{
+    REQUEST_PARAMS request;
+    struct timespec t0, t1, deadline;
+    unsigned long long total = 0;
+    unsigned int us;
+    unsigned int usMin = 0xFFFFFFFFU;
+    unsigned int usMax = 0;
+    unsigned int expected;
+    int errors = 0;
+    int i;
+
+    memset(&request, 0, sizeof(request));
+    request.flag = REQUEST_FLAG_POS_MEAS;
+    request.posMeas.flag = POS_MEAS_RRLP;
+    for (i = 0; i < n; i++) {
+        request.dbgStats.posRequestId = i;
+        pthread_mutex_lock(&gpsRingLock_t);
+        expected = gpsRingResponses_t + 1;
+        pthread_mutex_unlock(&gpsRingLock_t);
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        if (cpdFormatAndSendRequestToGps(pCpd, &request) <= CPD_NOK) {
+            errors++;
+            break;
+        }
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += 2;
+        pthread_mutex_lock(&gpsRingLock_t);
+        while (gpsRingResponses_t < expected) {
+            if (pthread_cond_timedwait(&gpsRingCond_t, &gpsRingLock_t, &deadline) != 0) {
+                break;
+            }
+        }
+        pthread_mutex_unlock(&gpsRingLock_t);
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        /* response is the one to this request, not a late one */
+        if ((gpsRingResponses_t < expected) || (gpsRingResponseId_t != (unsigned int) i)) {
+            errors++;
+            break;
+        }
+        us = (unsigned int) (((t1.tv_sec - t0.tv_sec) * 1000000L) + ((t1.tv_nsec - t0.tv_nsec) / 1000));
+        total += us;
+        usMin = (us < usMin) ? us : usMin;
+        usMax = (us > usMax) ? us : usMax;
+    }
+    /* request went through GPS side decoding and came back */
+    if ((i > 0) && (pCpd->response.dbgStats.posRequestId != (unsigned int) (i - 1))) {
+        errors++;
+    }
+    if ((i > 0) && (errors == 0)) {
+        CPD_LOG(CPD_LOG_ID_TXT | CPD_LOG_ID_CONSOLE, "\n%s%s: %d round trips, %u us min, %llu us avg, %u us max, %llu/s",
+                pName, (pCpd->gpsCommBuffer.txPacked == CPD_OK) ? ", packed" : "", i, usMin, total / i, usMax,
+                (total > 0) ? (i * 1000000ULL) / total : 0ULL);
+    }
+    return errors;
+}
+
+/*
+ * CPDD believes GPS has ephemeris of 4 SVs which it never got, as after a lost request. GPS side has to
+ * ask for all ephemeris again, instead of passing the request on with a partial navigation model,
+ * and still answer the request. Returns number of errors.
+ */
+static int cpdGpsRingResend_t(pCPD_CONTEXT pCpd)
+{
+    REQUEST_PARAMS request;
+    unsigned int expected;
+    int resent = CPD_NOK;
+    int answered = CPD_NOK;
+    int i;
+
+    memset(&request, 0, sizeof(request));
+    request.flag = REQUEST_FLAG_POS_MEAS;
+    request.posMeas.flag = POS_MEAS_RRLP;
+    request.dbgStats.posRequestId = 77;
+    for (i = 0; i < 4; i++) {
+        request.assist_data.GPS_assist.nav_model_elem_arr[i].sat_id = i + 1;
+        request.assist_data.GPS_assist.nav_model_elem_arr[i].sat_status = NAV_ELEM_SAT_STATUS_NS_NN;
+        request.assist_data.GPS_assist.nav_model_elem_arr[i].ephem_and_clock.toe = 100 + i;
+    }
+    request.assist_data.GPS_assist.nav_model_elem_arr_items = 4;
+    request.assist_data.flag = 1;
+    cpdAidingReset(pCpd);
+    cpdAidingSent(pCpd, &(request.assist_data), 0x0FULL);
+
+    pthread_mutex_lock(&gpsRingLock_t);
+    expected = gpsRingResponses_t + 1;
+    pthread_mutex_unlock(&gpsRingLock_t);
+    if (cpdFormatAndSendRequestToGps(pCpd, &request) <= CPD_NOK) {
+        return 1;
+    }
+    for (i = 0; (i < 200) && ((resent != CPD_OK) || (answered != CPD_OK)); i++) {
+        usleep(10000);
+        pthread_mutex_lock(&(pCpd->aidingCache.lock));
+        resent = (pCpd->aidingCache.sent == 0) ? CPD_OK : CPD_NOK;
+        pthread_mutex_unlock(&(pCpd->aidingCache.lock));
+        pthread_mutex_lock(&gpsRingLock_t);
+        answered = (gpsRingResponses_t >= expected) ? CPD_OK : CPD_NOK;
+        pthread_mutex_unlock(&gpsRingLock_t);
+    }
+    CPD_LOG(CPD_LOG_ID_TXT | CPD_LOG_ID_CONSOLE, "\nGPS ring: left out ephemeris GPS didn't have, %s, request %s",
+            (resent == CPD_OK) ? "asked for again" : "NOT asked for", (answered == CPD_OK) ? "answered" : "NOT answered");
+    return ((resent == CPD_OK) && (answered == CPD_OK)) ? 0 : 1;
+}
+
+/*
+ * Request/response round trips between CPDD and a GPS side in child process: <n> through local socket,
+ * then <n> through shared memory rings offered over it. Ring control message put to the ring is dropped
+ * by GPS side and the ring keeps working, as it does after a reserved message is aborted. GPS side missing
+ * left out ephemeris asks for it again.
+ */
+int cpdGpsRingBenchmark_t(pCPD_CONTEXT pCpd, int n, char *pFileName)
+{
+    pGPS_RING pR = &(pCpd->gpsRing);
+    pid_t child;
+    unsigned int head;
+    char *pC;
+    int errors = 0;
+    int i;
+
+    (void) pFileName;
+
+    unlink(GPS_RING_SOCKET_T);
+    child = fork();
+    if (child < 0) {
+        return CPD_NOK;
+    }
+    if (child == 0) {
+        cpdGpsRingServer_t(pCpd);
+    }
+    pCpd->scGps.type = SOCKET_SERVER_TYPE_CLIENT_LOCAL;
+    pCpd->scGps.maxConnections = 1;
+    pCpd->scGps.pfReadCallback = &cpdGpsCommMsgReader;
+    pCpd->pfMessageHandlerInCpd = cpdGpsRingResponse_t;
+    cpdSocketServerInit(&(pCpd->scGps));
+    for (i = 0; i < 200; i++) {
+        if (cpdSocketClientOpen(&(pCpd->scGps), GPS_RING_SOCKET_T, 0) == 0) {
+            break;
+        }
+        usleep(10000);
+    }
+    if (pCpd->scGps.clients[0].fd < 0) {
+        kill(child, SIGKILL);
+        waitpid(child, NULL, 0);
+        CPD_LOG(CPD_LOG_ID_TXT | CPD_LOG_ID_CONSOLE, "\nGPS ring: no socket to GPS");
+        return CPD_NOK;
+    }
+
+    cpdGpsCommNegotiate(pCpd);
+    for (i = 0; (i < 100) && (pCpd->gpsCommBuffer.txFraming != CPD_MSG_FRAMING_V2); i++) {
+        usleep(10000);
+    }
+    /* GPS side in child process restores left out ephemeris */
+    if (pCpd->gpsCommBuffer.txMirrored != CPD_OK) {
+        errors++;
+    }
+    errors += cpdGpsRingRoundTrips_t(pCpd, "socket", n);
+
+    if (cpdGpsRingOffer(pCpd) > CPD_NOK) {
+        for (i = 0; (i < 100) && (pR->state != CPD_OK); i++) {
+            usleep(10000);
+        }
+    }
+    if (pR->state != CPD_OK) {
+        CPD_LOG(CPD_LOG_ID_TXT | CPD_LOG_ID_CONSOLE, "\nGPS ring: not accepted, %d", errno);
+        errors++;
+    }
+    else {
+        errors += cpdGpsRingRoundTrips_t(pCpd, "ring", n);
+        pC = cpdGpsRingReserve(pCpd, CPD_MSG_TYPE_RING_REQ, sizeof(int));
+        if (pC != NULL) {
+            i = GPS_RING_VERSION;
+            memcpy(pC, &i, sizeof(int));
+            cpdGpsRingCommit(pCpd, sizeof(int));
+        }
+        errors += cpdGpsRingRoundTrips_t(pCpd, "ring after control message", 10);
+        errors += cpdGpsRingResend_t(pCpd);
+        /* request which could not be put is not seen by GPS side, next one goes through */
+        head = pR->pTx->head;
+        if (cpdGpsRingReserve(pCpd, CPD_MSG_TYPE_POS_MEAS_REQ, sizeof(REQUEST_PARAMS)) != NULL) {
+            cpdGpsRingAbort(pCpd);
+        }
+        if ((pR->pTx->head != head) || (pR->nAborted != 1)) {
+            errors++;
+        }
+        errors += cpdGpsRingRoundTrips_t(pCpd, "ring after aborted message", 10);
+        if ((pR->nTx != (unsigned int) n + 22) || (pR->nRx != (unsigned int) n + 21)) {
+            CPD_LOG(CPD_LOG_ID_TXT | CPD_LOG_ID_CONSOLE, "\nGPS ring: %u sent, %u received, %u full",
+                    pR->nTx, pR->nRx, pR->nFull);
+            errors++;
+        }
+    }
+
+    cpdGpsRingClose(pCpd);
+    kill(child, SIGKILL);
+    waitpid(child, NULL, 0);
+    cpdSocketClose(&(pCpd->scGps.clients[0]));
+    unlink(GPS_RING_SOCKET_T);
+    CPD_LOG(CPD_LOG_ID_TXT | CPD_LOG_ID_CONSOLE, "\nGPS ring errors: %d", errors);
+    return (errors == 0) ? CPD_OK : CPD_NOK;
+}
+
+/*
+ * Encode and decode <pStruct> <n> times, decoded structure must be the same as <pStruct> with pointers to
+ * GPS_WIRE storage pointing to the same items. Returns number of errors.
+ */
+static int cpdGpsWireRoundTrip_t(pCPD_CONTEXT pCpd, const char *pName, int kind, void *pStruct, int n)
+{
+    pREQUEST_PARAMS pReq;
+    pRESPONSE_PARAMS pResp;
+    pPOLYGON pPolygon = NULL;
+    pPOLYGON pSent = NULL;
+    pALMANAC pAlm;
+    pALMANAC pAlmSent;
+    struct timespec t0, t1;
+    unsigned long long encodeNs, decodeNs;
+    int structSize = (kind == GPS_WIRE_REQUEST) ? sizeof(REQUEST_PARAMS) : sizeof(RESPONSE_PARAMS);
+    int size = cpdGpsWireMaxSize(kind);
+    char *pB;
+    char *pDecoded;
+    int len = 0;
+    int errors = 0;
+    int i;
+
+    pB = malloc(size);
+    pDecoded = malloc(structSize);
+    if ((pB == NULL) || (pDecoded == NULL)) {
+        free(pB);
+        free(pDecoded);
+        return 1;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (i = 0; i < n; i++) {
+        len = cpdGpsWireEncode(pCpd, kind, pStruct, pB, size);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    encodeNs = ((t1.tv_sec - t0.tv_sec) * 1000000000ULL) + t1.tv_nsec - t0.tv_nsec;
+    if ((len <= 0) || (cpdGpsWireIsEncoded(pB, len) != CPD_OK)) {
+        CPD_LOG(CPD_LOG_ID_TXT | CPD_LOG_ID_CONSOLE, "\n%s: not encoded, %d", pName, len);
+        free(pB);
+        free(pDecoded);
+        return 1;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (i = 0; i < n; i++) {
+        if (cpdGpsWireDecode(pCpd, kind, pB, len, pDecoded) != CPD_OK) {
+            errors++;
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    decodeNs = ((t1.tv_sec - t0.tv_sec) * 1000000000ULL) + t1.tv_nsec - t0.tv_nsec;
+
+    if (kind == GPS_WIRE_REQUEST) {
+        pReq = (pREQUEST_PARAMS) pDecoded;
+        if (pReq->assist_data.GPS_assist.location_parameters.shape_type == SHAPE_TYPE_POLYGON) {
+            pPolygon = &(pReq->assist_data.GPS_assist.location_parameters.shape_data.polygon);
+            pSent = &(((pREQUEST_PARAMS) pStruct)->assist_data.GPS_assist.location_parameters.shape_data.polygon);
+        }
+        pAlm = &(pReq->assist_data.GPS_assist.almanac);
+        pAlmSent = &(((pREQUEST_PARAMS) pStruct)->assist_data.GPS_assist.almanac);
+        if ((pAlm->alm_elem_nb_items != pAlmSent->alm_elem_nb_items) || ((pAlm->alm_elem_nb_items > 0) &&
+            (memcmp(pAlm->pAlm_elem, pAlmSent->pAlm_elem, pAlm->alm_elem_nb_items * sizeof(ALM_ELEM)) != 0))) {
+            errors++;
+        }
+        pAlm->pAlm_elem = pAlmSent->pAlm_elem;
+    }
+    else {
+        pResp = (pRESPONSE_PARAMS) pDecoded;
+        if (pResp->location.location_parameters.shape_type == SHAPE_TYPE_POLYGON) {
+            pPolygon = &(pResp->location.location_parameters.shape_data.polygon);
+            pSent = &(((pRESPONSE_PARAMS) pStruct)->location.location_parameters.shape_data.polygon);
+        }
+    }
+    if (pPolygon != NULL) {
+        if ((pPolygon->nItems != pSent->nItems) || ((pPolygon->nItems > 0) &&
+            (memcmp(pPolygon->pCoordinates, pSent->pCoordinates, pPolygon->nItems * sizeof(COORDINATE)) != 0))) {
+            errors++;
+        }
+        pPolygon->pCoordinates = pSent->pCoordinates;
+    }
+    if (memcmp(pDecoded, pStruct, structSize) != 0) {
+        errors++;
+    }
+    CPD_LOG(CPD_LOG_ID_TXT | CPD_LOG_ID_CONSOLE, "\n%-28s %6d -> %5d bytes, encode %6llu ns, decode %6llu ns%s",
+            pName, structSize, len, encodeNs / n, decodeNs / n, (errors == 0) ? "" : ", DIFFERENT");
+    free(pB);
+    free(pDecoded);
+    return errors;
+}
+
+/*
+ * Wire encoding of messages to and from GPS: size and encode/decode time of typical requests and responses,
+ * each is <n> times encoded and decoded and has to come back the same.
+ */
+int cpdGpsWireBenchmark_t(pCPD_CONTEXT pCpd, int n, char *pFileName)
+{
+    static ALM_ELEM almanac[24];
+    REQUEST_PARAMS request;
+    unsigned long long sending;
+    char *pDoc;
+    int len;
+    int i;
+    int errors = 0;
+
+    (void) pFileName;
+
+    pDoc = malloc(XML_RX_MAX_DOC_SIZE);
+    if (pDoc == NULL) {
+        return CPD_NOK;
+    }
+    len = cpdXmlBenchmarkDoc_t(pDoc, XML_RX_MAX_DOC_SIZE);
+    cpdXmlBenchmarkPush_t(pCpd, pDoc, len);
+    free(pDoc);
+    pCpd->request.version = CPD_MSG_VERSION;
+    memcpy(&request, &(pCpd->request), sizeof(REQUEST_PARAMS));
+    errors += cpdGpsWireRoundTrip_t(pCpd, "request, full assist", GPS_WIRE_REQUEST, &request, n);
+
+    for (i = 0; i < (int) (sizeof(almanac) / sizeof(almanac[0])); i++) {
+        memset(&(almanac[i]), i + 1, sizeof(ALM_ELEM));
+    }
+    request.assist_data.GPS_assist.almanac.wna = 151;
+    request.assist_data.GPS_assist.almanac.alm_elem_nb_items = sizeof(almanac) / sizeof(almanac[0]);
+    request.assist_data.GPS_assist.almanac.pAlm_elem = almanac;
+    errors += cpdGpsWireRoundTrip_t(pCpd, "request, with almanac", GPS_WIRE_REQUEST, &request, n);
+
+    /* GPS already has all ephemeris */
+    memcpy(&request, &(pCpd->request), sizeof(REQUEST_PARAMS));
+    cpdAidingReset(pCpd);
+    cpdAidingStrip(pCpd, &(request.assist_data), &sending);
+    cpdAidingSent(pCpd, &(pCpd->request.assist_data), sending);
+    memcpy(&request, &(pCpd->request), sizeof(REQUEST_PARAMS));
+    cpdAidingStrip(pCpd, &(request.assist_data), &sending);
+    errors += cpdGpsWireRoundTrip_t(pCpd, "request, ephemeris left out", GPS_WIRE_REQUEST, &request, n);
+
+    cpdXmlFormatLocation_t(pCpd, SHAPE_TYPE_POINT_ALT_UNCERT_ELLIPSE, 0);
+    pCpd->response.version = CPD_MSG_VERSION;
+    errors += cpdGpsWireRoundTrip_t(pCpd, "response, MS-B ellipse", GPS_WIRE_RESPONSE, &(pCpd->response), n);
+    cpdXmlFormatLocation_t(pCpd, SHAPE_TYPE_POLYGON, 3);
+    pCpd->response.version = CPD_MSG_VERSION;
+    errors += cpdGpsWireRoundTrip_t(pCpd, "response, MS-B polygon", GPS_WIRE_RESPONSE, &(pCpd->response), n);
+    cpdXmlFormatMeasurements_t(pCpd, GPS_MAX_N_SVS, 0);
+    pCpd->response.version = CPD_MSG_VERSION;
+    errors += cpdGpsWireRoundTrip_t(pCpd, "response, MS-A 12 SVs", GPS_WIRE_RESPONSE, &(pCpd->response), n);
+    cpdXmlFormatMeasurements_t(pCpd, 4, 0);
+    pCpd->response.version = CPD_MSG_VERSION;
+    errors += cpdGpsWireRoundTrip_t(pCpd, "response, MS-A 4 SVs", GPS_WIRE_RESPONSE, &(pCpd->response), n);
+
+    /* damaged data is refused */
+    len = cpdGpsWireEncode(pCpd, GPS_WIRE_RESPONSE, &(pCpd->response), (char *) &request, sizeof(request));
+    if ((len <= 0) || (cpdGpsWireDecode(pCpd, GPS_WIRE_RESPONSE, (char *) &request, len - 1, &(pCpd->response)) != CPD_ERROR)) {
+        errors++;
+    }
+    cpdGpsWireStats(pCpd);
+    CPD_LOG(CPD_LOG_ID_TXT | CPD_LOG_ID_CONSOLE, "\nGPS wire errors: %d", errors);
+    return (errors == 0) ? CPD_OK : CPD_NOK;
+}
+
+/*
+ * Delimiter search the way modem_find_Esc() and modem_find_CtrlZ() did it, before cpdScan.c.
+ */
+static int cpdScanOldFindChar_t(char *pB, int len, char findMe)
+{
+    int i;
+
+    for (i = 0; i < len; i++) {
+        if (pB[i] == findMe) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/*
+ * cpdFindString() before cpdScan.c, <pB> has to be null-terminated.
+ */
+static int cpdScanOldFindString_t(char *pB, int len, char *findMe)
+{
+    int result = -1;
+    char *pS = NULL;
+    char *pC = NULL;
+    int i = 0;
+
+    while ((result < 0) && (i < len)) {
+        while (i < len) {
+            if (pB[i] == findMe[0]) {
+                pC = &(pB[i]);
+                break;
+            }
+            i++;
+        }
+        if (pC == NULL) {
+            break;
+        }
+        pS = strstr(pC, findMe);
+        if (pS != NULL) {
+            result = (int) (pS - pB);
+            if (result > len) {
+                result = -1;
+            }
+            break;
+        }
+        i++;
+    }
+    return result;
+}
+
+static unsigned int cpdScanNs_t(struct timespec *pT0, int n)
+{
+    struct timespec t1;
+
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    return (unsigned int) ((((long long) (t1.tv_sec - pT0->tv_sec) * 1000000000LL) + (t1.tv_nsec - pT0->tv_nsec)) / n);
+}
+
+/*
+ * Every <c> in pB[0..size), one search after each of them or one pass with cpdScanFindAll().
+ */
+static int cpdScanBenchmarkEvery_t(char *pB, int size, char c, char *pName, int *pPositions, int n)
+{
+    SCAN_SET set;
+    struct timespec t0;
+    unsigned int nsOld, nsScan, nsAll;
+    int i, j, r;
+    int nOld = 0;
+    int nScan = 0;
+    int nAll;
+    int errors = 0;
+    volatile int sum = 0;
+
+    set.n = 1;
+    set.c[0] = c;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (i = 0; i < n; i++) {
+        nOld = 0;
+        for (j = 0; (r = cpdScanOldFindChar_t(&(pB[j]), size - j, c)) >= 0; j = j + r + 1) {
+            nOld++;
+        }
+        sum = sum + nOld;
+    }
+    nsOld = cpdScanNs_t(&t0, n);
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (i = 0; i < n; i++) {
+        nScan = 0;
+        for (j = 0; (r = cpdScanFind(&(pB[j]), size - j, &set)) >= 0; j = j + r + 1) {
+            nScan++;
+        }
+        sum = sum + nScan;
+    }
+    nsScan = cpdScanNs_t(&t0, n);
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (i = 0; i < n; i++) {
+        sum = sum + cpdScanFindAll(pB, size, &set, pPositions, size);
+    }
+    nsAll = cpdScanNs_t(&t0, n);
+    nAll = cpdScanFindAll(pB, size, &set, pPositions, size);
+    if ((nOld != nScan) || (nAll != nScan)) {
+        errors++;
+    }
+    for (i = 0; i < nAll; i++) {
+        if ((pB[pPositions[i]] != c) || ((i > 0) && (pPositions[i] <= pPositions[i - 1]))) {
+            errors++;
+            break;
+        }
+    }
+    /* search stops at the limit */
+    if ((nAll > 2) && (cpdScanFindAll(pB, size, &set, pPositions, 2) != 2)) {
+        errors++;
+    }
+    CPD_LOG(CPD_LOG_ID_TXT | CPD_LOG_ID_CONSOLE, "\n%5d bytes, %4d %-5s    old %6u ns, scan %6u ns, all %6u ns",
+            size, nAll, pName, nsOld, nsScan, nsAll);
+    return errors;
+}
+
+/*
+ * <size> bytes of +CPOSR data from <pData>, ending with RING and Ctrl-Z, searched <n> times
+ * with the old searches and with cpdScan.c.
+ */
+static int cpdScanBenchmarkSize_t(char *pData, int dataLen, int size, int n)
+{
+    static const SCAN_SET endSet = { 2, { AT_CMD_CTRL_Z_CHR, AT_CMD_ESC_CHR } };
+    char pRing[] = AT_CMD_CRLF AT_CMD_RING AT_CMD_CRLF;
+    char *pB;
+    int *pPositions;
+    struct timespec t0;
+    unsigned int nsOld, nsScan;
+    int len, i, k;
+    int errors = 0;
+    volatile int sum = 0;
+
+    pB = malloc(size + 1);
+    pPositions = malloc(size * sizeof(int));
+    if ((pB == NULL) || (pPositions == NULL)) {
+        free(pB);
+        free(pPositions);
+        return 1;
+    }
+    for (len = 0; len < size; len = len + k) {
+        k = ((size - len) < dataLen) ? (size - len) : dataLen;
+        memcpy(&(pB[len]), pData, k);
+    }
+    k = strlen(pRing);
+    memcpy(&(pB[size - k - 1]), pRing, k);
+    pB[size - 1] = AT_CMD_CTRL_Z_CHR;
+    pB[size] = '\0';
+
+    /* Ctrl-Z terminating XML data */
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (i = 0; i < n; i++) {
+        sum = sum + cpdScanOldFindChar_t(pB, size, AT_CMD_CTRL_Z_CHR);
+    }
+    nsOld = cpdScanNs_t(&t0, n);
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (i = 0; i < n; i++) {
+        sum = sum + cpdScanFindChar(pB, size, AT_CMD_CTRL_Z_CHR);
+    }
+    nsScan = cpdScanNs_t(&t0, n);
+    if ((cpdScanOldFindChar_t(pB, size, AT_CMD_CTRL_Z_CHR) != size - 1) ||
+        (cpdScanFindChar(pB, size, AT_CMD_CTRL_Z_CHR) != size - 1)) {
+        errors++;
+    }
+    CPD_LOG(CPD_LOG_ID_TXT | CPD_LOG_ID_CONSOLE, "\n%5d bytes, Ctrl-Z:        old %6u ns, scan %6u ns",
+            size, nsOld, nsScan);
+
+    /* Ctrl-Z or ESC, two searches before */
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (i = 0; i < n; i++) {
+        sum = sum + cpdScanOldFindChar_t(pB, size, AT_CMD_CTRL_Z_CHR) + cpdScanOldFindChar_t(pB, size, AT_CMD_ESC_CHR);
+    }
+    nsOld = cpdScanNs_t(&t0, n);
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (i = 0; i < n; i++) {
+        sum = sum + cpdScanFind(pB, size, &endSet);
+    }
+    nsScan = cpdScanNs_t(&t0, n);
+    if ((cpdScanOldFindChar_t(pB, size, AT_CMD_ESC_CHR) != -1) || (cpdScanFind(pB, size, &endSet) != size - 1)) {
+        errors++;
+    }
+    CPD_LOG(CPD_LOG_ID_TXT | CPD_LOG_ID_CONSOLE, "\n%5d bytes, Ctrl-Z or ESC: old %6u ns, scan %6u ns",
+            size, nsOld, nsScan);
+
+    /* RING behind the data */
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (i = 0; i < n; i++) {
+        sum = sum + cpdScanOldFindString_t(pB, size, pRing);
+    }
+    nsOld = cpdScanNs_t(&t0, n);
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (i = 0; i < n; i++) {
+        sum = sum + cpdScanFindString(pB, size, pRing, k);
+    }
+    nsScan = cpdScanNs_t(&t0, n);
+    if ((cpdScanOldFindString_t(pB, size, pRing) != size - k - 1) || (cpdScanFindString(pB, size, pRing, k) != size - k - 1)) {
+        errors++;
+    }
+    CPD_LOG(CPD_LOG_ID_TXT | CPD_LOG_ID_CONSOLE, "\n%5d bytes, RING:          old %6u ns, scan %6u ns",
+            size, nsOld, nsScan);
+
+    errors += cpdScanBenchmarkEvery_t(pB, size, AT_CMD_LF_CHR, "LFs", pPositions, n);
+    errors += cpdScanBenchmarkEvery_t(pB, size, XML_START_CHAR, "'<'", pPositions, n);
+
+    free(pB);
+    free(pPositions);
+    return errors;
+}
+
+/*
+ * Delimiter scanner against the searches it replaced, on 4 KB and 8 KB of modem data, <n> times each.
+ */
+int cpdScanBenchmark_t(pCPD_CONTEXT pCpd, int n, char *pFileName)
+{
+    char *pData;
+    int len;
+    int errors = 0;
+
+    (void) pCpd;
+    (void) pFileName;
+
+    if (n <= 0) {
+        return CPD_NOK;
+    }
+    pData = malloc(XML_RX_MAX_DOC_SIZE);
+    if (pData == NULL) {
+        return CPD_NOK;
+    }
+    len = snprintf(pData, XML_RX_MAX_DOC_SIZE, "+CPOSR: ");
+    len = len + cpdXmlBenchmarkDoc_t(&(pData[len]), XML_RX_MAX_DOC_SIZE - len - 2);
+    len = len + snprintf(&(pData[len]), XML_RX_MAX_DOC_SIZE - len, AT_CMD_CRLF);
+#if defined(__AVX2__)
+    CPD_LOG(CPD_LOG_ID_TXT | CPD_LOG_ID_CONSOLE, "\nScanner: AVX2, %d runs", n);
+#elif defined(__SSE2__)
+    CPD_LOG(CPD_LOG_ID_TXT | CPD_LOG_ID_CONSOLE, "\nScanner: SSE2, %d runs", n);
+#else
+    CPD_LOG(CPD_LOG_ID_TXT | CPD_LOG_ID_CONSOLE, "\nScanner: byte loop, %d runs", n);
+#endif
+    errors += cpdScanBenchmarkSize_t(pData, len, 4 * 1024, n);
+    errors += cpdScanBenchmarkSize_t(pData, len, 8 * 1024, n);
+    free(pData);
+    CPD_LOG(CPD_LOG_ID_TXT | CPD_LOG_ID_CONSOLE, "\nScanner errors: %d", errors);
+    return (errors == 0) ? CPD_OK : CPD_NOK;
+}
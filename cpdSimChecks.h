@@ -0,0 +1,45 @@
+/*
+ * hardware/Intel/cp_daemon/cpdSimChecks.h
+ *
+ * Header file for cpdSimChecks.c.
+ *
+ * Martin Junkar 09/18/2011
+ *
+ */
+
+#ifndef _CPDSIMCHECKS_H_
+#define _CPDSIMCHECKS_H_
+#include "cpd.h"
+
+/* check or benchmark, <n> repetitions and <pFileName> as given on command line */
+typedef  int (fCPD_CHECK)(pCPD_CONTEXT pCpd, int n, char *pFileName);
+
+#define CPD_CHECK_ARG_COUNT     (1)     /* option can be followed by count */
+#define CPD_CHECK_ARG_FILE      (2)     /* option can be followed by file name, after count */
+
+typedef struct {
+    const char  *pOption;       /* compared with the first 2 characters of argument */
+    int         args;           /* CPD_CHECK_ARG_xx */
+    int         defaultCount;   /* count when none is given */
+    char        *pDefaultFile;  /* file name when none is given */
+    fCPD_CHECK  *pfCheck;
+    int         n;              /* > 0 when option was given */
+    char        *pFileName;
+} CPD_CHECK, *pCPD_CHECK;
+
+int cpdModemReplay_t(pCPD_CONTEXT pCpd, int n, char *pFileName);
+int cpdXmlBenchmark_t(pCPD_CONTEXT pCpd, int n, char *pFileName);
+int cpdXmlFormatBenchmark_t(pCPD_CONTEXT pCpd, int n, char *pFileName);
+int cpdXmlNamesBenchmark_t(pCPD_CONTEXT pCpd, int n, char *pFileName);
+int cpdGppCodecBenchmark_t(pCPD_CONTEXT pCpd, int n, char *pFileName);
+int cpdResponseSenderCheck_t(pCPD_CONTEXT pCpd, int n, char *pFileName);
+int cpdSessionTimerCheck_t(pCPD_CONTEXT pCpd, int n, char *pFileName);
+int cpdSessionCheck_t(pCPD_CONTEXT pCpd, int n, char *pFileName);
+int cpdLastFixCheck_t(pCPD_CONTEXT pCpd, int n, char *pFileName);
+int cpdAssistStoreCheck_t(pCPD_CONTEXT pCpd, int n, char *pFileName);
+int cpdAidingCacheCheck_t(pCPD_CONTEXT pCpd, int n, char *pFileName);
+int cpdGpsFramingBenchmark_t(pCPD_CONTEXT pCpd, int n, char *pFileName);
+int cpdGpsRingBenchmark_t(pCPD_CONTEXT pCpd, int n, char *pFileName);
+int cpdGpsWireBenchmark_t(pCPD_CONTEXT pCpd, int n, char *pFileName);
+int cpdScanBenchmark_t(pCPD_CONTEXT pCpd, int n, char *pFileName);
+#endif
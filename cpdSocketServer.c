@@ -127,6 +127,7 @@ int cpdSocketServerInit(pSOCKET_SERVER pSS)
         pSS->clients[i].fd = CPD_ERROR;
         pSS->clients[i].pRxBuff = NULL;
         pSS->clients[i].pfReadCallback = NULL;
+        pSS->clients[i].nRxFds = 0;
     }
     CPD_LOG(CPD_LOG_ID_TXT, "\r\n %s()= %d", __FUNCTION__, result);
     LOGD("%u: %s()=%d", getMsecTime(), __FUNCTION__, result);
@@ -151,6 +152,60 @@ int cpdSocketServerFindFreeFD(pSOCKET_SERVER pSS)
     return result;
 }
 
+/*
+ * Close file descriptors received on socket and not taken by reader.
+ */
+static void cpdSocketCloseRxFds(pSOCKET_CLIENT pSc)
+{
+    while (pSc->nRxFds > 0) {
+        pSc->nRxFds--;
+        close(pSc->rxFds[pSc->nRxFds]);
+    }
+}
+
+/*
+ * Read from socket, file descriptors passed with data are kept in <pSc> until reader takes them.
+ */
+static int cpdSocketRead(pSOCKET_CLIENT pSc, char *pB, int size)
+{
+    struct msghdr msg;
+    struct iovec iov;
+    struct cmsghdr *pCmsg;
+    char control[CMSG_SPACE(SOCKET_MAX_RX_FDS * sizeof(int))];
+    int *pFd;
+    int nRead;
+    int i, n;
+
+    iov.iov_base = pB;
+    iov.iov_len = size;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    nRead = recvmsg(pSc->fd, &msg, 0);
+    if (nRead <= 0) {
+        return nRead;
+    }
+    for (pCmsg = CMSG_FIRSTHDR(&msg); pCmsg != NULL; pCmsg = CMSG_NXTHDR(&msg, pCmsg)) {
+        if ((pCmsg->cmsg_level != SOL_SOCKET) || (pCmsg->cmsg_type != SCM_RIGHTS)) {
+            continue;
+        }
+        pFd = (int *) CMSG_DATA(pCmsg);
+        n = (pCmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+        for (i = 0; i < n; i++) {
+            if (pSc->nRxFds < SOCKET_MAX_RX_FDS) {
+                pSc->rxFds[pSc->nRxFds] = pFd[i];
+                pSc->nRxFds++;
+            }
+            else {
+                close(pFd[i]);
+            }
+        }
+    }
+    return nRead;
+}
+
 void  *cpdSocketReadThreadLoop(void *pArg)
 {
     int indexSocketFD;
@@ -191,7 +246,7 @@ void  *cpdSocketReadThreadLoop(void *pArg)
 
     while ((pSc->fd > CPD_ERROR) &&
             (pSc->state == SOCKET_STATE_RUNNING)) {
-        nRead = read(pSc->fd, pSc->pRxBuff, SOCKET_RX_BUFFER_SIZE-4);
+        nRead = cpdSocketRead(pSc, pSc->pRxBuff, SOCKET_RX_BUFFER_SIZE-4);
         if (nRead <= 0) {
             LOGV("%u: %s(), read error, %d", getMsecTime(), __FUNCTION__, nRead);
             break;
@@ -212,6 +267,7 @@ void  *cpdSocketReadThreadLoop(void *pArg)
     }
 
     pSc->state = SOCKET_STATE_TERMINATING;
+    cpdSocketCloseRxFds(pSc);
 
     CPD_LOG(CPD_LOG_ID_TXT , "\r\n %u: %s(), Exiting read thread %d", getMsecTime(), __FUNCTION__, indexSocketFD);
     if (pSc->fd != CPD_ERROR) {
@@ -304,6 +360,7 @@ void *cpdSocketAcceptThreadLoop(void *pArg)
             if (indexFreeFD != CPD_ERROR) {
                 pSc = &(pSS->clients[indexFreeFD]);
                 pSc->fd = newsockfd;
+                pSc->nRxFds = 0;
                 pSc->pfReadCallback = pSS->pfReadCallback;
                 memcpy(&(pSc->destAddr), &cli_addr, sizeof(struct sockaddr_in));
                 strncpy(pSc->localSocketname, pSS->localSocketname, sizeof(pSc->localSocketname));
@@ -466,6 +523,7 @@ int cpdSocketClientOpen(pSOCKET_SERVER pSs, char *serverName, int serverPort)
     }
 
     result--;
+    pSc->nRxFds = 0;
     pSc->pfReadCallback = pSs->pfReadCallback;
     pSc->pRxBuff = malloc(SOCKET_RX_BUFFER_SIZE);
     ssrl.socketIndex = indexFreeFD;
@@ -664,6 +722,55 @@ int cpdSocketWriteToIndex(pSOCKET_SERVER pSS, char *pB, int len, int index)
     return cpdSocketWrite(&(pSS->clients[index]), pB, len);
 }
 
+/*
+ * Write <len> bytes of <pB> together with <nFds> file descriptors (SCM_RIGHTS), local sockets only.
+ */
+int cpdSocketWriteFds(pSOCKET_CLIENT pSc, char *pB, int len, int *pFds, int nFds)
+{
+    struct msghdr msg;
+    struct iovec iov;
+    struct cmsghdr *pCmsg;
+    char control[CMSG_SPACE(SOCKET_MAX_RX_FDS * sizeof(int))];
 
+    if ((pSc == NULL) || (pB == NULL) || (len <= 0) || (nFds <= 0) || (nFds > SOCKET_MAX_RX_FDS)) {
+        return CPD_ERROR;
+    }
+    if (pSc->fd < 0) {
+        return CPD_ERROR;
+    }
+    iov.iov_base = pB;
+    iov.iov_len = len;
+    memset(&msg, 0, sizeof(msg));
+    memset(control, 0, sizeof(control));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = CMSG_SPACE(nFds * sizeof(int));
+    pCmsg = CMSG_FIRSTHDR(&msg);
+    pCmsg->cmsg_level = SOL_SOCKET;
+    pCmsg->cmsg_type = SCM_RIGHTS;
+    pCmsg->cmsg_len = CMSG_LEN(nFds * sizeof(int));
+    memcpy(CMSG_DATA(pCmsg), pFds, nFds * sizeof(int));
+    return sendmsg(pSc->fd, &msg, 0);
+}
 
+/*
+ * Move up to <maxFds> file descriptors received on socket to <pFds>, returns their number. Other received
+ * descriptors are closed. Called from read callback, descriptors came with the data passed to it.
+ */
+int cpdSocketTakeFds(pSOCKET_CLIENT pSc, int *pFds, int maxFds)
+{
+    int n = 0;
 
+    while ((n < pSc->nRxFds) && (n < maxFds)) {
+        pFds[n] = pSc->rxFds[n];
+        n++;
+    }
+    /* the rest is not expected by reader */
+    while (pSc->nRxFds > n) {
+        pSc->nRxFds--;
+        close(pSc->rxFds[pSc->nRxFds]);
+    }
+    pSc->nRxFds = 0;
+    return n;
+}
@@ -22,6 +22,7 @@
 
 #define SOCKET_SERVER_MAX_FD        4
 #define SOCKET_RX_BUFFER_SIZE       (4096)
+#define SOCKET_MAX_RX_FDS           (4)     /* file descriptors received with data (SCM_RIGHTS) kept for reader */
 
 
 
@@ -57,6 +58,8 @@ typedef struct {
     char                *pRxBuff;
     pthread_t           clientReadThread;
     fSOCKET_READ_CB     *pfReadCallback;
+    int                 rxFds[SOCKET_MAX_RX_FDS];
+    int                 nRxFds;
 } SOCKET_CLIENT, *pSOCKET_CLIENT;
 
 typedef struct {
@@ -92,6 +95,8 @@ int cpdSocketWriteToAll(pSOCKET_SERVER , char *, int );
 int cpdSocketWriteToAllExcpet(pSOCKET_SERVER , char *, int , int );
 int cpdSocketWrite(pSOCKET_CLIENT , char *, int);
 int cpdSocketWriteToIndex(pSOCKET_SERVER , char *, int , int );
+int cpdSocketWriteFds(pSOCKET_CLIENT , char *, int , int *, int );
+int cpdSocketTakeFds(pSOCKET_CLIENT , int *, int );
 
 
 
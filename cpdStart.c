@@ -31,6 +31,15 @@
 #include "cpdSocketServer.h"
 #include "cpdGpsComm.h"
 #include "cpdXmlFormatter.h"
+#include "cpdXmlParser.h"
+#include "cpdResponseSender.h"
+#include "cpdSessionTimer.h"
+#include "cpdSession.h"
+#include "cpdLastFix.h"
+#include "cpdAssistStore.h"
+#include "cpdAidingCache.h"
+#include "cpdGpsRing.h"
+#include "cpdGpsWire.h"
 #include "cpdSystemMonitor.h"
 #include "cpdUtil.h"
 #include "cpdDebug.h"
@@ -52,7 +61,17 @@ int cpdStart(pCPD_CONTEXT pCpd)
     CPD_LOG(CPD_LOG_ID_TXT, "\n%u: %s()", getMsecTime(), __FUNCTION__);
     LOGD("%u: %s()", getMsecTime(), __FUNCTION__);
     pCpd->pfCposrMessageHandlerInCpd =  (int (*)(void * )) &cpdFormatAndSendMsgToGps;
-    pCpd->pfMessageHandlerInCpd = (int (*)(void * )) &cpdSendCpPositionResponseToModem;
+    /* responses from GPS are given to open sessions, response sender thread sends them to modem */
+    pCpd->pfMessageHandlerInCpd = (int (*)(void * )) &cpdSessionFanOut;
+    if (cpdResponseSenderStart(pCpd) != CPD_OK) {
+        LOGE("%u: %s(), response sender not started, responses are sent from GPS socket reader", getMsecTime(), __FUNCTION__);
+    }
+    if (cpdSessionTimerStart(pCpd) != CPD_OK) {
+        LOGE("%u: %s(), session timers not started, sessions are not timed out", getMsecTime(), __FUNCTION__);
+    }
+    if (cpdAssistStoreOpen(pCpd) != CPD_OK) {
+        LOGE("%u: %s(), assistance data is not kept across restarts", getMsecTime(), __FUNCTION__);
+    }
 
     pCpd->pfMessageHandlerInGps = NULL;
     /* this is for debug testing while MUX is broken*/
@@ -95,6 +114,12 @@ int cpdStart(pCPD_CONTEXT pCpd)
         else {
             CPD_LOG(CPD_LOG_ID_TXT, "\r\n Socket to GPS established %s:%d, index=%d\n", SOCKET_HOST_GPS, SOCKET_PORT_GPS, pCpd->scIndexToGps);
             LOGD("Socket to GPS established %s:%d = %d\n", SOCKET_HOST_GPS, SOCKET_PORT_GPS, pCpd->scIndexToGps);
+            cpdGpsCommNegotiate(pCpd);
+#ifdef GPS_RING_USE
+            cpdGpsRingOffer(pCpd);
+#endif
+            cpdAidingReset(pCpd);
+            cpdAssistStorePush(pCpd);
         }
     }
     /* check if opening transparent socket server for modem comm is enabled */
@@ -148,14 +173,28 @@ int cpdStart(pCPD_CONTEXT pCpd)
     /* the end, stop monitoring service before closing connections */
     cpdSystemMonitorStop(pCpd);
 
+    cpdSessionTimerStop(pCpd);
+
+    cpdLastFixStats(pCpd);
+    cpdAidingStats(pCpd);
+    cpdGpsWireStats(pCpd);
+
+    /* response being sent still needs the modem */
+    cpdResponseSenderStop(pCpd);
+
     result = cpdModemClose(pCpd);
 
+    cpdGpsRingClose(pCpd);
     result = cpdSocketServerClose(&(pCpd->scGps));
     usleep(1000);
 
     result= cpdSocketServerClose(&(pCpd->ssModemComm));
     usleep(1000);
 
+    cpdXmlParserClose(pCpd);
+
+    cpdAssistStoreClose(pCpd);
+
     cpdDeInit();
     CPD_LOG(CPD_LOG_ID_TXT , "\n  %u: %s()=%d\n", getMsecTime(), __FUNCTION__, result);
     LOGD("%u: %s()=%d\n", getMsecTime(), __FUNCTION__, result);
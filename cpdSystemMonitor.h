@@ -11,7 +11,6 @@
 #define _CPDSYSTEMMONITOR_H_
 int cpdSystemMonitorStart(void);
 int cpdSystemMonitorStop(pCPD_CONTEXT);
-int cpdStaremActiveMonitorStart( void );
 
 #endif
 
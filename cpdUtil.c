@@ -15,6 +15,9 @@
 #include <utime.h>
 #include <sys/time.h>
 #include <time.h>
+#include <pthread.h>
+
+#include "cpdScan.h"
 
 static struct timeval start_time;
 
@@ -67,6 +70,66 @@ unsigned int getMsecDt(unsigned int t)
     return tNow - t;
 }
 
+/*
+ * Milliseconds of CLOCK_MONOTONIC, not affected by changes of system time.
+ */
+unsigned int getMsecMonotonic(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned int) ((ts.tv_sec * 1000) + (ts.tv_nsec / 1000000));
+}
+
+static unsigned int crc32cTable[8][256];
+static pthread_once_t crc32cTableOnce = PTHREAD_ONCE_INIT;
+
+static void cpdCrc32cInitTable(void)
+{
+    unsigned int crc;
+    int i, j;
+
+    for (i = 0; i < 256; i++) {
+        crc = i;
+        for (j = 0; j < 8; j++) {
+            crc = (crc >> 1) ^ (0x82F63B78U & (0U - (crc & 1)));
+        }
+        crc32cTable[0][i] = crc;
+    }
+    for (i = 0; i < 256; i++) {
+        for (j = 1; j < 8; j++) {
+            crc32cTable[j][i] = (crc32cTable[j - 1][i] >> 8) ^ crc32cTable[0][crc32cTable[j - 1][i] & 0xFF];
+        }
+    }
+}
+
+/*
+ * CRC-32C (Castagnoli) of <len> bytes, continued from <crc> (0 for the first block).
+ * It's computed for every message to and from GPS, 8 bytes are processed per step (slicing-by-8).
+ */
+unsigned int cpdCrc32c(unsigned int crc, const void *pData, unsigned int len)
+{
+    const unsigned char *pB = (const unsigned char *) pData;
+    unsigned int hi;
+
+    pthread_once(&crc32cTableOnce, cpdCrc32cInitTable);
+    crc = ~crc;
+    while (len >= 8) {
+        crc ^= pB[0] | (pB[1] << 8) | (pB[2] << 16) | ((unsigned int) pB[3] << 24);
+        hi = pB[4] | (pB[5] << 8) | (pB[6] << 16) | ((unsigned int) pB[7] << 24);
+        crc = crc32cTable[7][crc & 0xFF] ^ crc32cTable[6][(crc >> 8) & 0xFF] ^
+              crc32cTable[5][(crc >> 16) & 0xFF] ^ crc32cTable[4][crc >> 24] ^
+              crc32cTable[3][hi & 0xFF] ^ crc32cTable[2][(hi >> 8) & 0xFF] ^
+              crc32cTable[1][(hi >> 16) & 0xFF] ^ crc32cTable[0][hi >> 24];
+        pB += 8;
+        len -= 8;
+    }
+    while (len-- > 0) {
+        crc = (crc >> 8) ^ crc32cTable[0][(crc ^ *pB++) & 0xFF];
+    }
+    return ~crc;
+}
+
 int cpdMoveBufferLeft(char *pB, int *pIndex, int left)
 {
     if (left < 0) {
@@ -98,50 +161,18 @@ int readUserChoice(void)
 
 /*
  * find a string of bytes in a buffer of sub-bffer.
- * similar to strstr() but it handles special cases used in CPD.
+ * similar to strstr(), but search is limited to <len> bytes, pB does not need to be null-terminated.
+ * If <lenStr> is 0, findMe is null-terminated string.
  */
 int cpdFindString(char *pB, int len, char *findMe, int lenStr)
 {
-    int result = -1;
-    char *pS = NULL;
-    char *pC = NULL;
-    char *pN = NULL;
-    int i = 0;
-
-    if (len <= 0) {
-        return result;
+    if (findMe == NULL) {
+        return -1;
     }
-    if (pB == NULL) {
-        return result;
+    if (lenStr <= 0) {
+        lenStr = strlen(findMe);
     }
-    pN = pB;
-    while ((result < 0) && (i < len)) {
-        while (i < len) {
-            if (pN[i] == findMe[0]) {
-                pC = &(pN[i]);
-                break;
-            }
-            i++;
-        }
-
-        if (pC != NULL) {
-            pS = strstr(pC, findMe);
-            if (pS != NULL){
-                result = (int) (pS - pB);
-                if (result > len) {
-                    result = -1;
-                }
-                else {
-                    break;
-                }
-            }
-        }
-        else {
-            break;
-        }
-        i++;
-    }
-    return result;
+    return cpdScanFindString(pB, len, findMe, lenStr);
 }
 
 /*
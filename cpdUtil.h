@@ -14,6 +14,8 @@ void initTime(void);
 unsigned int get_msec_time_now(void);
 unsigned int getMsecTime(void);
 unsigned int getMsecDt(unsigned int t);
+unsigned int getMsecMonotonic(void);
+unsigned int cpdCrc32c(unsigned int crc, const void *pData, unsigned int len);
 int getTimeString(char *, int );
 int cpdMoveBufferLeft(char *pB, int *pIndex, int left);
 int readUserChoice(void);
@@ -0,0 +1,243 @@
+/*
+ * hardware/Intel/cp_daemon/cpdXmlArena.c
+ *
+ * libxml2 allocator with bump pointer arena for one formatted message.
+ * Arena is used only by the document tree formatter, for responses which have no template
+ * (cpdSendCpPositionResponseToModem()). Thread which opened the arena with cpdXmlArenaBegin() takes its
+ * libxml2 allocations from the arena, xmlFree() of arena memory does nothing and whole arena is released
+ * in one step by cpdXmlArenaEnd(), after the document was freed.
+ * libxml2 has one allocator for the whole process, so the hook sees every libxml2 allocation, CPOSR decoding
+ * included. All of them except those of the arena owner are passed straight to the allocator libxml2 had
+ * before, as are requests bigger than XML_ARENA_MAX_ALLOC and requests which don't fit any more.
+ *
+ * Martin Junkar 09/18/2011
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <libxml/xmlmemory.h>
+#define LOG_TAG "CPDD_XA"
+
+#include "cpd.h"
+#include "cpdUtil.h"
+#include "cpdXmlArena.h"
+#include "cpdDebug.h"
+
+#define XML_ARENA_ALIGN     (8)                 /* every block starts with its requested size */
+#define XML_ARENA_ROUND(n)  (((n) + XML_ARENA_ALIGN - 1) & ~(XML_ARENA_ALIGN - 1))
+
+static pXML_ARENA pXmlArena = NULL;
+static int xmlArenaInstalled = 0;
+
+/* allocator installed before the arena, everything the arena doesn't take goes there */
+static xmlFreeFunc pfXmlFree = free;
+static xmlMallocFunc pfXmlMalloc = malloc;
+static xmlReallocFunc pfXmlRealloc = realloc;
+static xmlStrdupFunc pfXmlStrdup = strdup;
+
+
+static int cpdXmlArenaOwns(void *p)
+{
+    return ((pXmlArena != NULL) && (pXmlArena->pBase != NULL) &&
+            ((char *) p >= pXmlArena->pBase) && ((char *) p < (pXmlArena->pBase + pXmlArena->size))) ? CPD_OK : CPD_NOK;
+}
+
+static int cpdXmlArenaInUse(void)
+{
+    return ((pXmlArena != NULL) && (pXmlArena->active == CPD_OK) &&
+            pthread_equal(pXmlArena->owner, pthread_self())) ? CPD_OK : CPD_NOK;
+}
+
+/*
+ * Take <size> bytes from the arena, NULL if request has to be passed to malloc().
+ */
+static void *cpdXmlArenaAlloc(size_t size)
+{
+    size_t n;
+    char *p;
+
+    if (size > pXmlArena->maxRequest) {
+        pXmlArena->maxRequest = size;
+    }
+    n = XML_ARENA_ALIGN + XML_ARENA_ROUND(size);
+    if ((size > XML_ARENA_MAX_ALLOC) || (n > (pXmlArena->size - pXmlArena->used))) {
+        pXmlArena->nFallbacks++;
+        return NULL;
+    }
+    p = pXmlArena->pBase + pXmlArena->used;
+    *((size_t *) p) = size;
+    pXmlArena->used = pXmlArena->used + n;
+    pXmlArena->nAllocs++;
+    return p + XML_ARENA_ALIGN;
+}
+
+static void *cpdXmlArenaMalloc(size_t size)
+{
+    void *p = NULL;
+
+    if (cpdXmlArenaInUse() == CPD_OK) {
+        p = cpdXmlArenaAlloc(size);
+    }
+    if (p == NULL) {
+        p = pfXmlMalloc(size);
+    }
+    return p;
+}
+
+static void cpdXmlArenaFree(void *p)
+{
+    if (cpdXmlArenaOwns(p) != CPD_OK) {
+        pfXmlFree(p);
+    }
+}
+
+static void *cpdXmlArenaRealloc(void *p, size_t size)
+{
+    size_t oldSize;
+    char *pNew;
+
+    if (p == NULL) {
+        return cpdXmlArenaMalloc(size);
+    }
+    if (cpdXmlArenaOwns(p) != CPD_OK) {
+        return pfXmlRealloc(p, size);
+    }
+    oldSize = *((size_t *) ((char *) p - XML_ARENA_ALIGN));
+    /* last block grows in place, xmlBuffer content is usually the last one */
+    if ((cpdXmlArenaInUse() == CPD_OK) && (size <= XML_ARENA_MAX_ALLOC) &&
+        (((char *) p + XML_ARENA_ROUND(oldSize)) == (pXmlArena->pBase + pXmlArena->used)) &&
+        (XML_ARENA_ROUND(size) <= (XML_ARENA_ROUND(oldSize) + (pXmlArena->size - pXmlArena->used)))) {
+        pXmlArena->used = pXmlArena->used - XML_ARENA_ROUND(oldSize) + XML_ARENA_ROUND(size);
+        *((size_t *) ((char *) p - XML_ARENA_ALIGN)) = size;
+        if (size > pXmlArena->maxRequest) {
+            pXmlArena->maxRequest = size;
+        }
+        return p;
+    }
+    pNew = cpdXmlArenaMalloc(size);
+    if (pNew != NULL) {
+        memcpy(pNew, p, (oldSize < size) ? oldSize : size);
+    }
+    return pNew;
+}
+
+static char *cpdXmlArenaStrdup(const char *s)
+{
+    size_t len;
+    char *p;
+
+    if (cpdXmlArenaInUse() != CPD_OK) {
+        return pfXmlStrdup(s);
+    }
+    len = strlen(s) + 1;
+    p = cpdXmlArenaMalloc(len);
+    if (p != NULL) {
+        memcpy(p, s, len);
+    }
+    return p;
+}
+
+/*
+ * Allocate arena of pCpd->xmlArena.size bytes and install arena allocator into libxml2.
+ * Called before libxml2 is initialized, memory allocated earlier is released by the allocator it came from.
+ */
+int cpdXmlArenaInit(pCPD_CONTEXT pCpd)
+{
+    pXML_ARENA pArena = &(pCpd->xmlArena);
+
+    if (pArena->pBase != NULL) {
+        return CPD_OK;
+    }
+    if (pArena->size == 0) {
+        return CPD_NOK;
+    }
+    pArena->pBase = malloc(pArena->size);
+    if (pArena->pBase == NULL) {
+        LOGE("%s(), can't allocate %u bytes", __FUNCTION__, pArena->size);
+        return CPD_NOK;
+    }
+    pArena->used = 0;
+    pArena->active = CPD_NOK;
+    pXmlArena = pArena;
+    /* allocator is installed once, it may be wrapped by somebody else later */
+    if (xmlArenaInstalled == 0) {
+        xmlMemGet(&pfXmlFree, &pfXmlMalloc, &pfXmlRealloc, &pfXmlStrdup);
+        if (xmlMemSetup(cpdXmlArenaFree, cpdXmlArenaMalloc, cpdXmlArenaRealloc, cpdXmlArenaStrdup) != 0) {
+            LOGE("%s(), xmlMemSetup() failed", __FUNCTION__);
+            free(pArena->pBase);
+            pArena->pBase = NULL;
+            return CPD_NOK;
+        }
+        xmlArenaInstalled = 1;
+    }
+    pArena->enabled = CPD_OK;
+    CPD_LOG(CPD_LOG_ID_TXT, "\nXML arena: %u bytes", pArena->size);
+    LOGD("%s(), %u bytes", __FUNCTION__, pArena->size);
+    return CPD_OK;
+}
+
+/*
+ * Release arena, at shut down after libxml2 was cleaned up.
+ * Allocator stays installed, everything is passed to the allocator libxml2 had before from now on.
+ */
+void cpdXmlArenaClose(pCPD_CONTEXT pCpd)
+{
+    pXML_ARENA pArena = &(pCpd->xmlArena);
+
+    pthread_mutex_lock(&(pArena->lock));
+    if (pArena->active != CPD_OK) {
+        pArena->enabled = CPD_NOK;
+        free(pArena->pBase);
+        pArena->pBase = NULL;
+    }
+    pthread_mutex_unlock(&(pArena->lock));
+}
+
+/*
+ * Take the arena for libxml2 allocations of the calling thread, until cpdXmlArenaEnd().
+ * CPD_NOK if arena is not used or another message has it, allocations go to malloc() then.
+ */
+int cpdXmlArenaBegin(pCPD_CONTEXT pCpd)
+{
+    pXML_ARENA pArena = &(pCpd->xmlArena);
+    int result = CPD_NOK;
+
+    if ((pArena->pBase == NULL) || (pArena->enabled != CPD_OK)) {
+        return result;
+    }
+    pthread_mutex_lock(&(pArena->lock));
+    if ((pArena->pBase != NULL) && (pArena->active != CPD_OK)) {
+        pArena->used = 0;
+        pArena->owner = pthread_self();
+        pArena->active = CPD_OK;
+        result = CPD_OK;
+    }
+    pthread_mutex_unlock(&(pArena->lock));
+    return result;
+}
+
+/*
+ * Release everything allocated from the arena since cpdXmlArenaBegin().
+ * Nothing allocated by libxml2 after cpdXmlArenaBegin() may be used any more.
+ */
+void cpdXmlArenaEnd(pCPD_CONTEXT pCpd)
+{
+    pXML_ARENA pArena = &(pCpd->xmlArena);
+
+    if (cpdXmlArenaInUse() != CPD_OK) {
+        return;
+    }
+    pthread_mutex_lock(&(pArena->lock));
+    pArena->nMessages++;
+    if (pArena->used > pArena->highWater) {
+        pArena->highWater = pArena->used;
+    }
+    CPD_LOG(CPD_LOG_ID_TXT, "\nXML arena: %u bytes used, high water %u/%u, biggest request %u, %u passed to malloc",
+            pArena->used, pArena->highWater, pArena->size, pArena->maxRequest, pArena->nFallbacks);
+    pArena->used = 0;
+    pArena->active = CPD_NOK;
+    pthread_mutex_unlock(&(pArena->lock));
+}
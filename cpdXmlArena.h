@@ -0,0 +1,18 @@
+/*
+ * hardware/Intel/cp_daemon/cpdXmlArena.h
+ *
+ * Header file for cpdXmlArena.c.
+ *
+ * Martin Junkar 09/18/2011
+ *
+ */
+
+#ifndef _CPDXMLARENA_H_
+#define _CPDXMLARENA_H_
+#include "cpd.h"
+
+int cpdXmlArenaInit(pCPD_CONTEXT pCpd);
+void cpdXmlArenaClose(pCPD_CONTEXT pCpd);
+int cpdXmlArenaBegin(pCPD_CONTEXT pCpd);
+void cpdXmlArenaEnd(pCPD_CONTEXT pCpd);
+#endif
@@ -12,7 +12,6 @@
 #include <errno.h>
 #include <stdio.h>
 #include <string.h>
-#include <math.h>
 #include <libxml/parser.h>
 #include <libxml/tree.h>
 
@@ -22,15 +21,25 @@
 #include "cpdUtil.h"
 #include "cpdInit.h"
 #include "cpdXmlUtils.h"
+#include "cpdGppCodec.h"
+#include "cpdXmlArena.h"
 #include "cpdModemReadWrite.h"
 #include "cpdDebug.h"
 
 
 extern int cpdSendAbortToGps(pCPD_CONTEXT );
 extern int cpdIsNumberOfResponsesSufficientForRequest(pCPD_CONTEXT );
+extern int cpdRequestIsFulfilled(pREQUEST_PARAMS );
 
 int cpdSendCposResponse(pCPD_CONTEXT pCpd, char *pBuff);
 
+/*
+ * Modem response to +CPOS used to be polled every 10 ms and checked after additional 50 ms delay,
+ * these are used only to report latency saved by waiting for the response directly.
+ */
+#define CPOS_RESPONSE_POLL_INTERVAL     (10)
+#define CPOS_RESPONSE_FIXED_DELAY       (50)
+
 
 /*
  * Create new, empty child for xml node.
@@ -100,41 +109,6 @@ xmlNode *cpdXmlNodeAddChildAttribute(xmlNode *pNode,
     return pChild;
 }
 
-static int cpdConvertHorizontalAccuracyTo3GPPK(int horizontalAccuracyInM)
-{
-    int result = GPP_LL_UNCERT_MAX_K;
-    double ftemp;
-    /* limit output value within 3GPP spec */
-    if (horizontalAccuracyInM > GPP_LL_UNCERT_MAX_M) {
-        horizontalAccuracyInM = GPP_LL_UNCERT_MAX_M;
-    }
-    ftemp =  (double) horizontalAccuracyInM;
-    ftemp = log10((ftemp / GPP_LL_UNCERT_1X) + 1.0) / log10(GPP_LL_UNCERT_1X);
-    result = (int)(ftemp + 0.5);
-    if (result > GPP_LL_UNCERT_MAX_K) {
-        result = GPP_LL_UNCERT_MAX_K;
-    }
-    return result;
-}
-
-static int cpdConvertVerticalAccuracyTo3GPPK(int horizontalAccuracyInM)
-{
-    int result = GPP_ALT_UNCERT_MAX_K;
-    double ftemp;
-    /* limit output value within 3GPP spec */
-    if (horizontalAccuracyInM > GPP_ALT_UNCERT_MAX_M) {
-        horizontalAccuracyInM = GPP_ALT_UNCERT_MAX_M;
-    }
-    ftemp =  (double) horizontalAccuracyInM;
-    ftemp = log10((ftemp / GPP_ALT_UNCERT_1X) + 1.0) / log10(GPP_ALT_UNCERT_1X);
-    result = (int)(ftemp + 0.5);
-    if (result > GPP_ALT_UNCERT_MAX_K) {
-        result = GPP_ALT_UNCERT_MAX_K;
-    }
-    return result;
-}
-
-
 /*
 * Format Loaction data into XML pDocument.
 */
@@ -223,28 +197,24 @@ int cpdXmlFormatLocation(pCPD_CONTEXT pCpd, xmlDoc *pDoc)
         pNode2 = cpdXmlNodeAddChild(pNode1, "latitude", NULL);
         cpdXmlNodeAddChild(pNode2, "north", xmlBoolToString(pLoc->location_parameters.shape_data.point_uncert_ellipse.coordinate.latitude.north));
 
-        if (pLoc->location_parameters.shape_data.point_uncert_ellipse.coordinate.latitude.north == 0) {
-            ltemp = (long) (LATITUDE_FLOAT_TO_GPP * pLoc->location_parameters.shape_data.point_uncert_ellipse.coordinate.latitude.degrees);
-        }
-        else {
-            ltemp = (long) (LATITUDE_FLOAT_TO_GPP * (-pLoc->location_parameters.shape_data.point_uncert_ellipse.coordinate.latitude.degrees));
-        }
+        ltemp = cpdGppLatitudeToK(pLoc->location_parameters.shape_data.point_uncert_ellipse.coordinate.latitude.north,
+                                  pLoc->location_parameters.shape_data.point_uncert_ellipse.coordinate.latitude.degrees);
         cpdXmlNodeAddChildLong(pNode2, "degrees", ltemp);
 
-        ltemp = (long) (LONGITUDE_FLOAT_TO_GPP * pLoc->location_parameters.shape_data.point_uncert_ellipse.coordinate.longitude);
+        ltemp = cpdGppLongitudeToK(pLoc->location_parameters.shape_data.point_uncert_ellipse.coordinate.longitude);
         cpdXmlNodeAddChildLong(pNode1, "longitude", ltemp);
 
         pNode1 = cpdXmlNodeAddChild(pNode,  "uncert_ellipse", NULL);
 //        cpdXmlNodeAddChildInt(pNode1,  "uncert_semi_major", pLoc->location_parameters.shape_data.point_uncert_ellipse.uncert_semi_major);
 //        cpdXmlNodeAddChildInt(pNode1,  "uncert_semi_minor", pLoc->location_parameters.shape_data.point_uncert_ellipse.uncert_semi_minor);
 
-        ltemp =  cpdConvertHorizontalAccuracyTo3GPPK(pLoc->location_parameters.shape_data.point_alt_uncertellipse.uncert_semi_major);
+        ltemp = cpdGppHorizontalUncertToK(pLoc->location_parameters.shape_data.point_uncert_ellipse.uncert_semi_major);
         cpdXmlNodeAddChildInt(pNode,  "uncert_semi_major", (int) ltemp);
-        ltemp =  cpdConvertHorizontalAccuracyTo3GPPK(pLoc->location_parameters.shape_data.point_alt_uncertellipse.uncert_semi_minor);
+        ltemp = cpdGppHorizontalUncertToK(pLoc->location_parameters.shape_data.point_uncert_ellipse.uncert_semi_minor);
         cpdXmlNodeAddChildInt(pNode,  "uncert_semi_minor", (int) ltemp);
 
         cpdXmlNodeAddChildInt(pNode1,  "orient_major", pLoc->location_parameters.shape_data.point_uncert_ellipse.orient_major);
-        cpdXmlNodeAddChildInt(pNode1,  "confidence", pLoc->location_parameters.shape_data.point_uncert_ellipse.confidence);
+        cpdXmlNodeAddChildInt(pNode1,  "confidence", cpdGppConfidence(pLoc->location_parameters.shape_data.point_uncert_ellipse.confidence));
         break;
 
     case SHAPE_TYPE_POLYGON:
@@ -282,35 +252,31 @@ int cpdXmlFormatLocation(pCPD_CONTEXT pCpd, xmlDoc *pDoc)
         pNode1 = cpdXmlNodeAddChild(pNode,  "coordinate",  NULL);
         pNode2 = cpdXmlNodeAddChild(pNode1, "latitude", NULL);
         cpdXmlNodeAddChild(pNode2, "north", xmlBoolToString(pLoc->location_parameters.shape_data.point_alt_uncertellipse.coordinate.latitude.north));
-        if (pLoc->location_parameters.shape_data.point_uncert_ellipse.coordinate.latitude.north == 0) {
-            ltemp = (long) (LATITUDE_FLOAT_TO_GPP * pLoc->location_parameters.shape_data.point_uncert_ellipse.coordinate.latitude.degrees);
-        }
-        else {
-            ltemp = (long) (LATITUDE_FLOAT_TO_GPP * (-pLoc->location_parameters.shape_data.point_uncert_ellipse.coordinate.latitude.degrees));
-        }
+        ltemp = cpdGppLatitudeToK(pLoc->location_parameters.shape_data.point_alt_uncertellipse.coordinate.latitude.north,
+                                  pLoc->location_parameters.shape_data.point_alt_uncertellipse.coordinate.latitude.degrees);
         CPD_LOG(CPD_LOG_ID_TXT, "\r\n Lat=%f = %d, N=%d",
-            pLoc->location_parameters.shape_data.point_uncert_ellipse.coordinate.latitude.degrees,
+            pLoc->location_parameters.shape_data.point_alt_uncertellipse.coordinate.latitude.degrees,
             ltemp,
-            pLoc->location_parameters.shape_data.point_uncert_ellipse.coordinate.latitude.north);
+            pLoc->location_parameters.shape_data.point_alt_uncertellipse.coordinate.latitude.north);
         cpdXmlNodeAddChildLong(pNode2, "degrees", ltemp);
 
-        ltemp = (long) (LONGITUDE_FLOAT_TO_GPP * pLoc->location_parameters.shape_data.point_uncert_ellipse.coordinate.longitude);
-        CPD_LOG(CPD_LOG_ID_TXT, "\r\n Lon=%f = %d, flag=%d", pLoc->location_parameters.shape_data.point_uncert_ellipse.coordinate.longitude, ltemp,
+        ltemp = cpdGppLongitudeToK(pLoc->location_parameters.shape_data.point_alt_uncertellipse.coordinate.longitude);
+        CPD_LOG(CPD_LOG_ID_TXT, "\r\n Lon=%f = %d, flag=%d", pLoc->location_parameters.shape_data.point_alt_uncertellipse.coordinate.longitude, ltemp,
             pCpd->request.posMeas.flag);
-        LOGD("Lon=%f = %ld, flag=%d", pLoc->location_parameters.shape_data.point_uncert_ellipse.coordinate.longitude, ltemp,
+        LOGD("Lon=%f = %ld, flag=%d", pLoc->location_parameters.shape_data.point_alt_uncertellipse.coordinate.longitude, ltemp,
             pCpd->request.posMeas.flag);
         cpdXmlNodeAddChildLong(pNode1, "longitude", ltemp);
 
         pNode1 = cpdXmlNodeAddChild(pNode,  "altitude", NULL);
         cpdXmlNodeAddChildInt(pNode1, "height_above_surface", pLoc->location_parameters.shape_data.point_alt_uncertellipse.altitude.height_above_surface);
         cpdXmlNodeAddChildInt(pNode1, "height", pLoc->location_parameters.shape_data.point_alt_uncertellipse.altitude.height);
-        ltemp =  cpdConvertHorizontalAccuracyTo3GPPK(pLoc->location_parameters.shape_data.point_alt_uncertellipse.uncert_semi_major);
+        ltemp = cpdGppHorizontalUncertToK(pLoc->location_parameters.shape_data.point_alt_uncertellipse.uncert_semi_major);
         cpdXmlNodeAddChildInt(pNode,  "uncert_semi_major", (int) ltemp);
-        ltemp =  cpdConvertHorizontalAccuracyTo3GPPK(pLoc->location_parameters.shape_data.point_alt_uncertellipse.uncert_semi_minor);
+        ltemp = cpdGppHorizontalUncertToK(pLoc->location_parameters.shape_data.point_alt_uncertellipse.uncert_semi_minor);
         cpdXmlNodeAddChildInt(pNode,  "uncert_semi_minor", (int) ltemp);
         cpdXmlNodeAddChildInt(pNode,  "orient_major", pLoc->location_parameters.shape_data.point_alt_uncertellipse.orient_major);
-        cpdXmlNodeAddChildInt(pNode,  "confidence", pLoc->location_parameters.shape_data.point_alt_uncertellipse.confidence);
-        ltemp =  cpdConvertVerticalAccuracyTo3GPPK(pLoc->location_parameters.shape_data.point_alt_uncertellipse.uncert_alt);
+        cpdXmlNodeAddChildInt(pNode,  "confidence", cpdGppConfidence(pLoc->location_parameters.shape_data.point_alt_uncertellipse.confidence));
+        ltemp = cpdGppVerticalUncertToK(pLoc->location_parameters.shape_data.point_alt_uncertellipse.uncert_alt);
         cpdXmlNodeAddChildInt(pNode,  "uncert_alt", (int) ltemp);
         break;
 
@@ -328,7 +294,7 @@ int cpdXmlFormatLocation(pCPD_CONTEXT pCpd, xmlDoc *pDoc)
         cpdXmlNodeAddChildInt(pNode,  "uncert_rad",  pLoc->location_parameters.shape_data.ellips_arc.uncert_rad);
         cpdXmlNodeAddChildInt(pNode,  "offset_angle",  pLoc->location_parameters.shape_data.ellips_arc.offset_angle);
         cpdXmlNodeAddChildInt(pNode,  "included_angle",  pLoc->location_parameters.shape_data.ellips_arc.included_angle);
-        cpdXmlNodeAddChildInt(pNode,  "confidence",  pLoc->location_parameters.shape_data.ellips_arc.confidence);
+        cpdXmlNodeAddChildInt(pNode,  "confidence",  cpdGppConfidence(pLoc->location_parameters.shape_data.ellips_arc.confidence));
         break;
     case SHAPE_TYPE_NONE:
         break;
@@ -340,31 +306,550 @@ int cpdXmlFormatLocation(pCPD_CONTEXT pCpd, xmlDoc *pDoc)
     return result;
 }
 
+/*
+ * Location response templates, output is the same as cpdXmlFormatLocation() document saved by xmlSaveFormatFileTo().
+ * Each value mark is replaced by the next value, formatted the way cpdXmlNodeAddChild*() formats it.
+ */
+#define XML_TEMPLATE_INT        "\001"      /* cpdXmlNodeAddChildInt(), up to 8 characters */
+#define XML_TEMPLATE_LONG       "\002"      /* cpdXmlNodeAddChildLong(), up to 14 characters */
+#define XML_TEMPLATE_BOOL       "\003"      /* xmlBoolToString() */
+#define XML_TEMPLATE_MULTIPATH  "\004"      /* xmlMultiPathToString() */
+#define XML_TEMPLATE_INT_CHR    '\001'
+#define XML_TEMPLATE_LONG_CHR   '\002'
+#define XML_TEMPLATE_BOOL_CHR   '\003'
+#define XML_TEMPLATE_MULTIPATH_CHR  '\004'
+#define XML_TEMPLATE_LAST_CHR   XML_TEMPLATE_MULTIPATH_CHR
+#define XML_TEMPLATE_INT_LEN    (8)
+#define XML_TEMPLATE_LONG_LEN   (14)
+#define XML_TEMPLATE_MAX_VALUES XML_TX_MAX_SLOTS
+
+#define XML_TEMPLATE_HEAD \
+    "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n" \
+    "<pos>\n" \
+    "  <location>\n" \
+    "    <time>" XML_TEMPLATE_LONG "</time>\n" \
+    "    <location_parameters>\n"
+#define XML_TEMPLATE_TAIL \
+    "    </location_parameters>\n" \
+    "  </location>\n" \
+    "</pos>\n"
+#define XML_TEMPLATE_COORDINATE \
+    "          <coordinate>\n" \
+    "            <latitude>\n" \
+    "              <north>" XML_TEMPLATE_BOOL "</north>\n" \
+    "              <degrees>" XML_TEMPLATE_LONG "</degrees>\n" \
+    "            </latitude>\n" \
+    "            <longitude>" XML_TEMPLATE_LONG "</longitude>\n" \
+    "          </coordinate>\n"
+#define XML_TEMPLATE_ALTITUDE \
+    "          <altitude>\n" \
+    "            <height_above_surface>" XML_TEMPLATE_INT "</height_above_surface>\n" \
+    "            <height>" XML_TEMPLATE_INT "</height>\n" \
+    "          </altitude>\n"
+
+#define XML_TEMPLATE_MEAS_HEAD \
+    "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n" \
+    "<pos>\n" \
+    "  <GPS_meas>\n" \
+    "    <ref_time_only>\n" \
+    "      <tow_msec>" XML_TEMPLATE_LONG "</tow_msec>\n" \
+    "    </ref_time_only>\n"
+#define XML_TEMPLATE_MEAS_TAIL \
+    "  </GPS_meas>\n" \
+    "</pos>\n"
+#define XML_MEAS_PARAMS_VALUES  (7)
+
+/* meas_params of one satellite */
+static const char xmlMeasParamsTemplate[] =
+    "    <meas_params>\n"
+    "      <sat_id>" XML_TEMPLATE_INT "</sat_id>\n"
+    "      <carr2_noise>" XML_TEMPLATE_INT "</carr2_noise>\n"
+    "      <dopl>" XML_TEMPLATE_INT "</dopl>\n"
+    "      <whole_chips>" XML_TEMPLATE_INT "</whole_chips>\n"
+    "      <fract_chips>" XML_TEMPLATE_INT "</fract_chips>\n"
+    "      <multi_path literal=\"" XML_TEMPLATE_MULTIPATH "\"/>\n"
+    "      <psr_rms_err>" XML_TEMPLATE_INT "</psr_rms_err>\n"
+    "    </meas_params>\n";
+
+/* shape_data of each SHAPE_TYPE_E, polygon coordinates are added one by one */
+static const char *xmlLocationTemplates[] = {
+    /* SHAPE_TYPE_NONE */
+    "      <shape_data/>\n",
+    /* SHAPE_TYPE_POINT */
+    "      <shape_data>\n"
+    "        <ellipsoid_point>\n"
+    XML_TEMPLATE_COORDINATE
+    "        </ellipsoid_point>\n"
+    "      </shape_data>\n",
+    /* SHAPE_TYPE_POINT_UNCERT_CIRCLE */
+    "      <shape_data>\n"
+    "        <ellipsoid_point_uncert_circle>\n"
+    XML_TEMPLATE_COORDINATE
+    "          <uncert_circle>" XML_TEMPLATE_INT "</uncert_circle>\n"
+    "        </ellipsoid_point_uncert_circle>\n"
+    "      </shape_data>\n",
+    /* SHAPE_TYPE_POINT_UNCERT_ELLIPSE */
+    "      <shape_data>\n"
+    "        <ellipsoid_point_uncert_ellipse>\n"
+    XML_TEMPLATE_COORDINATE
+    "          <uncert_ellipse>\n"
+    "            <orient_major>" XML_TEMPLATE_INT "</orient_major>\n"
+    "            <confidence>" XML_TEMPLATE_INT "</confidence>\n"
+    "          </uncert_ellipse>\n"
+    "          <uncert_semi_major>" XML_TEMPLATE_INT "</uncert_semi_major>\n"
+    "          <uncert_semi_minor>" XML_TEMPLATE_INT "</uncert_semi_minor>\n"
+    "        </ellipsoid_point_uncert_ellipse>\n"
+    "      </shape_data>\n",
+    /* SHAPE_TYPE_POLYGON */
+    "      <shape_data>\n"
+    "        <polygon>\n",
+    /* SHAPE_TYPE_POINT_ALT */
+    "      <shape_data>\n"
+    "        <ellipsoid_point_alt>\n"
+    XML_TEMPLATE_COORDINATE
+    XML_TEMPLATE_ALTITUDE
+    "        </ellipsoid_point_alt>\n"
+    "      </shape_data>\n",
+    /* SHAPE_TYPE_POINT_ALT_UNCERT_ELLIPSE */
+    "      <shape_data>\n"
+    "        <ellipsoid_point_alt_uncertellipse>\n"
+    XML_TEMPLATE_COORDINATE
+    XML_TEMPLATE_ALTITUDE
+    "          <uncert_semi_major>" XML_TEMPLATE_INT "</uncert_semi_major>\n"
+    "          <uncert_semi_minor>" XML_TEMPLATE_INT "</uncert_semi_minor>\n"
+    "          <orient_major>" XML_TEMPLATE_INT "</orient_major>\n"
+    "          <confidence>" XML_TEMPLATE_INT "</confidence>\n"
+    "          <uncert_alt>" XML_TEMPLATE_INT "</uncert_alt>\n"
+    "        </ellipsoid_point_alt_uncertellipse>\n"
+    "      </shape_data>\n",
+    /* SHAPE_TYPE_ARC */
+    "      <shape_data>\n"
+    "        <ellips_arc>\n"
+    XML_TEMPLATE_COORDINATE
+    "          <inner_rad>" XML_TEMPLATE_INT "</inner_rad>\n"
+    "          <uncert_rad>" XML_TEMPLATE_INT "</uncert_rad>\n"
+    "          <offset_angle>" XML_TEMPLATE_INT "</offset_angle>\n"
+    "          <included_angle>" XML_TEMPLATE_INT "</included_angle>\n"
+    "          <confidence>" XML_TEMPLATE_INT "</confidence>\n"
+    "        </ellips_arc>\n"
+    "      </shape_data>\n"
+};
+
+static const char xmlPolygonTemplate[] = XML_TEMPLATE_COORDINATE;
+static const char xmlPolygonTemplateEnd[] =
+    "        </polygon>\n"
+    "      </shape_data>\n";
+static const char xmlPolygonTemplateEmpty[] =
+    "      <shape_data>\n"
+    "        <polygon/>\n"
+    "      </shape_data>\n";
+
+/*
+ * Write decimal <value> into <pB>, which has room for at least 21 characters, return number of characters.
+ */
+static int cpdXmlItoa(char *pB, long value)
+{
+    char digits[24];
+    unsigned long u;
+    int n = 0;
+    int i = 0;
+
+    u = (value < 0) ? (0UL - (unsigned long) value) : (unsigned long) value;
+    do {
+        digits[n++] = (char) ('0' + (u % 10));
+        u = u / 10;
+    } while (u != 0);
+    if (value < 0) {
+        pB[i++] = '-';
+    }
+    while (n > 0) {
+        pB[i++] = digits[--n];
+    }
+    return i;
+}
+
+/*
+ * Format <value> for template mark <type> into <pB>, return number of characters.
+ */
+static int cpdXmlFormatValue(char *pB, char type, long value)
+{
+    const char *pS;
+    int len;
+
+    switch (type) {
+    case XML_TEMPLATE_BOOL_CHR:
+        pS = xmlBoolToString((int) value);
+        len = strlen(pS);
+        memcpy(pB, pS, len);
+        break;
+    case XML_TEMPLATE_MULTIPATH_CHR:
+        pS = xmlMultiPathToString((int) value);
+        len = strlen(pS);
+        memcpy(pB, pS, len);
+        break;
+    case XML_TEMPLATE_INT_CHR:
+        len = cpdXmlItoa(pB, (long) (int) value);
+        if (len > XML_TEMPLATE_INT_LEN) {
+            len = XML_TEMPLATE_INT_LEN;
+        }
+        break;
+    default:
+        len = cpdXmlItoa(pB, value);
+        if (len > XML_TEMPLATE_LONG_LEN) {
+            len = XML_TEMPLATE_LONG_LEN;
+        }
+        break;
+    }
+    return len;
+}
+
+/*
+ * Append <pTemplate> to <pB>, which already holds <n> characters, replacing value marks with values from <*ppValues>.
+ * Position of each value is recorded in <pSlots>, if it's not NULL.
+ * Returns new length, CPD_ERROR if output and terminating 0 don't fit into <size>.
+ */
+static int cpdXmlEmit(char *pB, int size, int n, const char *pTemplate, const long **ppValues, pXML_TX_TEMPLATE pSlots)
+{
+    char number[24];
+    const char *pS;
+    pXML_TX_SLOT pSlot;
+    int len;
+
+    if (n < 0) {
+        return CPD_ERROR;
+    }
+    while (*pTemplate != 0) {
+        /* literal text up to the next mark */
+        for (pS = pTemplate; (unsigned char) *pS > XML_TEMPLATE_LAST_CHR; pS++) {
+        }
+        len = pS - pTemplate;
+        if (len > 0) {
+            if ((n + len) >= size) {
+                return CPD_ERROR;
+            }
+            memcpy(&(pB[n]), pTemplate, len);
+            n = n + len;
+            pTemplate = pS;
+            continue;
+        }
+        len = cpdXmlFormatValue(number, *pTemplate, **ppValues);
+        if ((n + len) >= size) {
+            return CPD_ERROR;
+        }
+        memcpy(&(pB[n]), number, len);
+        if (pSlots != NULL) {
+            if (pSlots->nSlots >= XML_TX_MAX_SLOTS) {
+                return CPD_ERROR;
+            }
+            pSlot = &(pSlots->slots[pSlots->nSlots]);
+            pSlot->offset = (unsigned short) n;
+            pSlot->len = (unsigned char) len;
+            pSlot->type = (unsigned char) *pTemplate;
+            pSlot->value = **ppValues;
+            pSlots->nSlots++;
+        }
+        n = n + len;
+        (*ppValues)++;
+        pTemplate++;
+    }
+    pB[n] = 0;
+    return n;
+}
+
+/*
+ * Shape written into response, unknown shape is left out like SHAPE_TYPE_NONE.
+ */
+static SHAPE_TYPE_E cpdXmlLocationShape(pLOCATION pLoc)
+{
+    if ((unsigned int) pLoc->location_parameters.shape_type > SHAPE_TYPE_ARC) {
+        return SHAPE_TYPE_NONE;
+    }
+    return pLoc->location_parameters.shape_type;
+}
+
+/*
+ * Values of coordinate template.
+ */
+static long *cpdXmlCoordinateValues(long *pV, int north, long degrees, long longitude)
+{
+    *pV++ = north;
+    *pV++ = degrees;
+    *pV++ = longitude;
+    return pV;
+}
+
+/*
+ * Values of location response in the order of template marks, converted the same way as in cpdXmlFormatLocation().
+ * Returns number of values, CPD_ERROR if there are more than <max>.
+ */
+static int cpdXmlLocationValues(pCPD_CONTEXT pCpd, long *pValues, int max)
+{
+    long *pV = pValues;
+    pLOCATION pLoc = &(pCpd->response.location);
+    pSHAPE_DATA_U pShape = &(pLoc->location_parameters.shape_data);
+    unsigned int i;
+    long degrees;
+
+    *pV++ = pLoc->time_of_fix;
+    switch (cpdXmlLocationShape(pLoc)) {
+    case SHAPE_TYPE_POINT:
+        pV = cpdXmlCoordinateValues(pV, pShape->point.coordinate.latitude.north,
+                                    (long) pShape->point.coordinate.latitude.degrees, (long) pShape->point.coordinate.longitude);
+        break;
+
+    case SHAPE_TYPE_POINT_UNCERT_CIRCLE:
+        pV = cpdXmlCoordinateValues(pV, pShape->point_uncert_circle.coordinate.latitude.north,
+                                    (long) pShape->point_uncert_circle.coordinate.latitude.degrees,
+                                    (long) pShape->point_uncert_circle.coordinate.longitude);
+        *pV++ = pShape->point_uncert_circle.uncert_circle;
+        break;
+
+    case SHAPE_TYPE_POINT_UNCERT_ELLIPSE:
+        degrees = cpdGppLatitudeToK(pShape->point_uncert_ellipse.coordinate.latitude.north,
+                                    pShape->point_uncert_ellipse.coordinate.latitude.degrees);
+        pV = cpdXmlCoordinateValues(pV, pShape->point_uncert_ellipse.coordinate.latitude.north, degrees,
+                                    cpdGppLongitudeToK(pShape->point_uncert_ellipse.coordinate.longitude));
+        *pV++ = pShape->point_uncert_ellipse.orient_major;
+        *pV++ = cpdGppConfidence(pShape->point_uncert_ellipse.confidence);
+        *pV++ = cpdGppHorizontalUncertToK(pShape->point_uncert_ellipse.uncert_semi_major);
+        *pV++ = cpdGppHorizontalUncertToK(pShape->point_uncert_ellipse.uncert_semi_minor);
+        break;
+
+    case SHAPE_TYPE_POLYGON:
+        if ((1 + 3 * pShape->polygon.nItems) > (unsigned int) max) {
+            return CPD_ERROR;
+        }
+        for (i = 0; i < pShape->polygon.nItems; i++) {
+            pV = cpdXmlCoordinateValues(pV, pShape->polygon.pCoordinates[i].latitude.north,
+                                        (long) pShape->polygon.pCoordinates[i].latitude.degrees,
+                                        (long) pShape->polygon.pCoordinates[i].longitude);
+        }
+        break;
+
+    case SHAPE_TYPE_POINT_ALT:
+        pV = cpdXmlCoordinateValues(pV, pShape->point_alt.coordinate.latitude.north,
+                                    (long) pShape->point_alt.coordinate.latitude.degrees,
+                                    (long) pShape->point_alt.coordinate.longitude);
+        *pV++ = pShape->point_alt.altitude.height_above_surface;
+        *pV++ = pShape->point_alt.altitude.height;
+        break;
+
+    case SHAPE_TYPE_POINT_ALT_UNCERT_ELLIPSE:
+        degrees = cpdGppLatitudeToK(pShape->point_alt_uncertellipse.coordinate.latitude.north,
+                                    pShape->point_alt_uncertellipse.coordinate.latitude.degrees);
+        pV = cpdXmlCoordinateValues(pV, pShape->point_alt_uncertellipse.coordinate.latitude.north, degrees,
+                                    cpdGppLongitudeToK(pShape->point_alt_uncertellipse.coordinate.longitude));
+        *pV++ = pShape->point_alt_uncertellipse.altitude.height_above_surface;
+        *pV++ = pShape->point_alt_uncertellipse.altitude.height;
+        *pV++ = cpdGppHorizontalUncertToK(pShape->point_alt_uncertellipse.uncert_semi_major);
+        *pV++ = cpdGppHorizontalUncertToK(pShape->point_alt_uncertellipse.uncert_semi_minor);
+        *pV++ = pShape->point_alt_uncertellipse.orient_major;
+        *pV++ = cpdGppConfidence(pShape->point_alt_uncertellipse.confidence);
+        *pV++ = cpdGppVerticalUncertToK(pShape->point_alt_uncertellipse.uncert_alt);
+        break;
+
+    case SHAPE_TYPE_ARC:
+        pV = cpdXmlCoordinateValues(pV, pShape->ellips_arc.coordinate.latitude.north,
+                                    (long) pShape->ellips_arc.coordinate.latitude.degrees,
+                                    (long) pShape->ellips_arc.coordinate.longitude);
+        *pV++ = pShape->ellips_arc.inner_rad;
+        *pV++ = pShape->ellips_arc.uncert_rad;
+        *pV++ = pShape->ellips_arc.offset_angle;
+        *pV++ = pShape->ellips_arc.included_angle;
+        *pV++ = cpdGppConfidence(pShape->ellips_arc.confidence);
+        break;
+
+    default:
+        break;
+    }
+    return pV - pValues;
+}
+
+/*
+ * Write location response text made of <pValues> into <pB>, recording value positions in <pSlots> if it's not NULL.
+ */
+static int cpdXmlEmitLocationText(pLOCATION pLoc, char *pB, int size, const long *pValues, pXML_TX_TEMPLATE pSlots)
+{
+    SHAPE_TYPE_E shape = cpdXmlLocationShape(pLoc);
+    unsigned int i;
+    int n;
+
+    n = cpdXmlEmit(pB, size, 0, XML_TEMPLATE_HEAD, &pValues, pSlots);
+    if ((shape == SHAPE_TYPE_POLYGON) && (pLoc->location_parameters.shape_data.polygon.nItems == 0)) {
+        n = cpdXmlEmit(pB, size, n, xmlPolygonTemplateEmpty, &pValues, pSlots);
+    }
+    else if (shape == SHAPE_TYPE_POLYGON) {
+        n = cpdXmlEmit(pB, size, n, xmlLocationTemplates[shape], &pValues, pSlots);
+        for (i = 0; i < pLoc->location_parameters.shape_data.polygon.nItems; i++) {
+            n = cpdXmlEmit(pB, size, n, xmlPolygonTemplate, &pValues, pSlots);
+        }
+        n = cpdXmlEmit(pB, size, n, xmlPolygonTemplateEnd, &pValues, pSlots);
+    }
+    else {
+        n = cpdXmlEmit(pB, size, n, xmlLocationTemplates[shape], &pValues, pSlots);
+    }
+    return cpdXmlEmit(pB, size, n, XML_TEMPLATE_TAIL, &pValues, pSlots);
+}
+
+/*
+ * Write location response as XML text into <pB> of <size> bytes, without building the document.
+ * Returns length of the text, CPD_ERROR if it doesn't fit, terminating 0 is always written after the text.
+ */
+int cpdXmlEmitLocation(pCPD_CONTEXT pCpd, char *pB, int size)
+{
+    long values[XML_TEMPLATE_MAX_VALUES];
+
+    if ((pCpd == NULL) || (pB == NULL)) {
+        return CPD_ERROR;
+    }
+    CPD_LOG(CPD_LOG_ID_TXT, "\r\n %s(), shape type = %d", __FUNCTION__, pCpd->response.location.location_parameters.shape_type);
+    if (cpdXmlLocationValues(pCpd, values, XML_TEMPLATE_MAX_VALUES) < 0) {
+        return CPD_ERROR;
+    }
+    return cpdXmlEmitLocationText(&(pCpd->response.location), pB, size, values, NULL);
+}
+
+/*
+ * Location response for periodic reporting.
+ * Text is made once for each request <requestId> and shape, for next fixes values which changed are rewritten in place,
+ * the rest of the text is moved only when length of a value changes.
+ * Returns the text in pCpd->xmlTxTemplate, NULL if response can't be made from template.
+ */
+char *cpdXmlPatchLocation(pCPD_CONTEXT pCpd, unsigned int requestId)
+{
+    pXML_TX_TEMPLATE pT = &(pCpd->xmlTxTemplate);
+    pLOCATION pLoc = &(pCpd->response.location);
+    long values[XML_TEMPLATE_MAX_VALUES];
+    char number[24];
+    pXML_TX_SLOT pSlot;
+    int nValues;
+    int i, j, len, diff;
+
+    nValues = cpdXmlLocationValues(pCpd, values, XML_TEMPLATE_MAX_VALUES);
+    if (nValues < 0) {
+        pT->valid = CPD_NOK;
+        return NULL;
+    }
+    if ((pT->valid != CPD_OK) || (pT->requestId != requestId) ||
+        (pT->shape != cpdXmlLocationShape(pLoc)) || (pT->nSlots != nValues)) {
+        pT->nSlots = 0;
+        pT->len = cpdXmlEmitLocationText(pLoc, pT->text, sizeof(pT->text), values, pT);
+        pT->valid = (pT->len > 0) ? CPD_OK : CPD_NOK;
+        pT->requestId = requestId;
+        pT->shape = cpdXmlLocationShape(pLoc);
+        pT->nBuilt++;
+        CPD_LOG(CPD_LOG_ID_TXT, "\r\n %s(), new template: shape %d, %d values, %d bytes", __FUNCTION__, pT->shape, pT->nSlots, pT->len);
+        return (pT->valid == CPD_OK) ? pT->text : NULL;
+    }
+
+    for (i = 0; i < pT->nSlots; i++) {
+        pSlot = &(pT->slots[i]);
+        if (pSlot->value == values[i]) {
+            continue;
+        }
+        len = cpdXmlFormatValue(number, (char) pSlot->type, values[i]);
+        diff = len - pSlot->len;
+        if (diff != 0) {
+            if ((pT->len + diff) >= (int) sizeof(pT->text)) {
+                pT->valid = CPD_NOK;
+                return NULL;
+            }
+            /* move the rest of the text, with terminating 0 */
+            memmove(&(pT->text[pSlot->offset + len]), &(pT->text[pSlot->offset + pSlot->len]),
+                    pT->len - (pSlot->offset + pSlot->len) + 1);
+            pT->len = pT->len + diff;
+            for (j = i + 1; j < pT->nSlots; j++) {
+                pT->slots[j].offset = (unsigned short) (pT->slots[j].offset + diff);
+            }
+            pSlot->len = (unsigned char) len;
+        }
+        memcpy(&(pT->text[pSlot->offset]), number, len);
+        pSlot->value = values[i];
+    }
+    pT->nPatched++;
+    return pT->text;
+}
+
+/*
+ * GPS_meas document of MS-assisted response, pseudorange measurements of each satellite in meas_params.
+ */
 int cpdXmlFormatMeasurements(pCPD_CONTEXT pCpd, xmlDoc *pDoc)
 {
-        int result = CPD_NOK;
-        xmlNode *pRoot, *pNode, *pNode1, *pNode2;
-        unsigned int i;
-        xmlNs ns;
-        char *href = "http://www.w3.org/2001/XMLSchema-instance";
-        char *prefix = "pos.xsd";
-        xmlDtdPtr dtd = NULL;       /* DTD pointer */
-        long ltemp;
-
-
-        ns.context = NULL;
-        ns.href = (xmlChar *) href;
-        ns.prefix = (xmlChar *) prefix;
-        ns.type = XML_DTD_NODE;
-
-        CPD_LOG(CPD_LOG_ID_TXT , "\n%u: %s()\n", getMsecTime(), __FUNCTION__);
+    int result = CPD_NOK;
+    xmlNode *pRoot, *pNode, *pNode1;
+    unsigned int i;
+    pGPS_MEAS pMeas;
+    pMEAS_PARAMS pParams;
+
+    if (pCpd == NULL) {
         return result;
+    }
+    pMeas = &(pCpd->response.GPS_meas);
+    CPD_LOG(CPD_LOG_ID_TXT , "\n%u: %s(), %u satellites\n", getMsecTime(), __FUNCTION__, pMeas->meas_params_arr_items);
+
+    /* Create the pos pNode & add it to the pDocument */
+    pRoot = xmlNewNode(NULL, (xmlChar *) "pos");
+    xmlDocSetRootElement(pDoc, pRoot);
+
+    pNode = cpdXmlNodeAddChild(pRoot, "GPS_meas", NULL);
+    pNode1 = cpdXmlNodeAddChild(pNode, "ref_time_only", NULL);
+    cpdXmlNodeAddChildLong(pNode1, "tow_msec", (long) pMeas->tow_msec);
+
+    for (i = 0; (i < pMeas->meas_params_arr_items) && (i < GPS_MAX_N_SVS); i++) {
+        pParams = &(pMeas->meas_params_arr[i]);
+        pNode1 = cpdXmlNodeAddChild(pNode, "meas_params", NULL);
+        cpdXmlNodeAddChildInt(pNode1, "sat_id", pParams->sat_id);
+        cpdXmlNodeAddChildInt(pNode1, "carr2_noise", pParams->carr2_noise);
+        cpdXmlNodeAddChildInt(pNode1, "dopl", pParams->dopl);
+        cpdXmlNodeAddChildInt(pNode1, "whole_chips", pParams->whole_chips);
+        cpdXmlNodeAddChildInt(pNode1, "fract_chips", pParams->fract_chips);
+        cpdXmlNodeAddChildAttribute(pNode1, "multi_path", NULL, "literal", xmlMultiPathToString(pParams->multi_path));
+        cpdXmlNodeAddChildInt(pNode1, "psr_rms_err", pParams->psr_rms_err);
+    }
+    result = CPD_OK;
+    return result;
+}
+
+/*
+ * Write GPS_meas response as XML text into <pB> of <size> bytes, without building the document.
+ * Returns length of the text, CPD_ERROR if it doesn't fit.
+ */
+int cpdXmlEmitMeasurements(pCPD_CONTEXT pCpd, char *pB, int size)
+{
+    long values[1 + XML_MEAS_PARAMS_VALUES];
+    const long *pValues;
+    pGPS_MEAS pMeas;
+    pMEAS_PARAMS pParams;
+    unsigned int i;
+    int n;
+
+    if ((pCpd == NULL) || (pB == NULL)) {
+        return CPD_ERROR;
+    }
+    pMeas = &(pCpd->response.GPS_meas);
+    values[0] = (long) pMeas->tow_msec;
+    pValues = values;
+    n = cpdXmlEmit(pB, size, 0, XML_TEMPLATE_MEAS_HEAD, &pValues, NULL);
+    for (i = 0; (i < pMeas->meas_params_arr_items) && (i < GPS_MAX_N_SVS); i++) {
+        pParams = &(pMeas->meas_params_arr[i]);
+        values[0] = pParams->sat_id;
+        values[1] = pParams->carr2_noise;
+        values[2] = pParams->dopl;
+        values[3] = pParams->whole_chips;
+        values[4] = pParams->fract_chips;
+        values[5] = pParams->multi_path;
+        values[6] = pParams->psr_rms_err;
+        pValues = values;
+        n = cpdXmlEmit(pB, size, n, xmlMeasParamsTemplate, &pValues, NULL);
+    }
+    return cpdXmlEmit(pB, size, n, XML_TEMPLATE_MEAS_TAIL, &pValues, NULL);
 }
 
 /*
  * Send CPOS response to modem.
  * Creates AT+CPOS <XML> reponse(s) from XML data.
  * If needed, split large XML into pieces (handle mux/modem limit on packet size.
+ * <pBuff> is 0 terminated XML, it is sent from the buffer without a copy.
  */
 int cpdSendCposResponse(pCPD_CONTEXT pCpd, char *pBuff)
 {
@@ -372,52 +857,90 @@ int cpdSendCposResponse(pCPD_CONTEXT pCpd, char *pBuff)
     int rr = 0;
     int len = 0;
     int i;
-    int bufferSize = 0;
-//    char pTxBuffer[MODEM_MUX_AT_CMD_MAX_LENGTH +1];
-    char *pTxBuffer;
+    AT_COMMAND_WAIT wait;
+    unsigned int t0;
+    unsigned int saved = CPOS_RESPONSE_FIXED_DELAY;
+    char pCmd[16];
 
     CPD_LOG(CPD_LOG_ID_TXT , "\n  %u: %s()\n", getMsecTime(), __FUNCTION__);
-    bufferSize = strlen(pBuff) + 16;
-    pTxBuffer = malloc(bufferSize);
-    if (pTxBuffer == NULL) {
-        return result;
+    snprintf(pCmd, sizeof(pCmd), "%s%s%s%c", AT_CMD_CRLF, AT_CMD_AT, AT_CMD_CPOS, AT_CMD_CR_CHR);
+    len = len + strlen(pCmd);
+    t0 = getMsecTime();
+    rr = cpdModemSendCommandWait(pCpd, pCmd, strlen(pCmd), AT_RESPONSE_CRLF, 1000UL, &wait);
+    if (wait.response != AT_RESPONSE_NONE) {
+        saved = saved + (CPOS_RESPONSE_POLL_INTERVAL - (wait.latency % CPOS_RESPONSE_POLL_INTERVAL)) % CPOS_RESPONSE_POLL_INTERVAL;
     }
-    memset(pTxBuffer, 0, bufferSize);
-    sprintf(pTxBuffer, "%s%s%s%c", AT_CMD_CRLF, AT_CMD_AT, AT_CMD_CPOS, AT_CMD_CR_CHR);
-    len = len + strlen(pTxBuffer);
-    pCpd->modemInfo.waitForThisResponse = AT_RESPONSE_CRLF;
-    rr = cpdModemSendCommand(pCpd, pTxBuffer, strlen(pTxBuffer),1000UL);
-    pCpd->modemInfo.waitForThisResponse = AT_RESPONSE_NONE;
 
+    /* XML is sent from caller's buffer, its terminating 0 is Ctrl-Z while the command is sent */
     i = strlen(pBuff);
-    memcpy(pTxBuffer, pBuff, i);
-    pTxBuffer[i] = AT_CMD_CTRL_Z_CHR;
+    pBuff[i] = AT_CMD_CTRL_Z_CHR;
     i++;
-    pTxBuffer[i] = 0;
     len = len + i;
-    pCpd->modemInfo.haveResponse = 0;
-    pCpd->modemInfo.responseValue = CPD_ERROR;
-    rr = rr + cpdModemSendCommand(pCpd, pTxBuffer, i, 1000);
+    rr = rr + cpdModemSendCommandWait(pCpd, pBuff, i, AT_RESPONSE_OK, 1000UL, &wait);
+    pBuff[i - 1] = 0;
+    if (wait.response != AT_RESPONSE_NONE) {
+        saved = saved + (CPOS_RESPONSE_POLL_INTERVAL - (wait.latency % CPOS_RESPONSE_POLL_INTERVAL)) % CPOS_RESPONSE_POLL_INTERVAL;
+    }
 
-    CPD_LOG(CPD_LOG_ID_TXT, "\n  %u: %s(), rr=%d, len=%d", getMsecTime(), __FUNCTION__, rr, len);
-    if (rr == len) {
+    CPD_LOG(CPD_LOG_ID_TXT, "\n  %u: %s(), rr=%d, len=%d, response=%d", getMsecTime(), __FUNCTION__, rr, len, wait.response);
+    if ((rr == len) && (wait.response == AT_RESPONSE_OK)) {
         result = CPD_OK;
+        CPD_LOG(CPD_LOG_ID_TXT | CPD_LOG_ID_CONSOLE, "\n CPOS : %u ms, %u ms saved", getMsecDt(t0), saved);
+        LOGD("CPOS : %u ms, %u ms saved", getMsecDt(t0), saved);
     }
-    free ((void *) pTxBuffer);
     return result;
 }
 
 
-int cpdSendCpPositionResponseToModem(pCPD_CONTEXT pCpd)
+/*
+ * Format pCpd->response as +CPOS XML document into <pXmlBuffer>, CPD_OK if response was formatted.
+ */
+int cpdXmlFormatResponse(pCPD_CONTEXT pCpd, xmlBuffer *pXmlBuffer)
 {
-    int result = 0;
+    int result = CPD_NOK;
     xmlDoc *pDoc;
-    xmlBuffer *pXmlBuffer;
     xmlOutputBuffer *pOutBuffer;
+
+    pDoc = xmlNewDoc((xmlChar *) "1.0");
+    if ((pDoc == NULL) || (pXmlBuffer == NULL)) {
+        xmlFreeDoc(pDoc);
+        return result;
+    }
+
+    /* Create the XML document from data */
+    if (pCpd->response.flag == RESPONSE_FLAG_POS_MEAS) {
+        result = cpdXmlFormatLocation(pCpd, pDoc);
+    }
+    else if (pCpd->response.flag == RESPONSE_FLAG_GPS_MEAS) {
+        result = cpdXmlFormatMeasurements(pCpd, pDoc);
+    }
+    if (result == CPD_OK) {
+        /* Convert  XML Document into pXmlBuffer, output buffer is closed by xmlSaveFormatFileTo() */
+        pOutBuffer = xmlOutputBufferCreateBuffer(pXmlBuffer, NULL);
+        if ((pOutBuffer == NULL) || (xmlSaveFormatFileTo(pOutBuffer, pDoc, "utf-8", 1) < 0)) {
+            result = CPD_NOK;
+        }
+    }
+    xmlFreeDoc(pDoc);
+    return result;
+}
+
+/*
+ * Format pCpd->response to request <pRequest> and send it to modem, status of <pRequest> is updated when it was sent.
+ * <pResponseLock> is held by the caller while pCpd->response is used, it's released before the response is sent.
+ * Returns CPD_OK if response was sent or it's not needed any more, CPD_NOK if sending failed or it's too early
+ * to send it, CPD_ERROR if response can't be formatted.
+ */
+int cpdSendCpPositionResponse(pCPD_CONTEXT pCpd, pREQUEST_PARAMS pRequest, pthread_mutex_t *pResponseLock)
+{
+    int result = 0;
+    char pXml[XML_TX_MAX_DOC_SIZE];
+    char *pContent = NULL;
+    xmlBuffer *pXmlBuffer = NULL;
     int sendMultipleResponses = CPD_NOK;
 
-    CPD_LOG(CPD_LOG_ID_TXT , "\n  %u: %s(%u)\n", getMsecTime(), __FUNCTION__, pCpd->request.dbgStats.posRequestId);
-    LOGD("%u: %s(%u)", getMsecTime(), __FUNCTION__, pCpd->request.dbgStats.posRequestId);
+    CPD_LOG(CPD_LOG_ID_TXT , "\n  %u: %s(%u)\n", getMsecTime(), __FUNCTION__, pRequest->dbgStats.posRequestId);
+    LOGD("%u: %s(%u)", getMsecTime(), __FUNCTION__, pRequest->dbgStats.posRequestId);
     CPD_LOG(CPD_LOG_ID_TXT , "\n Location : %f, %f, %d",
         pCpd->response.location.location_parameters.shape_data.point_alt_uncertellipse.coordinate.longitude,
         pCpd->response.location.location_parameters.shape_data.point_alt_uncertellipse.coordinate.latitude.degrees,
@@ -443,28 +966,49 @@ int cpdSendCpPositionResponseToModem(pCPD_CONTEXT pCpd)
         pCpd->response.dbgStats.posReceivedFromGps
         );
     /* is this contignous-reporting mode? */
-    if (pCpd->request.posMeas.flag == POS_MEAS_RRC) {
-        if (pCpd->request.posMeas.posMeas_u.rrc_meas.rep_crit.period_rep_crit.rep_amount == 0){
+    if (pRequest->posMeas.flag == POS_MEAS_RRC) {
+        if (pRequest->posMeas.posMeas_u.rrc_meas.rep_crit.period_rep_crit.rep_amount == 0){
             sendMultipleResponses = CPD_OK;
         }
     }
 
-    pDoc = xmlNewDoc((xmlChar *) "1.0");
-    pXmlBuffer = xmlBufferCreate();
-    pOutBuffer = xmlOutputBufferCreateBuffer(pXmlBuffer, NULL);
-
-    /* Create the XML document from data */
+    /* location and measurements are written straight from their templates, other responses are formatted through document tree */
     if (pCpd->response.flag == RESPONSE_FLAG_POS_MEAS) {
-        result = cpdXmlFormatLocation(pCpd, pDoc);
+        if (sendMultipleResponses == CPD_OK) {
+            /* periodic reporting, only values of the previous response are rewritten */
+            pContent = cpdXmlPatchLocation(pCpd, pRequest->dbgStats.posRequestId);
+        }
+        else if (cpdXmlEmitLocation(pCpd, pXml, sizeof(pXml)) > 0) {
+            pContent = pXml;
+        }
     }
     else if (pCpd->response.flag == RESPONSE_FLAG_GPS_MEAS) {
-        result = cpdXmlFormatMeasurements(pCpd, pDoc);
+        /* MS-assisted, measurements are reported as soon as GPS has them */
+        if (cpdXmlEmitMeasurements(pCpd, pXml, sizeof(pXml)) > 0) {
+            pContent = pXml;
+        }
+    }
+    if (pContent != NULL) {
+        result = CPD_OK;
+    }
+    if (pContent == NULL) {
+        /* libxml2 allocations of this response are released at once, at the end */
+        cpdXmlArenaBegin(pCpd);
+        pXmlBuffer = xmlBufferCreate();
+        result = cpdXmlFormatResponse(pCpd, pXmlBuffer);
+        if (result == CPD_OK) {
+            pContent = (char *) pXmlBuffer->content;
+        }
+        else {
+            result = CPD_ERROR;
+        }
+    }
+    if (pResponseLock != NULL) {
+        pthread_mutex_unlock(pResponseLock);
     }
     if (result == CPD_OK) {
-        /* Convert  XML Document into pXmlBuffer */
-        xmlSaveFormatFileTo(pOutBuffer, pDoc, "utf-8", 1);
         CPD_LOG(CPD_LOG_ID_TXT, "\r\npOutBuffer[");
-        CPD_LOG_DATA(CPD_LOG_ID_TXT | CPD_LOG_ID_XML_TX, (char *)pXmlBuffer->content ,strlen((char *)pXmlBuffer->content));
+        CPD_LOG_DATA(CPD_LOG_ID_TXT | CPD_LOG_ID_XML_TX, pContent, strlen(pContent));
         CPD_LOG(CPD_LOG_ID_XML_TX, "\r\n");
         CPD_LOG(CPD_LOG_ID_TXT, "]\r\n");
 
@@ -473,46 +1017,53 @@ int cpdSendCpPositionResponseToModem(pCPD_CONTEXT pCpd)
             pCpd->modemInfo.sendingCPOSat, getMsecDt(pCpd->modemInfo.sendingCPOSat),
             pCpd->modemInfo.sentCPOSok,
             sendMultipleResponses);
-        if ((pCpd->modemInfo.sentCPOSok != CPD_OK) || (sendMultipleResponses == CPD_OK)) {
+        /* each request gets as many responses as it asked for, at least one */
+        if ((pRequest->status.nResponsesSent == 0) || (cpdRequestIsFulfilled(pRequest) != CPD_OK)) {
             CPD_LOG(CPD_LOG_ID_TXT , "\n  %u: %u!= 0\n", getMsecTime(), pCpd->modemInfo.sendingCPOSat);
-            if (getMsecDt(pCpd->modemInfo.sendingCPOSat) >= 1000UL) {
+            if (getMsecDt(pCpd->modemInfo.sendingCPOSat) >= CPOS_MIN_INTERVAL) {
                 pCpd->modemInfo.sendingCPOSat = getMsecTime();
-                pCpd->modemInfo.haveResponse = 0;
-                pCpd->modemInfo.responseValue = CPD_ERROR;
-                result = cpdSendCposResponse(pCpd, (char *)pXmlBuffer->content);
+                /* returns after modem accepted the response with OK */
+                result = cpdSendCposResponse(pCpd, pContent);
                 if (result == CPD_OK) {
-                    usleep(50 * MODEM_POOL_INTERVAL); /* wait for modem response, which comes in in another thread */
-                    if ((pCpd->modemInfo.haveResponse != 0) &&
-                        (pCpd->modemInfo.responseValue == AT_RESPONSE_OK)) {
-                        pCpd->request.status.nResponsesSent++;
-                        pCpd->modemInfo.sentCPOSok = CPD_OK;
-                        pCpd->systemMonitor.processingRequest = CPD_NOK;
-                        pCpd->request.status.responseSentToModemAt = getMsecTime();
-                        if (cpdIsNumberOfResponsesSufficientForRequest(pCpd) == CPD_OK) {
-                            cpdSendAbortToGps(pCpd);
-                        }
-                    }
-                    else {
-                        result = CPD_NOK;
-                    }
+                    pRequest->status.nResponsesSent++;
+                    pCpd->modemInfo.sentCPOSok = CPD_OK;
+                    pCpd->systemMonitor.processingRequest = CPD_NOK;
+                    pRequest->status.responseSentToModemAt = getMsecTime();
                 }
-                CPD_LOG(CPD_LOG_ID_TXT , "\n %u: cpdSendCposResponse() = %d, Modem: %d, %d, CPOSsent=%d",
-                    getMsecTime(), result, pCpd->modemInfo.haveResponse, pCpd->modemInfo.responseValue, pCpd->modemInfo.sentCPOSok);
+                CPD_LOG(CPD_LOG_ID_TXT , "\n %u: cpdSendCposResponse() = %d, CPOSsent=%d",
+                    getMsecTime(), result, pCpd->modemInfo.sentCPOSok);
             }
             else {
+                result = CPD_NOK;
                 CPD_LOG(CPD_LOG_ID_TXT , "\n  %u:Not sending response to modem, dT=%u\n",
                     getMsecTime(), getMsecDt(pCpd->modemInfo.sendingCPOSat));
             }
         }
     }
 
-    xmlBufferFree(pXmlBuffer);
-
     /* Release allocated resoucrs */
-    xmlFreeDoc(pDoc);
-    //xmlOutputBufferClose(pOutBuffer);
+    if (pXmlBuffer != NULL) {
+        xmlBufferFree(pXmlBuffer);
+    }
+    cpdXmlArenaEnd(pCpd);
     CPD_LOG(CPD_LOG_ID_TXT, "\r\n %u: END %s() = %d", getMsecTime(), __FUNCTION__, result);
     LOGD("%u: END %s() = %d", getMsecTime(), __FUNCTION__, result);
     return result;
 }
 
+/*
+ * Send pCpd->response to pCpd->request, GPS is stopped once the request is fulfilled.
+ */
+int cpdSendCpPositionResponseToModem(pCPD_CONTEXT pCpd)
+{
+    unsigned int nSent = pCpd->request.status.nResponsesSent;
+    int result;
+
+    result = cpdSendCpPositionResponse(pCpd, &(pCpd->request), NULL);
+    if ((result == CPD_OK) && (pCpd->request.status.nResponsesSent != nSent) &&
+        (cpdIsNumberOfResponsesSufficientForRequest(pCpd) == CPD_OK)) {
+        cpdSendAbortToGps(pCpd);
+    }
+    return result;
+}
+
@@ -11,5 +11,7 @@
 #ifndef _CPDXMLFORMATTER_H_
 #define _CPDXMLFORMATTER_H_
 int cpdSendCpPositionResponseToModem(pCPD_CONTEXT );
+int cpdSendCpPositionResponse(pCPD_CONTEXT , pREQUEST_PARAMS , pthread_mutex_t *);
+char *cpdXmlPatchLocation(pCPD_CONTEXT , unsigned int );
 #endif   /* _CPDXMLFORMATTER_H_ */
 
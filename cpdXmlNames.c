@@ -0,0 +1,180 @@
+/*
+ * hardware/Intel/cp_daemon/cpdXmlNames.c
+ *
+ * Perfect hash lookup of 3GPP pos.xsd names listed in cpdXmlNames.h.
+ * Table is built once, on first lookup, from XML_NAMES list:
+ * names are hashed into buckets and each bucket gets a displacement that moves its names into free slots,
+ * a lookup is one hash, one table read and one string compare.
+ *
+ * Martin Junkar 09/18/2011
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#define LOG_TAG "CPDD_XN"
+
+#include "cpd.h"
+#include "cpdXmlNames.h"
+#include "cpdDebug.h"
+
+#define XML_NAMES_SLOTS         (512)   /* power of 2, > 2 x XML_NAME_COUNT */
+#define XML_NAMES_BUCKETS       (128)   /* power of 2 */
+#define XML_NAMES_MAX_SEED      (1000)
+
+static const char *xmlNameStrings[XML_NAME_COUNT] = {
+    NULL,
+#define XML_NAME(id, s) s,
+    XML_NAMES
+#undef XML_NAME
+};
+
+static unsigned char xmlNameLengths[XML_NAME_COUNT];
+static unsigned short xmlNameSlots[XML_NAMES_SLOTS];         /* slot -> XML_NAME_E, XML_NAME_NONE if empty */
+static unsigned short xmlNameDisplacement[XML_NAMES_BUCKETS];
+static unsigned int xmlNameSeed = 0;
+static pthread_once_t xmlNamesOnce = PTHREAD_ONCE_INIT;
+
+
+/*
+ * FNV-1a, <len> is set to string length when <pName> is 0 terminated (<len> < 0).
+ */
+static unsigned int cpdXmlNameHash(unsigned int seed, const xmlChar *pName, int *pLen)
+{
+    unsigned int h = 2166136261U ^ seed;
+    int i;
+
+    if (*pLen < 0) {
+        for (i = 0; pName[i] != 0; i++) {
+            h = (h ^ pName[i]) * 16777619U;
+        }
+        *pLen = i;
+    }
+    else {
+        for (i = 0; i < *pLen; i++) {
+            h = (h ^ pName[i]) * 16777619U;
+        }
+    }
+    return h;
+}
+
+#define XML_NAME_BUCKET(h)      (((h) >> 20) & (XML_NAMES_BUCKETS - 1))
+#define XML_NAME_SLOT(h, d)     (((h) ^ (d)) & (XML_NAMES_SLOTS - 1))
+
+/*
+ * Try to place all names using hash <seed>, CPD_OK if every name got its own slot.
+ */
+static int cpdXmlNamesPlace(unsigned int seed)
+{
+    unsigned int hashes[XML_NAME_COUNT];
+    unsigned char bucketSize[XML_NAMES_BUCKETS];
+    int size, b, i, j, len;
+    unsigned int d;
+
+    memset(bucketSize, 0, sizeof(bucketSize));
+    memset(xmlNameSlots, 0, sizeof(xmlNameSlots));
+    for (i = 1; i < XML_NAME_COUNT; i++) {
+        len = CPD_ERROR;
+        hashes[i] = cpdXmlNameHash(seed, (const xmlChar *) xmlNameStrings[i], &len);
+        xmlNameLengths[i] = (unsigned char) len;
+        bucketSize[XML_NAME_BUCKET(hashes[i])]++;
+    }
+
+    /* fill biggest buckets first, while there are many free slots */
+    for (size = XML_NAME_COUNT; size > 0; size--) {
+        for (b = 0; b < XML_NAMES_BUCKETS; b++) {
+            if (bucketSize[b] != size) {
+                continue;
+            }
+            for (d = 0; d < XML_NAMES_SLOTS; d++) {
+                for (i = 1; i < XML_NAME_COUNT; i++) {
+                    if (XML_NAME_BUCKET(hashes[i]) != (unsigned int) b) {
+                        continue;
+                    }
+                    if (xmlNameSlots[XML_NAME_SLOT(hashes[i], d)] != XML_NAME_NONE) {
+                        break;
+                    }
+                    xmlNameSlots[XML_NAME_SLOT(hashes[i], d)] = (unsigned short) i;
+                }
+                if (i == XML_NAME_COUNT) {
+                    break;
+                }
+                /* collision, undo names of this bucket placed with <d> */
+                for (j = 1; j < i; j++) {
+                    if ((XML_NAME_BUCKET(hashes[j]) == (unsigned int) b) &&
+                        (xmlNameSlots[XML_NAME_SLOT(hashes[j], d)] == j)) {
+                        xmlNameSlots[XML_NAME_SLOT(hashes[j], d)] = XML_NAME_NONE;
+                    }
+                }
+            }
+            if (d == XML_NAMES_SLOTS) {
+                return CPD_NOK;
+            }
+            xmlNameDisplacement[b] = (unsigned short) d;
+        }
+    }
+    return CPD_OK;
+}
+
+static void cpdXmlNamesInit(void)
+{
+    unsigned int seed;
+
+    for (seed = 0; seed < XML_NAMES_MAX_SEED; seed++) {
+        if (cpdXmlNamesPlace(seed) == CPD_OK) {
+            xmlNameSeed = seed;
+            LOGD("%d XML names, hash seed %u", XML_NAME_COUNT - 1, seed);
+            return;
+        }
+    }
+    /* every lookup will return XML_NAME_NONE */
+    memset(xmlNameSlots, 0, sizeof(xmlNameSlots));
+    LOGE("Can not build XML name table");
+    CPD_LOG(CPD_LOG_ID_TXT | CPD_LOG_ID_CONSOLE, "\nCan not build XML name table");
+}
+
+static XML_NAME_E cpdXmlNameFind(const xmlChar *pName, int len)
+{
+    unsigned int h;
+    int id;
+
+    if (pName == NULL) {
+        return XML_NAME_NONE;
+    }
+    pthread_once(&xmlNamesOnce, cpdXmlNamesInit);
+    h = cpdXmlNameHash(xmlNameSeed, pName, &len);
+    id = xmlNameSlots[XML_NAME_SLOT(h, xmlNameDisplacement[XML_NAME_BUCKET(h)])];
+    if ((id != XML_NAME_NONE) && (xmlNameLengths[id] == len) &&
+        (memcmp(pName, xmlNameStrings[id], len) == 0)) {
+        return (XML_NAME_E) id;
+    }
+    return XML_NAME_NONE;
+}
+
+/*
+ * Id of the 0 terminated name <pName>, XML_NAME_NONE if <pName> is not in XML_NAMES list (or NULL).
+ */
+XML_NAME_E cpdXmlNameLookup(const xmlChar *pName)
+{
+    return cpdXmlNameFind(pName, CPD_ERROR);
+}
+
+/*
+ * Id of the name in the first <len> characters of <pName>, for example attribute value from SAX parser.
+ */
+XML_NAME_E cpdXmlNameLookupLen(const xmlChar *pName, int len)
+{
+    if (len < 0) {
+        return XML_NAME_NONE;
+    }
+    return cpdXmlNameFind(pName, len);
+}
+
+const char *cpdXmlNameString(XML_NAME_E id)
+{
+    if ((id <= XML_NAME_NONE) || (id >= XML_NAME_COUNT)) {
+        return NULL;
+    }
+    return xmlNameStrings[id];
+}
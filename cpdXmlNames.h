@@ -0,0 +1,294 @@
+/*
+ * hardware/Intel/cp_daemon/cpdXmlNames.h
+ *
+ * Element names, attribute names and enumerated literals of 3GPP pos.xsd (+CPOSR/+CPOS XML).
+ * header file for cpdXmlNames.c
+ *
+ * Martin Junkar 09/18/2011
+ *
+ */
+
+#ifndef _CPDXMLNAMES_H_
+#define _CPDXMLNAMES_H_
+
+#include <libxml/xmlstring.h>
+
+/*
+ * XML_NAME(id, string), one entry for each distinct name.
+ * The same string is used as element name and as a literal in some places (for example "ms_based"),
+ * it is listed only once. Lookup table is built from this list, new names only need to be added here.
+ */
+#define XML_NAMES \
+    /* elements: <pos> and its children */ \
+    XML_NAME(pos,                               "pos") \
+    XML_NAME(location,                          "location") \
+    XML_NAME(assist_data,                       "assist_data") \
+    XML_NAME(pos_meas,                          "pos_meas") \
+    XML_NAME(GPS_meas,                          "GPS_meas") \
+    XML_NAME(GPS_assist_req,                    "GPS_assist_req") \
+    XML_NAME(msg,                               "msg") \
+    XML_NAME(pos_err,                           "pos_err") \
+    /* elements: location */ \
+    XML_NAME(time_of_fix,                       "time_of_fix") \
+    XML_NAME(time,                              "time") \
+    XML_NAME(location_parameters,               "location_parameters") \
+    XML_NAME(shape_data,                        "shape_data") \
+    XML_NAME(coordinate,                        "coordinate") \
+    XML_NAME(latitude,                          "latitude") \
+    XML_NAME(north,                             "north") \
+    XML_NAME(degrees,                           "degrees") \
+    XML_NAME(longitude,                         "longitude") \
+    XML_NAME(altitude,                          "altitude") \
+    XML_NAME(height_above_surface,              "height_above_surface") \
+    XML_NAME(height,                            "height") \
+    XML_NAME(uncert_circle,                     "uncert_circle") \
+    XML_NAME(uncert_ellipse,                    "uncert_ellipse") \
+    XML_NAME(uncert_semi_major,                 "uncert_semi_major") \
+    XML_NAME(uncert_semi_minor,                 "uncert_semi_minor") \
+    XML_NAME(orient_major,                      "orient_major") \
+    XML_NAME(confidence,                        "confidence") \
+    XML_NAME(uncert_alt,                        "uncert_alt") \
+    XML_NAME(inner_rad,                         "inner_rad") \
+    XML_NAME(uncert_rad,                        "uncert_rad") \
+    XML_NAME(offset_angle,                      "offset_angle") \
+    XML_NAME(included_angle,                    "included_angle") \
+    XML_NAME(direction,                         "direction") \
+    /* elements and literals: shape types */ \
+    XML_NAME(ellipsoid_point,                   "ellipsoid_point") \
+    XML_NAME(ellipsoid_point_uncert_circle,     "ellipsoid_point_uncert_circle") \
+    XML_NAME(ellipsoid_point_uncert_ellipse,    "ellipsoid_point_uncert_ellipse") \
+    XML_NAME(polygon,                           "polygon") \
+    XML_NAME(ellipsoid_point_alt,               "ellipsoid_point_alt") \
+    XML_NAME(ellipsoid_point_alt_uncertellipse, "ellipsoid_point_alt_uncertellipse") \
+    XML_NAME(ellips_arc,                        "ellips_arc") \
+    /* elements: GPS_assist */ \
+    XML_NAME(GPS_assist,                        "GPS_assist") \
+    XML_NAME(ref_time,                          "ref_time") \
+    XML_NAME(GPS_time,                          "GPS_time") \
+    XML_NAME(GPS_TOW_msec,                      "GPS_TOW_msec") \
+    XML_NAME(GPS_week,                          "GPS_week") \
+    XML_NAME(GPS_TOW_assist,                    "GPS_TOW_assist") \
+    XML_NAME(tlm_word,                          "tlm_word") \
+    XML_NAME(anti_sp,                           "anti_sp") \
+    XML_NAME(alert,                             "alert") \
+    XML_NAME(tlm_res,                           "tlm_res") \
+    XML_NAME(nav_model_elem,                    "nav_model_elem") \
+    XML_NAME(sat_id,                            "sat_id") \
+    XML_NAME(sat_status,                        "sat_status") \
+    XML_NAME(ephem_and_clock,                   "ephem_and_clock") \
+    XML_NAME(l2_code,                           "l2_code") \
+    XML_NAME(ura,                               "ura") \
+    XML_NAME(sv_health,                         "sv_health") \
+    XML_NAME(iodc,                              "iodc") \
+    XML_NAME(l2p_flag,                          "l2p_flag") \
+    XML_NAME(esr1,                              "esr1") \
+    XML_NAME(esr2,                              "esr2") \
+    XML_NAME(esr3,                              "esr3") \
+    XML_NAME(esr4,                              "esr4") \
+    XML_NAME(tgd,                               "tgd") \
+    XML_NAME(toc,                               "toc") \
+    XML_NAME(af2,                               "af2") \
+    XML_NAME(af1,                               "af1") \
+    XML_NAME(af0,                               "af0") \
+    XML_NAME(crs,                               "crs") \
+    XML_NAME(delta_n,                           "delta_n") \
+    XML_NAME(m0,                                "m0") \
+    XML_NAME(cuc,                               "cuc") \
+    XML_NAME(ecc,                               "ecc") \
+    XML_NAME(cus,                               "cus") \
+    XML_NAME(power_half,                        "power_half") \
+    XML_NAME(toe,                               "toe") \
+    XML_NAME(fit_flag,                          "fit_flag") \
+    XML_NAME(aoda,                              "aoda") \
+    XML_NAME(cic,                               "cic") \
+    XML_NAME(omega0,                            "omega0") \
+    XML_NAME(cis,                               "cis") \
+    XML_NAME(i0,                                "i0") \
+    XML_NAME(crc,                               "crc") \
+    XML_NAME(omega,                             "omega") \
+    XML_NAME(omega_dot,                         "omega_dot") \
+    XML_NAME(idot,                              "idot") \
+    XML_NAME(ionospheric_model,                 "ionospheric_model") \
+    XML_NAME(UTC_model,                         "UTC_model") \
+    XML_NAME(almanac,                           "almanac") \
+    XML_NAME(acqu_assist,                       "acqu_assist") \
+    XML_NAME(GPS_rt_integrity,                  "GPS_rt_integrity") \
+    XML_NAME(DGPS_corrections,                  "DGPS_corrections") \
+    /* elements: pos_meas */ \
+    XML_NAME(meas_abort,                        "meas_abort") \
+    XML_NAME(RRLP_meas,                         "RRLP_meas") \
+    XML_NAME(RRLP_pos_instruct,                 "RRLP_pos_instruct") \
+    XML_NAME(RRLP_method_type,                  "RRLP_method_type") \
+    XML_NAME(RRLP_method,                       "RRLP_method") \
+    XML_NAME(resp_time_seconds,                 "resp_time_seconds") \
+    XML_NAME(mult_sets,                         "mult_sets") \
+    XML_NAME(method_accuracy,                   "method_accuracy") \
+    XML_NAME(uncertainty,                       "uncertainty") \
+    XML_NAME(RRC_meas,                          "RRC_meas") \
+    XML_NAME(rep_quant,                         "rep_quant") \
+    XML_NAME(RRC_method_type,                   "RRC_method_type") \
+    XML_NAME(RRC_method,                        "RRC_method") \
+    XML_NAME(hor_acc,                           "hor_acc") \
+    XML_NAME(vert_acc,                          "vert_acc") \
+    XML_NAME(rep_crit,                          "rep_crit") \
+    XML_NAME(no_rep,                            "no_rep") \
+    XML_NAME(event_rep_crit,                    "event_rep_crit") \
+    XML_NAME(period_rep_crit,                   "period_rep_crit") \
+    XML_NAME(event_par,                         "event_par") \
+    XML_NAME(meas_interval,                     "meas_interval") \
+    XML_NAME(tr_pos_chg,                        "tr_pos_chg") \
+    XML_NAME(tr_SFN_SFN_chg,                    "tr_SFN_SFN_chg") \
+    XML_NAME(tr_SFN_GPS_TOW,                    "tr_SFN_GPS_TOW") \
+    /* elements: GPS_meas */ \
+    XML_NAME(ref_time_only,                     "ref_time_only") \
+    XML_NAME(meas_params,                       "meas_params") \
+    XML_NAME(carr2_noise,                       "carr2_noise") \
+    XML_NAME(dopl,                              "dopl") \
+    XML_NAME(whole_chips,                       "whole_chips") \
+    XML_NAME(fract_chips,                       "fract_chips") \
+    XML_NAME(multi_path,                        "multi_path") \
+    XML_NAME(psr_rms_err,                       "psr_rms_err") \
+    /* elements: msg, pos_err */ \
+    XML_NAME(err_reason,                        "err_reason") \
+    /* attributes */ \
+    XML_NAME(literal,                           "literal") \
+    XML_NAME(status,                            "status") \
+    XML_NAME(gps_timing_of_cell_wanted,         "gps_timing_of_cell_wanted") \
+    XML_NAME(addl_assist_data_req,              "addl_assist_data_req") \
+    XML_NAME(rep_amount,                        "rep_amount") \
+    XML_NAME(rep_interval_long,                 "rep_interval_long") \
+    /* literals: boolean */ \
+    XML_NAME(true,                              "true") \
+    XML_NAME(false,                             "false") \
+    /* literals: method type */ \
+    XML_NAME(ms_assisted,                       "ms_assisted") \
+    XML_NAME(ms_assisted_pref,                  "ms_assisted_pref") \
+    XML_NAME(ue_assisted,                       "ue_assisted") \
+    XML_NAME(ue_assisted_pref,                  "ue_assisted_pref") \
+    XML_NAME(ms_based,                          "ms_based") \
+    XML_NAME(ms_based_pref,                     "ms_based_pref") \
+    XML_NAME(ue_based,                          "ue_based") \
+    XML_NAME(ue_based_pref,                     "ue_based_pref") \
+    XML_NAME(ms_assisted_no_accuracy,           "ms_assisted_no_accuracy") \
+    /* literals: positioning method */ \
+    XML_NAME(gps,                               "gps") \
+    XML_NAME(otdoa,                             "otdoa") \
+    XML_NAME(otdoaOrGPS,                        "otdoaOrGPS") \
+    XML_NAME(cellID,                            "cellID") \
+    /* literals: mult_sets, msg status */ \
+    XML_NAME(multiple,                          "multiple") \
+    XML_NAME(one,                               "one") \
+    XML_NAME(assist_data_delivered,             "assist_data_delivered") \
+    /* literals: sat_status */ \
+    XML_NAME(NS_NN_U,                           "NS_NN-U") \
+    XML_NAME(ES_NN_U,                           "ES_NN-U") \
+    XML_NAME(NS_NN,                             "NS_NN") \
+    XML_NAME(ES_SN,                             "ES_SN") \
+    XML_NAME(REVD,                              "REVD") \
+    /* literals: meas_interval */ \
+    XML_NAME(e5,                                "e5") \
+    XML_NAME(e15,                               "e15") \
+    XML_NAME(e60,                               "e60") \
+    XML_NAME(e300,                              "e300") \
+    XML_NAME(e900,                              "e900") \
+    XML_NAME(e1800,                             "e1800") \
+    XML_NAME(e3600,                             "e3600") \
+    XML_NAME(e7200,                             "e7200") \
+    /* literals: rep_amount */ \
+    XML_NAME(ra1,                               "ra1") \
+    XML_NAME(ra2,                               "ra2") \
+    XML_NAME(ra4,                               "ra4") \
+    XML_NAME(ra8,                               "ra8") \
+    XML_NAME(ra16,                              "ra16") \
+    XML_NAME(ra32,                              "ra32") \
+    XML_NAME(ra64,                              "ra64") \
+    XML_NAME(ra_Infinity,                       "ra-Infinity") \
+    /* literals: rep_interval_long */ \
+    XML_NAME(ril0,                              "ril0") \
+    XML_NAME(ril0_25,                           "ril0-25") \
+    XML_NAME(ril0_5,                            "ril0-5") \
+    XML_NAME(ril1,                              "ril1") \
+    XML_NAME(ril2,                              "ril2") \
+    XML_NAME(ril3,                              "ril3") \
+    XML_NAME(ril4,                              "ril4") \
+    XML_NAME(ril6,                              "ril6") \
+    XML_NAME(ril8,                              "ril8") \
+    XML_NAME(ril12,                             "ril12") \
+    XML_NAME(ril16,                             "ril16") \
+    XML_NAME(ril20,                             "ril20") \
+    XML_NAME(ril24,                             "ril24") \
+    XML_NAME(ril28,                             "ril28") \
+    XML_NAME(ril32,                             "ril32") \
+    XML_NAME(ril64,                             "ril64") \
+    /* literals: tr_pos_chg */ \
+    XML_NAME(pc10,                              "pc10") \
+    XML_NAME(pc20,                              "pc20") \
+    XML_NAME(pc30,                              "pc30") \
+    XML_NAME(pc40,                              "pc40") \
+    XML_NAME(pc50,                              "pc50") \
+    XML_NAME(pc100,                             "pc100") \
+    XML_NAME(pc200,                             "pc200") \
+    XML_NAME(pc300,                             "pc300") \
+    XML_NAME(pc500,                             "pc500") \
+    XML_NAME(pc1000,                            "pc1000") \
+    XML_NAME(pc2000,                            "pc2000") \
+    XML_NAME(pc5000,                            "pc5000") \
+    XML_NAME(pc10000,                           "pc10000") \
+    XML_NAME(pc20000,                           "pc20000") \
+    XML_NAME(pc50000,                           "pc50000") \
+    XML_NAME(pc100000,                          "pc100000") \
+    /* literals: tr_SFN_SFN_chg */ \
+    XML_NAME(c0_25,                             "c0-25") \
+    XML_NAME(c0_5,                              "c0-5") \
+    XML_NAME(c1,                                "c1") \
+    XML_NAME(c2,                                "c2") \
+    XML_NAME(c3,                                "c3") \
+    XML_NAME(c4,                                "c4") \
+    XML_NAME(c5,                                "c5") \
+    XML_NAME(c10,                               "c10") \
+    XML_NAME(c20,                               "c20") \
+    XML_NAME(c50,                               "c50") \
+    XML_NAME(c100,                              "c100") \
+    XML_NAME(c200,                              "c200") \
+    XML_NAME(c500,                              "c500") \
+    XML_NAME(c1000,                             "c1000") \
+    XML_NAME(c2000,                             "c2000") \
+    XML_NAME(c5000,                             "c5000") \
+    /* literals: tr_SFN_GPS_TOW */ \
+    XML_NAME(ms1,                               "ms1") \
+    XML_NAME(ms2,                               "ms2") \
+    XML_NAME(ms3,                               "ms3") \
+    XML_NAME(ms5,                               "ms5") \
+    XML_NAME(ms10,                              "ms10") \
+    XML_NAME(ms20,                              "ms20") \
+    XML_NAME(ms50,                              "ms50") \
+    XML_NAME(ms100,                             "ms100") \
+    /* literals: dopl1_uncert */ \
+    XML_NAME(hz12_5,                            "hz12-5") \
+    XML_NAME(hz25,                              "hz25") \
+    XML_NAME(hz50,                              "hz50") \
+    XML_NAME(hz100,                             "hz100") \
+    XML_NAME(hz200,                             "hz200") \
+    /* literals: err_reason */ \
+    XML_NAME(undefined_error,                   "undefined_error") \
+    XML_NAME(not_enough_gps_satellites,         "not_enough_gps_satellites") \
+    XML_NAME(gps_assist_data_missing,           "gps_assist_data_missing") \
+    /* literals: multi_path */ \
+    XML_NAME(not_measured,                      "not_measured") \
+    XML_NAME(low,                               "low") \
+    XML_NAME(medium,                            "medium") \
+    XML_NAME(high,                              "high")
+
+typedef enum {
+    XML_NAME_NONE = 0,      /* not a pos.xsd name */
+#define XML_NAME(id, s) XML_NAME_##id,
+    XML_NAMES
+#undef XML_NAME
+    XML_NAME_COUNT
+} XML_NAME_E;
+
+XML_NAME_E cpdXmlNameLookup(const xmlChar * );
+XML_NAME_E cpdXmlNameLookupLen(const xmlChar * , int );
+const char *cpdXmlNameString(XML_NAME_E );
+
+#endif /* _CPDXMLNAMES_H_ */
@@ -14,49 +14,29 @@
 
 #include <errno.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <libxml/parser.h>
 #include <libxml/tree.h>
+#include <libxml/SAX2.h>
 #include <math.h>
 #define LOG_TAG "CPDD_XP"
 
 #include "cpd.h"
 #include "cpdUtil.h"
 #include "cpdXmlUtils.h"
+#include "cpdGppCodec.h"
+#include "cpdXmlNames.h"
 #include "cpdGpsComm.h"
 #include "cpdXmlFormatter.h"
+#include "cpdSession.h"
+#include "cpdAssistStore.h"
+#include "cpdXmlSaxDecoder.h"
+#include "cpdXmlArena.h"
 #include "cpdDebug.h"
 
-#define CPOSR_POS_ELEMENT             "pos"
-#define CPOSR_LOCATION_ELEMENT        "location"
-#define CPOSR_ASSIST_DATA_ELEMENT     "assist_data"
-#define CPOSR_POS_MEAS_ELEMENT        "pos_meas"
-#define CPOSR_GPS_MEAS_ELEMENT        "GPS_meas"
-#define CPOSR_GPS_ASSIST_REQ_ELEMENT  "GPS_assist_req"
-#define CPOSR_MSG_ELEMENT             "msg"
-#define CPOSR_POS_ERR_ELEMENT         "pos_err"
-
 
 extern void cpdCloseSystemPowerState(pCPD_CONTEXT );
-extern int cpdSystemActiveMonitorStart( void );
-
-static int cpdConvert3GPPHorizontalAccuracyToM(int accuracyK)
-{
-    int result;
-    double ftemp;
-    ftemp = (double) GPP_LL_UNCERT_C * (pow(GPP_LL_UNCERT_1X, accuracyK) - 1.0);
-    result = (int) ftemp;
-    return result;
-}
-
-static int cpdConvert3GPPVerticalAccuracyToM(int accuracyK)
-{
-    int result;
-    double ftemp;
-    ftemp = (double) GPP_ALT_UNCERT_C * (pow(GPP_ALT_UNCERT_1X, accuracyK) - 1.0);
-    result = (int) ftemp;
-    return result;
-}
 
 void cpdLogRequestParametersInXmlParser_t(pCPD_CONTEXT pCpd)
 {
@@ -160,76 +140,19 @@ void cpdLogRequestParametersInXmlParser_t(pCPD_CONTEXT pCpd)
 
 }
 
-void cpdSendResponseThreradHandler_t(int sig)
-{
-    switch (sig) {
-    case SIGHUP:
-    case SIGTERM:
-    case SIGQUIT:
-    case SIGUSR1:
-        pthread_exit(0);
-    }
-}
-
-
-void *cpdSendResponseThrerad_t(void *pArg)
-{
-    int result = 0;
-    int n = 10;
-    pCPD_CONTEXT pCpd;
-    struct sigaction sigact;
-
-    /* Register the SIGUSR1 signal handler */
-    memset(&sigact, 0, sizeof(sigact));
-    sigact.sa_handler = cpdSendResponseThreradHandler_t;
-    sigaction(SIGUSR1, &sigact, NULL);
-
-
-
-    pCpd = (pCPD_CONTEXT) pArg;
-    CPD_LOG(CPD_LOG_ID_TXT , "\n  %u: %s()\n", getMsecTime(), __FUNCTION__);
-    if (pCpd != NULL) {
-        while (n > 0) {
-            usleep(10000);
-
-            result = cpdSendCpPositionResponseToModem(pCpd);
-
-            if (result != CPD_NOK) {
-                break;
-            }
-            else {
-                /* wait for next retry */
-                sleep(3);
-            }
-            n--;
-        }
-    }
-    CPD_LOG(CPD_LOG_ID_TXT , "\n  %u: %s()=%d\n", getMsecTime(), __FUNCTION__, result);
-    return NULL;
-}
-
 void cpdCreatePositionResponse_t(pCPD_CONTEXT pCpd)
 {
     pLOCATION pLoc;
-    int n = 7;
-    int result = CPD_NOK;
     static int nRun = 0;
     double lla;
-    static pthread_t sendThread = 0;
 
 
-    if (pCpd->request.flag == REQUEST_FLAG_POS_MEAS) {
-        if (pCpd->request.posMeas.flag == POS_MEAS_ABORT) {
-            if (sendThread != 0) {
-                pthread_kill(pCpd->systemMonitor.monitorThread, SIGUSR1);
-                usleep(1000);
-            }
-        }
-    }
     if ((pCpd->request.posMeas.flag == POS_MEAS_RRLP) ||
         (pCpd->request.posMeas.flag == POS_MEAS_RRC)) {
 
 
+        pthread_mutex_lock(&(pCpd->responseSender.lock));
+        pCpd->response.flag = RESPONSE_FLAG_POS_MEAS;
         pLoc = &(pCpd->response.location);
         memset(pLoc, 0, sizeof(LOCATION));
         CPD_LOG(CPD_LOG_ID_TXT , "\n  %u: %s()\n", getMsecTime(), __FUNCTION__);
@@ -270,11 +193,8 @@ void cpdCreatePositionResponse_t(pCPD_CONTEXT pCpd)
                 pLoc->location_parameters.shape_data.point_alt_uncertellipse.coordinate.latitude.degrees + (rand() % 200);
         }
 #endif
-        if (sendThread != 0) {
-            pthread_kill(pCpd->systemMonitor.monitorThread, SIGUSR1);
-            usleep(1000);
-        }
-        result = pthread_create(&(sendThread), NULL, cpdSendResponseThrerad_t, (void *) pCpd);
+        cpdSessionFanOut(pCpd);
+        pthread_mutex_unlock(&(pCpd->responseSender.lock));
     }
 }
 
@@ -384,17 +304,24 @@ static int xmlNodeGetChildNameCount(xmlNode *parent, const char *child_name)
 
 
 /*
- * Return value stored in <node>.
- * Must use xmlFree() to fee retuned string!!!!
+ * Return integer value stored in child <child_name> of <parent>.
+ * CPD_ERROR if there is no such child or it has no text, text is not copied.
  */
-static xmlChar *xmlNodeGetChildString(xmlDoc *pDoc, xmlNode *parent, const char *child_name)
+static int xmlNodeGetChildInt(xmlNode *parent, const char *child_name)
 {
-    xmlChar *value = NULL;
+    int value = CPD_ERROR;
     xmlNode *node;
+    xmlNode *pText;
 
     node = xmlNodeGetChild(parent, child_name);
     if (node != NULL) {
-        value = xmlNodeListGetString(pDoc, node->xmlChildrenNode, 1);
+        for (pText = node->xmlChildrenNode; pText != NULL; pText = pText->next) {
+            if ((pText->type == XML_TEXT_NODE) || (pText->type == XML_CDATA_SECTION_NODE) ||
+                (pText->type == XML_ENTITY_REF_NODE)) {
+                xmlNodeGetInt(node, &value);
+                break;
+            }
+        }
     }
 
     return value;
@@ -433,31 +360,13 @@ static xmlChar *xmlNodeGetChildProperty(xmlNode *parent, const char *child_name,
 }
 
 /*
- * 1. convert an xml string to XML_PARSER_METHOD_TYPE_*
+ * convert XML_NAME_E (rrlp_method literal) to RRLP_METHOD_T
  */
-static int cpdXmlStrTo_gpp_method_type(const xmlChar *value)
+int cpdXmlNameTo_rrlp_method(XML_NAME_E name)
 {
-    int result = GPP_METHOD_TYPE_NONE;
-    if (value == NULL) {
-       return result;
-    }
-
-    if ((!xmlStrcmp(value,  (xmlChar *) "ms_assisted")) ||
-        (!xmlStrcmp(value, (xmlChar *) "ms_assisted_pref")) ||
-        (!xmlStrcmp(value, (xmlChar *) "ue_assisted")) ||
-        (!xmlStrcmp(value, (xmlChar *) "ue_assisted_pref")))
-    {
-        result = GPP_METHOD_TYPE_MS_ASSISTED;
-    }
-    else if ((!xmlStrcmp(value, (xmlChar *) "ms_based")) ||
-             (!xmlStrcmp(value, (xmlChar *) "ms_based_pref")) ||
-             (!xmlStrcmp(value, (xmlChar *) "ue_based")) ||
-             (!xmlStrcmp(value, (xmlChar *) "ue_based_pref")))
-    {
-        result = GPP_METHOD_TYPE_MS_BASED;
-    }
-    else if (!xmlStrcmp(value, (xmlChar *) "ms_assisted_no_accuracy")) {
-        result = GPP_METHOD_TYPE_MS_ASSISTED_NO_ACCURACY;
+    int result = RRLP_METHOD_NONE;
+    if (name == XML_NAME_gps) {
+        result = RRLP_METHOD_GPS;
     }
     return result;
 }
@@ -468,14 +377,7 @@ static int cpdXmlStrTo_gpp_method_type(const xmlChar *value)
  */
 int cpdXmlStringTo_rrlp_method(xmlChar *value)
 {
-    int result = RRLP_METHOD_NONE;
-    if (value == NULL) {
-       return result;
-    }
-    if (xmlStrcmp(value, (xmlChar *) "gps") == 0) {
-        result = RRLP_METHOD_GPS;
-    }
-    return result;
+    return cpdXmlNameTo_rrlp_method(cpdXmlNameLookup(value));
 }
 
 static int cposXmlStringTo_mult_sets(xmlChar *value)
@@ -485,108 +387,20 @@ static int cposXmlStringTo_mult_sets(xmlChar *value)
        return result;
     }
 
-    if (!xmlStrcmp(value, (xmlChar *) "multiple")) {
-        result = MULT_SETS_MULTIPLE;
-    }
-    else if (!xmlStrcmp(value, (xmlChar *) "one")) {
-        result = MULT_SETS_ONE;
-    }
-
-    return result;
-}
-
-int cpdAddTextToXmlBuffer(pCPD_CONTEXT pCpd, char *pB, int len)
-{
-    int result = CPD_NOK;
-    int available;
-    /* copy data into the main buffer */
-    available = pCpd->xmlRxBuffer.xmlBufferSize - pCpd->xmlRxBuffer.xmlBufferIndex - 1;
-
-    if (len > available) {
-        LOGE("%s(), Not enough space in XML buffer!!!, %d, %d", __FUNCTION__, available, len);
-        len = available;
-        CPD_LOG(CPD_LOG_ID_TXT, "Not enough space in XML buffer!!!\n");
-    }
-    else {
-        available = len;
-    }
-
-    if (pCpd->xmlRxBuffer.xmlBufferIndex == 0) {
-        if (pB[0] != XML_START_CHAR) {
-            CPD_LOG(CPD_LOG_ID_TXT,"\n!!!Invalid Start for XML file\n");
-            LOGE("!!!Invalid Start for XML file");
-            return len;
-        }
-    }
-
-    pCpd->modemInfo.receivingXml = CPD_OK;
-
-    memcpy((pCpd->xmlRxBuffer.pXmlBuffer + pCpd->xmlRxBuffer.xmlBufferIndex), pB, available);
-    pCpd->xmlRxBuffer.xmlBufferIndex =  pCpd->xmlRxBuffer.xmlBufferIndex + available;
-    pCpd->xmlRxBuffer.pXmlBuffer[pCpd->xmlRxBuffer.xmlBufferIndex] = 0;
-    CPD_LOG(CPD_LOG_ID_TXT, "\nAdded %d bytes to XML buffer", len);
-    LOGD("Added %d bytes to XML buffer", len);
-    return available;
-}
-
-/*
- * Check if XML buffer contains old data.
- * This is a sign that previous XML document was never completed.
- * Clear old data, if needed.
- */
-int cpdClearOldXmlData(pXML_BUFFER pXmlBuff)
-{
-    int result = CPD_OK;
-    unsigned int tNow = get_msec_time_now();
-    unsigned int dT;
-    if ((pXmlBuff->lastUpdate == 0) || (pXmlBuff->maxAge == 0)) {
-        return result;
-    }
-    if (pXmlBuff->lastUpdate != 0) {
-        if ( getMsecDt(pXmlBuff->lastUpdate) > pXmlBuff->maxAge) {
-            pXmlBuff->pXmlBuffer[0] = 0;
-            pXmlBuff->xmlBufferIndex = 0;
-            pXmlBuff->lastUpdate = 0;
-            return CPD_NOK;
-
-        }
+    switch (cpdXmlNameLookup(value)) {
+        case XML_NAME_multiple:
+            result = MULT_SETS_MULTIPLE;
+            break;
+        case XML_NAME_one:
+            result = MULT_SETS_ONE;
+            break;
+        default:
+            break;
     }
-    return result;
-}
 
-/*
- * Check if xml buffer looks like a complete XML document.
- * This is to avoid parsing XML buffer if it is obvious that this is not full/complete XML document.
- * return:
- *          CPD_OK if buffer looks like closed XML document
- *          CPD_NOK if buffer does not look like closed XML document.
- */
-int cpdIsXmlClosed(char *pB, int len)
-{
-    int result = CPD_NOK;
-    int i, j;
-    if (len < 2) {
-        CPD_LOG(CPD_LOG_ID_TXT,"\nXML is too short");
-        return result;
-    }
-    i = 0;
-    while ((pB[i] == ' ') || (pB[i] == AT_CMD_CR_CHR) || (pB[i] == AT_CMD_LF_CHR)) {
-        i++;
-    }
-    j = len - 1;
-    while ((pB[j] == ' ') || (pB[j] == AT_CMD_CR_CHR) || (pB[j] == AT_CMD_LF_CHR)) {
-        j--;
-    }
-    if ((pB[i] == XML_START_CHAR) && (pB[j] == XML_END_CHAR)) {
-        result = CPD_OK;
-    }
-    CPD_LOG(CPD_LOG_ID_TXT,"\nXML[%d]=%c, XML[%d]=%c", i, pB[i], j, pB[j]);
     return result;
 }
 
-
-
-
 /*
  * Parse "ref_time" element
  */
@@ -693,17 +507,14 @@ int cpdXmlParse_ellipsoid_point_alt_uncertellipse(xmlDoc *pDoc, xmlNode *pParent
         xmlNodeGetLong(pNode, &ltemp);
         /* Convert 3GGP value into degrees */
         CPD_LOG(CPD_LOG_ID_TXT ,"\n degrees=%d, %08X, N=%d\n", ltemp, ltemp, pEllipse->coordinate.latitude.degrees);
-        pEllipse->coordinate.latitude.degrees = ((double) ltemp) * LATITUDE_GPP_TO_FLOAT;
-        if (pEllipse->coordinate.latitude.north == 1) {
-            pEllipse->coordinate.latitude.degrees =  -pEllipse->coordinate.latitude.degrees;
-        }
+        pEllipse->coordinate.latitude.degrees = cpdGppLatitudeToDegrees(pEllipse->coordinate.latitude.north, ltemp);
         CPD_LOG(CPD_LOG_ID_TXT ,"\nLatitude=%f", pEllipse->coordinate.latitude.degrees);
     }
     pNode = xmlNodeGetNode(pParent, "longitude");
     if (pNode != NULL) {
         xmlNodeGetLong(pNode, &ltemp);
         /* Convert 3GGP value into degrees */
-        pEllipse->coordinate.longitude = ((double) ltemp) * LONGITUDE_GPP_TO_FLOAT; //(90777.39816);
+        pEllipse->coordinate.longitude = cpdGppLongitudeToDegrees(ltemp);
         CPD_LOG(CPD_LOG_ID_TXT ,"\nLongitude=%d, %08X, %f\n", ltemp, ltemp, pEllipse->coordinate.longitude);
         LOGD("Longitude=%ld %08X, %f", ltemp, (unsigned int)ltemp, pEllipse->coordinate.longitude);
     }
@@ -720,14 +531,14 @@ int cpdXmlParse_ellipsoid_point_alt_uncertellipse(xmlDoc *pDoc, xmlNode *pParent
         xmlNodeGetInt(pNode, &(pEllipse->uncert_semi_major));
 //        dtemp = GPP_LL_UNCERT_C * (pow(GPP_LL_UNCERT_1X, (double) pEllipse->uncert_semi_major) - 1.0);
 //        pEllipse->uncert_semi_major = (int) dtemp;
-        pEllipse->uncert_semi_major = cpdConvert3GPPHorizontalAccuracyToM(pEllipse->uncert_semi_major);
+        pEllipse->uncert_semi_major = cpdGppHorizontalUncertToM(pEllipse->uncert_semi_major);
     }
     pNode = xmlNodeGetNode(pParent, "uncert_semi_minor");
     if (pNode != NULL) {
         xmlNodeGetInt(pNode, &(pEllipse->uncert_semi_minor));
 //        dtemp = GPP_LL_UNCERT_C * (pow(GPP_LL_UNCERT_1X, (double) pEllipse->uncert_semi_minor) - 1.0);
 //        pEllipse->uncert_semi_minor = (int) dtemp;
-        pEllipse->uncert_semi_minor = cpdConvert3GPPHorizontalAccuracyToM(pEllipse->uncert_semi_minor);
+        pEllipse->uncert_semi_minor = cpdGppHorizontalUncertToM(pEllipse->uncert_semi_minor);
     }
     pNode = xmlNodeGetNode(pParent, "orient_major");
     if (pNode != NULL) {
@@ -736,13 +547,14 @@ int cpdXmlParse_ellipsoid_point_alt_uncertellipse(xmlDoc *pDoc, xmlNode *pParent
     pNode = xmlNodeGetNode(pParent, "confidence");
     if (pNode != NULL) {
         xmlNodeGetInt(pNode, &(pEllipse->confidence));
+        pEllipse->confidence = cpdGppConfidence(pEllipse->confidence);
     }
     pNode = xmlNodeGetNode(pParent, "uncert_alt");
     if (pNode != NULL) {
         xmlNodeGetInt(pNode, &(pEllipse->uncert_alt));
 //        dtemp = GPP_ALT_UNCERT_C * (pow(GPP_ALT_UNCERT_1X, (double) pEllipse->uncert_alt) - 1.0);
 //        pEllipse->uncert_alt = dtemp;
-        pEllipse->uncert_alt = cpdConvert3GPPVerticalAccuracyToM(pEllipse->uncert_alt);
+        pEllipse->uncert_alt = cpdGppVerticalUncertToM(pEllipse->uncert_alt);
     }
     CPD_LOG(CPD_LOG_ID_TXT , "POINT_ALT_UNCERTELLIPSE,%d,%f,%f,%d,%d,%d,%d,%d,%d,%d\n",
         pEllipse->coordinate.latitude.north,
@@ -1047,8 +859,7 @@ static int cpdXmlParse_RRLP_meas(xmlDoc *pDoc, xmlNode *pStartNode, pRRLP_MEAS p
     pRrlpMeas->RRLP_method = cpdXmlStringTo_rrlp_method(pS);
     xmlFree(pS);
 
-    pS = xmlNodeGetChildString(pDoc, pNode, "resp_time_seconds");
-    pRrlpMeas->resp_time_seconds = xmlStringToInt(pS);
+    pRrlpMeas->resp_time_seconds = xmlNodeGetChildInt(pNode, "resp_time_seconds");
 
     pS = xmlNodeGetChildProperty(pNode, "mult_sets", "literal");
     pRrlpMeas->mult_sets = cposXmlStringTo_mult_sets(pS);
@@ -1065,15 +876,15 @@ static int cpdXmlParse_RRLP_meas(xmlDoc *pDoc, xmlNode *pStartNode, pRRLP_MEAS p
         CPD_LOG(CPD_LOG_ID_TXT, "Can't find method_type\n");
         return result;
     }
-    pRrlpMeas->method_type = cpdXmlStrTo_gpp_method_type(pN->name);
+    pRrlpMeas->method_type = xmlStringTo3GPP_method_type(pN->name);
 
     pN = xmlNodeGetChild(pN, "method_accuracy");
     if (pN == NULL) {
         CPD_LOG(CPD_LOG_ID_TXT, "Can't find method_accuracy\n");
         return result;
     }
-    pRrlpMeas->accurancy = xmlStringToInt(xmlNodeGetChildString(pDoc, pN, "uncertainty"));
-    pRrlpMeas->accurancy = cpdConvert3GPPHorizontalAccuracyToM(pRrlpMeas->accurancy);
+    pRrlpMeas->accurancy = xmlNodeGetChildInt(pN, "uncertainty");
+    pRrlpMeas->accurancy = cpdGppHorizontalUncertToM(pRrlpMeas->accurancy);
 
     CPD_LOG(CPD_LOG_ID_TXT , "\r\nRRLP_MEAS,%d, %d, %d, %d, %d\n",
         pRrlpMeas->method_type,
@@ -1117,7 +928,7 @@ static int cpdXmlParse_RRC_meas(xmlDoc *pDoc, xmlNode *pStartNode, pRRC_MEAS pRr
     pRrcMeas->rep_quant.addl_assist_data_req = xmlStringToBool(pS);
 
     pS = xmlNodeGetChildProperty(pStartNode, "RRC_method_type", "literal");
-    pRrcMeas->rep_quant.RRC_method_type = cpdXmlStrTo_gpp_method_type(pS);
+    pRrcMeas->rep_quant.RRC_method_type = xmlStringTo3GPP_method_type(pS);
     xmlFree(pS);
 
     pS = xmlNodeGetChildProperty(pStartNode, "RRC_method", "literal");
@@ -1126,7 +937,7 @@ static int cpdXmlParse_RRC_meas(xmlDoc *pDoc, xmlNode *pStartNode, pRRC_MEAS pRr
 
     pNode = xmlNodeGetNode(pStartNode, "hor_acc");
     xmlNodeGetInt(pNode, &(pRrcMeas->rep_quant.hor_acc));
-    pRrcMeas->rep_quant.hor_acc = cpdConvert3GPPHorizontalAccuracyToM(pRrcMeas->rep_quant.hor_acc);
+    pRrcMeas->rep_quant.hor_acc = cpdGppHorizontalUncertToM(pRrcMeas->rep_quant.hor_acc);
 
     pS = xmlNodeGetChildProperty(pStartNode, "period_rep_crit", "rep_amount");
     pRrcMeas->rep_crit.period_rep_crit.rep_amount = xmlStringTo3GPP_rep_amount(pS);
@@ -1229,130 +1040,153 @@ static int cpdXmlParse_pos_meas(pCPD_CONTEXT pCpd, xmlDoc *pDoc, xmlNode *pParen
 }
 
 /*
- * Converts string buffer into XML document and parses it.
+ * Decode one child of <pos> element from document tree.
  */
-static int cpdXmlParseDoc(pCPD_CONTEXT pCpd, char *pB, int len)
+static int cpdXmlParsePosChild(pCPD_CONTEXT pCpd, xmlDoc *pDoc, xmlNode *pNode)
 {
-    int result = CPD_ERROR;
-    int ret;
-    xmlDocPtr pDoc;
-    xmlNode *pNode, *pRoot;
-    POS_MEAS posMeas;
+    int ret = CPD_ERROR;
 
-//    char msg[128];
+    switch (cpdXmlNameLookup(pNode->name)) {
+        case XML_NAME_assist_data:
+            ret = cpdXmlParse_assist_data(pDoc, pNode, &(pCpd->request.assist_data));
+            break;
+        case XML_NAME_pos_meas:
+            ret = cpdXmlParse_pos_meas(pCpd, pDoc, pNode);
+            break;
+        default:
+            break;
+    }
+    return ret;
+}
 
-    /* check if xml buffer contains stale data */
-    cpdClearOldXmlData(&(pCpd->xmlRxBuffer));
+/*
+ * Child <pName> of <pos> element was decoded with result <ret>.
+ */
+static int cpdXmlPosChildDone(pCPD_CONTEXT pCpd, const xmlChar *pName, int ret)
+{
+    pCpd->modemInfo.receivedCPOSRat = getMsecTime();
+    pCpd->modemInfo.processingCPOSRat = 0;
+    pCpd->modemInfo.sendingCPOSat = 0;
+    switch (cpdXmlNameLookup(pName)) {
+        case XML_NAME_assist_data:
+            pCpd->systemMonitor.processingRequest = CPD_OK; /* disable power management during request processing */
+            if (ret == CPD_OK) {
+                pCpd->request.flag = REQUEST_FLAG_ASSIST_DATA;
+            }
+            break;
+        case XML_NAME_pos_meas:
+            pCpd->systemMonitor.processingRequest = CPD_OK; /* disable power management during request processing */
+            if (ret == CPD_OK) {
+                pCpd->request.flag = REQUEST_FLAG_POS_MEAS;
+                pCpd->xmlRxParser.posMeasDecoded = CPD_OK;
+            }
+            break;
+        case XML_NAME_location:
+        case XML_NAME_GPS_meas:
+        case XML_NAME_GPS_assist_req:
+        case XML_NAME_msg:
+        case XML_NAME_pos_err:
+            CPD_LOG(CPD_LOG_ID_TXT, "\r\n !!! Decode for %s not handled yet\n", (char *)pName);
+            break;
+        default:
+            CPD_LOG(CPD_LOG_ID_TXT, "\r\n !!! Invalid XML format (Unknown command : %s)!\n", (char *)pName);
+            break;
+    }
+    return ret;
+}
 
+/*
+ * XML_DECODE_VERIFY: request is saved before streaming decoder starts on a child of <pos>.
+ */
+static void cpdXmlVerifyStart(pCPD_CONTEXT pCpd)
+{
+    pXML_RX_PARSER pParser = &(pCpd->xmlRxParser);
 
-    result = cpdAddTextToXmlBuffer(pCpd, pB, len);
-    if (result == len) {
-        result = CPD_OK;
+    if (pParser->pVerify == NULL) {
+        pParser->pVerify = malloc(2 * sizeof(REQUEST_PARAMS));
     }
-
-    if (cpdIsXmlClosed(pCpd->xmlRxBuffer.pXmlBuffer, pCpd->xmlRxBuffer.xmlBufferIndex) != CPD_OK) {
-        CPD_LOG(CPD_LOG_ID_TXT,"\nXML not closed yet");
-        return result;
+    if (pParser->pVerify != NULL) {
+        memcpy(&(pParser->pVerify[0]), &(pCpd->request), sizeof(REQUEST_PARAMS));
     }
+}
 
-    /*
-         * The document in memory - it has no base per RFC 2396,
-         * "noname.xml" argument will serve as its base.
-         */
+/*
+ * XML_DECODE_VERIFY: keep streaming decoder result, put back request as it was before it,
+ * so that document tree decoder starts from the same state.
+ */
+static void cpdXmlVerifyRestore(pCPD_CONTEXT pCpd)
+{
+    pXML_RX_PARSER pParser = &(pCpd->xmlRxParser);
 
-    pDoc = xmlReadMemory(pCpd->xmlRxBuffer.pXmlBuffer, pCpd->xmlRxBuffer.xmlBufferIndex, "noname.xml", NULL, 0);
-    if (pDoc == NULL) {
-        CPD_LOG(CPD_LOG_ID_TXT,"\nFailed to read document:");
-        CPD_LOG(CPD_LOG_ID_TXT,"[\r\n");
-        CPD_LOG_DATA(CPD_LOG_ID_TXT, pCpd->xmlRxBuffer.pXmlBuffer, pCpd->xmlRxBuffer.xmlBufferIndex);
-        CPD_LOG(CPD_LOG_ID_TXT,"]\r\n");
-        return result;
+    if (pParser->pVerify != NULL) {
+        memcpy(&(pParser->pVerify[1]), &(pCpd->request), sizeof(REQUEST_PARAMS));
+        memcpy(&(pCpd->request), &(pParser->pVerify[0]), sizeof(REQUEST_PARAMS));
     }
+}
 
-    /* Check if it is a valid XML document */
-    pRoot = xmlDocGetRootElement(pDoc);
-    if (pRoot == NULL) {
-        CPD_LOG(CPD_LOG_ID_TXT,"\nXML Failed to get the document root");
-        CPD_LOG(CPD_LOG_ID_TXT,"[\r\n");
-        CPD_LOG_DATA(CPD_LOG_ID_TXT, pCpd->xmlRxBuffer.pXmlBuffer, pCpd->xmlRxBuffer.xmlBufferIndex);
-        CPD_LOG(CPD_LOG_ID_TXT,"]\r\n");
-        xmlFreeDoc(pDoc);
-        return result;
+/*
+ * XML_DECODE_VERIFY: compare streaming decoder result against document tree decoder result.
+ * Document tree result is kept.
+ */
+static int cpdXmlVerifyCompare(pCPD_CONTEXT pCpd, const xmlChar *pName, int saxRet, int domRet)
+{
+    pXML_RX_PARSER pParser = &(pCpd->xmlRxParser);
+    pREQUEST_PARAMS pSax;
+    const unsigned char *pA;
+    const unsigned char *pB;
+    unsigned int i;
+
+    if (pParser->pVerify == NULL) {
+        return CPD_NOK;
+    }
+    pSax = &(pParser->pVerify[1]);
+    /* reception time is taken separately by each decoder */
+    pSax->assist_data.GPS_assist.ref_time.GPS_time.gpsTimeReceivedAt =
+        pCpd->request.assist_data.GPS_assist.ref_time.GPS_time.gpsTimeReceivedAt;
+    pA = (const unsigned char *) pSax;
+    pB = (const unsigned char *) &(pCpd->request);
+    for (i = 0; i < sizeof(REQUEST_PARAMS); i++) {
+        if (pA[i] != pB[i]) {
+            break;
+        }
     }
-
-    /* Check if it is a valid document type => Should start with <pos> */
-    if (xmlStrcmp(pRoot->name, (const xmlChar *) CPOSR_POS_ELEMENT)) {
-        CPD_LOG(CPD_LOG_ID_TXT,"XML root node != pos (%s)\n", (char *) pRoot->name);
-        CPD_LOG(CPD_LOG_ID_TXT,"[\r\n");
-        CPD_LOG_DATA(CPD_LOG_ID_TXT, pCpd->xmlRxBuffer.pXmlBuffer, pCpd->xmlRxBuffer.xmlBufferIndex);
-        CPD_LOG(CPD_LOG_ID_TXT,"]\r\n");
-        xmlFreeDoc(pDoc);
-        return result;
+    if ((saxRet == domRet) && (i == sizeof(REQUEST_PARAMS))) {
+        return CPD_OK;
     }
+    pParser->verifyErrors++;
+    LOGE("%s(), <%s> SAX/DOM mismatch, result %d/%d, offset %u", __FUNCTION__, (const char *) pName, saxRet, domRet, i);
+    CPD_LOG(CPD_LOG_ID_TXT | CPD_LOG_ID_CONSOLE, "\n<%s> SAX/DOM mismatch, result %d/%d, offset %u", (const char *) pName, saxRet, domRet, i);
+    return CPD_NOK;
+}
 
-    CPD_LOG(CPD_LOG_ID_TXT | CPD_LOG_ID_XML_RX,"\nXML OK:");
-    CPD_LOG(CPD_LOG_ID_TXT | CPD_LOG_ID_XML_RX,"[\r\n");
-    CPD_LOG_DATA(CPD_LOG_ID_TXT | CPD_LOG_ID_XML_RX, pCpd->xmlRxBuffer.pXmlBuffer, pCpd->xmlRxBuffer.xmlBufferIndex);
-    CPD_LOG(CPD_LOG_ID_TXT | CPD_LOG_ID_XML_RX ,"]\r\n===== clearing XML Rx buffer =====\r\n\r\n");
-
-    /* OK, got full XML, do not need data in the buffer any more */
-    pCpd->xmlRxBuffer.pXmlBuffer[0] = 0;
-    pCpd->xmlRxBuffer.xmlBufferIndex = 0;
-    pCpd->xmlRxBuffer.lastUpdate = 0;
-
-    pNode = xmlNodeGetChild(pRoot, NULL);
+/*
+ * Whole CPOSR XML document was received and decoded, pass request to GPS.
+ */
+static void cpdXmlDocDone(pCPD_CONTEXT pCpd)
+{
+    ASSIST_DATA assistData;
+    int merged;
+    int toGps = CPD_OK;
 
-    if (pNode != NULL) {
-        pCpd->modemInfo.receivedCPOSRat = getMsecTime();
-        pCpd->modemInfo.processingCPOSRat = 0;
-        pCpd->modemInfo.sendingCPOSat = 0;
-        if (!xmlStrcmp(pNode->name, (const xmlChar *) CPOSR_LOCATION_ELEMENT)) {
-            CPD_LOG(CPD_LOG_ID_TXT, "\r\n !!! Decode for %s not handled yet\n", (char *)pNode->name);
-        }
-        else if (!xmlStrcmp(pNode->name, (const xmlChar *) CPOSR_ASSIST_DATA_ELEMENT)) {
-            pCpd->systemMonitor.processingRequest = CPD_OK; /* disable power management during request processing */
-            ret = cpdXmlParse_assist_data(pDoc, pNode, &(pCpd->request.assist_data));
-            if (ret == CPD_OK) {
-                pCpd->request.flag = REQUEST_FLAG_ASSIST_DATA;
-            }
-        }
-        else if (!xmlStrcmp(pNode->name, (const xmlChar *) CPOSR_POS_MEAS_ELEMENT)) {
-            pCpd->systemMonitor.processingRequest = CPD_OK; /* disable power management during request processing */
-            ret = cpdXmlParse_pos_meas(pCpd, pDoc, pNode);
-            if (ret == CPD_OK) {
-                pCpd->request.flag = REQUEST_FLAG_POS_MEAS;
-            }
-        }
-        else if (!xmlStrcmp(pNode->name, (const xmlChar *) CPOSR_GPS_MEAS_ELEMENT)) {
-            CPD_LOG(CPD_LOG_ID_TXT, "\r\n !!! Decode for %s not handled yet\n", (char *)pNode->name);
-        }
-        else if (!xmlStrcmp(pNode->name, (const xmlChar *) CPOSR_GPS_ASSIST_REQ_ELEMENT)) {
-            CPD_LOG(CPD_LOG_ID_TXT, "\r\n !!! Decode for %s not handled yet\n", (char *)pNode->name);
-        }
-        else if (!xmlStrcmp(pNode->name, (const xmlChar *) CPOSR_MSG_ELEMENT)) {
-            CPD_LOG(CPD_LOG_ID_TXT, "\r\n !!! Decode for %s not handled yet\n", (char *)pNode->name);
-        }
-        else if (!xmlStrcmp(pNode->name, (const xmlChar *) CPOSR_POS_ERR_ELEMENT)) {
-            CPD_LOG(CPD_LOG_ID_TXT, "\r\n !!! Decode for %s not handled yet\n", (char *)pNode->name);
-        }
-        else {
-            CPD_LOG(CPD_LOG_ID_TXT, "\r\n !!! Invalid XML format (Unknown command : %s)!\n", (char *)pNode->name);
-        }
-    }
-    xmlFreeDoc(pDoc);
-    pDoc = NULL;
     pCpd->modemInfo.receivingXml = CPD_NOK;
+    if (pCpd->request.assist_data.flag != 0) {
+        cpdAssistStoreUpdate(pCpd, &(pCpd->request.assist_data));
+    }
+    if (pCpd->xmlRxParser.posMeasDecoded == CPD_OK) {
+        /* pos_meas is the request, even if it was followed by other elements */
+        pCpd->request.flag = REQUEST_FLAG_POS_MEAS;
+    }
     if (pCpd->request.flag == REQUEST_FLAG_POS_MEAS) {
         if (pCpd->request.posMeas.flag != POS_MEAS_NONE) {
             if (pCpd->request.posMeas.flag == POS_MEAS_ABORT) {
+                /* abort has no session id, responses to all sessions in progress are of no use any more */
+                cpdSessionEndAll(pCpd);
                 pCpd->request.dbgStats.posAbortId++;
                 pCpd->request.status.stopSentToGpsAt = getMsecTime();
                 pCpd->systemMonitor.processingRequest = CPD_NOK;
-                pCpd->activeMonitor.processingRequest = CPD_NOK;
             }
             if ((pCpd->request.posMeas.flag == POS_MEAS_RRLP) || (pCpd->request.posMeas.flag == POS_MEAS_RRC)) {
                 pCpd->request.dbgStats.posRequestId++;
-                cpdSystemActiveMonitorStart();
 //                cpdCloseSystemPowerState(pCpd);
             }
             pCpd->modemInfo.sentCPOSok = CPD_NOK;
@@ -1369,30 +1203,320 @@ static int cpdXmlParseDoc(pCPD_CONTEXT pCpd, char *pB, int len)
                 pCpd->request.dbgStats.posReceivedFromGps = 0;
                 pCpd->request.dbgStats.posReceivedFromGps1 = 0;
                 pCpd->request.dbgStats.posRequestedByNetwork = getMsecTime();
+            }
+            if ((pCpd->request.posMeas.flag == POS_MEAS_RRLP) || (pCpd->request.posMeas.flag == POS_MEAS_RRC)) {
+                /* new session with its own deadlines, GPS which already runs for the same method isn't restarted */
+                toGps = cpdSessionOpen(pCpd);
+            }
+            if ((toGps == CPD_OK) && (pCpd->pfCposrMessageHandlerInCpd != NULL)) {
+                /* GPS also gets stored assistance which network didn't send, request keeps what was received */
+                memcpy(&assistData, &(pCpd->request.assist_data), sizeof(ASSIST_DATA));
+                merged = cpdAssistStoreMerge(pCpd, &(pCpd->request.assist_data));
                 pCpd->pfCposrMessageHandlerInCpd(pCpd);
+                if (merged > 0) {
+                    memcpy(&(pCpd->request.assist_data), &assistData, sizeof(ASSIST_DATA));
+                }
+            }
+            else if ((toGps != CPD_OK) && (pCpd->pfCposrMessageHandlerInCpd != NULL)) {
+                /* GPS runs for a session this one joined, fresh assistance is still of use to it */
+                cpdSessionForwardAssistance(pCpd, &(pCpd->request.assist_data));
             }
         }
     }
-    return result;
 }
 
+/*
+ * SAX handlers of the push parser.
+ * XML_DECODE_SAX: elements are decoded by cpdXmlSaxDecoder.c as they are parsed, no document tree is built.
+ * XML_DECODE_DOM, XML_DECODE_VERIFY: document tree is built by default SAX2 handlers,
+ * each child of <pos> is decoded and freed as soon as its end tag is parsed.
+ */
+static void cpdXmlSaxStartElementNs(void *ctx, const xmlChar *localname, const xmlChar *prefix, const xmlChar *URI,
+                                    int nb_namespaces, const xmlChar **namespaces,
+                                    int nb_attributes, int nb_defaulted, const xmlChar **attributes)
+{
+    xmlParserCtxtPtr pCtxt = (xmlParserCtxtPtr) ctx;
+    pCPD_CONTEXT pCpd = (pCPD_CONTEXT) pCtxt->_private;
+    pXML_RX_PARSER pParser = &(pCpd->xmlRxParser);
 
-int cpdXmlParse(pCPD_CONTEXT pCpd, char *pB, int len)
+    if ((pParser->depth == 0) && (cpdXmlNameLookup(localname) != XML_NAME_pos)) {
+        CPD_LOG(CPD_LOG_ID_TXT,"XML root node != pos (%s)\n", (char *) localname);
+        xmlStopParser(pCtxt);
+        return;
+    }
+    if ((pParser->depth == 1) && (pParser->decodeMode == XML_DECODE_VERIFY)) {
+        cpdXmlVerifyStart(pCpd);
+    }
+    pParser->depth++;
+    if (pParser->decodeMode != XML_DECODE_DOM) {
+        cpdXmlSaxDecoderStart(pCpd, localname, nb_attributes, attributes);
+    }
+    if (pParser->decodeMode != XML_DECODE_SAX) {
+        xmlSAX2StartElementNs(ctx, localname, prefix, URI, nb_namespaces, namespaces, nb_attributes, nb_defaulted, attributes);
+    }
+}
+
+static void cpdXmlSaxEndElementNs(void *ctx, const xmlChar *localname, const xmlChar *prefix, const xmlChar *URI)
 {
-    int result = -1;
-    /*
+    xmlParserCtxtPtr pCtxt = (xmlParserCtxtPtr) ctx;
+    pCPD_CONTEXT pCpd = (pCPD_CONTEXT) pCtxt->_private;
+    pXML_RX_PARSER pParser = &(pCpd->xmlRxParser);
+    xmlNode *pNode;
+    int saxRet = CPD_ERROR;
+    int ret;
+
+    if (pParser->decodeMode != XML_DECODE_DOM) {
+        saxRet = cpdXmlSaxDecoderEnd(pCpd);
+    }
+    if (pParser->decodeMode != XML_DECODE_SAX) {
+        xmlSAX2EndElementNs(ctx, localname, prefix, URI);
+    }
+    pParser->depth--;
+    if (pParser->depth == 1) {
+        /* child of <pos> is complete, parser is back in <pos> */
+        ret = saxRet;
+        if (pParser->decodeMode != XML_DECODE_SAX) {
+            pNode = (pCtxt->node != NULL) ? pCtxt->node->last : NULL;
+            if ((pNode != NULL) && (pNode->type == XML_ELEMENT_NODE)) {
+                if (pParser->decodeMode == XML_DECODE_VERIFY) {
+                    cpdXmlVerifyRestore(pCpd);
+                }
+                ret = cpdXmlParsePosChild(pCpd, pCtxt->myDoc, pNode);
+                if (pParser->decodeMode == XML_DECODE_VERIFY) {
+                    cpdXmlVerifyCompare(pCpd, localname, saxRet, ret);
+                }
+                xmlUnlinkNode(pNode);
+                xmlFreeNode(pNode);
+            }
+        }
+        cpdXmlPosChildDone(pCpd, localname, ret);
+    }
+    else if (pParser->depth == 0) {
+        pParser->docClosed = CPD_OK;
+    }
+}
+
+static void cpdXmlSaxCharacters(void *ctx, const xmlChar *ch, int len)
+{
+    xmlParserCtxtPtr pCtxt = (xmlParserCtxtPtr) ctx;
+    pCPD_CONTEXT pCpd = (pCPD_CONTEXT) pCtxt->_private;
+
+    if (pCpd->xmlRxParser.decodeMode != XML_DECODE_DOM) {
+        cpdXmlSaxDecoderText(pCpd, ch, len);
+    }
+    if (pCpd->xmlRxParser.decodeMode != XML_DECODE_SAX) {
+        xmlSAX2Characters(ctx, ch, len);
+    }
+}
+
+#define XML_RX_MAX_DICT_SIZE    (4096)  /* dictionary entries before parser context is created again */
+
+/*
+ * SAX handlers of the push parser, set up once.
+ */
+static xmlSAXHandler saxHandler;
+
+/*
+ * Free parser context and its dictionary.
+ */
+static void cpdXmlRxParserFree(pXML_RX_PARSER pParser)
+{
+    xmlParserCtxtPtr pCtxt = (xmlParserCtxtPtr) pParser->pCtxt;
+
+    if (pCtxt != NULL) {
+        if (pCtxt->myDoc != NULL) {
+            xmlFreeDoc(pCtxt->myDoc);
+            pCtxt->myDoc = NULL;
+        }
+        xmlFreeParserCtxt(pCtxt);
+    }
+    if (pParser->pDict != NULL) {
+        xmlDictFree((xmlDictPtr) pParser->pDict);
+    }
+    pParser->pCtxt = NULL;
+    pParser->pDict = NULL;
+}
+
+/*
+ * Release document being received, parser context is kept for the next document.
+ */
+static void cpdXmlRxParserReset(pXML_RX_PARSER pParser)
+{
+    xmlParserCtxtPtr pCtxt = (xmlParserCtxtPtr) pParser->pCtxt;
+
+    if (pCtxt != NULL) {
+        if (pCtxt->myDoc != NULL) {
+            xmlFreeDoc(pCtxt->myDoc);
+            pCtxt->myDoc = NULL;
+        }
+        /* text of unexpected documents is interned too, don't let the dictionary grow without limit */
+        if (xmlDictSize((xmlDictPtr) pParser->pDict) > XML_RX_MAX_DICT_SIZE) {
+            LOGD("%s(), XML dictionary size %d, parser context released", __FUNCTION__, (int) xmlDictSize((xmlDictPtr) pParser->pDict));
+            cpdXmlRxParserFree(pParser);
+        }
+        else if (xmlCtxtResetPush(pCtxt, NULL, 0, "noname.xml", NULL) != 0) {
+            LOGE("%s(), xmlCtxtResetPush() failed", __FUNCTION__);
+            cpdXmlRxParserFree(pParser);
+        }
+    }
+    pParser->receiving = CPD_NOK;
+    pParser->depth = 0;
+    pParser->docClosed = CPD_NOK;
+    pParser->posMeasDecoded = CPD_NOK;
+    pParser->nBytes = 0;
+    pParser->lastUpdate = 0;
+    cpdXmlSaxDecoderReset(&(pParser->sax));
+}
+
+/*
+ * Initialize libxml2 and create push parser context used for all XML documents received with +CPOSR.
+ * Context is reset between documents, its dictionary is kept, so element and attribute names
+ * are interned only once.
+ * Called once at start up, parser is created again only if it was released after an error.
+ */
+int cpdXmlParserInit(pCPD_CONTEXT pCpd)
+{
+    static int xmlLibReady = 0;
+    pXML_RX_PARSER pParser = &(pCpd->xmlRxParser);
+    xmlParserCtxtPtr pCtxt;
+    int i;
+
+    if (pParser->pCtxt != NULL) {
+        return CPD_OK;
+    }
+    /* optional, only responses formatted as document tree take the arena, everything else gets malloc() */
+    cpdXmlArenaInit(pCpd);
+    if (xmlLibReady == 0) {
+        /*
          * this initialize the library and check potential ABI mismatches
          * between the version it was compiled for and the actual shared
          * library used.
          */
-    LIBXML_TEST_VERSION
-
+        LIBXML_TEST_VERSION
+        xmlSAXVersion(&saxHandler, 2);
+        saxHandler.startElementNs = cpdXmlSaxStartElementNs;
+        saxHandler.endElementNs = cpdXmlSaxEndElementNs;
+        saxHandler.characters = cpdXmlSaxCharacters;
+        saxHandler.ignorableWhitespace = cpdXmlSaxCharacters;
+        xmlLibReady = 1;
+    }
+    /* The document in memory - it has no base per RFC 2396, "noname.xml" argument will serve as its base. */
+    pCtxt = xmlCreatePushParserCtxt(&saxHandler, NULL, NULL, 0, "noname.xml");
+    if (pCtxt == NULL) {
+        LOGE("%s(), xmlCreatePushParserCtxt() failed", __FUNCTION__);
+        return CPD_NOK;
+    }
+    /* small text nodes are stored in the node itself, document tree is never modified */
+    xmlCtxtUseOptions(pCtxt, XML_PARSE_NONET | XML_PARSE_COMPACT);
+    pCtxt->_private = pCpd;
+    pParser->pCtxt = pCtxt;
+    pParser->pDict = pCtxt->dict;
+    xmlDictReference(pCtxt->dict);
+    for (i = XML_NAME_NONE + 1; i < XML_NAME_COUNT; i++) {
+        xmlDictLookup(pCtxt->dict, (const xmlChar *) cpdXmlNameString((XML_NAME_E) i), -1);
+    }
+    CPD_LOG(CPD_LOG_ID_TXT, "\nXML parser ready, %d names", (int) xmlDictSize(pCtxt->dict));
+    LOGD("%s(), %d names", __FUNCTION__, (int) xmlDictSize(pCtxt->dict));
+    return CPD_OK;
+}
 
-    result = cpdXmlParseDoc(pCpd, pB, len);
+/*
+ * Release parser context and libxml2, at shut down.
+ */
+void cpdXmlParserClose(pCPD_CONTEXT pCpd)
+{
+    cpdXmlRxParserReset(&(pCpd->xmlRxParser));
+    cpdXmlRxParserFree(&(pCpd->xmlRxParser));
     /*
          * Cleanup function for the XML library.
          */
     xmlCleanupParser();
+    cpdXmlArenaClose(pCpd);
+}
+
+/*
+ * Start new XML document.
+ */
+static int cpdXmlRxParserStart(pCPD_CONTEXT pCpd)
+{
+    if (cpdXmlParserInit(pCpd) != CPD_OK) {
+        return CPD_NOK;
+    }
+    cpdXmlSaxDecoderReset(&(pCpd->xmlRxParser.sax));
+    pCpd->xmlRxParser.receiving = CPD_OK;
+    pCpd->xmlRxParser.startedAt = getMsecTime();
+    return CPD_OK;
+}
+
+/*
+ * Push XML fragment received with +CPOSR into the parser.
+ * Elements are decoded as soon as they are complete, request is passed on when the document is closed.
+ */
+static int cpdXmlParseDoc(pCPD_CONTEXT pCpd, char *pB, int len)
+{
+    int result = CPD_ERROR;
+    int ret;
+    pXML_RX_PARSER pParser = &(pCpd->xmlRxParser);
+
+    /* drop document which was never completed */
+    if ((pParser->receiving == CPD_OK) && (pParser->maxAge != 0) && (getMsecDt(pParser->lastUpdate) > pParser->maxAge)) {
+        CPD_LOG(CPD_LOG_ID_TXT,"\nXML document timed out, %d bytes", pParser->nBytes);
+        LOGW("%s(), XML document timed out, %d bytes", __FUNCTION__, pParser->nBytes);
+        cpdXmlRxParserReset(pParser);
+    }
+
+    if (pParser->receiving != CPD_OK) {
+        if ((len <= 0) || (pB[0] != XML_START_CHAR)) {
+            CPD_LOG(CPD_LOG_ID_TXT,"\n!!!Invalid Start for XML file\n");
+            LOGE("!!!Invalid Start for XML file");
+            return result;
+        }
+        if (cpdXmlRxParserStart(pCpd) != CPD_OK) {
+            return result;
+        }
+    }
+    if ((pParser->nBytes + len) > XML_RX_MAX_DOC_SIZE) {
+        LOGE("%s(), XML document too big, %d, %d", __FUNCTION__, pParser->nBytes, len);
+        CPD_LOG(CPD_LOG_ID_TXT, "XML document too big!!!\n");
+        cpdXmlRxParserReset(pParser);
+        pCpd->modemInfo.receivingXml = CPD_NOK;
+        return result;
+    }
+
+    pCpd->modemInfo.receivingXml = CPD_OK;
+    pParser->nBytes = pParser->nBytes + len;
+    pParser->lastUpdate = getMsecTime();
+    CPD_LOG(CPD_LOG_ID_TXT, "\nAdded %d bytes to XML parser", len);
+    LOGD("Added %d bytes to XML parser", len);
+    CPD_LOG_DATA(CPD_LOG_ID_XML_RX, pB, len);
+
+    ret = xmlParseChunk((xmlParserCtxtPtr) pParser->pCtxt, pB, len, 0);
+    if (pParser->docClosed == CPD_OK) {
+        /* anything after the root element is not part of this document */
+        CPD_LOG(CPD_LOG_ID_TXT | CPD_LOG_ID_XML_RX,"\nXML OK: %d bytes, %u ms\r\n", pParser->nBytes, getMsecDt(pParser->startedAt));
+        cpdXmlDocDone(pCpd);
+        cpdXmlRxParserReset(pParser);
+        result = CPD_OK;
+    }
+    else if ((ret != XML_ERR_OK) || (((xmlParserCtxtPtr) pParser->pCtxt)->wellFormed == 0)) {
+        CPD_LOG(CPD_LOG_ID_TXT,"\nFailed to read document: %d, %d bytes", ret, pParser->nBytes);
+        LOGE("%s(), failed to read document: %d, %d bytes", __FUNCTION__, ret, pParser->nBytes);
+        cpdXmlRxParserReset(pParser);
+        pCpd->modemInfo.receivingXml = CPD_NOK;
+    }
+    else {
+        CPD_LOG(CPD_LOG_ID_TXT,"\nXML not closed yet");
+        result = CPD_OK;
+    }
+    return result;
+}
+
+
+int cpdXmlParse(pCPD_CONTEXT pCpd, char *pB, int len)
+{
+    int result = -1;
+
+    result = cpdXmlParseDoc(pCpd, pB, len);
     /*
          * this is to debug memory for regression tests
          xmlMemoryDump();
@@ -14,6 +14,8 @@
 void cpdLogRequestParametersInXmlParser_t(pCPD_CONTEXT );
 void cpdCreatePositionResponse_t(pCPD_CONTEXT );
 /* END DEBUG: */
+int cpdXmlParserInit(pCPD_CONTEXT );
+void cpdXmlParserClose(pCPD_CONTEXT );
 int cpdXmlParse(pCPD_CONTEXT , char *, int );
 #endif  /* _CPDXMLPARSER_H_ */
 
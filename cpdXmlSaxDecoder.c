@@ -0,0 +1,821 @@
+/*
+ * hardware/Intel/cp_daemon/cpdXmlSaxDecoder.c
+ *
+ * Streaming decoder for XML received with +CPOSR, specialized to 3GPP pos.xsd element tree.
+ * Called from SAX handlers of the push parser in cpdXmlParser.c, no document tree is built.
+ * Each element is looked up once when it starts; values are converted and written into request structure
+ * in CPD_CONTEXT when element closes, with the same conversions as document tree decoders in cpdXmlParser.c.
+ *
+ * Martin Junkar 09/18/2011
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <libxml/parser.h>
+#include <libxml/tree.h>
+#define LOG_TAG "CPDD_XS"
+
+#include "cpd.h"
+#include "cpdUtil.h"
+#include "cpdXmlUtils.h"
+#include "cpdGppCodec.h"
+#include "cpdXmlNames.h"
+#include "cpdXmlSaxDecoder.h"
+#include "cpdDebug.h"
+
+extern int cpdXmlNameTo_rrlp_method(XML_NAME_E );
+
+typedef enum {
+    XML_EL_UNKNOWN = 0,
+    XML_EL_POS,
+    XML_EL_LOCATION,
+    XML_EL_ASSIST_DATA,
+    XML_EL_POS_MEAS,
+    XML_EL_GPS_MEAS,
+    XML_EL_GPS_ASSIST_REQ,
+    XML_EL_MSG,
+    XML_EL_POS_ERR,
+
+    XML_EL_LOCATION_PARAMETERS,
+    XML_EL_SHAPE_DATA,
+    XML_EL_NORTH,
+    XML_EL_DEGREES,
+    XML_EL_LONGITUDE,
+    XML_EL_HEIGHT_ABOVE_SURFACE,
+    XML_EL_HEIGHT,
+    XML_EL_UNCERT_SEMI_MAJOR,
+    XML_EL_UNCERT_SEMI_MINOR,
+    XML_EL_ORIENT_MAJOR,
+    XML_EL_CONFIDENCE,
+    XML_EL_UNCERT_ALT,
+
+    XML_EL_NAV_MODEL_ELEM,
+    XML_EL_SAT_ID,
+    XML_EL_SAT_STATUS,
+    XML_EL_EPHEM,
+
+    XML_EL_REF_TIME,
+    XML_EL_GPS_TOW_MSEC,
+    XML_EL_GPS_WEEK,
+    XML_EL_GPS_TOW_ASSIST,
+    XML_EL_TLM_WORD,
+    XML_EL_ANTI_SP,
+    XML_EL_ALERT,
+    XML_EL_TLM_RES,
+
+    XML_EL_MEAS_ABORT,
+    XML_EL_RRLP_MEAS,
+    XML_EL_RRLP_POS_INSTRUCT,
+    XML_EL_RRLP_METHOD,
+    XML_EL_RESP_TIME_SECONDS,
+    XML_EL_MULT_SETS,
+    XML_EL_RRLP_METHOD_TYPE,
+    XML_EL_METHOD_ACCURACY,
+    XML_EL_UNCERTAINTY,
+    XML_EL_RRC_MEAS,
+    XML_EL_REP_QUANT,
+    XML_EL_RRC_METHOD_TYPE,
+    XML_EL_RRC_METHOD,
+    XML_EL_HOR_ACC,
+    XML_EL_PERIOD_REP_CRIT
+} XML_EL_E;
+
+typedef struct {
+    XML_EL_E    id;
+    int         offset;     /* XML_EL_EPHEM: offset of the value in EPHEM_AND_CLOCK */
+    int         isLong;
+} XML_SAX_ELEMENT;
+
+#define XML_SAX_EPHEM_INT(name)     [XML_NAME_##name] = { XML_EL_EPHEM, offsetof(EPHEM_AND_CLOCK, name), 0 }
+#define XML_SAX_EPHEM_LONG(name)    [XML_NAME_##name] = { XML_EL_EPHEM, offsetof(EPHEM_AND_CLOCK, name), 1 }
+
+/*
+ * Elements of pos.xsd used by decoder, indexed by XML_NAME_E.
+ * Anything else is XML_EL_UNKNOWN and is skipped.
+ */
+static const XML_SAX_ELEMENT saxElements[XML_NAME_COUNT] = {
+    [XML_NAME_pos]                      = { XML_EL_POS,                 0, 0 },
+    [XML_NAME_location]                 = { XML_EL_LOCATION,            0, 0 },
+    [XML_NAME_assist_data]              = { XML_EL_ASSIST_DATA,         0, 0 },
+    [XML_NAME_pos_meas]                 = { XML_EL_POS_MEAS,            0, 0 },
+    [XML_NAME_GPS_meas]                 = { XML_EL_GPS_MEAS,            0, 0 },
+    [XML_NAME_GPS_assist_req]           = { XML_EL_GPS_ASSIST_REQ,      0, 0 },
+    [XML_NAME_msg]                      = { XML_EL_MSG,                 0, 0 },
+    [XML_NAME_pos_err]                  = { XML_EL_POS_ERR,             0, 0 },
+
+    [XML_NAME_location_parameters]      = { XML_EL_LOCATION_PARAMETERS, 0, 0 },
+    [XML_NAME_shape_data]               = { XML_EL_SHAPE_DATA,          0, 0 },
+    [XML_NAME_north]                    = { XML_EL_NORTH,               0, 0 },
+    [XML_NAME_degrees]                  = { XML_EL_DEGREES,             0, 0 },
+    [XML_NAME_longitude]                = { XML_EL_LONGITUDE,           0, 0 },
+    [XML_NAME_height_above_surface]     = { XML_EL_HEIGHT_ABOVE_SURFACE, 0, 0 },
+    [XML_NAME_height]                   = { XML_EL_HEIGHT,              0, 0 },
+    [XML_NAME_uncert_semi_major]        = { XML_EL_UNCERT_SEMI_MAJOR,   0, 0 },
+    [XML_NAME_uncert_semi_minor]        = { XML_EL_UNCERT_SEMI_MINOR,   0, 0 },
+    [XML_NAME_orient_major]             = { XML_EL_ORIENT_MAJOR,        0, 0 },
+    [XML_NAME_confidence]               = { XML_EL_CONFIDENCE,          0, 0 },
+    [XML_NAME_uncert_alt]               = { XML_EL_UNCERT_ALT,          0, 0 },
+
+    [XML_NAME_nav_model_elem]           = { XML_EL_NAV_MODEL_ELEM,      0, 0 },
+    [XML_NAME_sat_id]                   = { XML_EL_SAT_ID,              0, 0 },
+    [XML_NAME_sat_status]               = { XML_EL_SAT_STATUS,          0, 0 },
+    XML_SAX_EPHEM_INT(l2_code),
+    XML_SAX_EPHEM_INT(ura),
+    XML_SAX_EPHEM_INT(sv_health),
+    XML_SAX_EPHEM_INT(iodc),
+    XML_SAX_EPHEM_INT(l2p_flag),
+    XML_SAX_EPHEM_INT(esr1),
+    XML_SAX_EPHEM_INT(esr2),
+    XML_SAX_EPHEM_INT(esr3),
+    XML_SAX_EPHEM_INT(esr4),
+    XML_SAX_EPHEM_INT(tgd),
+    XML_SAX_EPHEM_INT(toc),
+    XML_SAX_EPHEM_INT(af2),
+    XML_SAX_EPHEM_INT(af1),
+    XML_SAX_EPHEM_INT(af0),
+    XML_SAX_EPHEM_INT(crs),
+    XML_SAX_EPHEM_INT(delta_n),
+    XML_SAX_EPHEM_INT(m0),
+    XML_SAX_EPHEM_INT(cuc),
+    XML_SAX_EPHEM_INT(ecc),
+    XML_SAX_EPHEM_INT(cus),
+    XML_SAX_EPHEM_LONG(power_half),
+    XML_SAX_EPHEM_INT(toe),
+    XML_SAX_EPHEM_INT(fit_flag),
+    XML_SAX_EPHEM_INT(aoda),
+    XML_SAX_EPHEM_INT(cic),
+    XML_SAX_EPHEM_INT(omega0),
+    XML_SAX_EPHEM_INT(cis),
+    XML_SAX_EPHEM_INT(i0),
+    XML_SAX_EPHEM_INT(crc),
+    XML_SAX_EPHEM_INT(omega),
+    XML_SAX_EPHEM_LONG(omega_dot),
+    XML_SAX_EPHEM_INT(idot),
+
+    [XML_NAME_ref_time]                 = { XML_EL_REF_TIME,            0, 0 },
+    [XML_NAME_GPS_TOW_msec]             = { XML_EL_GPS_TOW_MSEC,        0, 0 },
+    [XML_NAME_GPS_week]                 = { XML_EL_GPS_WEEK,            0, 0 },
+    [XML_NAME_GPS_TOW_assist]           = { XML_EL_GPS_TOW_ASSIST,      0, 0 },
+    [XML_NAME_tlm_word]                 = { XML_EL_TLM_WORD,            0, 0 },
+    [XML_NAME_anti_sp]                  = { XML_EL_ANTI_SP,             0, 0 },
+    [XML_NAME_alert]                    = { XML_EL_ALERT,               0, 0 },
+    [XML_NAME_tlm_res]                  = { XML_EL_TLM_RES,             0, 0 },
+
+    [XML_NAME_meas_abort]               = { XML_EL_MEAS_ABORT,          0, 0 },
+    [XML_NAME_RRLP_meas]                = { XML_EL_RRLP_MEAS,           0, 0 },
+    [XML_NAME_RRLP_pos_instruct]        = { XML_EL_RRLP_POS_INSTRUCT,   0, 0 },
+    [XML_NAME_RRLP_method]              = { XML_EL_RRLP_METHOD,         0, 0 },
+    [XML_NAME_resp_time_seconds]        = { XML_EL_RESP_TIME_SECONDS,   0, 0 },
+    [XML_NAME_mult_sets]                = { XML_EL_MULT_SETS,           0, 0 },
+    [XML_NAME_RRLP_method_type]         = { XML_EL_RRLP_METHOD_TYPE,    0, 0 },
+    [XML_NAME_method_accuracy]          = { XML_EL_METHOD_ACCURACY,     0, 0 },
+    [XML_NAME_uncertainty]              = { XML_EL_UNCERTAINTY,         0, 0 },
+    [XML_NAME_RRC_meas]                 = { XML_EL_RRC_MEAS,            0, 0 },
+    [XML_NAME_rep_quant]                = { XML_EL_REP_QUANT,           0, 0 },
+    [XML_NAME_RRC_method_type]          = { XML_EL_RRC_METHOD_TYPE,     0, 0 },
+    [XML_NAME_RRC_method]               = { XML_EL_RRC_METHOD,          0, 0 },
+    [XML_NAME_hor_acc]                  = { XML_EL_HOR_ACC,             0, 0 },
+    [XML_NAME_period_rep_crit]          = { XML_EL_PERIOD_REP_CRIT,     0, 0 }
+};
+
+
+/* XML_SAX_DECODER.flags */
+#define SAX_LOCATION_FOUND      0x00001     /* location_parameters found, only the first one is decoded */
+#define SAX_IN_LOCATION         0x00002
+#define SAX_SHAPE_DATA_FOUND    0x00004
+#define SAX_IN_SHAPE_DATA       0x00008
+#define SAX_IN_ELLIPSE          0x00010
+#define SAX_LATITUDE_FOUND      0x00020
+#define SAX_NAV_FOUND           0x00040
+#define SAX_NAV_SAT_ID_FOUND    0x00080
+#define SAX_REF_TIME_FOUND      0x00100
+#define SAX_IN_REF_TIME         0x00200
+#define SAX_IN_RRLP             0x00400
+#define SAX_POS_INSTRUCT_FOUND  0x00800
+#define SAX_METHOD_TYPE_FOUND   0x01000
+#define SAX_METHOD_FOUND        0x02000
+#define SAX_ACCURACY_FOUND      0x04000
+#define SAX_IN_RRC              0x08000
+
+
+/*
+ * Id of open element <up> levels above the innermost one.
+ */
+static XML_EL_E cpdXmlSaxOpenElement(pXML_SAX_DECODER pDec, int up)
+{
+    int i = pDec->depth - 1 - up;
+
+    if ((i < 0) || (i >= XML_SAX_MAX_DEPTH)) {
+        return XML_EL_UNKNOWN;
+    }
+    return saxElements[pDec->stack[i]].id;
+}
+
+static int cpdXmlSaxIsInside(pXML_SAX_DECODER pDec, XML_EL_E id)
+{
+    int i;
+
+    for (i = pDec->depth - 1; i >= 0; i--) {
+        if ((i < XML_SAX_MAX_DEPTH) && (saxElements[pDec->stack[i]].id == id)) {
+            return CPD_OK;
+        }
+    }
+    return CPD_NOK;
+}
+
+/*
+ * XML_NAME_E of attribute <name> value, XML_NAME_NONE if there is no such attribute.
+ * Value is looked up in place, nothing is copied.
+ */
+static XML_NAME_E cpdXmlSaxAttribute(int nb_attributes, const xmlChar **attributes, XML_NAME_E name)
+{
+    const xmlChar *pName = (const xmlChar *) cpdXmlNameString(name);
+    int i;
+
+    for (i = 0; i < nb_attributes; i++) {
+        /* localname, prefix, URI, value, end */
+        if (xmlStrEqual(attributes[5 * i], pName)) {
+            return cpdXmlNameLookupLen(attributes[5 * i + 3], (int) (attributes[5 * i + 4] - attributes[5 * i + 3]));
+        }
+    }
+    return XML_NAME_NONE;
+}
+
+/*
+ * Text of the element being closed, NULL if element has no text.
+ */
+static const xmlChar *cpdXmlSaxText(pXML_SAX_DECODER pDec)
+{
+    if (pDec->textLen < 0) {
+        return NULL;
+    }
+    pDec->text[pDec->textLen] = 0;
+    return (const xmlChar *) pDec->text;
+}
+
+void cpdXmlSaxDecoderReset(pXML_SAX_DECODER pDec)
+{
+    pDec->depth = 0;
+    pDec->textLen = CPD_ERROR;
+    pDec->flags = 0;
+    pDec->result = CPD_ERROR;
+    pDec->locationResult = CPD_ERROR;
+    pDec->navIndex = CPD_ERROR;
+    pDec->navSatStatus = NAV_ELEM_SAT_STATUS_NONE;
+    pDec->towIndex = CPD_ERROR;
+}
+
+static void cpdXmlSaxLogEllipse(pPOINT_ALT_UNCERTELLIPSE pEllipse)
+{
+    CPD_LOG(CPD_LOG_ID_TXT , "POINT_ALT_UNCERTELLIPSE,%d,%f,%f,%d,%d,%d,%d,%d,%d,%d\n",
+        pEllipse->coordinate.latitude.north,
+        pEllipse->coordinate.latitude.degrees,
+        pEllipse->coordinate.longitude,
+        pEllipse->altitude.height_above_surface,
+        pEllipse->altitude.height,
+        pEllipse->uncert_semi_major,
+        pEllipse->uncert_semi_minor,
+        pEllipse->orient_major,
+        pEllipse->confidence,
+        pEllipse->uncert_alt);
+    LOGD("POINT_ALT_UNCERTELLIPSE,%d,%f,%f,%d,%d,%d,%d,%d,%d,%d",
+        pEllipse->coordinate.latitude.north,
+        pEllipse->coordinate.latitude.degrees,
+        pEllipse->coordinate.longitude,
+        pEllipse->altitude.height_above_surface,
+        pEllipse->altitude.height,
+        pEllipse->uncert_semi_major,
+        pEllipse->uncert_semi_minor,
+        pEllipse->orient_major,
+        pEllipse->confidence,
+        pEllipse->uncert_alt);
+}
+
+static void cpdXmlSaxLogRefTime(pREF_TIME pRefTime)
+{
+    CPD_LOG(CPD_LOG_ID_TXT , "\r\nREF_TIME,%d,%d,%d\n",
+        pRefTime->GPS_time.GPS_TOW_msec,
+        pRefTime->GPS_time.GPS_week,
+        pRefTime->GPS_TOW_assist_arr_items);
+    LOGD("ASSIST, REF_TIME,%ld,%d,%d",
+        pRefTime->GPS_time.GPS_TOW_msec,
+        pRefTime->GPS_time.GPS_week,
+        pRefTime->GPS_TOW_assist_arr_items);
+}
+
+/*
+ * Element <localname> started.
+ */
+void cpdXmlSaxDecoderStart(pCPD_CONTEXT pCpd, const xmlChar *localname, int nb_attributes, const xmlChar **attributes)
+{
+    pXML_SAX_DECODER pDec = &(pCpd->xmlRxParser.sax);
+    pASSIST_DATA pAssistData = &(pCpd->request.assist_data);
+    pLOCATION_PARAMETERS pLocationParameters = &(pAssistData->GPS_assist.location_parameters);
+    pRRLP_MEAS pRrlpMeas = &(pCpd->request.posMeas.posMeas_u.rrlp_meas);
+    pRRC_MEAS pRrcMeas = &(pCpd->request.posMeas.posMeas_u.rrc_meas);
+    XML_EL_E parent;
+    int firstChild = CPD_NOK;
+    int index;
+    XML_NAME_E value;
+
+    pDec->textLen = CPD_ERROR;
+    if (pDec->depth >= XML_SAX_MAX_DEPTH) {
+        /* too deep for pos.xsd, nothing in here is decoded */
+        pDec->depth++;
+        return;
+    }
+    parent = cpdXmlSaxOpenElement(pDec, 0);
+    if (pDec->depth > 0) {
+        firstChild = (pDec->nChildren[pDec->depth - 1] == 0) ? CPD_OK : CPD_NOK;
+        if (pDec->nChildren[pDec->depth - 1] < 0xFF) {
+            pDec->nChildren[pDec->depth - 1]++;
+        }
+    }
+    index = cpdXmlNameLookup(localname);
+    pDec->stack[pDec->depth] = (unsigned short) index;
+    pDec->nChildren[pDec->depth] = 0;
+    pDec->depth++;
+
+    if (pDec->depth == 2) {
+        /* child of <pos> */
+        pDec->flags = 0;
+        pDec->result = CPD_ERROR;
+        pDec->locationResult = CPD_ERROR;
+        pDec->navIndex = CPD_ERROR;
+        pDec->towIndex = CPD_ERROR;
+    }
+
+    if ((parent == XML_EL_SHAPE_DATA) && (firstChild == CPD_OK) && (pDec->flags & SAX_IN_SHAPE_DATA)) {
+        /* shape is the first child of shape_data */
+        pLocationParameters->shape_type = xmlStringTo3GPP_shape_type(localname);
+        if (pLocationParameters->shape_type == SHAPE_TYPE_POINT_ALT_UNCERT_ELLIPSE) {
+            memset(&(pLocationParameters->shape_data.point_alt_uncertellipse), 0, sizeof(POINT_ALT_UNCERTELLIPSE));
+            pDec->flags |= SAX_IN_ELLIPSE;
+            pDec->locationResult = CPD_OK;
+        }
+        return;
+    }
+    if ((parent == XML_EL_RRLP_METHOD_TYPE) && (firstChild == CPD_OK) && (pDec->flags & SAX_METHOD_TYPE_FOUND)) {
+        /* method type is the first child of RRLP_method_type */
+        pRrlpMeas->method_type = xmlNameTo3GPP_method_type((XML_NAME_E) index);
+        pDec->flags |= SAX_METHOD_FOUND;
+        return;
+    }
+
+    switch (saxElements[index].id) {
+        case XML_EL_ASSIST_DATA:
+            if (parent == XML_EL_POS) {
+                if (pAssistData->flag == 0) {
+                    memset(pAssistData, 0, sizeof(ASSIST_DATA));
+                }
+            }
+            break;
+        case XML_EL_POS_MEAS:
+            if (parent == XML_EL_POS) {
+                pCpd->request.posMeas.flag = POS_MEAS_NONE;
+            }
+            break;
+        case XML_EL_LOCATION_PARAMETERS:
+            if ((cpdXmlSaxIsInside(pDec, XML_EL_ASSIST_DATA) == CPD_OK) && !(pDec->flags & SAX_LOCATION_FOUND)) {
+                memset(pLocationParameters, 0, sizeof(LOCATION_PARAMETERS));
+                pDec->flags |= SAX_LOCATION_FOUND | SAX_IN_LOCATION;
+            }
+            break;
+        case XML_EL_SHAPE_DATA:
+            if ((pDec->flags & SAX_IN_LOCATION) && !(pDec->flags & SAX_SHAPE_DATA_FOUND)) {
+                pDec->flags |= SAX_SHAPE_DATA_FOUND | SAX_IN_SHAPE_DATA;
+            }
+            break;
+        case XML_EL_NAV_MODEL_ELEM:
+            if (cpdXmlSaxIsInside(pDec, XML_EL_ASSIST_DATA) == CPD_OK) {
+                pDec->flags |= SAX_NAV_FOUND;
+                pDec->flags &= ~SAX_NAV_SAT_ID_FOUND;
+                pDec->navSatStatus = NAV_ELEM_SAT_STATUS_NONE;
+                pDec->navIndex = CPD_ERROR;
+                if (pAssistData->GPS_assist.nav_model_elem_arr_items < GPS_MAX_N_SVS) {
+                    pDec->navIndex = pAssistData->GPS_assist.nav_model_elem_arr_items;
+                    memset(&(pAssistData->GPS_assist.nav_model_elem_arr[pDec->navIndex]), 0, sizeof(NAV_MODEL_ELEM));
+                }
+            }
+            break;
+        case XML_EL_SAT_STATUS:
+            if (pDec->navIndex >= 0) {
+                value = cpdXmlSaxAttribute(nb_attributes, attributes, XML_NAME_literal);
+                pDec->navSatStatus = xmlNameTo3GPP_nav_elem_sat_status(value);
+            }
+            break;
+        case XML_EL_REF_TIME:
+            if ((cpdXmlSaxIsInside(pDec, XML_EL_ASSIST_DATA) == CPD_OK) && !(pDec->flags & SAX_REF_TIME_FOUND)) {
+                memset(&(pAssistData->GPS_assist.ref_time), 0, sizeof(REF_TIME));
+                pDec->flags |= SAX_REF_TIME_FOUND | SAX_IN_REF_TIME;
+            }
+            break;
+        case XML_EL_GPS_TOW_ASSIST:
+            pDec->towIndex = CPD_ERROR;
+            if ((pDec->flags & SAX_IN_REF_TIME) &&
+                (pAssistData->GPS_assist.ref_time.GPS_TOW_assist_arr_items < GPS_MAX_N_SVS)) {
+                pDec->towIndex = pAssistData->GPS_assist.ref_time.GPS_TOW_assist_arr_items;
+            }
+            break;
+
+        case XML_EL_MEAS_ABORT:
+            if (parent == XML_EL_POS_MEAS) {
+                pCpd->request.posMeas.flag = POS_MEAS_ABORT;
+                CPD_LOG(CPD_LOG_ID_TXT , "\r\nr\n !!! parsed meas_abort !!!\n");
+                pDec->result = CPD_OK;
+            }
+            break;
+        case XML_EL_RRLP_MEAS:
+            if (parent == XML_EL_POS_MEAS) {
+                memset(pRrlpMeas, 0, sizeof(RRLP_MEAS));
+                pDec->flags |= SAX_IN_RRLP;
+            }
+            break;
+        case XML_EL_RRLP_POS_INSTRUCT:
+            if ((parent == XML_EL_RRLP_MEAS) && (pDec->flags & SAX_IN_RRLP)) {
+                pRrlpMeas->RRLP_method = RRLP_METHOD_NONE;
+                pRrlpMeas->resp_time_seconds = CPD_ERROR;
+                pRrlpMeas->mult_sets = MULT_SETS_NONE;
+                pDec->flags |= SAX_POS_INSTRUCT_FOUND;
+            }
+            break;
+        case XML_EL_RRLP_METHOD:
+            if ((pDec->flags & SAX_IN_RRLP) && (cpdXmlSaxIsInside(pDec, XML_EL_RRLP_POS_INSTRUCT) == CPD_OK)) {
+                value = cpdXmlSaxAttribute(nb_attributes, attributes, XML_NAME_literal);
+                pRrlpMeas->RRLP_method = cpdXmlNameTo_rrlp_method(value);
+            }
+            break;
+        case XML_EL_MULT_SETS:
+            if ((pDec->flags & SAX_IN_RRLP) && (cpdXmlSaxIsInside(pDec, XML_EL_RRLP_POS_INSTRUCT) == CPD_OK)) {
+                value = cpdXmlSaxAttribute(nb_attributes, attributes, XML_NAME_literal);
+                pRrlpMeas->mult_sets = xmlNameTo3GPP_mult_sets(value);
+            }
+            break;
+        case XML_EL_RRLP_METHOD_TYPE:
+            if ((parent == XML_EL_RRLP_POS_INSTRUCT) && (pDec->flags & SAX_IN_RRLP)) {
+                pDec->flags |= SAX_METHOD_TYPE_FOUND;
+            }
+            break;
+        case XML_EL_METHOD_ACCURACY:
+            /* child of method type element */
+            if ((cpdXmlSaxOpenElement(pDec, 2) == XML_EL_RRLP_METHOD_TYPE) && (pDec->nChildren[pDec->depth - 3] == 1) &&
+                (pDec->flags & SAX_METHOD_FOUND)) {
+                pRrlpMeas->accurancy = cpdGppHorizontalUncertToM(CPD_ERROR);
+                pDec->flags |= SAX_ACCURACY_FOUND;
+            }
+            break;
+        case XML_EL_RRC_MEAS:
+            if (parent == XML_EL_POS_MEAS) {
+                memset(pRrcMeas, 0, sizeof(RRC_MEAS));
+                pRrcMeas->rep_quant.RRC_method_type = GPP_METHOD_TYPE_NONE;
+                pRrcMeas->rep_crit.period_rep_crit.rep_amount = CPD_ERROR;
+                pRrcMeas->rep_crit.period_rep_crit.rep_interval_long = CPD_ERROR;
+                pDec->flags |= SAX_IN_RRC;
+            }
+            break;
+        case XML_EL_REP_QUANT:
+            if (pDec->flags & SAX_IN_RRC) {
+                value = cpdXmlSaxAttribute(nb_attributes, attributes, XML_NAME_gps_timing_of_cell_wanted);
+                pRrcMeas->rep_quant.gps_timing_of_cell_wanted = xmlNameToBool(value);
+                value = cpdXmlSaxAttribute(nb_attributes, attributes, XML_NAME_addl_assist_data_req);
+                pRrcMeas->rep_quant.addl_assist_data_req = xmlNameToBool(value);
+            }
+            break;
+        case XML_EL_RRC_METHOD_TYPE:
+            if (pDec->flags & SAX_IN_RRC) {
+                value = cpdXmlSaxAttribute(nb_attributes, attributes, XML_NAME_literal);
+                pRrcMeas->rep_quant.RRC_method_type = xmlNameTo3GPP_method_type(value);
+            }
+            break;
+        case XML_EL_RRC_METHOD:
+            if (pDec->flags & SAX_IN_RRC) {
+                value = cpdXmlSaxAttribute(nb_attributes, attributes, XML_NAME_literal);
+                pRrcMeas->rep_quant.RRC_method = cpdXmlNameTo_rrlp_method(value);
+            }
+            break;
+        case XML_EL_PERIOD_REP_CRIT:
+            if (pDec->flags & SAX_IN_RRC) {
+                value = cpdXmlSaxAttribute(nb_attributes, attributes, XML_NAME_rep_amount);
+                pRrcMeas->rep_crit.period_rep_crit.rep_amount = xmlNameTo3GPP_rep_amount(value);
+                value = cpdXmlSaxAttribute(nb_attributes, attributes, XML_NAME_rep_interval_long);
+                pRrcMeas->rep_crit.period_rep_crit.rep_interval_long = xmlNameTo3GPP_rep_interval_long(value);
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+/*
+ * Leaf element of ellipsoid_point_alt_uncertellipse closed.
+ */
+static void cpdXmlSaxEllipseValue(pPOINT_ALT_UNCERTELLIPSE pEllipse, XML_EL_E id, const xmlChar *pText, unsigned int *pFlags)
+{
+    switch (id) {
+        case XML_EL_NORTH:
+            pEllipse->coordinate.latitude.north = xmlTextToInt(pText);
+            break;
+        case XML_EL_DEGREES:
+            /* Convert 3GGP value into degrees, sign is applied when ellipse is complete */
+            pEllipse->coordinate.latitude.degrees = cpdGppLatitudeToDegrees(0, xmlTextToLong(pText));
+            *pFlags |= SAX_LATITUDE_FOUND;
+            break;
+        case XML_EL_LONGITUDE:
+            pEllipse->coordinate.longitude = cpdGppLongitudeToDegrees(xmlTextToLong(pText));
+            break;
+        case XML_EL_HEIGHT_ABOVE_SURFACE:
+            pEllipse->altitude.height_above_surface = xmlTextToInt(pText);
+            break;
+        case XML_EL_HEIGHT:
+            pEllipse->altitude.height = xmlTextToInt(pText);
+            break;
+        case XML_EL_UNCERT_SEMI_MAJOR:
+            pEllipse->uncert_semi_major = cpdGppHorizontalUncertToM(xmlTextToInt(pText));
+            break;
+        case XML_EL_UNCERT_SEMI_MINOR:
+            pEllipse->uncert_semi_minor = cpdGppHorizontalUncertToM(xmlTextToInt(pText));
+            break;
+        case XML_EL_ORIENT_MAJOR:
+            pEllipse->orient_major = xmlTextToInt(pText);
+            break;
+        case XML_EL_CONFIDENCE:
+            pEllipse->confidence = cpdGppConfidence(xmlTextToInt(pText));
+            break;
+        case XML_EL_UNCERT_ALT:
+            pEllipse->uncert_alt = cpdGppVerticalUncertToM(xmlTextToInt(pText));
+            break;
+        default:
+            break;
+    }
+}
+
+/*
+ * Innermost element closed.
+ * Returns decode result of the element, meaningful for children of <pos> only.
+ */
+int cpdXmlSaxDecoderEnd(pCPD_CONTEXT pCpd)
+{
+    pXML_SAX_DECODER pDec = &(pCpd->xmlRxParser.sax);
+    pASSIST_DATA pAssistData = &(pCpd->request.assist_data);
+    pGPS_ASSIST pGPSassist = &(pAssistData->GPS_assist);
+    pREF_TIME pRefTime = &(pGPSassist->ref_time);
+    pPOS_MEAS pPosMeas = &(pCpd->request.posMeas);
+    pRRLP_MEAS pRrlpMeas = &(pPosMeas->posMeas_u.rrlp_meas);
+    pRRC_MEAS pRrcMeas = &(pPosMeas->posMeas_u.rrc_meas);
+    pNAV_MODEL_ELEM pNavModelElem;
+    pGPS_TOW_ASSIST pTow;
+    const XML_SAX_ELEMENT *pEl;
+    XML_EL_E parent;
+    const xmlChar *pText;
+    const xmlChar *pTextOrNull;
+    char *pValue;
+
+    if (pDec->depth <= 0) {
+        return CPD_ERROR;
+    }
+    pDec->depth--;
+    if (pDec->depth >= XML_SAX_MAX_DEPTH) {
+        return CPD_ERROR;
+    }
+    pEl = &(saxElements[pDec->stack[pDec->depth]]);
+    parent = cpdXmlSaxOpenElement(pDec, 0);
+    pText = cpdXmlSaxText(pDec);
+    pTextOrNull = pText;
+    if (pText == NULL) {
+        /* same as content of empty element */
+        pText = BAD_CAST "";
+    }
+    pDec->textLen = CPD_ERROR;
+
+    if (pDec->flags & SAX_IN_ELLIPSE) {
+        if (parent == XML_EL_SHAPE_DATA) {
+            /* shape element closed */
+            if ((pGPSassist->location_parameters.shape_data.point_alt_uncertellipse.coordinate.latitude.north == 1) &&
+                (pDec->flags & SAX_LATITUDE_FOUND)) {
+                pGPSassist->location_parameters.shape_data.point_alt_uncertellipse.coordinate.latitude.degrees =
+                    -pGPSassist->location_parameters.shape_data.point_alt_uncertellipse.coordinate.latitude.degrees;
+            }
+            pDec->flags &= ~SAX_IN_ELLIPSE;
+            cpdXmlSaxLogEllipse(&(pGPSassist->location_parameters.shape_data.point_alt_uncertellipse));
+        }
+        else {
+            cpdXmlSaxEllipseValue(&(pGPSassist->location_parameters.shape_data.point_alt_uncertellipse),
+                                  pEl->id, pText, &(pDec->flags));
+        }
+        return CPD_ERROR;
+    }
+
+    switch (pEl->id) {
+        case XML_EL_SHAPE_DATA:
+            pDec->flags &= ~SAX_IN_SHAPE_DATA;
+            break;
+        case XML_EL_LOCATION_PARAMETERS:
+            if (pDec->flags & SAX_IN_LOCATION) {
+                pDec->flags &= ~SAX_IN_LOCATION;
+                CPD_LOG(CPD_LOG_ID_TXT, "\nshape_type=%d, %d", pGPSassist->location_parameters.shape_type, pDec->locationResult);
+            }
+            break;
+
+        case XML_EL_EPHEM:
+            if (pDec->navIndex >= 0) {
+                pValue = ((char *) &(pGPSassist->nav_model_elem_arr[pDec->navIndex].ephem_and_clock)) + pEl->offset;
+                if (pEl->isLong) {
+                    *((long *) pValue) = xmlTextToLong(pText);
+                }
+                else {
+                    *((int *) pValue) = xmlTextToInt(pText);
+                }
+            }
+            break;
+        case XML_EL_SAT_ID:
+            if ((parent == XML_EL_GPS_TOW_ASSIST) && (pDec->towIndex >= 0)) {
+                pRefTime->GPS_TOW_assist_arr[pDec->towIndex].sat_id = xmlTextToInt(pText) + 1;
+            }
+            else if ((parent == XML_EL_NAV_MODEL_ELEM) && (pDec->navIndex >= 0)) {
+                pGPSassist->nav_model_elem_arr[pDec->navIndex].sat_id = xmlTextToInt(pText) + 1;
+                pDec->flags |= SAX_NAV_SAT_ID_FOUND;
+            }
+            break;
+        case XML_EL_NAV_MODEL_ELEM:
+            if (pDec->navIndex >= 0) {
+                pNavModelElem = &(pGPSassist->nav_model_elem_arr[pDec->navIndex]);
+                if (pDec->flags & SAX_NAV_SAT_ID_FOUND) {
+                    pNavModelElem->sat_status = pDec->navSatStatus;
+                }
+                CPD_LOG(CPD_LOG_ID_TXT , "\r\n NAV_MODEL_ELEM,%d,%d,%d\n",
+                    pDec->navIndex, pNavModelElem->sat_id, pNavModelElem->sat_status);
+                pGPSassist->nav_model_elem_arr_items++;
+                pDec->navIndex = CPD_ERROR;
+            }
+            break;
+
+        case XML_EL_GPS_TOW_MSEC:
+            if (pDec->flags & SAX_IN_REF_TIME) {
+                pRefTime->GPS_time.GPS_TOW_msec = xmlTextToLong(pText);
+                pRefTime->GPS_time.gpsTimeReceivedAt = getMsecTime();
+                pRefTime->isSet = CPD_OK;
+            }
+            break;
+        case XML_EL_GPS_WEEK:
+            if (pDec->flags & SAX_IN_REF_TIME) {
+                pRefTime->GPS_time.GPS_week = xmlTextToInt(pText);
+            }
+            break;
+        case XML_EL_TLM_WORD:
+        case XML_EL_ANTI_SP:
+        case XML_EL_ALERT:
+        case XML_EL_TLM_RES:
+            if (pDec->towIndex >= 0) {
+                pTow = &(pRefTime->GPS_TOW_assist_arr[pDec->towIndex]);
+                if (pEl->id == XML_EL_TLM_WORD) {
+                    pTow->tlm_word = xmlTextToInt(pText);
+                }
+                else if (pEl->id == XML_EL_ANTI_SP) {
+                    pTow->anti_sp = xmlTextToInt(pText);
+                }
+                else if (pEl->id == XML_EL_ALERT) {
+                    pTow->alert = xmlTextToInt(pText);
+                }
+                else {
+                    pTow->tlm_res = xmlTextToInt(pText);
+                }
+            }
+            break;
+        case XML_EL_GPS_TOW_ASSIST:
+            if (pDec->towIndex >= 0) {
+                pRefTime->GPS_TOW_assist_arr_items++;
+                pDec->towIndex = CPD_ERROR;
+            }
+            break;
+        case XML_EL_REF_TIME:
+            if (pDec->flags & SAX_IN_REF_TIME) {
+                pDec->flags &= ~SAX_IN_REF_TIME;
+                cpdXmlSaxLogRefTime(pRefTime);
+            }
+            break;
+
+        case XML_EL_ASSIST_DATA:
+            if (parent == XML_EL_POS) {
+                /* same order and result as cpdXmlParse_assist_data() */
+                pDec->result = CPD_ERROR;
+                if (pDec->flags & SAX_LOCATION_FOUND) {
+                    pDec->result = pDec->locationResult;
+                    if (pDec->result != CPD_ERROR) {
+                        pAssistData->flag++;
+                    }
+                }
+                if (pDec->flags & SAX_NAV_FOUND) {
+                    pDec->result = CPD_OK;
+                    pAssistData->flag++;
+                }
+                if (pDec->flags & SAX_REF_TIME_FOUND) {
+                    pDec->result = CPD_OK;
+                    pAssistData->flag++;
+                }
+                CPD_LOG(CPD_LOG_ID_TXT, "\r\n pAssistData->flag = %d ", pAssistData->flag);
+            }
+            break;
+
+        case XML_EL_RESP_TIME_SECONDS:
+            if ((parent == XML_EL_RRLP_POS_INSTRUCT) && (pDec->flags & SAX_IN_RRLP)) {
+                pRrlpMeas->resp_time_seconds = xmlTextToInt(pTextOrNull);
+            }
+            break;
+        case XML_EL_UNCERTAINTY:
+            if ((parent == XML_EL_METHOD_ACCURACY) && (pDec->flags & SAX_ACCURACY_FOUND)) {
+                pRrlpMeas->accurancy = cpdGppHorizontalUncertToM(xmlTextToInt(pTextOrNull));
+            }
+            break;
+        case XML_EL_RRLP_MEAS:
+            if ((parent == XML_EL_POS_MEAS) && (pDec->flags & SAX_IN_RRLP)) {
+                pDec->flags &= ~SAX_IN_RRLP;
+                pDec->result = CPD_ERROR;
+                if ((pDec->flags & SAX_POS_INSTRUCT_FOUND) && (pDec->flags & SAX_METHOD_TYPE_FOUND) &&
+                    (pDec->flags & SAX_METHOD_FOUND) && (pDec->flags & SAX_ACCURACY_FOUND)) {
+                    pDec->result = CPD_OK;
+                }
+                LOGD("RRLP_MEAS request,%d, %d, %d, %d, %d",
+                    pRrlpMeas->method_type,
+                    pRrlpMeas->accurancy,
+                    pRrlpMeas->RRLP_method,
+                    pRrlpMeas->resp_time_seconds,
+                    pRrlpMeas->mult_sets
+                    );
+                if ((pDec->result == CPD_OK) && (pRrlpMeas->RRLP_method == RRLP_METHOD_GPS)) {
+                    pPosMeas->flag = POS_MEAS_RRLP;
+                    pCpd->request.rs.method_type = pRrlpMeas->method_type;
+                    pCpd->request.rs.rep_resp_time_seconds = pRrlpMeas->resp_time_seconds;
+                    pCpd->request.rs.rep_hor_acc = pRrlpMeas->accurancy;
+                    pCpd->request.rs.rep_amount = pRrlpMeas->mult_sets;
+                    pCpd->request.rs.rep_vert_accuracy = 0;
+                    pCpd->request.rs.rep_interval_seconds = 1;
+                }
+            }
+            break;
+        case XML_EL_HOR_ACC:
+            if (pDec->flags & SAX_IN_RRC) {
+                pRrcMeas->rep_quant.hor_acc = xmlTextToInt(pText);
+            }
+            break;
+        case XML_EL_RRC_MEAS:
+            if ((parent == XML_EL_POS_MEAS) && (pDec->flags & SAX_IN_RRC)) {
+                pDec->flags &= ~SAX_IN_RRC;
+                pRrcMeas->rep_quant.hor_acc = cpdGppHorizontalUncertToM(pRrcMeas->rep_quant.hor_acc);
+                LOGD("RRC_MEAS request,%d, %d, %d, %d, %d, %d, %d",
+                    pRrcMeas->rep_quant.gps_timing_of_cell_wanted,
+                    pRrcMeas->rep_quant.addl_assist_data_req,
+                    pRrcMeas->rep_quant.RRC_method_type,
+                    pRrcMeas->rep_quant.RRC_method,
+                    pRrcMeas->rep_quant.hor_acc,
+                    pRrcMeas->rep_crit.period_rep_crit.rep_amount,
+                    pRrcMeas->rep_crit.period_rep_crit.rep_interval_long
+                    );
+                pDec->result = CPD_OK;
+                pPosMeas->flag = POS_MEAS_RRC;
+                pCpd->request.rs.method_type = pRrcMeas->method_type;
+                pCpd->request.rs.rep_resp_time_seconds = pRrcMeas->rep_crit.period_rep_crit.rep_interval_long;
+                pCpd->request.rs.rep_hor_acc = pRrcMeas->rep_quant.hor_acc;
+                pCpd->request.rs.rep_amount = pRrcMeas->rep_crit.period_rep_crit.rep_amount;
+                pCpd->request.rs.rep_vert_accuracy = pRrcMeas->rep_quant.vert_accuracy;
+                if (pCpd->request.rs.rep_amount == 0) {
+                    pCpd->request.rs.rep_interval_seconds = pRrcMeas->rep_crit.period_rep_crit.rep_interval_long;
+                    pCpd->request.rs.rep_resp_time_seconds = 16;
+                }
+                else {
+                    pCpd->request.rs.rep_interval_seconds = 1;
+                }
+            }
+            break;
+        default:
+            break;
+    }
+    return (pDec->depth == 1) ? pDec->result : CPD_ERROR;
+}
+
+/*
+ * Text of the innermost element, only short values are kept.
+ */
+void cpdXmlSaxDecoderText(pCPD_CONTEXT pCpd, const xmlChar *pCh, int len)
+{
+    pXML_SAX_DECODER pDec = &(pCpd->xmlRxParser.sax);
+    int i = 0;
+
+    if (pDec->textLen < 0) {
+        pDec->textLen = 0;
+    }
+    if (pDec->textLen == 0) {
+        while ((i < len) && ((pCh[i] == ' ') || (pCh[i] == '\t') || (pCh[i] == '\r') || (pCh[i] == '\n'))) {
+            i++;
+        }
+    }
+    if ((len - i) > (XML_SAX_TEXT_SIZE - 1 - pDec->textLen)) {
+        len = i + (XML_SAX_TEXT_SIZE - 1 - pDec->textLen);
+    }
+    if (len > i) {
+        memcpy(&(pDec->text[pDec->textLen]), &(pCh[i]), len - i);
+        pDec->textLen = pDec->textLen + (len - i);
+    }
+}
@@ -0,0 +1,20 @@
+/*
+ * hardware/Intel/cp_daemon/cpdXmlSaxDecoder.h
+ *
+ * Streaming decoder for +CPOSR XML - header file for cpdXmlSaxDecoder.c.
+ *
+ * Martin Junkar 09/18/2011
+ *
+ */
+
+#ifndef _CPDXMLSAXDECODER_H_
+#define _CPDXMLSAXDECODER_H_
+
+#include "cpd.h"
+
+void cpdXmlSaxDecoderReset(pXML_SAX_DECODER );
+void cpdXmlSaxDecoderStart(pCPD_CONTEXT , const xmlChar *, int , const xmlChar ** );
+int cpdXmlSaxDecoderEnd(pCPD_CONTEXT );
+void cpdXmlSaxDecoderText(pCPD_CONTEXT , const xmlChar *, int );
+
+#endif /* _CPDXMLSAXDECODER_H_ */
@@ -8,12 +8,15 @@
  *
  */
 
+#include <limits.h>
+#include <string.h>
 #include <libxml/parser.h>
 #include <libxml/tree.h>
 
 #define LOG_TAG "CPDD_XU"
 
 #include "cpd.h"
+#include "cpdXmlNames.h"
 
  /*
   * convert an xml int to bool string (CPD_ERROR if the input is NULL)
@@ -25,6 +28,27 @@
      return res;
  }
 
+ /*
+  * convert MULTIPATH_* to multi_path literal, "not_measured" for unknown value
+  */
+char *xmlMultiPathToString(int value)
+{
+    static char *pLiterals[] = { "not_measured", "low", "medium", "high" };
+
+    if ((value < MULTIPATH_NOT_MEASURED) || (value > MULTIPATH_HIGH)) {
+        value = MULTIPATH_NOT_MEASURED;
+    }
+    return pLiterals[value];
+}
+
+ /*
+  * convert XML_NAME_E of "false"/"true" ---> to 0/1
+  */
+int xmlNameToBool(XML_NAME_E name)
+{
+    return (name == XML_NAME_true);
+}
+
  /*
   * 1. convert an xml string from "false"/"true" ---> to 0/1
   * 2. Release the provided xml string
@@ -34,7 +58,7 @@ int xmlStringToBool(xmlChar *pValue)
     int result = CPD_NOK;
 
     if (pValue != NULL) {
-        result = (xmlStrcmp(pValue, BAD_CAST"true") == 0);
+        result = xmlNameToBool(cpdXmlNameLookup(pValue));
 
         xmlFree(pValue);
     }
@@ -42,6 +66,62 @@ int xmlStringToBool(xmlChar *pValue)
 }
 
 
+ /*
+  * Parse decimal number from <pS> like atol(): leading blanks and sign are skipped,
+  * parsing stops at the first non digit, 0 if there are no digits.
+  * Value is limited to <min>..<max>, parsing stops when the value can not grow any more.
+  */
+static long xmlTextParse(const xmlChar *pS, long min, long max)
+{
+    unsigned long value = 0;
+    unsigned long limit;
+    unsigned int digit;
+    int negative = 0;
+
+    while ((*pS == ' ') || ((*pS >= '\t') && (*pS <= '\r'))) {
+        pS++;
+    }
+    if ((*pS == '-') || (*pS == '+')) {
+        negative = (*pS == '-');
+        pS++;
+    }
+    limit = (negative) ? ((unsigned long) (-(min + 1))) + 1 : (unsigned long) max;
+    while ((digit = (unsigned int) (*pS - '0')) <= 9) {
+        if (value > (limit - digit) / 10) {
+            value = limit;
+            break;
+        }
+        value = value * 10 + digit;
+        pS++;
+    }
+    if (negative) {
+        return (value == 0) ? 0 : -((long) (value - 1)) - 1;
+    }
+    return (long) value;
+}
+
+ /*
+  * convert xml text to integer (CPD_ERROR if the input is NULL), input is not released
+  */
+int xmlTextToInt(const xmlChar *pS)
+{
+    if (pS == NULL) {
+        return CPD_ERROR;
+    }
+    return (int) xmlTextParse(pS, INT_MIN, INT_MAX);
+}
+
+ /*
+  * convert xml text to long (CPD_ERROR if the input is NULL), input is not released
+  */
+long xmlTextToLong(const xmlChar *pS)
+{
+    if (pS == NULL) {
+        return CPD_ERROR;
+    }
+    return xmlTextParse(pS, LONG_MIN, LONG_MAX);
+}
+
  /*
   * 1. convert an xml string to integer (CPD_ERROR if the input is NULL)
   * 2. Release the provided xml string
@@ -50,7 +130,7 @@ int xmlStringToInt(xmlChar *pValue)
  {
      int res = CPD_ERROR;
      if (pValue != NULL) {
-         res = atoi((const char *)pValue);
+         res = xmlTextToInt(pValue);
          xmlFree(pValue);
      }
      return res;
@@ -64,48 +144,73 @@ long xmlStringToLong(xmlChar *value)
 {
      long res = CPD_ERROR;
      if (value) {
-         res = atol((const char *)value);
+         res = xmlTextToLong(value);
          xmlFree(value);
      }
 
      return res;
 }
 
+/*
+ * Text content of element <pNode>.
+ * Points directly to the text node when element has only one text child (or none), nothing is copied.
+ * Otherwise a copy is made with xmlNodeGetContent() and returned in <ppCopy>, caller must xmlFree() it.
+ */
+static const xmlChar *xmlNodeText(xmlNode *pNode, xmlChar **ppCopy)
+{
+    xmlNode *pText = pNode->children;
+
+    *ppCopy = NULL;
+    if (pNode->type == XML_ELEMENT_NODE) {
+        if (pText == NULL) {
+            return BAD_CAST "";
+        }
+        if ((pText->next == NULL) && (pText->content != NULL) &&
+            ((pText->type == XML_TEXT_NODE) || (pText->type == XML_CDATA_SECTION_NODE))) {
+            return pText->content;
+        }
+    }
+    *ppCopy = xmlNodeGetContent(pNode);
+    return *ppCopy;
+}
+
 int xmlNodeGetInt(xmlNode *pNode, int *pValue)
 {
     int result = CPD_NOK;
-    xmlChar *pNodeValue = NULL;
+    const xmlChar *pNodeValue;
+    xmlChar *pCopy;
     if (pNode == NULL) {
         return result;
     }
     if (pValue == NULL) {
         return result;
     }
-    pNodeValue = xmlNodeGetContent(pNode);
+    pNodeValue = xmlNodeText(pNode, &pCopy);
     if (pNodeValue != NULL) {
-        *pValue = atoi((const char *)pNodeValue);
-        xmlFree(pNodeValue);
+        *pValue = xmlTextToInt(pNodeValue);
         result = CPD_OK;
     }
+    xmlFree(pCopy);
     return result;
 }
 
 int xmlNodeGetStr(xmlNode *pNode, char *pValue, int maxLen)
 {
     int result = CPD_NOK;
-    xmlChar *pNodeValue = NULL;
+    const xmlChar *pNodeValue;
+    xmlChar *pCopy;
     if (pNode == NULL) {
         return result;
     }
     if (pValue == NULL) {
         return result;
     }
-    pNodeValue = xmlNodeGetContent(pNode);
+    pNodeValue = xmlNodeText(pNode, &pCopy);
     if (pNodeValue != NULL) {
         strncpy(pValue, (const char *)pNodeValue, maxLen);
-        xmlFree(pNodeValue);
         result = CPD_OK;
     }
+    xmlFree(pCopy);
     return result;
 }
 
@@ -113,19 +218,20 @@ int xmlNodeGetStr(xmlNode *pNode, char *pValue, int maxLen)
  int xmlNodeGetLong(xmlNode *pNode, long *pValue)
  {
      int result = CPD_NOK;
-     xmlChar *pNodeValue = NULL;
+     const xmlChar *pNodeValue;
+     xmlChar *pCopy;
      if (pNode == NULL) {
          return result;
      }
      if (pValue == NULL) {
          return result;
      }
-     pNodeValue = xmlNodeGetContent(pNode);
+     pNodeValue = xmlNodeText(pNode, &pCopy);
      if (pNodeValue != NULL) {
-         *pValue = atol((const char *)pNodeValue);
-         xmlFree(pNodeValue);
+         *pValue = xmlTextToLong(pNodeValue);
          result = CPD_OK;
      }
+     xmlFree(pCopy);
      return result;
  }
 
@@ -140,29 +246,33 @@ int xmlStringTo3GPP_meas_interval(xmlChar *value)
         return result;
      }
 
-     if (!xmlStrcmp(value, BAD_CAST"e5")) {
-         result = 5;
-     }
-     else if  (!xmlStrcmp(value, BAD_CAST"e15")) {
-         result = 15;
-     }
-     else if  (!xmlStrcmp(value, BAD_CAST"e60")) {
-         result = 60;
-     }
-     else if  (!xmlStrcmp(value, BAD_CAST"e300")) {
-         result = 300;
-     }
-     else if  (!xmlStrcmp(value, BAD_CAST"e900")) {
-         result = 900;
-     }
-     else if  (!xmlStrcmp(value, BAD_CAST"e1800")) {
-         result = 1800;
-     }
-     else if  (!xmlStrcmp(value, BAD_CAST"e3600")) {
-         result = 3600;
-     }
-     else if  (!xmlStrcmp(value, BAD_CAST"e7200")) {
-         result = 7200;
+     switch (cpdXmlNameLookup(value)) {
+         case XML_NAME_e5:
+             result = 5;
+             break;
+         case XML_NAME_e15:
+             result = 15;
+             break;
+         case XML_NAME_e60:
+             result = 60;
+             break;
+         case XML_NAME_e300:
+             result = 300;
+             break;
+         case XML_NAME_e900:
+             result = 900;
+             break;
+         case XML_NAME_e1800:
+             result = 1800;
+             break;
+         case XML_NAME_e3600:
+             result = 3600;
+             break;
+         case XML_NAME_e7200:
+             result = 7200;
+             break;
+         default:
+             break;
      }
 
      xmlFree(value);
@@ -170,6 +280,45 @@ int xmlStringTo3GPP_meas_interval(xmlChar *value)
  }
 
 
+ /*
+  * convert XML_NAME_E (rep_amount literal) to integer
+  */
+int xmlNameTo3GPP_rep_amount(XML_NAME_E name)
+ {
+     int result = CPD_ERROR;
+
+     switch (name) {
+         case XML_NAME_ra1:
+             result = 1;
+             break;
+         case XML_NAME_ra2:
+             result = 2;
+             break;
+         case XML_NAME_ra4:
+             result = 4;
+             break;
+         case XML_NAME_ra8:
+             result = 8;
+             break;
+         case XML_NAME_ra16:
+             result = 16;
+             break;
+         case XML_NAME_ra32:
+             result = 32;
+             break;
+         case XML_NAME_ra64:
+             result = 64;
+             break;
+         case XML_NAME_ra_Infinity:
+             result = 0;
+             break;
+         default:
+             break;
+     }
+
+     return result;
+ }
+
  /*
   * 1. convert an xml  string (rep_amount) to integer
   * 2. Release the provided xml string
@@ -177,39 +326,78 @@ int xmlStringTo3GPP_meas_interval(xmlChar *value)
 int xmlStringTo3GPP_rep_amount(xmlChar *value)
  {
      int result = CPD_ERROR;
-     if (value == NULL) {
-        return result;
-     }
 
-     if (!xmlStrcmp(value, BAD_CAST"ra1")) {
-         result = 1;
-     }
-     else if  (!xmlStrcmp(value, BAD_CAST"ra2")) {
-         result = 2;
-     }
-     else if  (!xmlStrcmp(value, BAD_CAST"ra4")) {
-         result = 4;
-     }
-     else if  (!xmlStrcmp(value, BAD_CAST"ra8")) {
-         result = 8;
-     }
-     else if  (!xmlStrcmp(value, BAD_CAST"ra16")) {
-         result = 16;
-     }
-     else if  (!xmlStrcmp(value, BAD_CAST"ra32")) {
-         result = 32;
-     }
-     else if  (!xmlStrcmp(value, BAD_CAST"ra64")) {
-         result = 64;
-     }
-     else if  (!xmlStrcmp(value, BAD_CAST"ra-Infinity")) {
-         result = 0;
+     if (value != NULL) {
+         result = xmlNameTo3GPP_rep_amount(cpdXmlNameLookup(value));
+         xmlFree(value);
      }
-     xmlFree(value);
      return result;
  }
 
 
+ /*
+  * convert XML_NAME_E (rep_interval_long literal) to integer
+  */
+int xmlNameTo3GPP_rep_interval_long(XML_NAME_E name)
+ {
+     int result = CPD_ERROR;
+
+     switch (name) {
+         case XML_NAME_ril0:
+             result = 0;
+             break;
+         case XML_NAME_ril0_25:
+             result = 1;
+             break;
+         case XML_NAME_ril0_5:
+             result = 1;
+             break;
+         case XML_NAME_ril1:
+             result = 1;
+             break;
+         case XML_NAME_ril2:
+             result = 2;
+             break;
+         case XML_NAME_ril3:
+             result = 3;
+             break;
+         case XML_NAME_ril4:
+             result = 4;
+             break;
+         case XML_NAME_ril6:
+             result = 6;
+             break;
+         case XML_NAME_ril8:
+             result = 8;
+             break;
+         case XML_NAME_ril12:
+             result = 12;
+             break;
+         case XML_NAME_ril16:
+             result = 16;
+             break;
+         case XML_NAME_ril20:
+             result = 20;
+             break;
+         case XML_NAME_ril24:
+             result = 24;
+             break;
+         case XML_NAME_ril28:
+             result = 28;
+             break;
+         case XML_NAME_ril32:
+             result = 32;
+             break;
+         case XML_NAME_ril64:
+             result = 64;
+             break;
+         default:
+             break;
+     }
+
+     return result;
+ }
+
  /*
   * 1. convert an xml string (rep_interval_long) to integer
   * 2. Release the provided xml string
@@ -217,63 +405,36 @@ int xmlStringTo3GPP_rep_amount(xmlChar *value)
 int xmlStringTo3GPP_rep_interval_long(xmlChar *value)
  {
      int result = CPD_ERROR;
-     if (value == NULL) {
-        return result;
-     }
-     if (!xmlStrcmp(value, BAD_CAST"ril0")) {
-         result = 0;
-     }
-     else if  (!xmlStrcmp(value, BAD_CAST"ril0-25")) {
-         result = 1;
-     }
-     else if  (!xmlStrcmp(value, BAD_CAST"ril0-5")) {
-         result = 1;
-     }
-     else if  (!xmlStrcmp(value, BAD_CAST"ril1")) {
-         result = 1;
-     }
-     else if  (!xmlStrcmp(value, BAD_CAST"ril2")) {
-         result = 2;
-     }
-     else if  (!xmlStrcmp(value, BAD_CAST"ril3")) {
-         result = 3;
-     }
-     else if  (!xmlStrcmp(value, BAD_CAST"ril4")) {
-         result = 4;
-     }
-     else if  (!xmlStrcmp(value, BAD_CAST"ril6")) {
-         result = 6;
-     }
-     else if  (!xmlStrcmp(value, BAD_CAST"ril8")) {
-         result = 8;
-     }
-     else if  (!xmlStrcmp(value, BAD_CAST"ril12")) {
-         result = 12;
-     }
-     else if  (!xmlStrcmp(value, BAD_CAST"ril16")) {
-         result = 16;
-     }
-     else if  (!xmlStrcmp(value, BAD_CAST"ril20")) {
-         result = 20;
-     }
-     else if  (!xmlStrcmp(value, BAD_CAST"ril24")) {
-         result = 24;
-     }
-     else if  (!xmlStrcmp(value, BAD_CAST"ril28")) {
-         result = 28;
-     }
-     else if  (!xmlStrcmp(value, BAD_CAST"ril32")) {
-         result = 32;
+
+     if (value != NULL) {
+         result = xmlNameTo3GPP_rep_interval_long(cpdXmlNameLookup(value));
+         xmlFree(value);
      }
-     else if  (!xmlStrcmp(value, BAD_CAST"ril64")) {
-         result = 64;
+     return result;
+ }
+
+
+ /*
+  * convert XML_NAME_E (mult_sets literal) to integer
+  */
+int xmlNameTo3GPP_mult_sets(XML_NAME_E name)
+ {
+     int result = CPD_ERROR;
+
+     switch (name) {
+         case XML_NAME_multiple:
+             result = MULT_SETS_MULTIPLE;
+             break;
+         case XML_NAME_one:
+             result = MULT_SETS_ONE;
+             break;
+         default:
+             break;
      }
 
-     xmlFree(value);
      return result;
  }
 
-
  /*
   * 1. convert an xml  string (mutl_sets) to mutl_sets_t
   * 2. Release the provided xml string
@@ -281,18 +442,11 @@ int xmlStringTo3GPP_rep_interval_long(xmlChar *value)
 int xmlStringTo3GPP_mult_sets(xmlChar *value)
  {
      int result = CPD_ERROR;
-     if (value == NULL) {
-        return result;
-     }
 
-     if (!xmlStrcmp(value, BAD_CAST"multiple")) {
-         result = MULT_SETS_MULTIPLE;
-     }
-     else if (!xmlStrcmp(value, BAD_CAST"one")) {
-         result = MULT_SETS_ONE;
+     if (value != NULL) {
+         result = xmlNameTo3GPP_mult_sets(cpdXmlNameLookup(value));
+         xmlFree(value);
      }
-
-     xmlFree(value);
      return result;
  }
 
@@ -306,7 +460,7 @@ int xmlStringTo3GPP_msg_status(xmlChar *value)
      if (value == NULL) {
         return result;
      }
-     if (!xmlStrcmp(value, BAD_CAST"assist_data_delivered")) {
+     if (cpdXmlNameLookup(value) == XML_NAME_assist_data_delivered) {
          result = MSG_STATUS_ASSIST_DATA_DELIVERED;
      }
 
@@ -324,7 +478,7 @@ int xmlStringTo3GPP_rrlp_method(xmlChar *value)
      if (value == NULL) {
         return result;
      }
-     if (!xmlStrcmp(value, BAD_CAST"gps")) {
+     if (cpdXmlNameLookup(value) == XML_NAME_gps) {
          result = RRLP_METHOD_GPS;
      }
 
@@ -344,53 +498,57 @@ int xmlStringTo3GPP_tr_pos_chg(xmlChar *value)
         return result;
      }
 
-     if (!xmlStrcmp(value, BAD_CAST"pc10")) {
-         result = 10;
-     }
-     else if (!xmlStrcmp(value, BAD_CAST"pc20")) {
-         result = 20;
-     }
-     else if (!xmlStrcmp(value, BAD_CAST"pc30")) {
-         result = 30;
-     }
-     else if (!xmlStrcmp(value, BAD_CAST"pc40")) {
-         result = 40;
-     }
-     else if (!xmlStrcmp(value, BAD_CAST"pc50")) {
-         result = 50;
-     }
-     else if (!xmlStrcmp(value, BAD_CAST"pc100")) {
-         result = 100;
-     }
-     else if (!xmlStrcmp(value, BAD_CAST"pc200")) {
-         result = 200;
-     }
-     else if (!xmlStrcmp(value, BAD_CAST"pc300")) {
-         result = 300;
-     }
-     else if (!xmlStrcmp(value, BAD_CAST"pc500")) {
-         result = 500;
-     }
-     else if (!xmlStrcmp(value, BAD_CAST"pc1000")) {
-         result = 1000;
-     }
-     else if (!xmlStrcmp(value, BAD_CAST"pc2000")) {
-         result = 2000;
-     }
-     else if (!xmlStrcmp(value, BAD_CAST"pc5000")) {
-         result = 5000;
-     }
-     else if (!xmlStrcmp(value, BAD_CAST"pc10000")) {
-         result = 10000;
-     }
-     else if (!xmlStrcmp(value, BAD_CAST"pc20000")) {
-         result = 20000;
-     }
-     else if (!xmlStrcmp(value, BAD_CAST"pc50000")) {
-         result = 50000;
-     }
-     else if (!xmlStrcmp(value, BAD_CAST"pc100000")) {
-         result = 100000;
+     switch (cpdXmlNameLookup(value)) {
+         case XML_NAME_pc10:
+             result = 10;
+             break;
+         case XML_NAME_pc20:
+             result = 20;
+             break;
+         case XML_NAME_pc30:
+             result = 30;
+             break;
+         case XML_NAME_pc40:
+             result = 40;
+             break;
+         case XML_NAME_pc50:
+             result = 50;
+             break;
+         case XML_NAME_pc100:
+             result = 100;
+             break;
+         case XML_NAME_pc200:
+             result = 200;
+             break;
+         case XML_NAME_pc300:
+             result = 300;
+             break;
+         case XML_NAME_pc500:
+             result = 500;
+             break;
+         case XML_NAME_pc1000:
+             result = 1000;
+             break;
+         case XML_NAME_pc2000:
+             result = 2000;
+             break;
+         case XML_NAME_pc5000:
+             result = 5000;
+             break;
+         case XML_NAME_pc10000:
+             result = 10000;
+             break;
+         case XML_NAME_pc20000:
+             result = 20000;
+             break;
+         case XML_NAME_pc50000:
+             result = 50000;
+             break;
+         case XML_NAME_pc100000:
+             result = 100000;
+             break;
+         default:
+             break;
      }
 
      xmlFree(value);
@@ -405,53 +563,57 @@ int xmlStringTo3GPP_tr_SFN_SFN_chg(xmlChar *value)
  {
      int res = CPD_ERROR;
 
-     if (!xmlStrcmp(value, BAD_CAST"c0-25")) {
-         res = 25;
-     }
-     else if (!xmlStrcmp(value, BAD_CAST"c0-5")) {
-         res = 50;
-     }
-     else if (!xmlStrcmp(value, BAD_CAST"c1")) {
-         res = 1;
-     }
-     else if (!xmlStrcmp(value, BAD_CAST"c2")) {
-         res = 2;
-     }
-     else if (!xmlStrcmp(value, BAD_CAST"c3")) {
-         res = 3;
-     }
-     else if (!xmlStrcmp(value, BAD_CAST"c4")) {
-         res = 4;
-     }
-     else if (!xmlStrcmp(value, BAD_CAST"c5")) {
-         res = 5;
-     }
-     else if (!xmlStrcmp(value, BAD_CAST"c10")) {
-         res = 10;
-     }
-     else if (!xmlStrcmp(value, BAD_CAST"c20")) {
-         res = 20;
-     }
-     else if (!xmlStrcmp(value, BAD_CAST"c50")) {
-         res = 50;
-     }
-     else if (!xmlStrcmp(value, BAD_CAST"c100")) {
-         res = 100;
-     }
-     else if (!xmlStrcmp(value, BAD_CAST"c200")) {
-         res = 200;
-     }
-     else if (!xmlStrcmp(value, BAD_CAST"c500")) {
-         res = 500;
-     }
-     else if (!xmlStrcmp(value, BAD_CAST"c1000")) {
-         res = 1000;
-     }
-     else if (!xmlStrcmp(value, BAD_CAST"c2000")) {
-         res = 2000;
-     }
-     else if (!xmlStrcmp(value, BAD_CAST"c5000")) {
-         res = 5000;
+     switch (cpdXmlNameLookup(value)) {
+         case XML_NAME_c0_25:
+             res = 25;
+             break;
+         case XML_NAME_c0_5:
+             res = 50;
+             break;
+         case XML_NAME_c1:
+             res = 1;
+             break;
+         case XML_NAME_c2:
+             res = 2;
+             break;
+         case XML_NAME_c3:
+             res = 3;
+             break;
+         case XML_NAME_c4:
+             res = 4;
+             break;
+         case XML_NAME_c5:
+             res = 5;
+             break;
+         case XML_NAME_c10:
+             res = 10;
+             break;
+         case XML_NAME_c20:
+             res = 20;
+             break;
+         case XML_NAME_c50:
+             res = 50;
+             break;
+         case XML_NAME_c100:
+             res = 100;
+             break;
+         case XML_NAME_c200:
+             res = 200;
+             break;
+         case XML_NAME_c500:
+             res = 500;
+             break;
+         case XML_NAME_c1000:
+             res = 1000;
+             break;
+         case XML_NAME_c2000:
+             res = 2000;
+             break;
+         case XML_NAME_c5000:
+             res = 5000;
+             break;
+         default:
+             break;
      }
 
      xmlFree(value);
@@ -466,29 +628,33 @@ int xmlStringTo3GPP_tr_SFN_GPS_TOW(xmlChar *value)
 {
     int res = CPD_ERROR;
 
-    if (!xmlStrcmp(value, BAD_CAST"ms1")) {
-        res = 1;
-    }
-    else if (!xmlStrcmp(value, BAD_CAST"ms2")) {
-        res = 2;
-    }
-    else if (!xmlStrcmp(value, BAD_CAST"ms3")) {
-        res = 3;
-    }
-    else if (!xmlStrcmp(value, BAD_CAST"ms5")) {
-        res = 5;
-    }
-    else if (!xmlStrcmp(value, BAD_CAST"ms10")) {
-        res = 10;
-    }
-    else if (!xmlStrcmp(value, BAD_CAST"ms20")) {
-        res = 20;
-    }
-    else if (!xmlStrcmp(value, BAD_CAST"ms50")) {
-        res = 50;
-    }
-    else if (!xmlStrcmp(value, BAD_CAST"ms100")) {
-        res = 100;
+    switch (cpdXmlNameLookup(value)) {
+        case XML_NAME_ms1:
+            res = 1;
+            break;
+        case XML_NAME_ms2:
+            res = 2;
+            break;
+        case XML_NAME_ms3:
+            res = 3;
+            break;
+        case XML_NAME_ms5:
+            res = 5;
+            break;
+        case XML_NAME_ms10:
+            res = 10;
+            break;
+        case XML_NAME_ms20:
+            res = 20;
+            break;
+        case XML_NAME_ms50:
+            res = 50;
+            break;
+        case XML_NAME_ms100:
+            res = 100;
+            break;
+        default:
+            break;
     }
 
     xmlFree(value);
@@ -502,56 +668,75 @@ int xmlStringTo3GPP_tr_SFN_GPS_TOW(xmlChar *value)
 SHAPE_TYPE_E xmlStringTo3GPP_shape_type(const xmlChar *pValue)
 {
     SHAPE_TYPE_E result = SHAPE_TYPE_NONE;
-    if (!xmlStrcmp(pValue, (xmlChar *) "ellipsoid_point")) {
-        result = SHAPE_TYPE_POINT;
-    }
-    else if (!xmlStrcmp(pValue, (xmlChar *) "ellipsoid_point_uncert_circle")) {
-        result = SHAPE_TYPE_POINT_UNCERT_CIRCLE;
-    }
-    else if (!xmlStrcmp(pValue, (xmlChar *) "ellipsoid_point_uncert_ellipse")) {
-        result = SHAPE_TYPE_POINT_UNCERT_ELLIPSE;
-    }
-    else if (!xmlStrcmp(pValue, (xmlChar *) "polygon")) {
-        result = SHAPE_TYPE_POLYGON;
-    }
-    else if (!xmlStrcmp(pValue, (xmlChar *) "ellipsoid_point_alt")) {
-        result = SHAPE_TYPE_POINT_ALT;
-    }
-    else if (!xmlStrcmp(pValue, (xmlChar *) "ellipsoid_point_alt_uncertellipse")) {
-        result = SHAPE_TYPE_POINT_ALT_UNCERT_ELLIPSE;
-    }
-    else if (!xmlStrcmp(pValue, (xmlChar *) "ellips_arc")) {
-        result = SHAPE_TYPE_ARC;
+    switch (cpdXmlNameLookup(pValue)) {
+        case XML_NAME_ellipsoid_point:
+            result = SHAPE_TYPE_POINT;
+            break;
+        case XML_NAME_ellipsoid_point_uncert_circle:
+            result = SHAPE_TYPE_POINT_UNCERT_CIRCLE;
+            break;
+        case XML_NAME_ellipsoid_point_uncert_ellipse:
+            result = SHAPE_TYPE_POINT_UNCERT_ELLIPSE;
+            break;
+        case XML_NAME_polygon:
+            result = SHAPE_TYPE_POLYGON;
+            break;
+        case XML_NAME_ellipsoid_point_alt:
+            result = SHAPE_TYPE_POINT_ALT;
+            break;
+        case XML_NAME_ellipsoid_point_alt_uncertellipse:
+            result = SHAPE_TYPE_POINT_ALT_UNCERT_ELLIPSE;
+            break;
+        case XML_NAME_ellips_arc:
+            result = SHAPE_TYPE_ARC;
+            break;
+        default:
+            break;
     }
 
     return result;
 }
 
  /*
-  * 1. convert an xml string to NAV_ELEM_SAT_STATUS_*
-  * 2. Release the provided xml string
+  * convert XML_NAME_E (sat_status literal) to integer
   */
-int xmlStringTo3GPP_nav_elem_sat_status(xmlChar *pValue)
+int xmlNameTo3GPP_nav_elem_sat_status(XML_NAME_E name)
  {
      int result = NAV_ELEM_SAT_STATUS_NONE;
 
-     if (pValue != NULL) {
-         if (!xmlStrcmp(pValue, BAD_CAST"NS_NN-U")) {
+     switch (name) {
+         case XML_NAME_NS_NN_U:
              result = NAV_ELEM_SAT_STATUS_NS_NN_U;
-         }
-         else if (!xmlStrcmp(pValue, BAD_CAST"ES_NN-U")) {
+             break;
+         case XML_NAME_ES_NN_U:
              result = NAV_ELEM_SAT_STATUS_ES_NN_U;
-         }
-         else if (!xmlStrcmp(pValue, BAD_CAST"NS_NN")) {
+             break;
+         case XML_NAME_NS_NN:
              result = NAV_ELEM_SAT_STATUS_NS_NN;
-         }
-         else if (!xmlStrcmp(pValue, BAD_CAST"ES_SN")) {
+             break;
+         case XML_NAME_ES_SN:
              result = NAV_ELEM_SAT_STATUS_ES_SN;
-         }
-         else if (!xmlStrcmp(pValue, BAD_CAST"REVD")) {
+             break;
+         case XML_NAME_REVD:
              result = NAV_ELEM_SAT_STATUS_REVD;
-         }
+             break;
+         default:
+             break;
+     }
 
+     return result;
+ }
+
+ /*
+  * 1. convert an xml string to NAV_ELEM_SAT_STATUS_*
+  * 2. Release the provided xml string
+  */
+int xmlStringTo3GPP_nav_elem_sat_status(xmlChar *pValue)
+ {
+     int result = NAV_ELEM_SAT_STATUS_NONE;
+
+     if (pValue != NULL) {
+         result = xmlNameTo3GPP_nav_elem_sat_status(cpdXmlNameLookup(pValue));
          xmlFree(pValue);
      }
      return result;
@@ -565,17 +750,21 @@ int xmlStringTo3GPP_rep_quant_rrc_method(xmlChar *value)
  {
      int res = CPD_ERROR;
 
-     if (!xmlStrcmp(value, BAD_CAST"otdoa")) {
-         res = REP_QUANT_RRC_METHOD_OTDOA;
-     }
-     else if (!xmlStrcmp(value, BAD_CAST"gps")) {
-         res = REP_QUANT_RRC_METHOD_GPS;
-     }
-     else if (!xmlStrcmp(value, BAD_CAST"otdoaOrGPS")) {
-         res = REP_QUANT_RRC_METHOD_OTDOAORGPS;
-     }
-     else if (!xmlStrcmp(value, BAD_CAST"cellID")) {
-         res = REP_QUANT_RRC_METHOD_CELLID;
+     switch (cpdXmlNameLookup(value)) {
+         case XML_NAME_otdoa:
+             res = REP_QUANT_RRC_METHOD_OTDOA;
+             break;
+         case XML_NAME_gps:
+             res = REP_QUANT_RRC_METHOD_GPS;
+             break;
+         case XML_NAME_otdoaOrGPS:
+             res = REP_QUANT_RRC_METHOD_OTDOAORGPS;
+             break;
+         case XML_NAME_cellID:
+             res = REP_QUANT_RRC_METHOD_CELLID;
+             break;
+         default:
+             break;
      }
 
      xmlFree(value);
@@ -590,20 +779,24 @@ int xmlStringTo3GPP_dopl1_uncert(xmlChar *value)
  {
      int res = CPD_ERROR;
 
-     if (!xmlStrcmp(value, BAD_CAST"hz12-5")) {
-         res = SAT_INFO_DOPL1_UNCERT_12_5HZ;
-     }
-     else if (!xmlStrcmp(value, BAD_CAST"hz25")) {
-         res = SAT_INFO_DOPL1_UNCERT_25HZ;
-     }
-     else if (!xmlStrcmp(value, BAD_CAST"hz50")) {
-         res = SAT_INFO_DOPL1_UNCERT_50HZ;
-     }
-     else if (!xmlStrcmp(value, BAD_CAST"hz100")) {
-         res = SAT_INFO_DOPL1_UNCERT_100HZ;
-     }
-     else if (!xmlStrcmp(value, BAD_CAST"hz200")) {
-         res = SAT_INFO_DOPL1_UNCERT_200HZ;
+     switch (cpdXmlNameLookup(value)) {
+         case XML_NAME_hz12_5:
+             res = SAT_INFO_DOPL1_UNCERT_12_5HZ;
+             break;
+         case XML_NAME_hz25:
+             res = SAT_INFO_DOPL1_UNCERT_25HZ;
+             break;
+         case XML_NAME_hz50:
+             res = SAT_INFO_DOPL1_UNCERT_50HZ;
+             break;
+         case XML_NAME_hz100:
+             res = SAT_INFO_DOPL1_UNCERT_100HZ;
+             break;
+         case XML_NAME_hz200:
+             res = SAT_INFO_DOPL1_UNCERT_200HZ;
+             break;
+         default:
+             break;
      }
 
      xmlFree(value);
@@ -617,47 +810,61 @@ int xmlStringTo3GPP_rep_crit(const xmlChar *value)
  {
      int res = CPD_ERROR;
 
-     if (!xmlStrcmp(value, BAD_CAST"no_rep")) {
-         res = REP_CRIT_NONE;
-     }
-     else if (!xmlStrcmp(value, BAD_CAST"event_rep_crit")) {
-         res = REP_CRIT_EVENT;
-     }
-     else if (!xmlStrcmp(value, BAD_CAST"period_rep_crit")) {
-         res = REP_CRIT_PERIOD;
+     switch (cpdXmlNameLookup(value)) {
+         case XML_NAME_no_rep:
+             res = REP_CRIT_NONE;
+             break;
+         case XML_NAME_event_rep_crit:
+             res = REP_CRIT_EVENT;
+             break;
+         case XML_NAME_period_rep_crit:
+             res = REP_CRIT_PERIOD;
+             break;
+         default:
+             break;
      }
 
      return res;
  }
 
  /*
-  * 1. convert an xml string to XML_PARSER_METHOD_TYPE_*
+  * convert XML_NAME_E (method type) to integer
   */
-GPP_METHOD_TYPE_E xmlStringTo3GPP_method_type(const xmlChar *value)
+GPP_METHOD_TYPE_E xmlNameTo3GPP_method_type(XML_NAME_E name)
  {
      int result = GPP_METHOD_TYPE_NONE;
 
-     if ((!xmlStrcmp(value, BAD_CAST"ms_assisted")) ||
-         (!xmlStrcmp(value, BAD_CAST"ms_assisted_pref")) ||
-         (!xmlStrcmp(value, BAD_CAST"ue_assisted")) ||
-         (!xmlStrcmp(value, BAD_CAST"ue_assisted_pref")))
-     {
-         result = GPP_METHOD_TYPE_MS_ASSISTED;
-     }
-     else if ((!xmlStrcmp(value, BAD_CAST"ms_based")) ||
-              (!xmlStrcmp(value, BAD_CAST"ms_based_pref")) ||
-              (!xmlStrcmp(value, BAD_CAST"ue_based")) ||
-              (!xmlStrcmp(value, BAD_CAST"ue_based_pref")))
-     {
-         result = GPP_METHOD_TYPE_MS_BASED;
-     }
-     else if (!xmlStrcmp(value, BAD_CAST"ms_assisted_no_accuracy")) {
-         result = GPP_METHOD_TYPE_MS_ASSISTED_NO_ACCURACY;
+     switch (name) {
+         case XML_NAME_ms_assisted:
+         case XML_NAME_ms_assisted_pref:
+         case XML_NAME_ue_assisted:
+         case XML_NAME_ue_assisted_pref:
+             result = GPP_METHOD_TYPE_MS_ASSISTED;
+             break;
+         case XML_NAME_ms_based:
+         case XML_NAME_ms_based_pref:
+         case XML_NAME_ue_based:
+         case XML_NAME_ue_based_pref:
+             result = GPP_METHOD_TYPE_MS_BASED;
+             break;
+         case XML_NAME_ms_assisted_no_accuracy:
+             result = GPP_METHOD_TYPE_MS_ASSISTED_NO_ACCURACY;
+             break;
+         default:
+             break;
      }
 
      return result;
  }
 
+ /*
+  * 1. convert an xml string to XML_PARSER_METHOD_TYPE_*
+  */
+GPP_METHOD_TYPE_E xmlStringTo3GPP_method_type(const xmlChar *value)
+ {
+     return xmlNameTo3GPP_method_type(cpdXmlNameLookup(value));
+ }
+
 
  /*
   * 1. convert an xml string to SAT_INFO_DOPL1_UNCERT_*
@@ -667,14 +874,18 @@ int xmlStringToErrorReason(xmlChar *value)
  {
      int res = CPD_ERROR;
 
-     if (!xmlStrcmp(value, BAD_CAST"undefined_error")) {
-         res = POS_ERROR_UNDEFINED;
-     }
-     else if (!xmlStrcmp(value, BAD_CAST"not_enough_gps_satellites")) {
-         res = POS_ERROR_NOT_ENOUGH_GPS_SATELLITES;
-     }
-     else if (!xmlStrcmp(value, BAD_CAST"gps_assist_data_missing")) {
-         res = POS_ERROR_NOT_GPS_ASSISTANCE_DATA_MISSING;
+     switch (cpdXmlNameLookup(value)) {
+         case XML_NAME_undefined_error:
+             res = POS_ERROR_UNDEFINED;
+             break;
+         case XML_NAME_not_enough_gps_satellites:
+             res = POS_ERROR_NOT_ENOUGH_GPS_SATELLITES;
+             break;
+         case XML_NAME_gps_assist_data_missing:
+             res = POS_ERROR_NOT_GPS_ASSISTANCE_DATA_MISSING;
+             break;
+         default:
+             break;
      }
 
      xmlFree(value);
@@ -689,17 +900,21 @@ int xmlStringToMultiPath(xmlChar *value)
  {
      int res = CPD_ERROR;
 
-     if (!xmlStrcmp(value, BAD_CAST"not_measured")) {
-         res = MULTIPATH_NOT_MEASURED;
-     }
-     else if (!xmlStrcmp(value, BAD_CAST"low")) {
-         res = MULTIPATH_LOW;
-     }
-     else if (!xmlStrcmp(value, BAD_CAST"medium")) {
-         res = MULTIPATH_MEDIUM;
-     }
-     else if (!xmlStrcmp(value, BAD_CAST"high")) {
-         res = MULTIPATH_HIGH;
+     switch (cpdXmlNameLookup(value)) {
+         case XML_NAME_not_measured:
+             res = MULTIPATH_NOT_MEASURED;
+             break;
+         case XML_NAME_low:
+             res = MULTIPATH_LOW;
+             break;
+         case XML_NAME_medium:
+             res = MULTIPATH_MEDIUM;
+             break;
+         case XML_NAME_high:
+             res = MULTIPATH_HIGH;
+             break;
+         default:
+             break;
      }
 
      xmlFree(value);
@@ -10,10 +10,16 @@
 #ifndef _CPDXMLUTILS_H_
 #define _CPDXMLUTILS_H_
 
+#include "cpdXmlNames.h"
+
 char *xmlBoolToString(int value);
+char *xmlMultiPathToString(int value);
 int xmlStringToBool(xmlChar *value);
 int xmlStringToInt(xmlChar *value);
 long xmlStringToLong(xmlChar *value);
+int xmlTextToInt(const xmlChar *value);
+long xmlTextToLong(const xmlChar *value);
+int xmlNameToBool(XML_NAME_E name);
 
 int xmlNodeGetInt(xmlNode *pNode, int *pValue);
 int xmlNodeGetLong(xmlNode *pNode, long *pValue);
@@ -37,5 +43,11 @@ int xmlStringTo3GPP_rep_crit(const xmlChar *value);
 int xmlStringTo3GPP_method_type(const xmlChar *value);
 int xmlStringToErrorReason(xmlChar *value);
 int xmlStringToMultiPath(xmlChar *value);
+
+int xmlNameTo3GPP_rep_amount(XML_NAME_E name);
+int xmlNameTo3GPP_rep_interval_long(XML_NAME_E name);
+int xmlNameTo3GPP_mult_sets(XML_NAME_E name);
+int xmlNameTo3GPP_nav_elem_sat_status(XML_NAME_E name);
+int xmlNameTo3GPP_method_type(XML_NAME_E name);
 #endif
 
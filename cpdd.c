@@ -44,6 +44,7 @@
 #include "cpdSocketServer.h"
 #include "cpdGpsComm.h"
 #include "cpdXmlFormatter.h"
+#include "cpdXmlParser.h"
 #include "cpdSystemMonitor.h"
 #include "cpdDebug.h"
 
@@ -172,6 +173,7 @@ int main(int argc, char *argv[])
         CPD_LOG_CLOSE();
         return 0;
     }
+    cpdXmlParserInit(pCpd);
     result = cpdStart(pCpd);
     if (result == CPD_OK) {
         /* Creating MMgr threads if MMgr is available or